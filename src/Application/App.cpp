@@ -54,6 +54,7 @@
 #include "TextEditor/TextLanguage.h"
 #include "TextEditor/TextStyle.h"
 #include "UI/SBrush.h"
+#include "Utility/ThreadPool.h"
 #include "Utility/Tokenizer.h"
 #include "SLADEWxApp.h"
 
@@ -86,6 +87,17 @@ string dir_separator = "/";
 Console        console_main;
 PaletteManager palette_manager;
 ArchiveManager archive_manager;
+
+// Startup timing
+struct InitPhase
+{
+	string name;
+	long   start;  // Time since startup (ms)
+	long   time;   // Time taken (ms)
+	bool   worker; // Run on a worker thread
+};
+vector<InitPhase> init_phases;
+std::mutex        init_phases_mutex;
 } // namespace App
 
 CVAR(Int, temp_location, 0, CVAR_SAVE)
@@ -272,6 +284,170 @@ vector<string> processCommandLine(vector<string>& args)
 
 	return to_open;
 }
+
+// -----------------------------------------------------------------------------
+// Runs initialisation phase [func], recording the time taken as [name] for the
+// startup report. Returns false if the phase failed
+// -----------------------------------------------------------------------------
+bool initPhase(const string& name, const std::function<bool()>& func)
+{
+	long      start = timer.Time();
+	sf::Clock clock;
+	bool      ok = func();
+
+	std::lock_guard<std::mutex> lock(init_phases_mutex);
+	init_phases.push_back(
+		{ name, start, (long)clock.getElapsedTime().asMilliseconds(), std::this_thread::get_id() != main_thread_id });
+
+	return ok;
+}
+
+// An initialisation phase that can run alongside others once the phases it
+// depends on are done
+struct InitTask
+{
+	string                name;
+	vector<string>        depends;
+	bool                  main_thread; // Needs to run on the main (UI) thread
+	std::function<bool()> func;
+};
+
+// -----------------------------------------------------------------------------
+// Runs all initialisation [tasks], each once the tasks it depends on are done.
+// Main thread tasks are run on this thread, others on the global thread pool
+// in the meantime. Returns false if any task failed
+// -----------------------------------------------------------------------------
+bool runInitTasks(const vector<InitTask>& tasks)
+{
+	enum State
+	{
+		Waiting,
+		Running,
+		Done
+	};
+	vector<State>           state(tasks.size(), Waiting);
+	unsigned                running = 0;
+	bool                    failed  = false;
+	std::mutex              mutex;
+	std::condition_variable cv_done;
+
+	auto is_ready = [&](size_t index) {
+		for (auto& depend : tasks[index].depends)
+			for (size_t a = 0; a < tasks.size(); ++a)
+				if (tasks[a].name == depend && state[a] != Done)
+					return false;
+		return true;
+	};
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!failed)
+	{
+		// Start any ready worker tasks, and find a ready main thread task
+		int  main_task = -1;
+		bool waiting   = false;
+		for (size_t a = 0; a < tasks.size(); ++a)
+		{
+			if (state[a] != Waiting)
+				continue;
+			waiting = true;
+			if (!is_ready(a))
+				continue;
+
+			if (tasks[a].main_thread)
+			{
+				if (main_task < 0)
+					main_task = a;
+				continue;
+			}
+
+			state[a] = Running;
+			running++;
+			ThreadPool::global().queue([&, a]() {
+				bool ok = initPhase(tasks[a].name, tasks[a].func);
+
+				std::lock_guard<std::mutex> lock_done(mutex);
+				state[a] = Done;
+				running--;
+				failed |= !ok;
+				cv_done.notify_all();
+			});
+		}
+
+		// Everything done (or started)
+		if (!waiting)
+			break;
+
+		// Run main thread task
+		if (main_task >= 0)
+		{
+			state[main_task] = Running;
+			lock.unlock();
+			bool ok = initPhase(tasks[main_task].name, tasks[main_task].func);
+			lock.lock();
+			state[main_task] = Done;
+			failed |= !ok;
+			continue;
+		}
+
+		// Nothing can run until a worker task finishes
+		if (running == 0)
+		{
+			Log::error("Initialisation tasks have unsatisfiable dependencies");
+			failed = true;
+			break;
+		}
+		cv_done.wait(lock);
+	}
+
+	// Wait for any worker tasks still running
+	cv_done.wait(lock, [&]() { return running == 0; });
+
+	return !failed;
+}
+
+// -----------------------------------------------------------------------------
+// Loads the data for all entries at [paths] in the program resource archive.
+// Paths ending in '/' are directories (not including subdirectories), others
+// are single entries. Init tasks run on worker threads mustn't load entry data
+// themselves, so anything they read is loaded here first
+// -----------------------------------------------------------------------------
+void loadResourceData(const vector<string>& paths)
+{
+	auto res_archive = archive_manager.programResourceArchive();
+	if (!res_archive)
+		return;
+
+	for (auto& path : paths)
+	{
+		if (path.EndsWith("/"))
+		{
+			auto dir = res_archive->getDir(path);
+			for (unsigned a = 0; dir && a < dir->numEntries(); a++)
+				dir->entryAt(a)->getMCData();
+		}
+		else if (auto entry = res_archive->entryAtPath(path))
+			entry->getMCData();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns a report of the time taken by each initialisation phase
+// -----------------------------------------------------------------------------
+vector<string> startupReport()
+{
+	std::lock_guard<std::mutex> lock(init_phases_mutex);
+
+	vector<string> lines;
+	for (auto& phase : init_phases)
+		lines.push_back(S_FMT(
+			"%-24s %5dms (at %dms%s)",
+			CHR(phase.name),
+			(int)phase.time,
+			(int)phase.start,
+			phase.worker ? ", worker thread" : ""));
+
+	return lines;
+}
 } // namespace App
 
 // -----------------------------------------------------------------------------
@@ -345,16 +521,21 @@ bool App::init(vector<string>& args, double ui_scale)
 	vector<string> paths_to_open = processCommandLine(args);
 
 	// Init keybinds
-	KeyBind::initBinds();
+	initPhase("Keybinds", []() {
+		KeyBind::initBinds();
+		return true;
+	});
 
 	// Load configuration file
 	Log::info("Loading configuration");
-	readConfigFile();
+	initPhase("Configuration", []() {
+		readConfigFile();
+		return true;
+	});
 
 	// Check that SLADE.pk3 can be found
 	Log::info("Loading resources");
-	archive_manager.init();
-	if (!archive_manager.resArchiveOK())
+	if (!initPhase("Program resource", []() { return archive_manager.init(); }) || !archive_manager.resArchiveOK())
 	{
 		wxMessageBox(
 			"Unable to find slade.pk3, make sure it exists in the same directory as the "
@@ -365,76 +546,146 @@ bool App::init(vector<string>& args, double ui_scale)
 	}
 
 	// Init SActions
-	SAction::initWxId(26000);
-	SAction::initActions();
+	initPhase("Actions", []() {
+		SAction::initWxId(26000);
+		SAction::initActions();
+		return true;
+	});
 
 	// Init lua
-	Lua::init();
+	initPhase("Lua", []() { return Lua::init(); });
 
 	// Init UI
-	UI::init(ui_scale);
+	initPhase("UI", [ui_scale]() {
+		UI::init(ui_scale);
+		return true;
+	});
 
 	// Show splash screen
 	UI::showSplash("Starting up...");
 
-	// Init palettes
-	if (!palette_manager.init())
-	{
-		Log::error("Failed to initialise palettes");
+	// Load program resources from slade.pk3. These are mostly independent of
+	// each other, so anything that doesn't need the UI is done on worker threads
+	// alongside the rest. The data read by the worker tasks is loaded from the
+	// archive beforehand (palettes, brush icons and config files)
+	initPhase("Resource data", []() {
+		loadResourceData({ "palettes/",
+						   "icons/general/",
+						   "config/entry_types/",
+						   "config/languages/",
+						   "config/nodebuilders.cfg",
+						   "config/executables.cfg" });
+		return true;
+	});
+	vector<InitTask> init_tasks = {
+		{ "Image formats",
+		  {},
+		  false,
+		  []() {
+			  SIFormat::initFormats();
+			  return true;
+		  } },
+		{ "Palettes",
+		  {},
+		  false,
+		  []() {
+			  if (palette_manager.init())
+				  return true;
+			  Log::error("Failed to initialise palettes");
+			  return false;
+		  } },
+		{ "Brushes",
+		  { "Image formats", "Entry types" },
+		  false,
+		  []() {
+			  theBrushManager->initBrushes();
+			  return true;
+		  } },
+		{ "Icons",
+		  {},
+		  true,
+		  []() {
+			  Log::info("Loading icons");
+			  Icons::loadIcons();
+			  return true;
+		  } },
+		{ "Fonts",
+		  {},
+		  true,
+		  []() {
+			  Drawing::initFonts();
+			  return true;
+		  } },
+		{ "Entry types",
+		  {},
+		  false,
+		  []() {
+			  Log::info("Loading entry types");
+			  EntryDataFormat::initBuiltinFormats();
+			  return EntryType::loadEntryTypes();
+		  } },
+		{ "Text languages",
+		  {},
+		  false,
+		  []() {
+			  Log::info("Loading text languages");
+			  return TextLanguage::loadLanguages();
+		  } },
+		{ "Text styles",
+		  {},
+		  true,
+		  []() {
+			  Log::info("Loading text style sets");
+			  StyleSet::loadResourceStyles();
+			  StyleSet::loadCustomStyles();
+			  return true;
+		  } },
+		{ "Colour configuration",
+		  {},
+		  true,
+		  []() {
+			  Log::info("Loading colour configuration");
+			  ColourConfiguration::init();
+			  return true;
+		  } },
+		{ "Node builders",
+		  {},
+		  false,
+		  []() {
+			  NodeBuilders::init();
+			  return true;
+		  } },
+		{ "Executables",
+		  {},
+		  false,
+		  []() {
+			  Executables::init();
+			  return true;
+		  } },
+	};
+	if (!runInitTasks(init_tasks))
 		return false;
-	}
-
-	// Init SImage formats
-	SIFormat::initFormats();
-
-	// Init brushes
-	theBrushManager->initBrushes();
-
-	// Load program icons
-	Log::info("Loading icons");
-	Icons::loadIcons();
-
-	// Load program fonts
-	Drawing::initFonts();
-
-	// Load entry types
-	Log::info("Loading entry types");
-	EntryDataFormat::initBuiltinFormats();
-	EntryType::loadEntryTypes();
-
-	// Load text languages
-	Log::info("Loading text languages");
-	TextLanguage::loadLanguages();
-
-	// Init text stylesets
-	Log::info("Loading text style sets");
-	StyleSet::loadResourceStyles();
-	StyleSet::loadCustomStyles();
-
-	// Init colour configuration
-	Log::info("Loading colour configuration");
-	ColourConfiguration::init();
-
-	// Init nodebuilders
-	NodeBuilders::init();
-
-	// Init game executables
-	Executables::init();
 
 	// Init main editor
-	MainEditor::init();
+	initPhase("Main editor", []() { return MainEditor::init(); });
 
 	// Init base resource
 	Log::info("Loading base resource");
-	archive_manager.initBaseResource();
+	initPhase("Base resource", []() { return archive_manager.initBaseResource(); });
 	Log::info("Base resource loaded");
 
 	// Init game configuration
 	Log::info("Loading game configurations");
-	Game::init();
+	initPhase("Game configurations", []() {
+		Game::init();
+		return true;
+	});
 
 	// Init script manager
-	ScriptManager::init();
+	initPhase("Script manager", []() {
+		ScriptManager::init();
+		return true;
+	});
 
 	// Show the main window
 	MainEditor::windowWx()->Show(true);
@@ -442,12 +693,20 @@ bool App::init(vector<string>& args, double ui_scale)
 	UI::showSplash("Starting up...", false, MainEditor::windowWx());
 
 	// Open any archives from the command line
-	for (auto& path : paths_to_open)
-		archive_manager.openArchive(path);
+	initPhase("Open archives", [&paths_to_open]() {
+		for (auto& path : paths_to_open)
+			archive_manager.openArchive(path);
+		return true;
+	});
 
 	// Hide splash screen
 	UI::hideSplash();
 
+	// Log startup times
+	Log::info(S_FMT("Startup times (%dms total):", (int)timer.Time()));
+	for (auto& line : startupReport())
+		Log::info(line);
+
 	init_ok = true;
 	Log::info("SLADE Initialisation OK");
 
@@ -683,3 +942,10 @@ CONSOLE_COMMAND(setup_wizard, 0, false)
 	SetupWizardDialog dlg(MainEditor::windowWx());
 	dlg.ShowModal();
 }
+
+CONSOLE_COMMAND(startup_report, 0, true)
+{
+	Log::console(S_FMT("Startup times (%s):", App::isInitialised() ? "complete" : "in progress"));
+	for (auto& line : App::startupReport())
+		Log::console(line);
+}
@@ -57,7 +57,7 @@
 // -----------------------------------------------------------------------------
 namespace Global
 {
-string error = "";
+thread_local string error = "";
 
 int    beta_num    = 5;
 int    version_num = 3120;
@@ -244,8 +244,8 @@ public:
 
 		// Last 10 log lines
 		trace_ += "\nLast Log Messages:\n";
-		auto& log = Log::history();
-		for (auto a = log.size() - 10; a < log.size(); a++)
+		auto log = Log::history();
+		for (auto a = log.size() > 10 ? log.size() - 10 : 0; a < log.size(); a++)
 			trace_ += log[a].message + "\n";
 
 		// Add stack trace text area
@@ -591,6 +591,8 @@ int SLADEWxApp::OnExit()
 	delete single_instance_checker_;
 	delete file_listener_;
 
+	Log::close();
+
 	return 0;
 }
 
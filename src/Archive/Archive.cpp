@@ -47,6 +47,7 @@ bool                  Archive::save_backup = true;
 vector<ArchiveFormat> Archive::formats;
 
 
+
 // -----------------------------------------------------------------------------
 //
 // Undo Steps
@@ -657,8 +658,8 @@ bool Archive::save(string filename)
 		{
 			// No filename is given, but the archive has a filename, so overwrite it (and make a backup)
 
-			// Create backup
-			if (backup_archives && wxFileName::FileExists(this->filename_) && save_backup)
+			// Create backup (not needed if the archive format safely updates the file in place)
+			if (backup_archives && wxFileName::FileExists(this->filename_) && save_backup && !savesInPlace())
 			{
 				// Copy current file contents to new backup file
 				string bakfile = this->filename_ + ".bak";
@@ -1372,6 +1373,22 @@ string Archive::detectNamespace(ArchiveEntry* entry)
 		return "global"; // Error, just return global
 }
 
+// -----------------------------------------------------------------------------
+// Returns true if [entry] is of [type] (or could be, if its type is unknown).
+// An entry with deferred type detection is checked against [type] first, so
+// its type is only detected if it could be a match
+// -----------------------------------------------------------------------------
+bool Archive::matchesType(ArchiveEntry* entry, EntryType* type)
+{
+	if (entry->isTypeDeferred() && !type->isThisType(entry))
+		return false;
+
+	if (entry->getType() == EntryType::unknownType())
+		return type->isThisType(entry) != 0;
+
+	return entry->getType() == type;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the first entry matching the search criteria in [options], or null if
 // no matching entry was found
@@ -1392,16 +1409,8 @@ ArchiveEntry* Archive::findFirst(SearchOptions& options)
 		ArchiveEntry* entry = dir->entryAt(a);
 
 		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-					continue;
-			}
-			else if (options.match_type != entry->getType())
-				continue;
-		}
+		if (options.match_type && !matchesType(entry, options.match_type))
+			continue;
 
 		// Check name
 		if (!options.match_name.IsEmpty())
@@ -1482,16 +1491,8 @@ ArchiveEntry* Archive::findLast(SearchOptions& options)
 		ArchiveEntry* entry = dir->entryAt(a);
 
 		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-					continue;
-			}
-			else if (options.match_type != entry->getType())
-				continue;
-		}
+		if (options.match_type && !matchesType(entry, options.match_type))
+			continue;
 
 		// Check name
 		if (!options.match_name.IsEmpty())
@@ -1542,16 +1543,8 @@ vector<ArchiveEntry*> Archive::findAll(SearchOptions& options)
 		ArchiveEntry* entry = dir->entryAt(a);
 
 		// Check type
-		if (options.match_type)
-		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-					continue;
-			}
-			else if (options.match_type != entry->getType())
-				continue;
-		}
+		if (options.match_type && !matchesType(entry, options.match_type))
+			continue;
 
 		// Check name
 		if (!options.match_name.IsEmpty())
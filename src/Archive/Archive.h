@@ -4,6 +4,8 @@
 #include "ArchiveTreeNode.h"
 #include "General/ListenerAnnouncer.h"
 
+class ArchiveProbe;
+
 struct ArchiveFormat
 {
 	string              id;
@@ -85,6 +87,7 @@ public:
 	virtual bool write(MemChunk& mc, bool update = true) = 0; // Write to MemChunk
 	virtual bool write(string filename, bool update = true);  // Write to File
 	virtual bool save(string filename = "");                  // Save archive
+	virtual bool savesInPlace() { return false; }             // True if overwriting the file is journaled
 
 	// Misc
 	virtual bool     loadEntryData(ArchiveEntry* entry) = 0;
@@ -169,6 +172,8 @@ protected:
 	bool          on_disk_;   // Specifies whether the archive exists on disk (as opposed to being newly created)
 	bool          read_only_; // If true, the archive cannot be modified
 
+	static bool matchesType(ArchiveEntry* entry, EntryType* type);
+
 private:
 	bool            modified_;
 	ArchiveTreeNode dir_root_;
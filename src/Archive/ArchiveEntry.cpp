@@ -39,6 +39,14 @@
 #include "Utility/StringUtils.h"
 
 
+// -----------------------------------------------------------------------------
+//
+// External Variables
+//
+// -----------------------------------------------------------------------------
+EXTERN_CVAR(Bool, archive_load_data)
+
+
 // -----------------------------------------------------------------------------
 //
 // ArchiveEntry Class Functions
@@ -56,16 +64,17 @@ ArchiveEntry::ArchiveEntry(string name, uint32_t size)
 	name_         = name;
 	upper_name_   = name.Upper();
 	size_         = size;
-	data_loaded_  = true;
-	state_        = 2;
-	type_         = EntryType::unknownType();
-	locked_       = false;
-	state_locked_ = false;
-	reliability_  = 0;
-	next_         = nullptr;
-	prev_         = nullptr;
-	encrypted_    = ENC_NONE;
-	index_guess_  = 0;
+	data_loaded_   = true;
+	state_         = 2;
+	type_          = EntryType::unknownType();
+	type_deferred_ = false;
+	locked_        = false;
+	state_locked_  = false;
+	reliability_   = 0;
+	next_          = nullptr;
+	prev_          = nullptr;
+	encrypted_     = ENC_NONE;
+	index_guess_   = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -78,16 +87,17 @@ ArchiveEntry::ArchiveEntry(ArchiveEntry& copy)
 	name_         = copy.name_;
 	upper_name_   = copy.upper_name_;
 	size_         = copy.size_;
-	data_loaded_  = true;
-	state_        = 2;
-	type_         = copy.type_;
-	locked_       = false;
-	state_locked_ = false;
-	reliability_  = copy.reliability_;
-	next_         = nullptr;
-	prev_         = nullptr;
-	encrypted_    = copy.encrypted_;
-	index_guess_  = 0;
+	data_loaded_   = true;
+	state_         = 2;
+	type_          = copy.getType();
+	type_deferred_ = false;
+	locked_        = false;
+	state_locked_  = false;
+	reliability_   = copy.reliability_;
+	next_          = nullptr;
+	prev_          = nullptr;
+	encrypted_     = copy.encrypted_;
+	index_guess_   = 0;
 
 	// Copy data
 	data_.importMem(copy.getData(true), copy.getSize());
@@ -270,6 +280,27 @@ void ArchiveEntry::unloadData()
 	setLoaded(false);
 }
 
+// -----------------------------------------------------------------------------
+// Detects the type of an entry that had its type detection deferred (eg. when
+// its archive was opened lazily). The entry data is only kept loaded if it was
+// already, or archive_load_data is set
+// -----------------------------------------------------------------------------
+void ArchiveEntry::detectDeferredType()
+{
+	type_deferred_ = false;
+
+	// Loading the data shouldn't count as a modification
+	bool was_loaded   = data_loaded_;
+	bool state_locked = state_locked_;
+	state_locked_     = true;
+
+	EntryType::detectEntryType(this);
+
+	if (!was_loaded && !archive_load_data)
+		unloadData();
+	state_locked_ = state_locked;
+}
+
 // -----------------------------------------------------------------------------
 // Locks the entry. A locked entry cannot be modified
 // -----------------------------------------------------------------------------
@@ -47,12 +47,18 @@ public:
 	Archive*         getParent();
 	Archive*         getTopParent();
 	string           getPath(bool name = false) const;
-	EntryType*       getType() { return type_; }
+	EntryType*       getType()
+	{
+		if (type_deferred_)
+			detectDeferredType();
+		return type_;
+	}
 	PropertyList&    exProps() { return ex_props_; }
 	Property&        exProp(string key) { return ex_props_[key]; }
 	uint8_t          getState() { return state_; }
 	bool             isLocked() { return locked_; }
 	bool             isLoaded() { return data_loaded_; }
+	bool             isTypeDeferred() const { return type_deferred_; }
 	int              isEncrypted() { return encrypted_; }
 	ArchiveEntry*    nextEntry() { return next_; }
 	ArchiveEntry*    prevEntry() { return prev_; }
@@ -67,9 +73,11 @@ public:
 	void setLoaded(bool loaded = true) { data_loaded_ = loaded; }
 	void setType(EntryType* type, int r = 0)
 	{
-		this->type_  = type;
-		reliability_ = r;
+		this->type_    = type;
+		reliability_   = r;
+		type_deferred_ = false;
 	}
+	void deferTypeDetection() { type_deferred_ = true; }
 	void setState(uint8_t state, bool silent = false);
 	void setEncryption(int enc) { encrypted_ = enc; }
 	void unloadData();
@@ -105,14 +113,14 @@ public:
 	string getSizeString();
 	string getTypeString()
 	{
-		if (type_)
+		if (getType())
 			return type_->name();
 		else
 			return "Unknown";
 	}
 	void          stateChanged();
 	void          setExtensionByType();
-	int           getTypeReliability() { return (type_ ? (getType()->reliability() * reliability_ / 255) : 0); }
+	int           getTypeReliability() { return (getType() ? (type_->reliability() * reliability_ / 255) : 0); }
 	bool          isInNamespace(string ns);
 	ArchiveEntry* relativeEntry(const string& path, bool allow_absolute_path = true) const;
 
@@ -127,11 +135,12 @@ private:
 	PropertyList     ex_props_;
 
 	// Entry status
-	uint8_t state_;        // 0 = unmodified, 1 = modified, 2 = newly created (not saved to disk)
-	bool    state_locked_; // If true the entry state cannot be changed (used for initial loading)
-	bool    locked_;       // If true the entry data+info cannot be changed
-	bool    data_loaded_;  // True if the entry's data is currently loaded into the data MemChunk
-	int     encrypted_;    // Is there some encrypting on the archive?
+	uint8_t state_;         // 0 = unmodified, 1 = modified, 2 = newly created (not saved to disk)
+	bool    state_locked_;  // If true the entry state cannot be changed (used for initial loading)
+	bool    locked_;        // If true the entry data+info cannot be changed
+	bool    data_loaded_;   // True if the entry's data is currently loaded into the data MemChunk
+	bool    type_deferred_; // True if the entry's type will be detected when first needed
+	int     encrypted_;     // Is there some encrypting on the archive?
 
 	// Misc stuff
 	int           reliability_; // The reliability of the entry's identification
@@ -139,4 +148,6 @@ private:
 	ArchiveEntry* prev_;
 
 	size_t index_guess_; // for speed
+
+	void detectDeferredType();
 };
@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "ArchiveManager.h"
 #include "App.h"
+#include "ArchiveProbe.h"
 #include "Formats/All.h"
 #include "Formats/DirArchive.h"
 #include "General/Console/Console.h"
@@ -48,6 +49,7 @@
 CVAR(Int, base_resource, -1, CVAR_SAVE)
 CVAR(Int, max_recent_files, 25, CVAR_SAVE)
 CVAR(Bool, auto_open_wads_root, false, CVAR_SAVE)
+CVAR(Bool, base_resource_lazy_load, true, CVAR_SAVE)
 
 
 // -----------------------------------------------------------------------------
@@ -304,57 +306,17 @@ Archive* ArchiveManager::openArchive(string filename, bool manage, bool silent)
 	}
 
 	// Determine file format
-	if (WadArchive::isWadArchive(filename))
-		new_archive = new WadArchive();
-	else if (ZipArchive::isZipArchive(filename))
-		new_archive = new ZipArchive();
-	else if (ResArchive::isResArchive(filename))
-		new_archive = new ResArchive();
-	else if (DatArchive::isDatArchive(filename))
-		new_archive = new DatArchive();
-	else if (LibArchive::isLibArchive(filename))
-		new_archive = new LibArchive();
-	else if (PakArchive::isPakArchive(filename))
-		new_archive = new PakArchive();
-	else if (BSPArchive::isBSPArchive(filename))
-		new_archive = new BSPArchive();
-	else if (GrpArchive::isGrpArchive(filename))
-		new_archive = new GrpArchive();
-	else if (RffArchive::isRffArchive(filename))
-		new_archive = new RffArchive();
-	else if (GobArchive::isGobArchive(filename))
-		new_archive = new GobArchive();
-	else if (LfdArchive::isLfdArchive(filename))
-		new_archive = new LfdArchive();
-	else if (HogArchive::isHogArchive(filename))
-		new_archive = new HogArchive();
-	else if (ADatArchive::isADatArchive(filename))
-		new_archive = new ADatArchive();
-	else if (Wad2Archive::isWad2Archive(filename))
-		new_archive = new Wad2Archive();
-	else if (WadJArchive::isWadJArchive(filename))
-		new_archive = new WadJArchive();
-	else if (WolfArchive::isWolfArchive(filename))
-		new_archive = new WolfArchive();
-	else if (GZipArchive::isGZipArchive(filename))
-		new_archive = new GZipArchive();
-	else if (BZip2Archive::isBZip2Archive(filename))
-		new_archive = new BZip2Archive();
-	else if (TarArchive::isTarArchive(filename))
-		new_archive = new TarArchive();
-	else if (DiskArchive::isDiskArchive(filename))
-		new_archive = new DiskArchive();
-	else if (PodArchive::isPodArchive(filename))
-		new_archive = new PodArchive();
-	else if (ChasmBinArchive::isChasmBinArchive(filename))
-		new_archive = new ChasmBinArchive();
-	else if (SiNArchive::isSiNArchive(filename))
-		new_archive = new SiNArchive();
-	else
 	{
-		// Unsupported format
-		Global::error = "Unsupported or invalid Archive format";
-		return nullptr;
+		ArchiveProbe probe(filename);
+		auto         format = probe.detectFormat();
+		if (!format)
+		{
+			// Unsupported format
+			Global::error = "Unsupported or invalid Archive format";
+			return nullptr;
+		}
+
+		new_archive = format->create();
 	}
 
 	// If it opened successfully, add it to the list if needed & return it,
@@ -420,58 +382,14 @@ Archive* ArchiveManager::openArchive(ArchiveEntry* entry, bool manage, bool sile
 	}
 
 	// Check entry type
-	if (WadArchive::isWadArchive(entry->getMCData()))
-		new_archive = new WadArchive();
-	else if (ZipArchive::isZipArchive(entry->getMCData()))
-		new_archive = new ZipArchive();
-	else if (ResArchive::isResArchive(entry->getMCData()))
-		new_archive = new ResArchive();
-	else if (LibArchive::isLibArchive(entry->getMCData()))
-		new_archive = new LibArchive();
-	else if (DatArchive::isDatArchive(entry->getMCData()))
-		new_archive = new DatArchive();
-	else if (PakArchive::isPakArchive(entry->getMCData()))
-		new_archive = new PakArchive();
-	else if (BSPArchive::isBSPArchive(entry->getMCData()))
-		new_archive = new BSPArchive();
-	else if (GrpArchive::isGrpArchive(entry->getMCData()))
-		new_archive = new GrpArchive();
-	else if (RffArchive::isRffArchive(entry->getMCData()))
-		new_archive = new RffArchive();
-	else if (GobArchive::isGobArchive(entry->getMCData()))
-		new_archive = new GobArchive();
-	else if (LfdArchive::isLfdArchive(entry->getMCData()))
-		new_archive = new LfdArchive();
-	else if (HogArchive::isHogArchive(entry->getMCData()))
-		new_archive = new HogArchive();
-	else if (ADatArchive::isADatArchive(entry->getMCData()))
-		new_archive = new ADatArchive();
-	else if (Wad2Archive::isWad2Archive(entry->getMCData()))
-		new_archive = new Wad2Archive();
-	else if (WadJArchive::isWadJArchive(entry->getMCData()))
-		new_archive = new WadJArchive();
-	else if (WolfArchive::isWolfArchive(entry->getMCData()))
-		new_archive = new WolfArchive();
-	else if (GZipArchive::isGZipArchive(entry->getMCData()))
-		new_archive = new GZipArchive();
-	else if (BZip2Archive::isBZip2Archive(entry->getMCData()))
-		new_archive = new BZip2Archive();
-	else if (TarArchive::isTarArchive(entry->getMCData()))
-		new_archive = new TarArchive();
-	else if (DiskArchive::isDiskArchive(entry->getMCData()))
-		new_archive = new DiskArchive();
-	else if (entry->getName().Lower().EndsWith(".pod") && PodArchive::isPodArchive(entry->getMCData()))
-		new_archive = new PodArchive();
-	else if (ChasmBinArchive::isChasmBinArchive(entry->getMCData()))
-		new_archive = new ChasmBinArchive();
-	else if (SiNArchive::isSiNArchive(entry->getMCData()))
-		new_archive = new SiNArchive();
-	else
+	auto format = ArchiveProbe::detectFormat(entry);
+	if (!format)
 	{
 		// Unsupported format
 		Global::error = "Unsupported or invalid Archive format";
 		return nullptr;
 	}
+	new_archive = format->create();
 
 	// If it opened successfully, add it to the list & return it,
 	// Otherwise, delete it and return nullptr
@@ -921,9 +839,15 @@ bool ArchiveManager::openBaseResource(int index)
 	else
 		return false;
 
-	// Attempt to open the file
+	// Attempt to open the file (wads are opened lazily, since usually only a
+	// few base resource entries are ever needed)
 	UI::showSplash(S_FMT("Opening %s...", filename), true);
-	if (base_resource_archive_->open(filename))
+	bool opened;
+	if (base_resource_lazy_load && base_resource_archive_->formatId() == "wad")
+		opened = ((WadArchive*)base_resource_archive_)->openLazy(filename);
+	else
+		opened = base_resource_archive_->open(filename);
+	if (opened)
 	{
 		base_resource = index;
 		UI::hideSplash();
@@ -0,0 +1,289 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ArchiveProbe.cpp
+// Description: ArchiveProbe class, a read-only view of a file for detecting
+//              its archive format, and the registry of detectable archive
+//              formats
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ArchiveProbe.h"
+#include "EntryType/EntryDataFormat.h"
+#include "Formats/All.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+vector<ArchiveProbe::Format> formats; // Sorted by confidence (highest first)
+bool                         builtin_formats_registered = false;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Creates an empty archive of type [T]
+// -----------------------------------------------------------------------------
+template<class T> Archive* createArchive()
+{
+	return new T();
+}
+
+// -----------------------------------------------------------------------------
+// Registers all built-in archive formats, if they haven't been already.
+// Formats with the same confidence are probed in the order they are
+// registered here
+// -----------------------------------------------------------------------------
+void registerBuiltinFormats()
+{
+	if (builtin_formats_registered)
+		return;
+	builtin_formats_registered = true;
+
+	// Formats with a signature
+	ArchiveProbe::registerFormat(
+		{ "wad", EDF_TRUE, &WadArchive::isWadArchive, &WadArchive::isWadArchive, &createArchive<WadArchive> });
+	ArchiveProbe::registerFormat(
+		{ "zip", EDF_TRUE, &ZipArchive::isZipArchive, &ZipArchive::isZipArchive, &createArchive<ZipArchive> });
+	ArchiveProbe::registerFormat(
+		{ "res", EDF_TRUE, &ResArchive::isResArchive, &ResArchive::isResArchive, &createArchive<ResArchive> });
+	ArchiveProbe::registerFormat(
+		{ "pak", EDF_TRUE, &PakArchive::isPakArchive, &PakArchive::isPakArchive, &createArchive<PakArchive> });
+	ArchiveProbe::registerFormat(
+		{ "grp", EDF_TRUE, &GrpArchive::isGrpArchive, &GrpArchive::isGrpArchive, &createArchive<GrpArchive> });
+	ArchiveProbe::registerFormat(
+		{ "rff", EDF_TRUE, &RffArchive::isRffArchive, &RffArchive::isRffArchive, &createArchive<RffArchive> });
+	ArchiveProbe::registerFormat(
+		{ "gob", EDF_TRUE, &GobArchive::isGobArchive, &GobArchive::isGobArchive, &createArchive<GobArchive> });
+	ArchiveProbe::registerFormat(
+		{ "lfd", EDF_TRUE, &LfdArchive::isLfdArchive, &LfdArchive::isLfdArchive, &createArchive<LfdArchive> });
+	ArchiveProbe::registerFormat(
+		{ "hog", EDF_TRUE, &HogArchive::isHogArchive, &HogArchive::isHogArchive, &createArchive<HogArchive> });
+	ArchiveProbe::registerFormat(
+		{ "adat", EDF_TRUE, &ADatArchive::isADatArchive, &ADatArchive::isADatArchive, &createArchive<ADatArchive> });
+	ArchiveProbe::registerFormat(
+		{ "wad2", EDF_TRUE, &Wad2Archive::isWad2Archive, &Wad2Archive::isWad2Archive, &createArchive<Wad2Archive> });
+	ArchiveProbe::registerFormat(
+		{ "wadj", EDF_TRUE, &WadJArchive::isWadJArchive, &WadJArchive::isWadJArchive, &createArchive<WadJArchive> });
+	ArchiveProbe::registerFormat(
+		{ "gzip", EDF_TRUE, &GZipArchive::isGZipArchive, &GZipArchive::isGZipArchive, &createArchive<GZipArchive> });
+	ArchiveProbe::registerFormat({ "bz2",
+								   EDF_TRUE,
+								   &BZip2Archive::isBZip2Archive,
+								   &BZip2Archive::isBZip2Archive,
+								   &createArchive<BZip2Archive> });
+	ArchiveProbe::registerFormat(
+		{ "tar", EDF_TRUE, &TarArchive::isTarArchive, &TarArchive::isTarArchive, &createArchive<TarArchive> });
+	ArchiveProbe::registerFormat({ "chasm_bin",
+								   EDF_TRUE,
+								   &ChasmBinArchive::isChasmBinArchive,
+								   &ChasmBinArchive::isChasmBinArchive,
+								   &createArchive<ChasmBinArchive> });
+	ArchiveProbe::registerFormat(
+		{ "sin", EDF_TRUE, &SiNArchive::isSiNArchive, &SiNArchive::isSiNArchive, &createArchive<SiNArchive> });
+
+	// Formats detected by their structure only
+	ArchiveProbe::registerFormat(
+		{ "bsp", EDF_PROBABLY, &BSPArchive::isBSPArchive, &BSPArchive::isBSPArchive, &createArchive<BSPArchive> });
+	ArchiveProbe::registerFormat({ "wolf",
+								   EDF_PROBABLY,
+								   &WolfArchive::isWolfArchive,
+								   &WolfArchive::isWolfArchive,
+								   &createArchive<WolfArchive> });
+	ArchiveProbe::registerFormat({ "disk",
+								   EDF_PROBABLY,
+								   &DiskArchive::isDiskArchive,
+								   &DiskArchive::isDiskArchive,
+								   &createArchive<DiskArchive> });
+	ArchiveProbe::registerFormat(
+		{ "lib", EDF_MAYBE, &LibArchive::isLibArchive, &LibArchive::isLibArchive, &createArchive<LibArchive> });
+	ArchiveProbe::registerFormat(
+		{ "dat", EDF_MAYBE, &DatArchive::isDatArchive, &DatArchive::isDatArchive, &createArchive<DatArchive> });
+	ArchiveProbe::registerFormat({ "pod",
+								   EDF_MAYBE,
+								   &PodArchive::isPodArchive,
+								   &PodArchive::isPodArchive,
+								   &createArchive<PodArchive>,
+								   "pod" });
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// ArchiveProbe Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ArchiveProbe class constructor. Opens [filename] and reads the start and end
+// of it
+// -----------------------------------------------------------------------------
+ArchiveProbe::ArchiveProbe(const string& filename) : filename_{ filename }
+{
+	if (!wxFile::Exists(filename) || !file_.Open(filename))
+		return;
+
+	size_ = file_.Length();
+	if (size_ <= 0)
+	{
+		size_ = 0;
+		return;
+	}
+
+	// Read start of file
+	head_.resize(std::min<wxFileOffset>(size_, BUFFER_SIZE));
+	if (file_.Read(head_.data(), head_.size()) != (ssize_t)head_.size())
+		head_.clear();
+
+	// Read end of file
+	tail_.resize(std::min<wxFileOffset>(size_ - head_.size(), BUFFER_SIZE));
+	if (!tail_.empty())
+	{
+		file_.Seek(size_ - tail_.size(), wxFromStart);
+		if (file_.Read(tail_.data(), tail_.size()) != (ssize_t)tail_.size())
+			tail_.clear();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Sets the current read position to [ofs], relative to [mode]. As with wxFile,
+// the position can be past the end of the file but not before the start.
+// Returns the new position, or wxInvalidOffset if it is invalid
+// -----------------------------------------------------------------------------
+wxFileOffset ArchiveProbe::Seek(wxFileOffset ofs, wxSeekMode mode)
+{
+	if (!file_.IsOpened())
+		return wxInvalidOffset;
+
+	wxFileOffset pos = ofs;
+	if (mode == wxFromCurrent)
+		pos += pos_;
+	else if (mode == wxFromEnd)
+		pos += size_;
+
+	if (pos < 0)
+		return wxInvalidOffset;
+
+	pos_ = pos;
+	return pos_;
+}
+
+// -----------------------------------------------------------------------------
+// Reads up to [count] bytes from the current position into [buffer], from the
+// start/end buffers if possible.
+// Returns the number of bytes read
+// -----------------------------------------------------------------------------
+ssize_t ArchiveProbe::Read(void* buffer, size_t count)
+{
+	if (!file_.IsOpened() || pos_ >= size_)
+		return 0;
+	count = std::min<wxFileOffset>(count, size_ - pos_);
+
+	auto tail_start = size_ - (wxFileOffset)tail_.size();
+	if (pos_ + (wxFileOffset)count <= (wxFileOffset)head_.size())
+		memcpy(buffer, head_.data() + pos_, count);
+	else if (!tail_.empty() && pos_ >= tail_start)
+		memcpy(buffer, tail_.data() + (pos_ - tail_start), count);
+	else
+	{
+		// Not buffered, read from the file
+		if (file_.Seek(pos_, wxFromStart) == wxInvalidOffset)
+			return 0;
+		auto read = file_.Read(buffer, count);
+		if (read <= 0)
+			return read;
+		count = read;
+	}
+
+	pos_ += count;
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the archive format the file is detected as, or nullptr if it isn't
+// a supported archive. If the file is detected as multiple formats, the one
+// with the highest confidence is returned
+// -----------------------------------------------------------------------------
+const ArchiveProbe::Format* ArchiveProbe::detectFormat()
+{
+	if (!file_.IsOpened())
+		return nullptr;
+
+	registerBuiltinFormats();
+	for (auto& format : formats)
+	{
+		Seek(0);
+		if (format.probe_file(*this))
+			return &format;
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the archive format [entry]'s data is detected as, or nullptr if it
+// isn't a supported archive
+// -----------------------------------------------------------------------------
+const ArchiveProbe::Format* ArchiveProbe::detectFormat(ArchiveEntry* entry)
+{
+	registerBuiltinFormats();
+	for (auto& format : formats)
+	{
+		if (!format.entry_ext.empty() && !entry->getName().Lower().EndsWith("." + format.entry_ext))
+			continue;
+		if (format.probe_data(entry->getMCData()))
+			return &format;
+	}
+
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Adds [format] to the list of archive formats that can be detected, after
+// any formats with the same or higher confidence
+// -----------------------------------------------------------------------------
+void ArchiveProbe::registerFormat(const Format& format)
+{
+	auto pos = std::upper_bound(
+		formats.begin(), formats.end(), format, [](const Format& l, const Format& r) {
+			return l.confidence > r.confidence;
+		});
+	formats.insert(pos, format);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+class Archive;
+class ArchiveEntry;
+
+// Read-only view of a file used to detect its archive format.
+//
+// The file is opened once, and its first and last BUFFER_SIZE bytes are read
+// into memory up-front so that (most) format probes don't need to read from
+// the file at all. It has the same interface as wxFile, so format probes can
+// use it in the same way.
+//
+// Also holds the registry of archive formats that can be detected, each with
+// a probe function and a confidence for when it detects a file as its format
+class ArchiveProbe
+{
+public:
+	// An archive format that can be detected
+	struct Format
+	{
+		string   id;                                // Archive format id
+		int      confidence;                        // How certain a detection is (EDF_*)
+		bool     (*probe_file)(ArchiveProbe& file); // Checks a file
+		bool     (*probe_data)(MemChunk& mc);       // Checks entry data
+		Archive* (*create)();                       // Creates an empty archive of the format
+		string   entry_ext = "";                    // If set, entries need this extension to be detected
+	};
+
+	static const uint32_t BUFFER_SIZE = 65536;
+
+	ArchiveProbe(const string& filename);
+	~ArchiveProbe() = default;
+
+	const string& filename() const { return filename_; }
+
+	// wxFile interface
+	bool         IsOpened() const { return file_.IsOpened(); }
+	void         Close() {}
+	wxFileOffset Length() const { return size_; }
+	wxFileOffset Tell() const { return pos_; }
+	wxFileOffset Seek(wxFileOffset ofs, wxSeekMode mode = wxFromStart);
+	wxFileOffset SeekEnd(wxFileOffset ofs = 0) { return Seek(ofs, wxFromEnd); }
+	ssize_t      Read(void* buffer, size_t count);
+
+	// Detection
+	const Format* detectFormat();
+
+	static const Format* detectFormat(ArchiveEntry* entry);
+	static void          registerFormat(const Format& format);
+
+private:
+	string          filename_;
+	wxFile          file_;
+	wxFileOffset    size_ = 0;
+	wxFileOffset    pos_  = 0;
+	vector<uint8_t> head_;
+	vector<uint8_t> tail_;
+};
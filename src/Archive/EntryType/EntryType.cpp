@@ -224,27 +224,6 @@ int EntryType::isThisType(ArchiveEntry* entry)
 			return EDF_FALSE;
 	}
 
-	// Check for data format match if needed
-	int r = EDF_TRUE;
-	if (format_ == EntryDataFormat::textFormat())
-	{
-		// Hack for identifying ACS script sources despite DB2 apparently appending
-		// two null bytes to them, which make the memchr test fail.
-		size_t end = entry->getSize() - 1;
-		if (end > 3)
-			end -= 2;
-		// Text is a special case, as other data formats can sometimes be detected as 'text',
-		// we'll only check for it if text data is specified in the entry type
-		if (entry->getSize() > 0 && memchr(entry->getData(), 0, end) != nullptr)
-			return EDF_FALSE;
-	}
-	else if (format_ != EntryDataFormat::anyFormat() && entry->getSize() > 0)
-	{
-		r = format_->isThisFormat(entry->getMCData());
-		if (r == EDF_FALSE)
-			return EDF_FALSE;
-	}
-
 	// Check for size multiple match if needed
 	if (!size_multiple_.empty())
 	{
@@ -333,12 +312,40 @@ int EntryType::isThisType(ArchiveEntry* entry)
 
 		string e_section = entry->getParent()->detectNamespace(entry);
 
-		r = EDF_FALSE;
+		bool match = false;
 		for (auto ns : section_)
 			if (S_CMPNOCASE(ns, e_section))
-				r = EDF_TRUE;
+				match = true;
+		if (!match)
+			return EDF_FALSE;
 	}
 
+	// Check for data format match if needed (last, since the checks above don't
+	// need the entry data to be loaded)
+	int r = EDF_TRUE;
+	if (format_ == EntryDataFormat::textFormat())
+	{
+		// Hack for identifying ACS script sources despite DB2 apparently appending
+		// two null bytes to them, which make the memchr test fail.
+		size_t end = entry->getSize() - 1;
+		if (end > 3)
+			end -= 2;
+		// Text is a special case, as other data formats can sometimes be detected as 'text',
+		// we'll only check for it if text data is specified in the entry type
+		if (entry->getSize() > 0 && memchr(entry->getData(), 0, end) != nullptr)
+			return EDF_FALSE;
+	}
+	else if (format_ != EntryDataFormat::anyFormat() && entry->getSize() > 0)
+	{
+		r = format_->isThisFormat(entry->getMCData());
+		if (r == EDF_FALSE)
+			return EDF_FALSE;
+	}
+
+	// A section match overrides the data format's reliability
+	if (!section_.empty())
+		r = EDF_TRUE;
+
 	// Passed all checks, so we have a match
 	return r;
 }
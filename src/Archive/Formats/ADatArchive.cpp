@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "ADatArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "Utility/Compression.h"
@@ -419,9 +420,15 @@ bool ADatArchive::isADatArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ADatArchive::isADatArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isADatArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Anachronox dat archive
+// -----------------------------------------------------------------------------
+bool ADatArchive::isADatArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 16)
 		return false;
@@ -21,4 +21,5 @@ public:
 	// Static functions
 	static bool isADatArchive(MemChunk& mc);
 	static bool isADatArchive(string filename);
+	static bool isADatArchive(ArchiveProbe& file);
 };
@@ -39,6 +39,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "BSPArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -458,9 +459,15 @@ bool BSPArchive::isBSPArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool BSPArchive::isBSPArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isBSPArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Quake BSP archive
+// -----------------------------------------------------------------------------
+bool BSPArchive::isBSPArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -19,4 +19,5 @@ public:
 	// Static functions
 	static bool isBSPArchive(MemChunk& mc);
 	static bool isBSPArchive(string filename);
+	static bool isBSPArchive(ArchiveProbe& file);
 };
@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "BZip2Archive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/Misc.h"
 #include "UI/SplashWindow.h"
 #include "Utility/Compression.h"
@@ -253,9 +254,15 @@ bool BZip2Archive::isBZip2Archive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool BZip2Archive::isBZip2Archive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isBZip2Archive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid BZip2 archive
+// -----------------------------------------------------------------------------
+bool BZip2Archive::isBZip2Archive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 14)
 	{
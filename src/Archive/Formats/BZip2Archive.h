@@ -47,4 +47,5 @@ public:
 	// Static functions
 	static bool isBZip2Archive(MemChunk& mc);
 	static bool isBZip2Archive(string filename);
+	static bool isBZip2Archive(ArchiveProbe& file);
 };
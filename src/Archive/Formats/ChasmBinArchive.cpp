@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "ChasmBinArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -374,9 +375,15 @@ bool ChasmBinArchive::isChasmBinArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ChasmBinArchive::isChasmBinArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isChasmBinArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Chasm bin archive
+// -----------------------------------------------------------------------------
+bool ChasmBinArchive::isChasmBinArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < HEADER_SIZE)
 	{
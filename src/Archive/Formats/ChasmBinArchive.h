@@ -17,4 +17,5 @@ public:
 	// Static functions
 	static bool isChasmBinArchive(MemChunk& mc);
 	static bool isChasmBinArchive(string filename);
+	static bool isChasmBinArchive(ArchiveProbe& file);
 };
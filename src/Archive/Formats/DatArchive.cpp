@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "DatArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -662,9 +663,15 @@ bool DatArchive::isDatArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool DatArchive::isDatArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isDatArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Shadowcaster dat archive
+// -----------------------------------------------------------------------------
+bool DatArchive::isDatArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -43,6 +43,7 @@ public:
 
 	static bool isDatArchive(MemChunk& mc);
 	static bool isDatArchive(string filename);
+	static bool isDatArchive(ArchiveProbe& file);
 
 private:
 	int sprites_[2];
@@ -34,6 +34,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "DiskArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -384,9 +385,15 @@ bool DiskArchive::isDiskArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool DiskArchive::isDiskArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isDiskArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Quake disk archive
+// -----------------------------------------------------------------------------
+bool DiskArchive::isDiskArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 4)
 		return false;
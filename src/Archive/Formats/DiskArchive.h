@@ -25,4 +25,5 @@ public:
 	// Static functions
 	static bool isDiskArchive(MemChunk& mc);
 	static bool isDiskArchive(string filename);
+	static bool isDiskArchive(ArchiveProbe& file);
 };
@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "GZipArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/Misc.h"
 #include "UI/SplashWindow.h"
 #include "Utility/Compression.h"
@@ -510,9 +511,15 @@ bool GZipArchive::isGZipArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool GZipArchive::isGZipArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isGZipArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid GZip archive
+// -----------------------------------------------------------------------------
+bool GZipArchive::isGZipArchive(ArchiveProbe& file)
+{
 	// Minimal metadata size is 18: 10 for header, 8 for footer
 	size_t mds = 18;
 
@@ -47,6 +47,7 @@ public:
 	// Static functions
 	static bool isGZipArchive(MemChunk& mc);
 	static bool isGZipArchive(string filename);
+	static bool isGZipArchive(ArchiveProbe& file);
 
 private:
 	string   comment_;
@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "GobArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -409,9 +410,15 @@ bool GobArchive::isGobArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool GobArchive::isGobArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isGobArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Dark Forces gob archive
+// -----------------------------------------------------------------------------
+bool GobArchive::isGobArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -33,4 +33,5 @@ public:
 	// Static functions
 	static bool isGobArchive(MemChunk& mc);
 	static bool isGobArchive(string filename);
+	static bool isGobArchive(ArchiveProbe& file);
 };
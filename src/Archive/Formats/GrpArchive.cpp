@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "GrpArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -404,9 +405,15 @@ bool GrpArchive::isGrpArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool GrpArchive::isGrpArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isGrpArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid DN3D grp archive
+// -----------------------------------------------------------------------------
+bool GrpArchive::isGrpArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
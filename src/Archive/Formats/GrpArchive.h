@@ -33,4 +33,5 @@ public:
 	// Static functions
 	static bool isGrpArchive(MemChunk& mc);
 	static bool isGrpArchive(string filename);
+	static bool isGrpArchive(ArchiveProbe& file);
 };
@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "HogArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -454,9 +455,15 @@ bool HogArchive::isHogArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool HogArchive::isHogArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isHogArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Descent hog archive
+// -----------------------------------------------------------------------------
+bool HogArchive::isHogArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -33,4 +33,5 @@ public:
 	// Static functions
 	static bool isHogArchive(MemChunk& mc);
 	static bool isHogArchive(string filename);
+	static bool isHogArchive(ArchiveProbe& file);
 };
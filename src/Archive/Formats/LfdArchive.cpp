@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "LfdArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -453,9 +454,15 @@ bool LfdArchive::isLfdArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool LfdArchive::isLfdArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isLfdArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Dark Forces lfd archive
+// -----------------------------------------------------------------------------
+bool LfdArchive::isLfdArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -33,4 +33,5 @@ public:
 	// Static functions
 	static bool isLfdArchive(MemChunk& mc);
 	static bool isLfdArchive(string filename);
+	static bool isLfdArchive(ArchiveProbe& file);
 };
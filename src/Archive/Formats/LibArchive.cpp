@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "LibArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -399,9 +400,15 @@ bool LibArchive::isLibArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool LibArchive::isLibArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isLibArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Shadowcaster lib archive
+// -----------------------------------------------------------------------------
+bool LibArchive::isLibArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
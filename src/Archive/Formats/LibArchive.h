@@ -31,4 +31,5 @@ public:
 
 	static bool isLibArchive(MemChunk& mc);
 	static bool isLibArchive(string filename);
+	static bool isLibArchive(ArchiveProbe& file);
 };
@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "PakArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -360,9 +361,15 @@ bool PakArchive::isPakArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool PakArchive::isPakArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isPakArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Quake pak archive
+// -----------------------------------------------------------------------------
+bool PakArchive::isPakArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 12)
 		return false;
@@ -18,4 +18,5 @@ public:
 	// Static functions
 	static bool isPakArchive(MemChunk& mc);
 	static bool isPakArchive(string filename);
+	static bool isPakArchive(ArchiveProbe& file);
 };
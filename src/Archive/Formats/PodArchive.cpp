@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "PodArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/Console/Console.h"
 #include "General/UI.h"
 #include "MainEditor/MainEditor.h"
@@ -331,8 +332,16 @@ bool PodArchive::isPodArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool PodArchive::isPodArchive(string filename)
 {
-	wxFile file;
-	if (!file.Open(filename))
+	ArchiveProbe file(filename);
+	return isPodArchive(file);
+}
+
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid pod archive
+// -----------------------------------------------------------------------------
+bool PodArchive::isPodArchive(ArchiveProbe& file)
+{
+	if (!file.IsOpened())
 		return false;
 
 	file.SeekEnd(0);
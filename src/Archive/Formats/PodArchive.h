@@ -23,6 +23,7 @@ public:
 	// Static functions
 	static bool isPodArchive(MemChunk& mc);
 	static bool isPodArchive(string filename);
+	static bool isPodArchive(ArchiveProbe& file);
 
 private:
 	char id_[80];
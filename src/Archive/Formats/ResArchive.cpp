@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "ResArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -485,9 +486,15 @@ bool ResArchive::isResArchive(MemChunk& mc, size_t& dir_offset, size_t& num_lump
 // -----------------------------------------------------------------------------
 bool ResArchive::isResArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isResArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid A&A res archive
+// -----------------------------------------------------------------------------
+bool ResArchive::isResArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -35,4 +35,5 @@ public:
 	static bool isResArchive(MemChunk& mc);
 	static bool isResArchive(MemChunk& mc, size_t& d_o, size_t& n_l);
 	static bool isResArchive(string filename);
+	static bool isResArchive(ArchiveProbe& file);
 };
@@ -67,6 +67,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "RffArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -462,9 +463,15 @@ bool RffArchive::isRffArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool RffArchive::isRffArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isRffArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid DN3D grp archive
+// -----------------------------------------------------------------------------
+bool RffArchive::isRffArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -33,4 +33,5 @@ public:
 	// Static functions
 	static bool isRffArchive(MemChunk& mc);
 	static bool isRffArchive(string filename);
+	static bool isRffArchive(ArchiveProbe& file);
 };
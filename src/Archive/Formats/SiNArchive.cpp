@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "SiNArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -361,9 +362,15 @@ bool SiNArchive::isSiNArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool SiNArchive::isSiNArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isSiNArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Ritual SiN archive
+// -----------------------------------------------------------------------------
+bool SiNArchive::isSiNArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 12)
 		return false;
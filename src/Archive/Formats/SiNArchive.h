@@ -18,4 +18,5 @@ public:
 	// Static functions
 	static bool isSiNArchive(MemChunk& mc);
 	static bool isSiNArchive(string filename);
+	static bool isSiNArchive(ArchiveProbe& file);
 };
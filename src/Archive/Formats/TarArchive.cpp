@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "TarArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -575,9 +576,15 @@ bool TarArchive::isTarArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool TarArchive::isTarArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isTarArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Unix tar archive
+// -----------------------------------------------------------------------------
+bool TarArchive::isTarArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened() || file.Length() < 512)
 		return false;
@@ -18,4 +18,5 @@ public:
 	// Static functions
 	static bool isTarArchive(MemChunk& mc);
 	static bool isTarArchive(string filename);
+	static bool isTarArchive(ArchiveProbe& file);
 };
@@ -33,6 +33,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Wad2Archive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -390,9 +391,15 @@ bool Wad2Archive::isWad2Archive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool Wad2Archive::isWad2Archive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isWad2Archive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Quake wad2 archive
+// -----------------------------------------------------------------------------
+bool Wad2Archive::isWad2Archive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
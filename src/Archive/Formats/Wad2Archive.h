@@ -40,6 +40,7 @@ public:
 	// Static functions
 	static bool isWad2Archive(MemChunk& mc);
 	static bool isWad2Archive(string filename);
+	static bool isWad2Archive(ArchiveProbe& file);
 
 private:
 	bool wad3_;
@@ -31,10 +31,12 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "WadArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "Utility/Tokenizer.h"
 #include "WadJArchive.h"
+#include <set>
 
 
 // -----------------------------------------------------------------------------
@@ -44,6 +46,8 @@
 // -----------------------------------------------------------------------------
 CVAR(Bool, wad_force_uppercase, true, CVAR_SAVE)
 CVAR(Bool, iwad_lock, true, CVAR_SAVE)
+CVAR(Bool, wad_save_in_place, true, CVAR_SAVE)
+CVAR(Int, wad_save_compact_threshold, 25, CVAR_SAVE) // Max % of unused space after saving in place
 
 namespace
 {
@@ -105,6 +109,68 @@ const int n_special_namespaces = 11;
 EXTERN_CVAR(Bool, archive_load_data)
 
 
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// A region of a wad file
+struct FileRegion
+{
+	uint64_t offset;
+	uint64_t size;
+};
+
+// -----------------------------------------------------------------------------
+// Returns the filename of the journal written while saving the wad file at
+// [filename] in place
+// -----------------------------------------------------------------------------
+string journalFilename(const string& filename)
+{
+	return filename + ".journal";
+}
+
+// -----------------------------------------------------------------------------
+// Writes the wad directory for all entries in [archive] to [mc], with the
+// given lump [offsets]
+// -----------------------------------------------------------------------------
+void writeDirectory(Archive& archive, const vector<uint32_t>& offsets, MemChunk& mc)
+{
+	mc.reSize(archive.numEntries() * 16, false);
+	mc.seek(0, SEEK_SET);
+	for (unsigned a = 0; a < archive.numEntries(); a++)
+	{
+		auto     entry   = archive.getEntry(a);
+		char     name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		uint32_t size    = entry->getSize();
+
+		for (size_t c = 0; c < entry->getName().length() && c < 8; c++)
+			name[c] = entry->getName()[c];
+
+		mc.write(&offsets[a], 4);
+		mc.write(&size, 4);
+		mc.write(name, 8);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Updates the offsets of all entries in [archive] after being written, and
+// sets them to unmodified
+// -----------------------------------------------------------------------------
+void updateEntries(Archive& archive, const vector<uint32_t>& offsets)
+{
+	for (unsigned a = 0; a < archive.numEntries(); a++)
+	{
+		auto entry = archive.getEntry(a);
+		entry->setState(0);
+		entry->exProp("Offset") = (int)offsets[a];
+	}
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // WadArchive Class Functions
@@ -301,47 +367,15 @@ bool WadArchive::hasFlatHack()
 }
 
 // -----------------------------------------------------------------------------
-// Reads wad format data from a MemChunk
-// Returns true if successful, false otherwise
+// Reads [num_lumps] lump definitions from wad directory data [dir] (from its
+// current position), and adds an (unloaded) entry for each. [dir_offset] and
+// [file_size] are the directory offset and total size of the wad file.
+// Returns false if the directory is invalid
 // -----------------------------------------------------------------------------
-bool WadArchive::open(MemChunk& mc)
+bool WadArchive::readDirectory(MemChunk& dir, uint32_t num_lumps, uint32_t dir_offset, size_t file_size)
 {
-	// Check data was given
-	if (!mc.hasData())
-		return false;
-
-	// Read wad header
-	uint32_t num_lumps   = 0;
-	uint32_t dir_offset  = 0;
-	char     wad_type[4] = "";
-	mc.seek(0, SEEK_SET);
-	mc.read(&wad_type, 4);   // Wad type
-	mc.read(&num_lumps, 4);  // No. of lumps in wad
-	mc.read(&dir_offset, 4); // Offset to directory
-
-	// Byteswap values for big endian if needed
-	num_lumps  = wxINT32_SWAP_ON_BE(num_lumps);
-	dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
-
-	// Check the header
-	if (wad_type[1] != 'W' || wad_type[2] != 'A' || wad_type[3] != 'D')
-	{
-		LOG_MESSAGE(1, "WadArchive::openFile: File %s has invalid header", filename_);
-		Global::error = "Invalid wad header";
-		return false;
-	}
-
-	// Check for iwad
-	if (wad_type[0] == 'I')
-		iwad_ = true;
-
-	// Stop announcements (don't want to be announcing modification due to entries being added etc)
-	setMuted(true);
-
 	vector<uint32_t> offsets;
 
-	// Read the directory
-	mc.seek(dir_offset, SEEK_SET);
 	UI::setSplashProgressMessage("Reading wad archive data");
 	for (uint32_t d = 0; d < num_lumps; d++)
 	{
@@ -353,9 +387,9 @@ bool WadArchive::open(MemChunk& mc)
 		uint32_t offset  = 0;
 		uint32_t size    = 0;
 
-		mc.read(&offset, 4); // Offset
-		mc.read(&size, 4);   // Size
-		mc.read(name, 8);    // Name
+		dir.read(&offset, 4); // Offset
+		dir.read(&size, 4);   // Size
+		dir.read(name, 8);    // Name
 		name[8] = '\0';
 
 		// Byteswap values for big endian if needed
@@ -379,7 +413,7 @@ bool WadArchive::open(MemChunk& mc)
 		}
 
 		// Hack to open Operation: Rheingold WAD files
-		if (size == 0 && offset > mc.getSize())
+		if (size == 0 && offset > file_size)
 			offset = 0;
 
 		// Is there a compression/encryption thing going on?
@@ -392,26 +426,26 @@ bool WadArchive::open(MemChunk& mc)
 		{
 			if (d < num_lumps - 1)
 			{
-				size_t   pos        = mc.currentPos();
+				size_t   pos        = dir.currentPos();
 				uint32_t nextoffset = 0;
 				for (int i = 0; i + d < num_lumps; ++i)
 				{
-					mc.read(&nextoffset, 4);
+					dir.read(&nextoffset, 4);
 					if (nextoffset != 0)
 						break;
-					mc.seek(12, SEEK_CUR);
+					dir.seek(12, SEEK_CUR);
 				}
 				nextoffset = wxINT32_SWAP_ON_BE(nextoffset);
 				if (nextoffset == 0)
 					nextoffset = dir_offset;
-				mc.seek(pos, SEEK_SET);
+				dir.seek(pos, SEEK_SET);
 				actualsize = nextoffset - offset;
 			}
 			else
 			{
 				if (offset > dir_offset)
 				{
-					actualsize = mc.getSize() - offset;
+					actualsize = file_size - offset;
 				}
 				else
 				{
@@ -422,12 +456,11 @@ bool WadArchive::open(MemChunk& mc)
 
 		// If the lump data goes past the end of the file,
 		// the wadfile is invalid
-		if (offset + actualsize > mc.getSize())
+		if (offset + actualsize > file_size)
 		{
 			LOG_MESSAGE(1, "WadArchive::open: Wad archive is invalid or corrupt");
 			Global::error =
 				S_FMT("Archive is invalid and/or corrupt (lump %d: %s data goes past end of file)", d, name);
-			setMuted(false);
 			return false;
 		}
 
@@ -447,6 +480,161 @@ bool WadArchive::open(MemChunk& mc)
 		rootDir()->addEntry(nlump);
 	}
 
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads a wad file from [filename], first recovering it from an incomplete
+// save if needed
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::open(string filename)
+{
+	if (!recoverJournal(filename))
+	{
+		Global::error = S_FMT("Unable to recover from incomplete save (see %s)", journalFilename(filename));
+		return false;
+	}
+
+	return Archive::open(filename);
+}
+
+// -----------------------------------------------------------------------------
+// Opens the wad file [filename] lazily: only the header and directory are
+// read, and entry type detection is deferred until each entry's type is first
+// needed (entry data is loaded from the file as usual). Map and #include
+// detection is not done, so this is only intended for read-only use (eg. the
+// base resource archive).
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::openLazy(string filename)
+{
+	if (!recoverJournal(filename))
+	{
+		Global::error = S_FMT("Unable to recover from incomplete save (see %s)", journalFilename(filename));
+		return false;
+	}
+
+	wxFile file(filename);
+	if (!file.IsOpened())
+	{
+		Global::error = "Unable to open file. Make sure it isn't in use by another program.";
+		return false;
+	}
+
+	// Read wad header
+	sf::Clock timer;
+	uint32_t  num_lumps   = 0;
+	uint32_t  dir_offset  = 0;
+	char      wad_type[4] = "";
+	size_t    file_size   = file.Length();
+	if (file.Read(wad_type, 4) != 4 || file.Read(&num_lumps, 4) != 4 || file.Read(&dir_offset, 4) != 4)
+	{
+		Global::error = "Invalid wad header";
+		return false;
+	}
+	num_lumps  = wxINT32_SWAP_ON_BE(num_lumps);
+	dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
+
+	// Check the header
+	if (wad_type[1] != 'W' || wad_type[2] != 'A' || wad_type[3] != 'D')
+	{
+		LOG_MESSAGE(1, "WadArchive::openLazy: File %s has invalid header", filename);
+		Global::error = "Invalid wad header";
+		return false;
+	}
+	if ((uint64_t)dir_offset + (uint64_t)num_lumps * 16 > file_size)
+	{
+		Global::error = "Archive is invalid and/or corrupt (directory goes past end of file)";
+		return false;
+	}
+	iwad_ = (wad_type[0] == 'I');
+
+	// Read the directory
+	MemChunk dir;
+	file.Seek(dir_offset, wxFromStart);
+	if (num_lumps > 0 && !dir.importFileStream(file, num_lumps * 16))
+	{
+		Global::error = "Unable to read wad directory";
+		return false;
+	}
+
+	string backupname = filename_;
+	filename_         = filename;
+	setMuted(true);
+	dir.seek(0, SEEK_SET);
+	if (!readDirectory(dir, num_lumps, dir_offset, file_size))
+	{
+		close();
+		filename_ = backupname;
+		setMuted(false);
+		return false;
+	}
+
+	// Namespaces are needed by type detection, so still detect them now
+	updateNamespaces();
+
+	// Defer type detection
+	for (size_t a = 0; a < numEntries(); a++)
+		getEntry(a)->deferTypeDetection();
+
+	setMuted(false);
+	setModified(false);
+	on_disk_ = true;
+	announce("opened");
+
+	UI::setSplashProgressMessage("");
+	LOG_MESSAGE(2, "WadArchive::openLazy took %dms", timer.getElapsedTime().asMilliseconds());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads wad format data from a MemChunk
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::open(MemChunk& mc)
+{
+	// Check data was given
+	if (!mc.hasData())
+		return false;
+
+	// Read wad header
+	uint32_t num_lumps   = 0;
+	uint32_t dir_offset  = 0;
+	char     wad_type[4] = "";
+	mc.seek(0, SEEK_SET);
+	mc.read(&wad_type, 4);   // Wad type
+	mc.read(&num_lumps, 4);  // No. of lumps in wad
+	mc.read(&dir_offset, 4); // Offset to directory
+
+	// Byteswap values for big endian if needed
+	num_lumps  = wxINT32_SWAP_ON_BE(num_lumps);
+	dir_offset = wxINT32_SWAP_ON_BE(dir_offset);
+
+	// Check the header
+	if (wad_type[1] != 'W' || wad_type[2] != 'A' || wad_type[3] != 'D')
+	{
+		LOG_MESSAGE(1, "WadArchive::openFile: File %s has invalid header", filename_);
+		Global::error = "Invalid wad header";
+		return false;
+	}
+
+	// Check for iwad
+	if (wad_type[0] == 'I')
+		iwad_ = true;
+
+	// Stop announcements (don't want to be announcing modification due to entries being added etc)
+	setMuted(true);
+
+	// Read the directory
+	mc.seek(dir_offset, SEEK_SET);
+	if (!readDirectory(mc, num_lumps, dir_offset, mc.getSize()))
+	{
+		setMuted(false);
+		return false;
+	}
+
 	// Detect namespaces (needs to be done before type detection as some types
 	// rely on being within certain namespaces)
 	updateNamespaces();
@@ -526,13 +714,14 @@ bool WadArchive::write(MemChunk& mc, bool update)
 	}
 
 	// Determine directory offset & individual lump offsets
-	uint32_t      dir_offset = 12;
-	ArchiveEntry* entry      = nullptr;
+	// (entry offsets aren't updated until after writing, since any unloaded
+	// lumps need to be read from their current offset)
+	uint32_t         dir_offset = 12;
+	vector<uint32_t> offsets(numEntries());
 	for (uint32_t l = 0; l < numEntries(); l++)
 	{
-		entry = getEntry(l);
-		setEntryOffset(entry, dir_offset);
-		dir_offset += entry->getSize();
+		offsets[l] = dir_offset;
+		dir_offset += getEntry(l)->getSize();
 	}
 
 	// Clear/init MemChunk
@@ -558,37 +747,26 @@ bool WadArchive::write(MemChunk& mc, bool update)
 	// Write the lumps
 	for (uint32_t l = 0; l < num_lumps; l++)
 	{
-		entry = getEntry(l);
+		auto entry = getEntry(l);
 		mc.write(entry->getData(), entry->getSize());
 	}
 
 	// Write the directory
-	for (uint32_t l = 0; l < num_lumps; l++)
-	{
-		entry        = getEntry(l);
-		char name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-		long offset  = getEntryOffset(entry);
-		long size    = entry->getSize();
+	MemChunk dir;
+	writeDirectory(*this, offsets, dir);
+	mc.write(dir.getData(), dir.getSize());
 
-		for (size_t c = 0; c < entry->getName().length() && c < 8; c++)
-			name[c] = entry->getName()[c];
-
-		mc.write(&offset, 4);
-		mc.write(&size, 4);
-		mc.write(name, 8);
-
-		if (update)
-		{
-			entry->setState(0);
-			entry->exProp("Offset") = (int)offset;
-		}
-	}
+	if (update)
+		updateEntries(*this, offsets);
 
 	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Writes the wad archive to a file at [filename]
+// Writes the wad archive to a file at [filename]. If [filename] is the
+// archive's current file, it is updated in place if possible (see
+// writeInPlace), otherwise it is replaced with a fully rewritten (compacted)
+// copy
 // Returns true if successful, false otherwise
 // -----------------------------------------------------------------------------
 bool WadArchive::write(string filename, bool update)
@@ -600,6 +778,57 @@ bool WadArchive::write(string filename, bool update)
 		return false;
 	}
 
+	vector<uint32_t> offsets;
+	if (on_disk_ && filename == filename_ && wxFileExists(filename))
+	{
+		// Update the existing file in place if possible
+		if (!(update && wad_save_in_place && writeInPlace(offsets)))
+		{
+			// Otherwise write to a temp file and replace the existing file with it
+			// (can't write to it directly since unloaded lumps are read from it)
+			string temp = filename + ".tmp";
+			if (!writeFile(temp, offsets))
+			{
+				wxRemoveFile(temp);
+				return false;
+			}
+			if (!wxRenameFile(temp, filename, true))
+			{
+				Global::error = "Unable to overwrite file. Make sure it isn't in use by another program.";
+				wxRemoveFile(temp);
+				return false;
+			}
+
+			// Remove any leftover journal from a failed in-place save
+			if (wxFileExists(journalFilename(filename)))
+				wxRemoveFile(journalFilename(filename));
+		}
+	}
+	else if (!writeFile(filename, offsets))
+		return false;
+
+	if (update)
+		updateEntries(*this, offsets);
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if overwriting the archive's file is done safely in place, so
+// there is no need to back it up first
+// -----------------------------------------------------------------------------
+bool WadArchive::savesInPlace()
+{
+	return wad_save_in_place;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the whole wad archive to a new file at [filename], and the offset
+// each lump was written at to [offsets]
+// Returns true if successful, false otherwise
+// -----------------------------------------------------------------------------
+bool WadArchive::writeFile(string filename, vector<uint32_t>& offsets)
+{
 	// Open file for writing
 	wxFile file;
 	file.Open(filename, wxFile::write);
@@ -610,13 +839,13 @@ bool WadArchive::write(string filename, bool update)
 	}
 
 	// Determine directory offset & individual lump offsets
-	uint32_t      dir_offset = 12;
-	ArchiveEntry* entry      = nullptr;
-	for (uint32_t l = 0; l < numEntries(); l++)
+	uint32_t num_lumps  = numEntries();
+	uint32_t dir_offset = 12;
+	offsets.resize(num_lumps);
+	for (uint32_t l = 0; l < num_lumps; l++)
 	{
-		entry = getEntry(l);
-		setEntryOffset(entry, dir_offset);
-		dir_offset += entry->getSize();
+		offsets[l] = dir_offset;
+		dir_offset += getEntry(l)->getSize();
 	}
 
 	// Setup wad type
@@ -625,45 +854,274 @@ bool WadArchive::write(string filename, bool update)
 		wad_type[0] = 'I';
 
 	// Write the header
-	uint32_t num_lumps = numEntries();
-	file.Write(wad_type, 4);
-	file.Write(&num_lumps, 4);
-	file.Write(&dir_offset, 4);
+	bool ok = file.Write(wad_type, 4) == 4;
+	ok      = ok && file.Write(&num_lumps, 4) == 4;
+	ok      = ok && file.Write(&dir_offset, 4) == 4;
 
 	// Write the lumps
-	for (uint32_t l = 0; l < num_lumps; l++)
+	for (uint32_t l = 0; l < num_lumps && ok; l++)
 	{
-		entry = getEntry(l);
+		auto entry = getEntry(l);
 		if (entry->getSize())
-		{
-			file.Write(entry->getData(), entry->getSize());
-		}
+			ok = file.Write(entry->getData(), entry->getSize()) == entry->getSize();
 	}
 
 	// Write the directory
-	for (uint32_t l = 0; l < num_lumps; l++)
+	MemChunk dir;
+	writeDirectory(*this, offsets, dir);
+	ok = ok && file.Write(dir.getData(), dir.getSize()) == dir.getSize();
+
+	file.Close();
+
+	if (!ok)
+		Global::error = "Unable to write file, check there is enough disk space";
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Updates the archive's existing file in place, only writing lumps that have
+// been modified or added since it was last saved. These are written to unused
+// space in the file if they fit, or otherwise appended to the end. Unmodified
+// lumps are left where they are and a new directory and header are written.
+//
+// Nothing used by the file's existing directory is overwritten, so the file
+// stays valid until the new header is written. The old header is saved to a
+// journal file beforehand, which is removed once the save is complete (if the
+// journal still exists when the file is next opened, the old header is
+// restored from it - see recoverJournal).
+//
+// Returns false (leaving the file unmodified) if the file can't be updated in
+// place or too much of it would be unused space afterwards, in which case it
+// should be fully rewritten instead. Otherwise writes the offset of each lump
+// to [offsets] and returns true
+// -----------------------------------------------------------------------------
+bool WadArchive::writeInPlace(vector<uint32_t>& offsets)
+{
+	wxFile file(filename_, wxFile::read_write);
+	if (!file.IsOpened())
+		return false;
+
+	// Read the existing header
+	uint64_t file_size = file.Length();
+	char     header[12];
+	if (file_size < 12 || file.Read(header, 12) != 12 || header[1] != 'W' || header[2] != 'A' || header[3] != 'D')
+		return false;
+	uint32_t old_num_lumps, old_dir_offset;
+	memcpy(&old_num_lumps, header + 4, 4);
+	memcpy(&old_dir_offset, header + 8, 4);
+	old_num_lumps  = wxINT32_SWAP_ON_BE(old_num_lumps);
+	old_dir_offset = wxINT32_SWAP_ON_BE(old_dir_offset);
+	if (old_dir_offset + (uint64_t)old_num_lumps * 16 > file_size)
+		return false;
+
+	// Read the existing directory, and determine which regions of the file are
+	// used by it (these can't be written to)
+	vector<uint8_t> old_dir(old_num_lumps * 16);
+	if (file.Seek(old_dir_offset) == wxInvalidOffset
+		|| file.Read(old_dir.data(), old_dir.size()) != (ssize_t)old_dir.size())
+		return false;
+	vector<FileRegion>                      used = { { 0, 12 }, { old_dir_offset, old_dir.size() } };
+	std::set<std::pair<uint32_t, uint32_t>> old_lumps;
+	for (uint32_t a = 0; a < old_num_lumps; a++)
 	{
-		entry        = getEntry(l);
-		char name[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-		long offset  = getEntryOffset(entry);
-		long size    = entry->getSize();
+		uint32_t offset, size;
+		memcpy(&offset, old_dir.data() + a * 16, 4);
+		memcpy(&size, old_dir.data() + a * 16 + 4, 4);
+		offset = wxINT32_SWAP_ON_BE(offset);
+		size   = wxINT32_SWAP_ON_BE(size);
 
-		for (size_t c = 0; c < entry->getName().length() && c < 8; c++)
-			name[c] = entry->getName()[c];
+		// Jaguar-encrypted lumps take up more space than their size
+		if (old_dir[a * 16 + 8] & 0x80)
+			return false;
+
+		if (size == 0)
+			continue;
+		if (offset + (uint64_t)size > file_size)
+			return false;
+
+		used.push_back({ offset, size });
+		old_lumps.insert({ offset, size });
+	}
 
-		file.Write(&offset, 4);
-		file.Write(&size, 4);
-		file.Write(name, 8);
+	// Determine which lumps are unchanged and can be left where they are
+	uint32_t        num_lumps = numEntries();
+	vector<bool>    keep(num_lumps, false);
+	uint64_t        used_size = 12 + (uint64_t)num_lumps * 16;
+	vector<uint8_t> old_data;
+	offsets.assign(num_lumps, 12);
+	for (uint32_t a = 0; a < num_lumps; a++)
+	{
+		auto     entry = getEntry(a);
+		uint32_t size  = entry->getSize();
+		used_size += size;
 
-		if (update)
+		// Zero-sized lumps don't take up any space
+		if (size == 0)
 		{
-			entry->setState(0);
-			entry->exProp("Offset") = (int)offset;
+			keep[a] = true;
+			continue;
 		}
+
+		// Check the lump is in the existing directory
+		if (entry->getState() == 2 || entry->isEncrypted() || !entry->exProps().propertyExists("Offset"))
+			continue;
+		uint32_t offset = getEntryOffset(entry);
+		if (old_lumps.count({ offset, size }) == 0)
+			continue;
+
+		if (!entry->isLoaded() || entry->getState() == 0)
+			keep[a] = true; // Data hasn't been modified
+		else
+		{
+			// Modified (or just renamed), check if the data is different
+			old_data.resize(size);
+			keep[a] = file.Seek(offset) != wxInvalidOffset && file.Read(old_data.data(), size) == (ssize_t)size
+					  && memcmp(old_data.data(), entry->getData(), size) == 0;
+		}
+
+		if (keep[a])
+		{
+			offsets[a] = offset;
+			old_lumps.erase({ offset, size });
+		}
+	}
+
+	// Find unused regions of the file (by size, for best-fit allocation)
+	std::sort(used.begin(), used.end(), [](const FileRegion& l, const FileRegion& r) { return l.offset < r.offset; });
+	std::multimap<uint64_t, uint64_t> unused;
+	uint64_t                          end = 0;
+	for (auto& region : used)
+	{
+		if (region.offset > end)
+			unused.emplace(region.offset - end, end);
+		end = std::max(end, region.offset + region.size);
+	}
+	auto allocate = [&](uint64_t size) {
+		auto region = unused.lower_bound(size);
+		if (region == unused.end())
+		{
+			end += size;
+			return end - size;
+		}
+
+		uint64_t offset = region->second;
+		if (region->first > size)
+			unused.emplace(region->first - size, offset + size);
+		unused.erase(region);
+		return offset;
+	};
+
+	// Allocate space for modified/new lumps and the directory
+	for (uint32_t a = 0; a < num_lumps; a++)
+		if (!keep[a])
+			offsets[a] = allocate(getEntry(a)->getSize());
+	uint64_t dir_offset = allocate((uint64_t)num_lumps * 16);
+
+	// Check how much space would be unused
+	uint64_t new_size = std::max(end, file_size);
+	if (new_size > 0xFFFFFFFF)
+		return false;
+	if ((new_size - used_size) * 100 > new_size * (uint64_t)std::max(0, (int)wad_save_compact_threshold))
+	{
+		LOG_MESSAGE(2, "Compacting %s (%llu unused bytes)", filename_, (unsigned long long)(new_size - used_size));
+		return false;
+	}
+
+	// Load data for lumps to be written first (unloaded ones are read from the file)
+	for (uint32_t a = 0; a < num_lumps; a++)
+		if (!keep[a])
+			getEntry(a)->getData();
+
+	// Write the existing header to the journal
+	string journal_file = journalFilename(filename_);
+	wxFile journal(journal_file, wxFile::write);
+	bool   ok = journal.IsOpened() && journal.Write(header, 12) == 12 && journal.Flush();
+	journal.Close();
+	if (!ok)
+	{
+		wxRemoveFile(journal_file);
+		return false;
+	}
+
+	// Write modified/new lumps
+	unsigned written = 0;
+	for (uint32_t a = 0; a < num_lumps && ok; a++)
+	{
+		auto entry = getEntry(a);
+		if (keep[a] || entry->getSize() == 0)
+			continue;
+
+		ok = file.Seek(offsets[a]) != wxInvalidOffset
+			 && file.Write(entry->getData(), entry->getSize()) == entry->getSize();
+		written++;
+	}
+
+	// Write the directory
+	MemChunk dir;
+	writeDirectory(*this, offsets, dir);
+	ok = ok && file.Seek(dir_offset) != wxInvalidOffset && file.Write(dir.getData(), dir.getSize()) == dir.getSize()
+		 && file.Flush();
+	if (!ok)
+	{
+		// The header hasn't been written yet so the file is still valid
+		file.Close();
+		wxRemoveFile(journal_file);
+		return false;
 	}
 
+	// Write the new header
+	uint32_t new_dir_offset = dir_offset;
+	memcpy(header + 4, &num_lumps, 4);
+	memcpy(header + 8, &new_dir_offset, 4);
+	header[0] = iwad_ ? 'I' : 'P';
+	ok        = file.Seek(0) != wxInvalidOffset && file.Write(header, 12) == 12 && file.Flush();
 	file.Close();
+	if (!ok)
+		return false;
+
+	// Done, remove the journal
+	wxRemoveFile(journal_file);
+
+	LOG_MESSAGE(
+		2,
+		"Saved %s in place (%d of %d lumps written, %llu unused bytes)",
+		filename_,
+		written,
+		num_lumps,
+		(unsigned long long)(new_size - used_size));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Checks for a journal left by an incomplete in-place save of the wad file at
+// [filename], and if one exists restores the file's header from it (which
+// points to the directory from before the save, still intact in the file)
+// Returns false if the header couldn't be restored
+// -----------------------------------------------------------------------------
+bool WadArchive::recoverJournal(string filename)
+{
+	string journal_file = journalFilename(filename);
+	if (!wxFileExists(journal_file))
+		return true;
+
+	// If the journal itself is incomplete, the file wasn't modified
+	char   header[12];
+	wxFile journal(journal_file);
+	bool   complete = journal.IsOpened() && journal.Read(header, 12) == 12;
+	journal.Close();
+
+	if (complete)
+	{
+		LOG_MESSAGE(1, "Last save of %s didn't complete, restoring previous version", filename);
+
+		wxFile file(filename, wxFile::read_write);
+		if (!file.IsOpened() || file.Write(header, 12) != 12 || !file.Flush())
+			return false;
+	}
 
+	wxRemoveFile(journal_file);
 	return true;
 }
 
@@ -696,8 +1154,22 @@ bool WadArchive::loadEntryData(ArchiveEntry* entry)
 	}
 
 	// Seek to lump offset in file and read it in
+	bool type_deferred = entry->isTypeDeferred();
 	file.Seek(getEntryOffset(entry), wxFromStart);
 	entry->importFileStream(file, entry->getSize());
+	if (type_deferred)
+		entry->deferTypeDetection();
+
+	// Decode Jaguar-compressed lumps (as when opened)
+	if (entry->isEncrypted() == ENC_JAGUAR)
+	{
+		MemChunk& edata = entry->getMCData(false);
+		if (entry->exProps().propertyExists("FullSize")
+			&& (unsigned)(int)(entry->exProp("FullSize")) > edata.getSize())
+			edata.reSize((int)(entry->exProp("FullSize")), true);
+		if (!WadJArchive::jaguarDecode(edata))
+			LOG_MESSAGE(1, "WadArchive::loadEntryData: %s did not decode properly", entry->getName());
+	}
 
 	// Set the lump to loaded
 	entry->setLoaded();
@@ -1330,21 +1802,10 @@ ArchiveEntry* WadArchive::findFirst(SearchOptions& options)
 	while (entry != end)
 	{
 		// Check type
-		if (options.match_type)
+		if (options.match_type && !matchesType(entry, options.match_type))
 		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->nextEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
+			entry = entry->nextEntry();
+			continue;
 		}
 
 		// Check name
@@ -1410,21 +1871,10 @@ ArchiveEntry* WadArchive::findLast(SearchOptions& options)
 	while (entry != end)
 	{
 		// Check type
-		if (options.match_type)
+		if (options.match_type && !matchesType(entry, options.match_type))
 		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->prevEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->prevEntry();
-				continue;
-			}
+			entry = entry->prevEntry();
+			continue;
 		}
 
 		// Check name
@@ -1486,21 +1936,10 @@ vector<ArchiveEntry*> WadArchive::findAll(SearchOptions& options)
 	while (entry != end)
 	{
 		// Check type
-		if (options.match_type)
+		if (options.match_type && !matchesType(entry, options.match_type))
 		{
-			if (entry->getType() == EntryType::unknownType())
-			{
-				if (!options.match_type->isThisType(entry))
-				{
-					entry = entry->nextEntry();
-					continue;
-				}
-			}
-			else if (options.match_type != entry->getType())
-			{
-				entry = entry->nextEntry();
-				continue;
-			}
+			entry = entry->nextEntry();
+			continue;
 		}
 
 		// Check name
@@ -1570,9 +2009,15 @@ bool WadArchive::isWadArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool WadArchive::isWadArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isWadArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Doom wad archive
+// -----------------------------------------------------------------------------
+bool WadArchive::isWadArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -16,11 +16,15 @@ public:
 	void     updateNamespaces();
 
 	// Opening
+	using Archive::open;
+	bool open(string filename) override; // Open from File
 	bool open(MemChunk& mc) override;
+	bool openLazy(string filename);
 
 	// Writing/Saving
 	bool write(MemChunk& mc, bool update = true) override;    // Write to MemChunk
 	bool write(string filename, bool update = true) override; // Write to File
+	bool savesInPlace() override;
 
 	// Misc
 	bool loadEntryData(ArchiveEntry* entry) override;
@@ -58,6 +62,7 @@ public:
 	// Static functions
 	static bool isWadArchive(MemChunk& mc);
 	static bool isWadArchive(string filename);
+	static bool isWadArchive(ArchiveProbe& file);
 
 	static bool exportEntriesAsWad(string filename, vector<ArchiveEntry*> entries)
 	{
@@ -94,4 +99,9 @@ private:
 
 	bool           iwad_;
 	vector<NSPair> namespaces_;
+
+	bool writeFile(string filename, vector<uint32_t>& offsets);
+	bool writeInPlace(vector<uint32_t>& offsets);
+
+	static bool recoverJournal(string filename);
 };
@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "WadJArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 #include "MainEditor/UI/MainWindow.h"
 
@@ -373,9 +374,15 @@ bool WadJArchive::isWadJArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool WadJArchive::isWadJArchive(string filename)
 {
-	// Open file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isWadJArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Jaguar Doom wad archive
+// -----------------------------------------------------------------------------
+bool WadJArchive::isWadJArchive(ArchiveProbe& file)
+{
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
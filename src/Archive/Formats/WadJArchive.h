@@ -18,6 +18,7 @@ public:
 
 	static bool isWadJArchive(MemChunk& mc);
 	static bool isWadJArchive(string filename);
+	static bool isWadJArchive(ArchiveProbe& file);
 
 	static bool jaguarDecode(MemChunk& mc);
 
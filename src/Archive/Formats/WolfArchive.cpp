@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "WolfArchive.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 
 
@@ -1163,9 +1164,18 @@ bool WolfArchive::isWolfArchive(MemChunk& mc)
 // Checks if the file at [filename] is a valid Wolfenstein VSWAP archive
 // -----------------------------------------------------------------------------
 bool WolfArchive::isWolfArchive(string filename)
+{
+	ArchiveProbe file(filename);
+	return isWolfArchive(file);
+}
+
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid Wolfenstein VSWAP archive
+// -----------------------------------------------------------------------------
+bool WolfArchive::isWolfArchive(ArchiveProbe& file)
 {
 	// Find wolf archive type
-	wxFileName fn1(filename);
+	wxFileName fn1(file.filename());
 	if (fn1.GetName().MakeUpper() == "MAPHEAD" || fn1.GetName().MakeUpper() == "GAMEMAPS"
 		|| fn1.GetName().MakeUpper() == "MAPTEMP")
 	{
@@ -1202,9 +1212,6 @@ bool WolfArchive::isWolfArchive(string filename)
 
 	// else we have to deal with a VSWAP archive, which is the only self-contained type
 
-	// Open file for reading
-	wxFile file(filename);
-
 	// Check it opened ok
 	if (!file.IsOpened())
 		return false;
@@ -46,6 +46,7 @@ public:
 
 	static bool isWolfArchive(MemChunk& mc);
 	static bool isWolfArchive(string filename);
+	static bool isWolfArchive(ArchiveProbe& file);
 
 private:
 	uint16_t spritestart_;
@@ -32,6 +32,7 @@
 #include "Main.h"
 #include "ZipArchive.h"
 #include "App.h"
+#include "Archive/ArchiveProbe.h"
 #include "General/UI.h"
 #include "WadArchive.h"
 #include <fstream>
@@ -683,9 +684,16 @@ bool ZipArchive::isZipArchive(MemChunk& mc)
 // -----------------------------------------------------------------------------
 bool ZipArchive::isZipArchive(string filename)
 {
-	// Open the file for reading
-	wxFile file(filename);
+	ArchiveProbe file(filename);
+	return isZipArchive(file);
+}
 
+// -----------------------------------------------------------------------------
+// Checks if [file] is a valid zip archive
+// -----------------------------------------------------------------------------
+bool ZipArchive::isZipArchive(ArchiveProbe& file)
+{
+	// Open the file for reading
 	// Check it opened
 	if (!file.IsOpened())
 		return false;
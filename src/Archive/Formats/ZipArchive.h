@@ -34,6 +34,7 @@ public:
 	// Static functions
 	static bool isZipArchive(MemChunk& mc);
 	static bool isZipArchive(string filename);
+	static bool isZipArchive(ArchiveProbe& file);
 
 private:
 	string temp_file_;
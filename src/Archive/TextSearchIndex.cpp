@@ -0,0 +1,738 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextSearchIndex.cpp
+// Description: TextSearchIndex class, a trigram index of the content of text
+//              entries in all open archives for searching text across
+//              archives in the background
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextSearchIndex.h"
+#include "App.h"
+#include "Archive/ArchiveManager.h"
+#include "Utility/ThreadPool.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Maximum length of line text in search results
+const size_t MAX_LINE_LENGTH = 200;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns [c] in lower case if it is an (ascii) upper case letter
+// -----------------------------------------------------------------------------
+inline char lowerChar(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the (case-insensitive) trigram key for the 3 characters at [text]
+// -----------------------------------------------------------------------------
+inline uint32_t trigramKey(const char* text)
+{
+	return ((uint8_t)lowerChar(text[0]) << 16) | ((uint8_t)lowerChar(text[1]) << 8) | (uint8_t)lowerChar(text[2]);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all unique trigrams in [text], sorted
+// -----------------------------------------------------------------------------
+vector<uint32_t> textTrigrams(const std::string& text)
+{
+	vector<uint32_t> trigrams;
+	if (text.size() < 3)
+		return trigrams;
+
+	trigrams.reserve(text.size() - 2);
+	for (size_t a = 0; a + 2 < text.size(); ++a)
+		trigrams.push_back(trigramKey(text.data() + a));
+
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	trigrams.shrink_to_fit();
+
+	return trigrams;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the longest run of literal characters in [regex] that any match
+// must contain, or an empty string if there isn't one (eg. if [regex] has
+// alternatives). Anything within groups is ignored
+// -----------------------------------------------------------------------------
+std::string requiredLiteral(const std::string& regex)
+{
+	if (regex.find('|') != std::string::npos)
+		return {};
+
+	std::string longest;
+	std::string current;
+	auto        end_run = [&]() {
+		if (current.size() > longest.size())
+			longest = current;
+		current.clear();
+	};
+
+	for (size_t a = 0; a < regex.size(); ++a)
+	{
+		char c = regex[a];
+
+		// Quantifiers make the previous character optional (or repeated),
+		// so it can't be part of the literal
+		if (c == '*' || c == '?' || c == '{')
+		{
+			if (!current.empty())
+				current.pop_back();
+			end_run();
+
+			// Skip {n,m}
+			if (c == '{')
+				while (a < regex.size() && regex[a] != '}')
+					++a;
+			continue;
+		}
+
+		// Bracket expression
+		if (c == '[')
+		{
+			end_run();
+			while (a < regex.size() && regex[a] != ']')
+				++a;
+			continue;
+		}
+
+		// Group (may be optional)
+		if (c == '(')
+		{
+			end_run();
+			int depth = 0;
+			for (; a < regex.size(); ++a)
+			{
+				if (regex[a] == '\\')
+					++a;
+				else if (regex[a] == '(')
+					++depth;
+				else if (regex[a] == ')' && --depth == 0)
+					break;
+			}
+			continue;
+		}
+
+		// Escaped character, only punctuation is taken literally
+		// (\w, \d etc. are classes)
+		if (c == '\\')
+		{
+			if (a + 1 < regex.size() && ispunct((unsigned char)regex[a + 1]))
+			{
+				current += regex[++a];
+				continue;
+			}
+
+			end_run();
+			++a;
+			continue;
+		}
+
+		if (c == '.' || c == '^' || c == '$' || c == ')' || c == '+')
+		{
+			// A '+' means at least one of the previous character, so it is
+			// still required but can't be followed by anything else in a run
+			end_run();
+			continue;
+		}
+
+		current += c;
+	}
+	end_run();
+
+	return longest;
+}
+
+// -----------------------------------------------------------------------------
+// Finds [query] in [text] starting from [pos], ignoring (ascii) case.
+// Returns the position of the match or std::string::npos if not found
+// -----------------------------------------------------------------------------
+size_t findNoCase(const std::string& text, const std::string& query, size_t pos)
+{
+	auto found = std::search(text.begin() + pos, text.end(), query.begin(), query.end(), [](char a, char b) {
+		return lowerChar(a) == lowerChar(b);
+	});
+
+	return found == text.end() ? std::string::npos : found - text.begin();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the text of the line from [start] to [end] in [text] for a search
+// result (trimmed and truncated if very long)
+// -----------------------------------------------------------------------------
+string resultLineText(const std::string& text, size_t start, size_t end)
+{
+	while (start < end && isspace((unsigned char)text[start]))
+		++start;
+	while (end > start && isspace((unsigned char)text[end - 1]))
+		--end;
+
+	// Truncate (at a UTF-8 character boundary)
+	if (end - start > MAX_LINE_LENGTH)
+	{
+		end = start + MAX_LINE_LENGTH;
+		while (end > start && ((uint8_t)text[end] & 0xC0) == 0x80)
+			--end;
+	}
+
+	return wxString::FromUTF8(text.data() + start, end - start);
+}
+
+// -----------------------------------------------------------------------------
+// Finds all lines in [text] matching [query] (either plain text or a compiled
+// [regex]), adding them to [results] for [entry]
+// -----------------------------------------------------------------------------
+void findMatches(
+	const std::string&                 text,
+	const std::string&                 query,
+	bool                               match_case,
+	wxRegEx*                           regex,
+	const std::weak_ptr<ArchiveEntry>& entry,
+	vector<TextSearchIndex::Result>&   results)
+{
+	unsigned line       = 1;
+	size_t   line_start = 0;
+
+	// Regex, check each line
+	if (regex)
+	{
+		while (line_start < text.size())
+		{
+			auto line_end = text.find('\n', line_start);
+			if (line_end == std::string::npos)
+				line_end = text.size();
+
+			auto length = line_end - line_start;
+			if (length > 0 && text[line_end - 1] == '\r')
+				--length;
+			if (regex->Matches(wxString::FromUTF8(text.data() + line_start, length)))
+				results.push_back({ entry, line, resultLineText(text, line_start, line_end) });
+
+			line_start = line_end + 1;
+			++line;
+		}
+
+		return;
+	}
+
+	// Plain text, find each match and the line it is on
+	size_t pos  = 0;
+	size_t scan = 0;
+	while (true)
+	{
+		auto match = match_case ? text.find(query, pos) : findNoCase(text, query, pos);
+		if (match == std::string::npos)
+			break;
+
+		for (; scan < match; ++scan)
+			if (text[scan] == '\n')
+			{
+				++line;
+				line_start = scan + 1;
+			}
+
+		auto line_end = text.find('\n', match);
+		if (line_end == std::string::npos)
+			line_end = text.size();
+		results.push_back({ entry, line, resultLineText(text, line_start, line_end) });
+
+		// Only one result per line
+		if (line_end >= text.size())
+			break;
+		pos = line_end;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns true if [entry] is a text entry that should be indexed
+// -----------------------------------------------------------------------------
+bool isTextEntry(ArchiveEntry* entry)
+{
+	return entry->getType()->formatId() == "text";
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// TextSearchIndex Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns the number of entries that have been indexed
+// -----------------------------------------------------------------------------
+unsigned TextSearchIndex::numIndexed()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entry_docs_.size() - num_pending_;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of entries waiting to be indexed
+// -----------------------------------------------------------------------------
+unsigned TextSearchIndex::numPending()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return num_pending_;
+}
+
+// -----------------------------------------------------------------------------
+// Starts indexing all open archives (in the background) and listening for any
+// changes to them
+// -----------------------------------------------------------------------------
+void TextSearchIndex::start()
+{
+	if (active_)
+		return;
+
+	active_ = true;
+	listenTo(&App::archiveManager());
+	for (int a = 0; a < App::archiveManager().numArchives(); ++a)
+	{
+		auto archive = App::archiveManager().getArchive(a);
+		listenTo(archive);
+		addArchive(archive);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Starts a search for [query] across all indexed entries in the background,
+// [on_results] is called (on a worker thread) with results as they are found.
+// Any search already in progress is cancelled.
+//
+// Returns the id of the search, or 0 if [query] is an invalid regex
+// -----------------------------------------------------------------------------
+unsigned TextSearchIndex::search(const string& query, const Options& options, const ResultsFunc& on_results)
+{
+	unsigned id = ++search_id_;
+
+	std::string query_utf8 = query.ToUTF8().data();
+	if (query_utf8.empty())
+		return 0;
+
+	// Check regex is valid
+	int re_flags = wxRE_DEFAULT | wxRE_NOSUB | (options.match_case ? 0 : wxRE_ICASE);
+	if (options.regex && !wxRegEx().Compile(query, re_flags))
+		return 0;
+
+	// Get trigrams that any match must contain
+	auto literal  = options.regex ? requiredLiteral(query_utf8) : query_utf8;
+	auto trigrams = textTrigrams(literal);
+
+	// Get candidate entries (that contain all trigrams, or haven't been
+	// indexed yet) along with their text
+	struct Candidate
+	{
+		std::weak_ptr<ArchiveEntry>        entry;
+		std::shared_ptr<const std::string> text;
+	};
+	auto     candidates = std::make_shared<vector<Candidate>>();
+	unsigned num_docs   = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		num_docs = entry_docs_.size();
+
+		auto has_trigrams = [&](const Document& doc) {
+			for (auto trigram : trigrams)
+				if (!std::binary_search(doc.trigrams.begin(), doc.trigrams.end(), trigram))
+					return false;
+			return true;
+		};
+
+		if (trigrams.empty())
+		{
+			// No trigrams to check (short query), check everything
+			for (auto& doc : documents_)
+				if (doc.live)
+					candidates->push_back({ doc.entry, doc.text });
+		}
+		else
+		{
+			// Check documents in the shortest list of documents containing
+			// one of the trigrams
+			const vector<unsigned>* shortest = nullptr;
+			static const vector<unsigned> none;
+			for (auto trigram : trigrams)
+			{
+				auto posting = postings_.find(trigram);
+				if (posting == postings_.end())
+				{
+					shortest = &none;
+					break;
+				}
+				if (!shortest || posting->second.size() < shortest->size())
+					shortest = &posting->second;
+			}
+
+			for (auto index : *shortest)
+			{
+				auto& doc = documents_[index];
+				if (doc.live && doc.indexed && has_trigrams(doc))
+					candidates->push_back({ doc.entry, doc.text });
+			}
+
+			// Documents still being indexed
+			if (num_pending_ > 0)
+				for (auto& doc : documents_)
+					if (doc.live && !doc.indexed)
+						candidates->push_back({ doc.entry, doc.text });
+		}
+	}
+
+	Log::info(2, S_FMT("Searching %lu of %u text entries for \"%s\"", candidates->size(), num_docs, query));
+
+	// Search candidates on worker threads
+	ThreadPool::global().queue([this, id, candidates, query, query_utf8, options, re_flags, on_results]() {
+		std::mutex            results_mutex;
+		std::atomic<unsigned> num_results{ 0 };
+
+		ThreadPool::global().parallelFor(candidates->size(), [&](size_t index) {
+			if (search_id_ != id || num_results >= options.max_results)
+				return;
+
+			auto& candidate = (*candidates)[index];
+
+			std::unique_ptr<wxRegEx> regex;
+			if (options.regex)
+				regex = std::make_unique<wxRegEx>(query, re_flags);
+
+			vector<Result> results;
+			findMatches(*candidate.text, query_utf8, options.match_case, regex.get(), candidate.entry, results);
+			if (results.empty())
+				return;
+
+			std::lock_guard<std::mutex> lock(results_mutex);
+			if (search_id_ != id || num_results >= options.max_results)
+				return;
+			if (num_results + results.size() > options.max_results)
+				results.resize(options.max_results - num_results);
+			num_results += results.size();
+			on_results(id, results, false);
+		});
+
+		if (search_id_ == id)
+		{
+			vector<Result> none;
+			on_results(id, none, true);
+		}
+	});
+
+	return id;
+}
+
+// -----------------------------------------------------------------------------
+// Called when an announcement is recieved from the archive manager or an open
+// archive
+// -----------------------------------------------------------------------------
+void TextSearchIndex::onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data)
+{
+	event_data.seek(0, SEEK_SET);
+
+	// Archive manager
+	if (announcer == &App::archiveManager())
+	{
+		// Archive opened
+		if (event_name == "archive_added")
+		{
+			auto archive = App::archiveManager().getArchive(App::archiveManager().numArchives() - 1);
+			if (archive)
+			{
+				listenTo(archive);
+				addArchive(archive);
+			}
+		}
+
+		// Archive closing
+		else if (event_name == "archive_closing")
+		{
+			int32_t index = -1;
+			event_data.read(&index, 4);
+			if (auto archive = App::archiveManager().getArchive(index))
+				removeArchive(archive);
+		}
+
+		return;
+	}
+
+	// Entry added or modified
+	if (event_name == "entry_added" || event_name == "entry_state_changed")
+	{
+		wxUIntPtr ptr;
+		event_data.read(&ptr, sizeof(wxUIntPtr), 4);
+		addEntries({ (ArchiveEntry*)wxUIntToPtr(ptr) });
+	}
+
+	// Entry removed
+	else if (event_name == "entry_removing")
+	{
+		wxUIntPtr ptr;
+		event_data.read(&ptr, sizeof(wxUIntPtr), sizeof(int));
+		removeEntry((ArchiveEntry*)wxUIntToPtr(ptr));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns the global text search index
+// -----------------------------------------------------------------------------
+TextSearchIndex& TextSearchIndex::global()
+{
+	static TextSearchIndex index;
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// Adds all text entries in [archive] to the index
+// -----------------------------------------------------------------------------
+void TextSearchIndex::addArchive(Archive* archive)
+{
+	vector<ArchiveEntry*> entries;
+	archive->getEntryTreeAsList(entries);
+	addEntries(entries);
+}
+
+// -----------------------------------------------------------------------------
+// Removes all entries in [archive] from the index
+// -----------------------------------------------------------------------------
+void TextSearchIndex::removeArchive(Archive* archive)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for (unsigned a = 0; a < documents_.size(); ++a)
+		if (documents_[a].live && documents_[a].archive == archive)
+			removeDocument(a);
+
+	compact();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [entries] to the index (or updates them if their text has changed).
+// The entries' text is copied here, the trigrams are built on worker threads
+// -----------------------------------------------------------------------------
+void TextSearchIndex::addEntries(const vector<ArchiveEntry*>& entries)
+{
+	vector<std::pair<unsigned, std::shared_ptr<const std::string>>> to_index;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		for (auto entry : entries)
+		{
+			auto existing = entry_docs_.find(entry);
+
+			// Remove if no longer a text entry
+			if (!isTextEntry(entry))
+			{
+				if (existing != entry_docs_.end())
+					removeDocument(existing->second);
+				continue;
+			}
+
+			// Entry data can only be loaded on the main thread, so copy the
+			// text for indexing and searching
+			auto& data = entry->getMCData();
+			if (existing != entry_docs_.end())
+			{
+				// Ignore if the text hasn't changed
+				auto& text = *documents_[existing->second].text;
+				if (text.size() == data.getSize() && memcmp(text.data(), data.getData(), text.size()) == 0)
+					continue;
+
+				removeDocument(existing->second);
+			}
+
+			Document doc;
+			doc.entry_ptr = entry;
+			doc.entry     = entry->getShared();
+			doc.archive   = entry->getParent();
+			doc.text      = std::make_shared<const std::string>((const char*)data.getData(), data.getSize());
+
+			entry_docs_[entry] = documents_.size();
+			to_index.emplace_back(documents_.size(), doc.text);
+			documents_.push_back(std::move(doc));
+			++num_pending_;
+		}
+
+		compact();
+	}
+
+	if (to_index.empty())
+		return;
+
+	// Build trigrams in the background
+	ThreadPool::global().queue([this, to_index]() {
+		vector<vector<uint32_t>> trigrams(to_index.size());
+		ThreadPool::global().parallelFor(
+			to_index.size(), [&](size_t index) { trigrams[index] = textTrigrams(*to_index[index].second); });
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (unsigned a = 0; a < to_index.size(); ++a)
+		{
+			auto  doc_index = to_index[a].first;
+			auto& doc       = documents_[doc_index];
+
+			// Ignore if removed while indexing
+			if (!doc.live)
+				continue;
+
+			doc.trigrams.swap(trigrams[a]);
+			doc.indexed = true;
+			--num_pending_;
+			for (auto trigram : doc.trigrams)
+				postings_[trigram].push_back(doc_index);
+		}
+	});
+}
+
+// -----------------------------------------------------------------------------
+// Removes [entry] from the index
+// -----------------------------------------------------------------------------
+void TextSearchIndex::removeEntry(ArchiveEntry* entry)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto existing = entry_docs_.find(entry);
+	if (existing != entry_docs_.end())
+		removeDocument(existing->second);
+
+	compact();
+}
+
+// -----------------------------------------------------------------------------
+// Removes the document at [index] (mutex_ must be locked).
+// Documents are never actually removed from the list, since their indices may
+// be in use by indexing jobs, they are just marked as dead and cleared
+// -----------------------------------------------------------------------------
+void TextSearchIndex::removeDocument(unsigned index)
+{
+	auto& doc = documents_[index];
+	if (!doc.live)
+		return;
+
+	if (doc.indexed)
+		++num_dead_;
+	else
+		--num_pending_;
+
+	entry_docs_.erase(doc.entry_ptr);
+	doc.live = false;
+	doc.text.reset();
+	doc.entry.reset();
+	vector<uint32_t>().swap(doc.trigrams);
+}
+
+// -----------------------------------------------------------------------------
+// Removes dead documents from the trigram lists if there are enough of them
+// (mutex_ must be locked)
+// -----------------------------------------------------------------------------
+void TextSearchIndex::compact()
+{
+	if (num_dead_ < 256 || num_dead_ < entry_docs_.size())
+		return;
+
+	for (auto i = postings_.begin(); i != postings_.end();)
+	{
+		auto& list = i->second;
+		list.erase(
+			std::remove_if(list.begin(), list.end(), [this](unsigned index) { return !documents_[index].live; }),
+			list.end());
+
+		if (list.empty())
+			i = postings_.erase(i);
+		else
+			++i;
+	}
+
+	num_dead_ = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+#include "General/Console/Console.h"
+#include "Archive/ArchiveEntry.h"
+#include <future>
+
+CONSOLE_COMMAND(search_text, 1, true)
+{
+	TextSearchIndex::Options opt;
+	string                   query = args[0];
+	for (unsigned a = 1; a < args.size(); ++a)
+	{
+		if (S_CMPNOCASE(args[a], "-case"))
+			opt.match_case = true;
+		else if (S_CMPNOCASE(args[a], "-regex"))
+			opt.regex = true;
+	}
+
+	auto& index = TextSearchIndex::global();
+	index.start();
+
+	// Collect results and wait for the search to finish
+	vector<TextSearchIndex::Result> results;
+	std::promise<void>              finished;
+	auto                            start = App::runTimer();
+	if (!index.search(query, opt, [&](unsigned, vector<TextSearchIndex::Result>& found, bool done) {
+			results.insert(results.end(), found.begin(), found.end());
+			if (done)
+				finished.set_value();
+		}))
+	{
+		Log::console(S_FMT("Invalid search \"%s\"", query));
+		return;
+	}
+	finished.get_future().wait();
+
+	for (auto& result : results)
+		if (auto entry = result.entry.lock())
+			Log::console(S_FMT("%s:%u: %s", entry->getPath(true), result.line, result.text));
+
+	Log::console(S_FMT("%lu results in %ldms", results.size(), App::runTimer() - start));
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "General/ListenerAnnouncer.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+class Archive;
+class ArchiveEntry;
+
+// Trigram index of the content of all text entries in open archives, used to
+// quickly search for text across all archives. Entries are indexed on worker
+// threads and re-indexed as they are added, removed or modified.
+//
+// The index isn't built until start() is called (eg. when the search dialog
+// is first opened), after which it is kept up to date
+class TextSearchIndex : public Listener
+{
+public:
+	struct Options
+	{
+		bool     match_case  = false;
+		bool     regex       = false;
+		unsigned max_results = 5000;
+	};
+
+	struct Result
+	{
+		std::weak_ptr<ArchiveEntry> entry;
+		unsigned                    line = 0; // First line is 1
+		string                      text;     // Text of the matching line
+	};
+
+	// Called on a worker thread with each batch of results for search [id] as
+	// they are found, and a final time with [finished] true once the search is
+	// complete
+	typedef std::function<void(unsigned id, vector<Result>& results, bool finished)> ResultsFunc;
+
+	TextSearchIndex() = default;
+	~TextSearchIndex() = default;
+
+	bool     isActive() const { return active_; }
+	unsigned numIndexed();
+	unsigned numPending();
+
+	void     start();
+	unsigned search(const string& query, const Options& options, const ResultsFunc& on_results);
+	void     cancelSearch() { ++search_id_; }
+
+	void onAnnouncement(Announcer* announcer, string event_name, MemChunk& event_data) override;
+
+	static TextSearchIndex& global();
+
+private:
+	struct Document
+	{
+		ArchiveEntry*                      entry_ptr = nullptr;
+		std::weak_ptr<ArchiveEntry>        entry;
+		Archive*                           archive = nullptr;
+		std::shared_ptr<const std::string> text;
+		vector<uint32_t>                   trigrams; // Sorted
+		bool                               indexed = false;
+		bool                               live    = true;
+	};
+
+	bool                                          active_ = false;
+	std::mutex                                    mutex_;
+	vector<Document>                              documents_;
+	std::unordered_map<ArchiveEntry*, unsigned>   entry_docs_;
+	std::unordered_map<uint32_t, vector<unsigned>> postings_;
+	unsigned                                      num_dead_    = 0;
+	unsigned                                      num_pending_ = 0;
+	std::atomic<unsigned>                         search_id_{ 0 };
+
+	void addArchive(Archive* archive);
+	void removeArchive(Archive* archive);
+	void addEntries(const vector<ArchiveEntry*>& entries);
+	void removeEntry(ArchiveEntry* entry);
+	void removeDocument(unsigned index);
+	void compact();
+};
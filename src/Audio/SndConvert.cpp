@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    SndConvert.cpp
+// Description: Batch sound format conversion, split into a main thread setup
+//              step and a conversion step that can be run on worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "SndConvert.h"
+#include "Archive/ArchiveEntry.h"
+#include "MainEditor/Conversions.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// SndConvert Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Returns true if [entry] can be converted to [target]
+// -----------------------------------------------------------------------------
+bool SndConvert::canConvert(ArchiveEntry* entry, Target target)
+{
+	if (!entry)
+		return false;
+
+	string format = entry->getType()->formatId();
+	if (target == Target::DoomSound)
+		return format == "snd_wav";
+
+	return format == "snd_doom" || format == "snd_doom_mac" || format == "snd_speaker" || format == "snd_jaguar"
+		   || format == "snd_wolf" || format == "snd_voc" || format == "snd_bloodsfx";
+}
+
+// -----------------------------------------------------------------------------
+// Sets up [job] to convert [entry]. The entry data is copied to the job so it
+// can be converted on another thread, other than Blood SFX which needs the
+// entry's archive (for its raw data), so is converted here instead
+// -----------------------------------------------------------------------------
+bool SndConvert::prepare(Job& job, ArchiveEntry* entry, Target target)
+{
+	if (!canConvert(entry, target))
+	{
+		job.error = "Not a convertible sound format";
+		return false;
+	}
+
+	job.format = entry->getType()->formatId();
+	if (job.format == "snd_bloodsfx")
+	{
+		sf::Clock clock;
+		job.ok   = Conversions::bloodToWav(entry, job.out);
+		job.time = clock.getElapsedTime().asMilliseconds();
+		if (!job.ok)
+			job.error = Global::error;
+
+		return job.ok;
+	}
+
+	job.data.importMem(entry->getData(), entry->getSize());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Converts the sound in [job] to [target], writing it to the job's output data
+// -----------------------------------------------------------------------------
+bool SndConvert::convert(Job& job, Target target)
+{
+	// Already converted in prepare()
+	if (job.ok)
+		return true;
+
+	sf::Clock clock;
+	bool      ok = false;
+	if (target == Target::DoomSound)
+		ok = Conversions::wavToDoomSnd(job.data, job.out, false);
+	else if (job.format == "snd_doom" || job.format == "snd_doom_mac")
+		ok = Conversions::doomSndToWav(job.data, job.out);
+	else if (job.format == "snd_speaker")
+		ok = Conversions::spkSndToWav(job.data, job.out);
+	else if (job.format == "snd_jaguar")
+		ok = Conversions::jagSndToWav(job.data, job.out);
+	else if (job.format == "snd_wolf")
+		ok = Conversions::wolfSndToWav(job.data, job.out);
+	else if (job.format == "snd_voc")
+		ok = Conversions::vocToWav(job.data, job.out);
+	job.data.clear();
+
+	if (!ok)
+	{
+		job.error = Global::error;
+		return false;
+	}
+
+	job.ok   = true;
+	job.time = clock.getElapsedTime().asMilliseconds();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the name of [target]
+// -----------------------------------------------------------------------------
+string SndConvert::targetName(Target target)
+{
+	return target == Target::DoomSound ? "Doom Sound" : "Wav";
+}
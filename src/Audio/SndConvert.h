@@ -0,0 +1,41 @@
+#pragma once
+
+class ArchiveEntry;
+
+// Batch sound format conversion.
+//
+// Each sound to convert is set up as a Job on the main thread with prepare()
+// (which copies the entry data), after which convert() can be run on any
+// thread to convert it. Committing the result back to the entry is left to the
+// caller, on the main thread
+namespace SndConvert
+{
+enum class Target
+{
+	Wav,      // Any supported sound format to wav
+	DoomSound // Wav to doom sound format
+};
+
+struct Job
+{
+	MemChunk data;   // Source sound data
+	string   format; // Source format id
+	MemChunk out;    // Converted sound data
+	bool     ok = false;
+	string   error;
+	long     time = 0; // Time taken to convert in ms
+};
+
+// Returns true if [entry] can be converted to [target]
+bool canConvert(ArchiveEntry* entry, Target target);
+
+// Sets up [job] to convert [entry] to [target]. Must be called on the main
+// thread. Returns false if [entry] can't be converted
+bool prepare(Job& job, ArchiveEntry* entry, Target target);
+
+// Converts the sound in [job] to [target]. Can be called from a worker thread
+bool convert(Job& job, Target target);
+
+// Returns the name of [target]
+string targetName(Target target);
+} // namespace SndConvert
@@ -69,6 +69,7 @@ CVAR(Bool, gfx_extraconv, false, CVAR_SAVE)
 GfxConvDialog::GfxConvDialog(wxWindow* parent) : SDialog(parent, "Graphic Format Conversion", "gfxconv")
 {
 	current_item = 0;
+	batch_start  = -1;
 
 	// Set dialog icon
 	wxIcon icon;
@@ -532,6 +533,18 @@ void GfxConvDialog::getConvertOptions(SIFormat::ConvertOptions& opt)
 	opt.col_format = current_format.coltype;
 }
 
+// -----------------------------------------------------------------------------
+// Writes the conversion options selected for a batch conversion to [opt], with
+// the palettes to use for [entry]. The palettes are only valid until this is
+// next called
+// -----------------------------------------------------------------------------
+void GfxConvDialog::getBatchConvertOptions(ArchiveEntry* entry, SIFormat::ConvertOptions& opt)
+{
+	opt             = batch_options;
+	opt.pal_current = pal_chooser_current->getSelectedPalette(entry);
+	opt.pal_target  = pal_chooser_target->getSelectedPalette(entry);
+}
+
 // -----------------------------------------------------------------------------
 // Returns true if the item at [index] has been modified, false otherwise
 // -----------------------------------------------------------------------------
@@ -632,6 +645,18 @@ void GfxConvDialog::onBtnConvert(wxCommandEvent& e)
 // -----------------------------------------------------------------------------
 void GfxConvDialog::onBtnConvertAll(wxCommandEvent& e)
 {
+	// Entries after the current one are converted by the caller as a batch,
+	// with the current format and options
+	if (items[current_item].entry && current_item + 1 < items.size())
+	{
+		applyConversion();
+		getConvertOptions(batch_options);
+		batch_format = current_format;
+		batch_start  = current_item + 1;
+		this->Close(true);
+		return;
+	}
+
 	// Show splash window
 	UI::showSplash("Converting Gfx...", true);
 
@@ -92,6 +92,12 @@ public:
 
 	void applyConversion();
 
+	// 'Convert All' on entries is left to the caller to do as a batch
+	bool      batchConvert() const { return batch_start >= 0; }
+	int       batchStart() const { return batch_start; }
+	SIFormat* batchFormat() const { return batch_format.format; }
+	void      getBatchConvertOptions(ArchiveEntry* entry, SIFormat::ConvertOptions& opt);
+
 private:
 	struct ConvFormat
 	{
@@ -105,10 +111,13 @@ private:
 		}
 	};
 
-	vector<gcd_item_t> items;
-	size_t             current_item;
-	vector<ConvFormat> conv_formats;
-	ConvFormat         current_format;
+	vector<gcd_item_t>       items;
+	size_t                   current_item;
+	vector<ConvFormat>       conv_formats;
+	ConvFormat               current_format;
+	int                      batch_start; // First item to convert in a batch, -1 if none
+	ConvFormat               batch_format;
+	SIFormat::ConvertOptions batch_options;
 
 	wxStaticText*   label_current_format;
 	GfxCanvas*      gfx_current;
@@ -0,0 +1,275 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    TextSearchDialog.cpp
+// Description: Dialog for searching the content of text entries in all open
+//              archives. Results are shown as they are found by the
+//              (background) TextSearchIndex
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "TextSearchDialog.h"
+#include "App.h"
+#include "Archive/Archive.h"
+#include "General/UI.h"
+#include "MainEditor/MainEditor.h"
+#include "MainEditor/UI/ArchiveManagerPanel.h"
+#include "MainEditor/UI/ArchivePanel.h"
+#include "MainEditor/UI/EntryPanel/TextEntryPanel.h"
+#include "MainEditor/UI/MainWindow.h"
+#include "UI/WxUtils.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+TextSearchDialog* dialog_instance = nullptr;
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// TextSearchDialog Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// TextSearchDialog class constructor
+// -----------------------------------------------------------------------------
+TextSearchDialog::TextSearchDialog(wxWindow* parent) :
+	SDialog(parent, "Search Text in Archives", "text_search", 800, 500),
+	state_{ std::make_shared<SearchState>() }
+{
+	auto sizer = new wxBoxSizer(wxVERTICAL);
+	SetSizer(sizer);
+
+	// Query
+	auto hbox   = new wxBoxSizer(wxHORIZONTAL);
+	text_query_ = new wxTextCtrl(this, -1, "", wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	btn_search_ = new wxButton(this, -1, "Search");
+	hbox->Add(new wxStaticText(this, -1, "Find:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, UI::pad());
+	hbox->Add(text_query_, 1, wxEXPAND | wxRIGHT, UI::pad());
+	hbox->Add(btn_search_, 0, wxEXPAND);
+	sizer->Add(hbox, 0, wxEXPAND | wxLEFT | wxRIGHT | wxTOP, UI::padLarge());
+
+	// Options
+	cb_match_case_ = new wxCheckBox(this, -1, "Match Case");
+	cb_regex_      = new wxCheckBox(this, -1, "Regular Expression");
+	WxUtils::layoutHorizontally(
+		sizer, { cb_match_case_, cb_regex_ }, wxSizerFlags(0).Expand().Border(wxLEFT | wxRIGHT | wxTOP, UI::padLarge()));
+
+	// Results
+	list_results_ = new wxDataViewListCtrl(this, -1);
+	list_results_->AppendTextColumn("Entry", wxDATAVIEW_CELL_INERT, UI::scalePx(250));
+	list_results_->AppendTextColumn("Line", wxDATAVIEW_CELL_INERT, UI::scalePx(50));
+	list_results_->AppendTextColumn("Text", wxDATAVIEW_CELL_INERT, -2);
+	list_results_->SetMinSize(wxSize(0, UI::scalePx(200)));
+	sizer->Add(list_results_, 1, wxEXPAND | wxALL, UI::padLarge());
+
+	// Status
+	label_status_ = new wxStaticText(this, -1, "");
+	sizer->Add(label_status_, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, UI::padLarge());
+
+	// Bind events
+	btn_search_->Bind(wxEVT_BUTTON, &TextSearchDialog::onSearch, this);
+	text_query_->Bind(wxEVT_TEXT_ENTER, &TextSearchDialog::onSearch, this);
+	list_results_->Bind(wxEVT_DATAVIEW_ITEM_ACTIVATED, &TextSearchDialog::onResultActivated, this);
+	Bind(wxEVT_CLOSE_WINDOW, &TextSearchDialog::onClose, this);
+
+	Layout();
+	CenterOnParent();
+}
+
+// -----------------------------------------------------------------------------
+// TextSearchDialog class destructor
+// -----------------------------------------------------------------------------
+TextSearchDialog::~TextSearchDialog()
+{
+	// Stop any running search from sending more results
+	TextSearchIndex::global().cancelSearch();
+	std::lock_guard<std::mutex> lock(state_->mutex);
+	state_->open = false;
+
+	if (dialog_instance == this)
+		dialog_instance = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Starts searching for the current query
+// -----------------------------------------------------------------------------
+void TextSearchDialog::search()
+{
+	results_.clear();
+	list_results_->DeleteAllItems();
+
+	if (text_query_->GetValue().IsEmpty())
+	{
+		label_status_->SetLabel("");
+		return;
+	}
+
+	TextSearchIndex::Options opt;
+	opt.match_case = cb_match_case_->GetValue();
+	opt.regex      = cb_regex_->GetValue();
+
+	// Send results to the dialog (on the main thread) as they are found
+	auto& index = TextSearchIndex::global();
+	auto  send  = [this, state = state_](unsigned id, vector<TextSearchIndex::Result>& results, bool finished) {
+		std::lock_guard<std::mutex> lock(state->mutex);
+		if (state->open)
+			CallAfter([this, id, results, finished]() { addResults(id, results, finished); });
+	};
+	search_id_ = index.search(text_query_->GetValue(), opt, send);
+
+	if (search_id_ == 0)
+	{
+		label_status_->SetLabel("Invalid regular expression");
+		return;
+	}
+
+	search_start_ = App::runTimer();
+	auto pending  = index.numPending();
+	if (pending > 0)
+		label_status_->SetLabel(S_FMT("Searching... (%u entries still being indexed)", pending));
+	else
+		label_status_->SetLabel("Searching...");
+}
+
+// -----------------------------------------------------------------------------
+// Opens the entry for the result at [index] and goes to the matching line
+// -----------------------------------------------------------------------------
+void TextSearchDialog::openResult(int index)
+{
+	if (index < 0 || index >= (int)results_.size())
+		return;
+
+	// Check the entry still exists
+	auto entry = results_[index].entry.lock();
+	if (!entry || !entry->getParent())
+		return;
+
+	// Open its archive tab and the entry
+	auto panel = MainEditor::window()->getArchiveManagerPanel();
+	panel->openTab(entry->getParent());
+	auto tab = panel->getArchiveTab(entry->getParent());
+	if (!tab)
+		return;
+	tab->focusOnEntry(entry.get());
+	tab->openEntry(entry.get(), true);
+
+	// Go to the line
+	if (auto text_panel = dynamic_cast<TextEntryPanel*>(tab->currentArea()))
+		text_panel->goToLine(results_[index].line);
+}
+
+// -----------------------------------------------------------------------------
+// Shows the text search dialog (creating it if needed)
+// -----------------------------------------------------------------------------
+void TextSearchDialog::open(wxWindow* parent)
+{
+	// Start indexing open archives if it hasn't been already
+	TextSearchIndex::global().start();
+
+	if (!dialog_instance)
+		dialog_instance = new TextSearchDialog(parent);
+
+	dialog_instance->Show();
+	dialog_instance->Raise();
+	dialog_instance->text_query_->SetFocus();
+	dialog_instance->text_query_->SelectAll();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [results] from the search with [search_id] to the list, if it is still
+// the current search
+// -----------------------------------------------------------------------------
+void TextSearchDialog::addResults(unsigned search_id, const vector<TextSearchIndex::Result>& results, bool finished)
+{
+	if (search_id != search_id_)
+		return;
+
+	wxVector<wxVariant> row;
+	for (auto& result : results)
+	{
+		// Ignore if the entry was deleted since the result was found
+		auto entry = result.entry.lock();
+		if (!entry || !entry->getParent())
+			continue;
+
+		row.push_back(wxVariant(entry->getParent()->filename(false) + ": " + entry->getPath(true)));
+		row.push_back(wxVariant(S_FMT("%u", result.line)));
+		row.push_back(wxVariant(result.text));
+		list_results_->AppendItem(row);
+		row.clear();
+
+		results_.push_back(result);
+	}
+
+	if (finished)
+		label_status_->SetLabel(
+			S_FMT("%lu results (%ldms)", (unsigned long)results_.size(), App::runTimer() - search_start_));
+}
+
+
+// -----------------------------------------------------------------------------
+//
+// TextSearchDialog Class Events
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Called when the search button is clicked or enter is pressed in the query
+// text box
+// -----------------------------------------------------------------------------
+void TextSearchDialog::onSearch(wxCommandEvent& e)
+{
+	search();
+}
+
+// -----------------------------------------------------------------------------
+// Called when a result is double-clicked or enter is pressed on it
+// -----------------------------------------------------------------------------
+void TextSearchDialog::onResultActivated(wxDataViewEvent& e)
+{
+	openResult(list_results_->ItemToRow(e.GetItem()));
+}
+
+// -----------------------------------------------------------------------------
+// Called when the dialog is closed
+// -----------------------------------------------------------------------------
+void TextSearchDialog::onClose(wxCloseEvent& e)
+{
+	// Just hide the dialog so it keeps the last search when reopened
+	TextSearchIndex::global().cancelSearch();
+	Hide();
+}
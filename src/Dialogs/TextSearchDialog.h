@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Archive/TextSearchIndex.h"
+#include "UI/SDialog.h"
+
+class wxDataViewListCtrl;
+class wxDataViewEvent;
+class TextSearchDialog : public SDialog
+{
+public:
+	TextSearchDialog(wxWindow* parent);
+	~TextSearchDialog();
+
+	void search();
+	void openResult(int index);
+
+	static void open(wxWindow* parent);
+
+private:
+	// Shared with search result callbacks, which may outlive the dialog
+	struct SearchState
+	{
+		std::mutex mutex;
+		bool       open = true;
+	};
+
+	wxTextCtrl*                     text_query_    = nullptr;
+	wxButton*                       btn_search_    = nullptr;
+	wxCheckBox*                     cb_match_case_ = nullptr;
+	wxCheckBox*                     cb_regex_      = nullptr;
+	wxDataViewListCtrl*             list_results_  = nullptr;
+	wxStaticText*                   label_status_  = nullptr;
+	vector<TextSearchIndex::Result> results_;
+	std::shared_ptr<SearchState>    state_;
+	unsigned                        search_id_    = 0;
+	long                            search_start_ = 0;
+
+	void addResults(unsigned search_id, const vector<TextSearchIndex::Result>& results, bool finished);
+
+	// Events
+	void onSearch(wxCommandEvent& e);
+	void onResultActivated(wxDataViewEvent& e);
+	void onClose(wxCloseEvent& e);
+};
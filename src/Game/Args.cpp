@@ -32,6 +32,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "Args.h"
+#include "DefinitionsCache.h"
 #include "Utility/Parser.h"
 
 using namespace Game;
@@ -256,6 +257,55 @@ void Arg::parse(ParseTreeNode* node, SpecialMap* shared_args)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Writes the arg definition to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void Arg::writeCache(CacheWriter& writer) const
+{
+	writer.write(name);
+	writer.write(desc);
+	writer.write<int32_t>(type);
+
+	for (auto customs : { &custom_values, &custom_flags })
+	{
+		writer.write<uint32_t>(customs->size());
+		for (auto& custom : *customs)
+		{
+			writer.write(custom.name);
+			writer.write<int32_t>(custom.value);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads the arg definition from the definitions cache [reader]
+// -----------------------------------------------------------------------------
+bool Arg::readCache(CacheReader& reader)
+{
+	int32_t atype = Number;
+	reader.read(name);
+	reader.read(desc);
+	reader.read(atype);
+	type = atype;
+
+	for (auto customs : { &custom_values, &custom_flags })
+	{
+		uint32_t count = 0;
+		reader.read(count);
+		customs->clear();
+		for (uint32_t a = 0; a < count && reader.ok(); ++a)
+		{
+			int32_t value = 0;
+			customs->push_back({});
+			reader.read(customs->back().name);
+			reader.read(value);
+			customs->back().value = value;
+		}
+	}
+
+	return reader.ok();
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -293,3 +343,27 @@ string ArgSpec::stringDesc(int values[5], string values_str[2]) const
 
 	return ret;
 }
+
+// -----------------------------------------------------------------------------
+// Writes all args to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void ArgSpec::writeCache(CacheWriter& writer) const
+{
+	writer.write<int32_t>(count);
+	for (auto& arg : args)
+		arg.writeCache(writer);
+}
+
+// -----------------------------------------------------------------------------
+// Reads all args from the definitions cache [reader]
+// -----------------------------------------------------------------------------
+bool ArgSpec::readCache(CacheReader& reader)
+{
+	int32_t num = 0;
+	reader.read(num);
+	count = num;
+	for (auto& arg : args)
+		arg.readCache(reader);
+
+	return reader.ok();
+}
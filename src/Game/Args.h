@@ -4,6 +4,9 @@ class ParseTreeNode;
 
 namespace Game
 {
+class CacheReader;
+class CacheWriter;
+
 struct ArgValue
 {
 	string name;
@@ -37,6 +40,9 @@ struct Arg
 	string valueString(int value) const;
 	string speedLabel(int value) const;
 	void   parse(ParseTreeNode* node, SpecialMap* shared_args);
+
+	void writeCache(CacheWriter& writer) const;
+	bool readCache(CacheReader& reader);
 };
 
 struct ArgSpec
@@ -50,5 +56,8 @@ struct ArgSpec
 	const Arg& operator[](int index) const { return args[index]; }
 
 	string stringDesc(int values[5], string values_str[2]) const;
+
+	void writeCache(CacheWriter& writer) const;
+	bool readCache(CacheReader& reader);
 };
 } // namespace Game
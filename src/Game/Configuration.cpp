@@ -37,8 +37,10 @@
 #include "Archive/Archive.h"
 #include "Archive/ArchiveManager.h"
 #include "Decorate.h"
+#include "DefinitionsCache.h"
 #include "GenLineSpecial.h"
 #include "General/Console/Console.h"
+#include "General/Misc.h"
 #include "MapEditor/SLADEMap/SLADEMap.h"
 #include "Utility/Parser.h"
 #include "Utility/StringUtils.h"
@@ -941,6 +943,11 @@ bool Configuration::openConfig(string game, string port, uint8_t format)
 		test.Close();
 	}
 
+	// Keep a CRC of the configuration text (so anything cached from it can be
+	// invalidated if the configuration changes)
+	auto cfg_utf8 = full_config.ToUTF8();
+	config_crc_   = Misc::crc((const uint8_t*)cfg_utf8.data(), cfg_utf8.length());
+
 	// Read fully built configuration
 	bool ok = true;
 	if (readConfiguration(full_config, "full.cfg", format))
@@ -970,6 +977,7 @@ bool Configuration::openConfig(string game, string port, uint8_t format)
 
 		// Read embedded config
 		string config = wxString::FromAscii(cfg_entries[a]->getData(), cfg_entries[a]->getSize());
+		config_crc_   = config_crc_ * 31 + cfg_entries[a]->getMCData().crc();
 		if (!readConfiguration(config, cfg_entries[a]->getName(), format, true, false))
 			LOG_MESSAGE(1, "Error reading embedded game configuration, not loaded");
 	}
@@ -1381,7 +1389,7 @@ bool Configuration::parseDecorateDefs(Archive* archive)
 // -----------------------------------------------------------------------------
 void Configuration::clearDecorateDefs()
 {
-	for (auto def : thing_types_)
+	for (auto& def : thing_types_)
 		if (def.second.decorate() && def.second.defined())
 			def.second.define(-1, "", "");
 }
@@ -1425,6 +1433,87 @@ void Configuration::linkDoomEdNums()
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Writes all custom definitions (DECORATE/ZScript/MAPINFO) to the definitions
+// cache [writer]. Only thing types that were added or modified compared to
+// [types_before] (the thing types before custom definitions were parsed) are
+// written
+// -----------------------------------------------------------------------------
+void Configuration::writeCustomDefsCache(CacheWriter& writer, const std::map<int, ThingType>& types_before) const
+{
+	// Thing types
+	vector<std::pair<int, const ThingType*>> modified;
+	for (auto& i : thing_types_)
+	{
+		auto before = types_before.find(i.first);
+		if (before != types_before.end())
+		{
+			CacheWriter current, previous;
+			i.second.writeCache(current);
+			before->second.writeCache(previous);
+			if (current.data() == previous.data())
+				continue;
+		}
+
+		modified.emplace_back(i.first, &i.second);
+	}
+	writer.write<uint32_t>(modified.size());
+	for (auto& type : modified)
+	{
+		writer.write<int32_t>(type.first);
+		type.second->writeCache(writer);
+	}
+
+	// Parsed types (no DoomEdNum)
+	writer.write<uint32_t>(parsed_types_.size());
+	for (auto& type : parsed_types_)
+		type.writeCache(writer);
+
+	// MapInfo
+	map_info_.writeCache(writer);
+}
+
+// -----------------------------------------------------------------------------
+// Reads custom definitions from the definitions cache [reader] (see
+// writeCustomDefsCache). Nothing is changed if the cached data is invalid
+// -----------------------------------------------------------------------------
+bool Configuration::readCustomDefsCache(CacheReader& reader)
+{
+	// Thing types
+	vector<std::pair<int, ThingType>> modified;
+	uint32_t                          count = 0;
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		int32_t number = 0;
+		reader.read(number);
+		modified.emplace_back(number, ThingType());
+		modified.back().second.readCache(reader);
+	}
+
+	// Parsed types
+	vector<ThingType> parsed;
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		parsed.emplace_back();
+		parsed.back().readCache(reader);
+	}
+
+	// MapInfo
+	MapInfo map_info;
+	if (!map_info.readCache(reader))
+		return false;
+
+	// Apply
+	for (auto& type : modified)
+		thing_types_[type.first] = type.second;
+	parsed_types_ = parsed;
+	map_info_     = map_info;
+
+	return true;
+}
+
 // -----------------------------------------------------------------------------
 // Returns the name of the line flag at [index]
 // -----------------------------------------------------------------------------
@@ -75,6 +75,7 @@ public:
 	void   setDefaults();
 	string currentGame() const { return current_game_; }
 	string currentPort() const { return current_port_; }
+	uint32_t configCrc() const { return config_crc_; }
 	bool   supportsSectorFlags() const { return boom_sector_flag_start_ > 0; }
 	string udmfNamespace();
 	string skyFlat() const { return sky_flat_; }
@@ -91,8 +92,16 @@ public:
 	const std::map<int, string>&        allSectorTypes() const { return sector_types_; }
 
 	// Feature Support
-	bool featureSupported(Feature feature) { return supported_features_[feature]; }
-	bool featureSupported(UDMFFeature feature) { return udmf_features_[feature]; }
+	bool featureSupported(Feature feature) const
+	{
+		auto i = supported_features_.find(feature);
+		return i != supported_features_.end() && i->second;
+	}
+	bool featureSupported(UDMFFeature feature) const
+	{
+		auto i = udmf_features_.find(feature);
+		return i != udmf_features_.end() && i->second;
+	}
 
 	// Configuration reading
 	void readActionSpecials(ParseTreeNode* node, Arg::SpecialMap& shared_args, ActionSpecial* group_defaults = nullptr);
@@ -138,6 +147,10 @@ public:
 	void clearMapInfo() { map_info_.clear(); }
 	void linkDoomEdNums();
 
+	// Custom definitions cache
+	void writeCustomDefsCache(CacheWriter& writer, const std::map<int, ThingType>& types_before) const;
+	bool readCustomDefsCache(CacheReader& reader);
+
 	// Line flags
 	unsigned    nLineFlags() const { return flags_line_.size(); }
 	const Flag& lineFlag(unsigned flag_index);
@@ -195,6 +208,7 @@ public:
 private:
 	string      current_game_;           // Current game name
 	string      current_port_;           // Current port name (empty if none)
+	uint32_t    config_crc_ = 0;         // CRC of the full configuration text read
 	bool        map_formats_[4];         // Supported map formats
 	string      udmf_namespace_;         // Namespace to use for UDMF
 	int         boom_sector_flag_start_; // Beginning of Boom sector flags
@@ -34,6 +34,7 @@
 #include "Archive/Archive.h"
 #include "Configuration.h"
 #include "Game.h"
+#include "ParallelParse.h"
 #include "ThingType.h"
 #include "Utility/StringUtils.h"
 #include "Utility/Tokenizer.h"
@@ -49,7 +50,23 @@ using namespace Game;
 namespace
 {
 EntryType* etype_decorate = nullptr;
-}
+
+// A thing definition (or #include) parsed from a DECORATE entry, added to the
+// thing types list in order once all entries have been parsed
+struct ParsedDef
+{
+	ArchiveEntry* include = nullptr;
+	bool          actor   = false;
+	bool          add     = false; // False if filtered out or no editor number
+	int           ednum   = -1;
+	string        name;
+	string        actor_name;
+	string        parent;
+	string        group;
+	PropertyList  props;
+};
+typedef vector<ParsedDef> ParsedDefs;
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -235,9 +252,10 @@ void parseStates(Tokenizer& tz, PropertyList& props)
 }
 
 // -----------------------------------------------------------------------------
-// Parses a DECORATE 'actor' definition
+// Parses a DECORATE 'actor' definition into [def]. Game filters are checked
+// against [game]
 // -----------------------------------------------------------------------------
-void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+void parseDecorateActor(Tokenizer& tz, const GameDef& game, ParsedDef& def)
 {
 	// Get actor name
 	string name       = tz.next().text;
@@ -298,7 +316,7 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 			else if (tz.checkNC("game"))
 			{
 				filters_present = true;
-				if (gameDef(configuration().currentGame()).supportsFilter(tz.next().text))
+				if (game.supportsFilter(tz.next().text))
 					available = true;
 			}
 
@@ -423,59 +441,71 @@ void parseDecorateActor(Tokenizer& tz, std::map<int, ThingType>& types, vector<T
 
 	// Ignore actors filtered for other games,
 	// and actors with a negative or null type
-	if (available || !filters_present)
-	{
-		string group_path = group.empty() ? "Decorate" : "Decorate/" + group;
+	def.actor      = true;
+	def.add        = available || !filters_present;
+	def.ednum      = ednum;
+	def.name       = name;
+	def.actor_name = actor_name;
+	def.parent     = parent;
+	def.group      = group;
+	def.props      = found_props;
+}
 
-		// Find existing definition or create it
-		ThingType* def = nullptr;
-		if (ednum <= 0)
-		{
-			for (auto& ptype : parsed)
-				if (S_CMPNOCASE(ptype.className(), actor_name))
-				{
-					def = &ptype;
-					break;
-				}
+// -----------------------------------------------------------------------------
+// Adds/updates the thing type for parsed actor definition [pdef]
+// -----------------------------------------------------------------------------
+void addDecorateActor(ParsedDef& pdef, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+{
+	string group_path = pdef.group.empty() ? "Decorate" : "Decorate/" + pdef.group;
 
-			if (!def)
+	// Find existing definition or create it
+	ThingType* def = nullptr;
+	if (pdef.ednum <= 0)
+	{
+		for (auto& ptype : parsed)
+			if (S_CMPNOCASE(ptype.className(), pdef.actor_name))
 			{
-				parsed.push_back(ThingType(name, group_path, actor_name));
-				def = &parsed.back();
+				def = &ptype;
+				break;
 			}
-		}
-		else
-			def = &types[ednum];
 
-		// Add/update definition
-		def->define(ednum, name, group_path);
-
-		// Set group defaults (if any)
-		if (!group.empty())
+		if (!def)
 		{
-			auto& group_defaults = configuration().thingTypeGroupDefaults(group);
-			if (!group_defaults.group().empty())
-				def->copy(group_defaults);
+			parsed.push_back(ThingType(pdef.name, group_path, pdef.actor_name));
+			def = &parsed.back();
 		}
+	}
+	else
+		def = &types[pdef.ednum];
 
-		// Inherit from parent
-		if (!parent.empty())
-			for (auto& ptype : parsed)
-				if (S_CMPNOCASE(ptype.className(), parent))
-				{
-					def->copy(ptype);
-					break;
-				}
+	// Add/update definition
+	def->define(pdef.ednum, pdef.name, group_path);
 
-		// Set parsed properties
-		def->loadProps(found_props);
+	// Set group defaults (if any)
+	if (!pdef.group.empty())
+	{
+		auto& group_defaults = configuration().thingTypeGroupDefaults(pdef.group);
+		if (!group_defaults.group().empty())
+			def->copy(group_defaults);
 	}
+
+	// Inherit from parent
+	if (!pdef.parent.empty())
+		for (auto& ptype : parsed)
+			if (S_CMPNOCASE(ptype.className(), pdef.parent))
+			{
+				def->copy(ptype);
+				break;
+			}
+
+	// Set parsed properties
+	def->loadProps(pdef.props);
 }
 
 // -----------------------------------------------------------------------------
-// Parses an old-style (non-actor) DECORATE definition
+// Parses an old-style (non-actor) DECORATE definition into [def]
 // -----------------------------------------------------------------------------
-void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
+void parseDecorateOld(Tokenizer& tz, ParsedDef& def)
 {
 	string       name, sprite, group;
 	bool         spritefound = false;
@@ -551,11 +581,11 @@ void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
 		if (spritefound && framefound)
 			found_props["sprite"] = sprite + frame + '?';
 
-		// Add type
-		types[type].define(type, name, group.empty() ? "Decorate" : "Decorate/" + group);
-
-		// Set parsed properties
-		types[type].loadProps(found_props);
+		def.add   = true;
+		def.ednum = type;
+		def.name  = name;
+		def.group = group;
+		def.props = found_props;
 
 		LOG_MESSAGE(3, "Parsed %s %s: %d", group.length() ? group : "decoration", name, type);
 	}
@@ -564,15 +594,17 @@ void parseDecorateOld(Tokenizer& tz, std::map<int, ThingType>& types)
 }
 
 // -----------------------------------------------------------------------------
-// Parses all DECORATE thing definitions in [entry] and adds them to [types]
+// Parses all DECORATE thing definitions in [entry] into [defs].
+// Only reads from [entry] so it can be run on a worker thread, the entry's data
+// must already be loaded
 // -----------------------------------------------------------------------------
-void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+void parseDecorateEntry(ArchiveEntry* entry, const GameDef& game, ParsedDefs& defs)
 {
 	// Init tokenizer
 	Tokenizer tz;
 	tz.setSpecialCharacters(":,{}");
 	tz.enableDecorate(true);
-	tz.openMem(entry->getMCData(), entry->getName());
+	tz.openMem(entry->getMCData(false), entry->getName());
 
 	// --- Parse ---
 	while (!tz.atEnd())
@@ -593,23 +625,109 @@ void parseDecorateEntry(ArchiveEntry* entry, std::map<int, ThingType>& types, ve
 					tz.current().line_no));
 			}
 			else
-				parseDecorateEntry(inc_entry, types, parsed);
+			{
+				defs.emplace_back();
+				defs.back().include = inc_entry;
+			}
 
 			tz.adv();
 		}
 
 		// Check for actor definition
 		else if (tz.checkNC("actor"))
-			parseDecorateActor(tz, types, parsed);
+		{
+			defs.emplace_back();
+			parseDecorateActor(tz, game, defs.back());
+		}
 		else
-			parseDecorateOld(tz, types); // Old DECORATE definitions might be found
+		{
+			// Old DECORATE definitions might be found
+			defs.emplace_back();
+			parseDecorateOld(tz, defs.back());
+		}
 
 		tz.advIf("}");
 	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds all thing definitions parsed from [entry] (and any entries it
+// #includes) to [types]/[parsed], in order
+// -----------------------------------------------------------------------------
+void addDecorateDefs(
+	ArchiveEntry*                        entry,
+	std::map<ArchiveEntry*, ParsedDefs>& entry_defs,
+	std::map<int, ThingType>&            types,
+	vector<ThingType>&                   parsed,
+	vector<ArchiveEntry*>&               stack)
+{
+	auto defs = entry_defs.find(entry);
+	if (defs == entry_defs.end())
+		return;
+
+	stack.push_back(entry);
+	for (auto& def : defs->second)
+	{
+		// #include
+		if (def.include)
+		{
+			if (VECTOR_EXISTS(stack, def.include))
+				Log::warning(S_FMT(
+					"Warning parsing DECORATE entry %s: Recursive #include of \"%s\", skipping",
+					CHR(entry->getName()),
+					CHR(def.include->getPath(true))));
+			else
+				addDecorateDefs(def.include, entry_defs, types, parsed, stack);
+		}
+
+		// Ignore filtered/invalid definitions
+		else if (!def.add)
+			continue;
+
+		// Actor
+		else if (def.actor)
+			addDecorateActor(def, types, parsed);
+
+		// Old-style
+		else
+		{
+			types[def.ednum].define(def.ednum, def.name, def.group.empty() ? "Decorate" : "Decorate/" + def.group);
+			types[def.ednum].loadProps(def.props);
+		}
+	}
+	stack.pop_back();
+}
 
-	// Set entry type
-	if (etype_decorate && entry->getType() != etype_decorate)
-		entry->setType(etype_decorate);
+// -----------------------------------------------------------------------------
+// Parses all DECORATE thing definitions in [entries] (in parallel) and adds
+// them to [types]/[parsed]
+// -----------------------------------------------------------------------------
+void readDecorateEntries(const vector<ArchiveEntry*>& entries, std::map<int, ThingType>& types, vector<ThingType>& parsed)
+{
+	// Parse all entries and anything they #include
+	auto&                               game = gameDef(configuration().currentGame());
+	std::map<ArchiveEntry*, ParsedDefs> entry_defs;
+	auto parse_entry  = [&game](ArchiveEntry* entry, ParsedDefs& defs) { parseDecorateEntry(entry, game, defs); };
+	auto get_includes = [](const ParsedDefs& defs) {
+		vector<ArchiveEntry*> includes;
+		for (auto& def : defs)
+			if (def.include)
+				includes.push_back(def.include);
+		return includes;
+	};
+	auto times = parseEntriesParallel(entries, entry_defs, parse_entry, get_includes);
+	Log::debug(2, S_FMT("DECORATE parse: %s", CHR(times.asString())));
+
+	// Set entry types
+	if (etype_decorate)
+		for (auto& i : entry_defs)
+			if (i.first->getType() != etype_decorate)
+				i.first->setType(etype_decorate);
+
+	// Add definitions in order
+	vector<ArchiveEntry*> stack;
+	for (auto entry : entries)
+		addDecorateDefs(entry, entry_defs, types, parsed, stack);
 }
 
 } // namespace
@@ -646,8 +764,7 @@ bool Game::readDecorateDefs(Archive* archive, std::map<int, ThingType>& types, v
 		etype_decorate = nullptr;
 
 	// Parse DECORATE entries
-	for (auto entry : decorate_entries)
-		parseDecorateEntry(entry, types, parsed);
+	readDecorateEntries(decorate_entries, types, parsed);
 
 	return true;
 }
@@ -677,7 +794,7 @@ CONSOLE_COMMAND(test_decorate, 0, false)
 	{
 		auto entry = archive->entryAtPath(args[0]);
 		if (entry)
-			parseDecorateEntry(entry, types, parsed);
+			readDecorateEntries({ entry }, types, parsed);
 		else
 			Log::console("Entry not found");
 	}
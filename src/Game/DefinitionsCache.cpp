@@ -0,0 +1,324 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    DefinitionsCache.cpp
+// Description: Functions for reading and writing the custom definitions cache,
+//              which stores the results of parsing DECORATE/ZScript/MAPINFO
+//              from a set of archives so they don't need to be re-parsed if
+//              nothing has changed
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "DefinitionsCache.h"
+#include "App.h"
+#include "Archive/Archive.h"
+#include "Configuration.h"
+#include "General/Misc.h"
+#include "ZScript.h"
+
+using namespace Game;
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Increment this whenever anything written to the cache changes
+const uint32_t CACHE_VERSION = 1;
+
+// A source entry that cached definitions were read from
+struct Source
+{
+	uint32_t archive = 0; // Index in the list of archives
+	string   path;
+	uint32_t size = 0;
+	uint32_t crc  = 0;
+
+	bool operator==(const Source& rhs) const
+	{
+		return archive == rhs.archive && size == rhs.size && crc == rhs.crc && path == rhs.path;
+	}
+	bool operator!=(const Source& rhs) const { return !(*this == rhs); }
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the cache key for definitions parsed from [archives] with the
+// current game configuration (including a CRC of its content, so the cache is
+// invalidated if the configuration files change)
+// -----------------------------------------------------------------------------
+string cacheKey(const vector<Archive*>& archives)
+{
+	string key = S_FMT(
+		"%s|%s|%08x", configuration().currentGame(), configuration().currentPort(), configuration().configCrc());
+	for (auto archive : archives)
+		key += "|" + archive->filename();
+
+	return key;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the path to the cache file for definitions parsed from [archives]
+// -----------------------------------------------------------------------------
+string cacheFilename(const vector<Archive*>& archives)
+{
+	auto key = cacheKey(archives).ToUTF8();
+	return App::path(S_FMT("defcache/%08x.dat", Misc::crc((const uint8_t*)key.data(), key.length())), App::Dir::User);
+}
+
+// -----------------------------------------------------------------------------
+// Returns all entries in [archive] that custom definitions are parsed from
+// (not including any entries they #include)
+// -----------------------------------------------------------------------------
+vector<ArchiveEntry*> definitionRoots(Archive* archive)
+{
+	Archive::SearchOptions opt;
+	opt.ignore_ext = true;
+
+	// ZScript
+	opt.match_name = "zscript";
+	auto roots     = archive->findAll(opt);
+
+	// DECORATE
+	opt.match_name = "decorate";
+	for (auto entry : archive->findAll(opt))
+		roots.push_back(entry);
+
+	// *MAPINFO
+	vector<ArchiveEntry*> entries;
+	archive->getEntryTreeAsList(entries);
+	for (auto entry : entries)
+	{
+		auto& type = entry->getType()->id();
+		if (type == "zmapinfo" || type == "mapinfo" || type == "emapinfo")
+			roots.push_back(entry);
+	}
+
+	return roots;
+}
+
+// -----------------------------------------------------------------------------
+// Gets source info for [entry] in [source].
+// Returns false if the entry isn't in any of [archives]
+// -----------------------------------------------------------------------------
+bool sourceInfo(const vector<Archive*>& archives, ArchiveEntry* entry, Source& source)
+{
+	auto archive = std::find(archives.begin(), archives.end(), entry->getParent());
+	if (archive == archives.end())
+		return false;
+
+	source.archive = archive - archives.begin();
+	source.path    = entry->getPath(true);
+	source.size    = entry->getSize();
+	source.crc     = entry->getMCData().crc();
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes source info for all [entries] to [writer].
+// Returns false if any of the entries aren't in [archives]
+// -----------------------------------------------------------------------------
+bool writeSources(CacheWriter& writer, const vector<Archive*>& archives, const vector<ArchiveEntry*>& entries)
+{
+	writer.write<uint32_t>(entries.size());
+	for (auto entry : entries)
+	{
+		Source source;
+		if (!sourceInfo(archives, entry, source))
+			return false;
+
+		writer.write<uint32_t>(source.archive);
+		writer.write(source.path);
+		writer.write<uint32_t>(source.size);
+		writer.write<uint32_t>(source.crc);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Reads source info from [reader] into [sources]
+// -----------------------------------------------------------------------------
+bool readSources(CacheReader& reader, vector<Source>& sources)
+{
+	uint32_t count = 0;
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		sources.emplace_back();
+		reader.read(sources.back().archive);
+		reader.read(sources.back().path);
+		reader.read(sources.back().size);
+		reader.read(sources.back().crc);
+	}
+
+	return reader.ok();
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// DefinitionsCache Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Reads cached custom definitions for [archives] into [config] and [zscript].
+// Returns false if there is no valid cache for [archives], or if any of the
+// entries the definitions were parsed from have changed
+// -----------------------------------------------------------------------------
+bool DefinitionsCache::read(const vector<Archive*>& archives, Configuration& config, ZScript::Definitions& zscript)
+{
+	if (archives.empty())
+		return false;
+
+	auto filename = cacheFilename(archives);
+	if (!wxFileExists(filename))
+		return false;
+
+	auto     start = App::runTimer();
+	MemChunk mc;
+	if (!mc.importFile(filename))
+		return false;
+	CacheReader reader(mc.getData(), mc.getSize());
+
+	// Check cache version and key
+	uint32_t version = 0;
+	string   key;
+	reader.read(version);
+	reader.read(key);
+	if (!reader.ok() || version != CACHE_VERSION || key != cacheKey(archives))
+		return false;
+
+	// Check definition entries in the archives are the same as when cached
+	vector<Source> roots;
+	if (!readSources(reader, roots))
+		return false;
+	unsigned index = 0;
+	for (auto archive : archives)
+		for (auto entry : definitionRoots(archive))
+		{
+			Source source;
+			if (index >= roots.size() || !sourceInfo(archives, entry, source) || source != roots[index++])
+			{
+				Log::info(2, "Custom definitions changed, not using cache");
+				return false;
+			}
+		}
+	if (index != roots.size())
+		return false;
+
+	// Check #included entries are unchanged
+	vector<Source> includes;
+	if (!readSources(reader, includes))
+		return false;
+	for (auto& include : includes)
+	{
+		auto   entry = include.archive < archives.size() ? archives[include.archive]->entryAtPath(include.path) : nullptr;
+		Source source;
+		if (!entry || !sourceInfo(archives, entry, source) || source != include)
+		{
+			Log::info(2, "Custom definitions changed, not using cache");
+			return false;
+		}
+	}
+
+	// Read definitions
+	ZScript::Definitions defs;
+	if (!defs.readCache(reader) || !config.readCustomDefsCache(reader))
+	{
+		Log::warning(S_FMT("Invalid custom definitions cache file %s", CHR(filename)));
+		return false;
+	}
+	zscript = defs;
+
+	Log::info(2, S_FMT("Read cached custom definitions (%ldms)", App::runTimer() - start));
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writes custom definitions in [config] and [zscript] parsed from [archives]
+// to the cache. [sources] are all entries the definitions were parsed from,
+// and [types_before] are the thing types in [config] before any custom
+// definitions were parsed
+// -----------------------------------------------------------------------------
+void DefinitionsCache::write(
+	const vector<Archive*>&         archives,
+	const vector<ArchiveEntry*>&    sources,
+	const std::map<int, ThingType>& types_before,
+	const Configuration&            config,
+	const ZScript::Definitions&     zscript)
+{
+	if (archives.empty())
+		return;
+
+	CacheWriter writer;
+	writer.write<uint32_t>(CACHE_VERSION);
+	writer.write(cacheKey(archives));
+
+	// Definition entries
+	vector<ArchiveEntry*> roots;
+	for (auto archive : archives)
+		for (auto entry : definitionRoots(archive))
+			roots.push_back(entry);
+	vector<ArchiveEntry*> includes;
+	for (auto entry : sources)
+		if (!(VECTOR_EXISTS(roots, entry)) && !(VECTOR_EXISTS(includes, entry)))
+			includes.push_back(entry);
+	if (!writeSources(writer, archives, roots) || !writeSources(writer, archives, includes))
+	{
+		Log::info(2, "Custom definitions include entries outside of resource archives, not caching");
+		return;
+	}
+
+	// Definitions
+	zscript.writeCache(writer);
+	config.writeCustomDefsCache(writer, types_before);
+
+	// Write to file
+	auto dir = App::path("defcache", App::Dir::User);
+	if (!wxDirExists(dir))
+		wxMkdir(dir);
+	MemChunk mc(writer.data().data(), writer.data().size());
+	if (!mc.exportFile(cacheFilename(archives)))
+		Log::warning("Unable to write custom definitions cache");
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+class Archive;
+class ArchiveEntry;
+namespace ZScript
+{
+class Definitions;
+}
+
+namespace Game
+{
+class Configuration;
+class ThingType;
+
+// Writes values to a binary definitions cache buffer
+class CacheWriter
+{
+public:
+	const vector<uint8_t>& data() const { return data_; }
+
+	template<typename T> void write(T value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "CacheWriter can only write arithmetic values and strings");
+		auto bytes = reinterpret_cast<const uint8_t*>(&value);
+		data_.insert(data_.end(), bytes, bytes + sizeof(T));
+	}
+
+	void write(const string& value)
+	{
+		auto utf8 = value.ToUTF8();
+		write<uint32_t>(utf8.length());
+		data_.insert(data_.end(), (const uint8_t*)utf8.data(), (const uint8_t*)utf8.data() + utf8.length());
+	}
+
+	void write(const rgba_t& colour)
+	{
+		write<uint8_t>(colour.r);
+		write<uint8_t>(colour.g);
+		write<uint8_t>(colour.b);
+		write<uint8_t>(colour.a);
+		write<int16_t>(colour.index);
+		write<char>(colour.blend);
+	}
+
+private:
+	vector<uint8_t> data_;
+};
+
+// Reads values from a binary definitions cache buffer. Once a read fails
+// (past the end of the data), all further reads fail
+class CacheReader
+{
+public:
+	CacheReader(const uint8_t* data, size_t size) : pos_{ data }, end_{ data + size } {}
+
+	bool ok() const { return ok_; }
+	bool atEnd() const { return pos_ == end_; }
+
+	template<typename T> bool read(T& value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "CacheReader can only read arithmetic values and strings");
+		if (!ok_ || (size_t)(end_ - pos_) < sizeof(T))
+			return ok_ = false;
+
+		memcpy(&value, pos_, sizeof(T));
+		pos_ += sizeof(T);
+		return true;
+	}
+
+	bool read(string& value)
+	{
+		uint32_t length = 0;
+		if (!read(length) || (size_t)(end_ - pos_) < length)
+			return ok_ = false;
+
+		value = wxString::FromUTF8((const char*)pos_, length);
+		pos_ += length;
+		return true;
+	}
+
+	bool read(rgba_t& colour)
+	{
+		read(colour.r);
+		read(colour.g);
+		read(colour.b);
+		read(colour.a);
+		read(colour.index);
+		return read(colour.blend);
+	}
+
+private:
+	const uint8_t* pos_;
+	const uint8_t* end_;
+	bool           ok_ = true;
+};
+
+// Cache of custom (DECORATE/ZScript/MAPINFO) definitions parsed from a set of
+// archives, stored in the user dir. A cache is only used if all the entries
+// the definitions were parsed from are unchanged (same size and CRC)
+namespace DefinitionsCache
+{
+bool read(const vector<Archive*>& archives, Configuration& config, ZScript::Definitions& zscript);
+void write(
+	const vector<Archive*>&         archives,
+	const vector<ArchiveEntry*>&    sources,
+	const std::map<int, ThingType>& types_before,
+	const Configuration&            config,
+	const ZScript::Definitions&     zscript);
+} // namespace DefinitionsCache
+} // namespace Game
@@ -36,6 +36,8 @@
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "Configuration.h"
+#include "DefinitionsCache.h"
+#include "ParallelParse.h"
 #include "TextEditor/TextLanguage.h"
 #include "Utility/Parser.h"
 #include "ZScript.h"
@@ -63,6 +65,7 @@ std::unique_ptr<Listener> listener;
 CVAR(String, game_configuration, "", CVAR_SAVE)
 CVAR(String, port_configuration, "", CVAR_SAVE)
 CVAR(String, zdoom_pk3_path, "", CVAR_SAVE)
+CVAR(Bool, custom_defs_cache, true, CVAR_SAVE)
 
 
 // -----------------------------------------------------------------------------
@@ -265,38 +268,54 @@ void Game::updateCustomDefinitions()
 	config_current.clearMapInfo();
 	zscript_custom.clear();
 
-	// Parse custom definitions in base resource
-	auto base_resource = App::archiveManager().baseResourceArchive();
+	// Get archives to parse custom definitions from (base resource first)
+	vector<Archive*> archives;
+	auto             base_resource = App::archiveManager().baseResourceArchive();
 	if (base_resource)
-	{
-		zscript_custom.parseZScript(base_resource);
-		config_current.parseDecorateDefs(base_resource);
-		config_current.parseMapInfo(base_resource);
-	}
-
-	// Parse custom definitions in all resource archives
-	vector<Archive*> resource_archives;
+		archives.push_back(base_resource);
 	for (auto a = 0; a < App::archiveManager().numArchives(); a++)
 	{
 		auto archive = App::archiveManager().getArchive(a);
 		if (App::archiveManager().archiveIsResource(archive))
-			resource_archives.push_back(archive);
+			archives.push_back(archive);
 	}
 
-	// ZScript first
-	for (auto archive : resource_archives)
-		zscript_custom.parseZScript(archive);
-
-	// Other definitions
-	for (auto archive : resource_archives)
+	// Use cached definitions if nothing has changed since they were parsed
+	if (!custom_defs_cache || !DefinitionsCache::read(archives, config_current, zscript_custom))
 	{
-		config_current.parseDecorateDefs(archive);
-		config_current.parseMapInfo(archive);
-	}
+		auto                types_before = config_current.allThingTypes();
+		ParsedEntryRecorder parsed_entries;
+
+		// Parse custom definitions in base resource
+		if (base_resource)
+		{
+			zscript_custom.parseZScript(base_resource);
+			config_current.parseDecorateDefs(base_resource);
+			config_current.parseMapInfo(base_resource);
+		}
 
-	// Process custom definitions
-	config_current.importZScriptDefs(zscript_custom);
-	config_current.linkDoomEdNums();
+		// Parse custom definitions in all resource archives
+		vector<Archive*> resource_archives(archives.begin() + (base_resource ? 1 : 0), archives.end());
+
+		// ZScript first
+		for (auto archive : resource_archives)
+			zscript_custom.parseZScript(archive);
+
+		// Other definitions
+		for (auto archive : resource_archives)
+		{
+			config_current.parseDecorateDefs(archive);
+			config_current.parseMapInfo(archive);
+		}
+
+		// Process custom definitions
+		config_current.importZScriptDefs(zscript_custom);
+		config_current.linkDoomEdNums();
+
+		// Update cache
+		if (custom_defs_cache)
+			DefinitionsCache::write(archives, parsed_entries.entries(), types_before, config_current, zscript_custom);
+	}
 
 	auto lang = TextLanguage::fromId("zscript");
 	if (lang)
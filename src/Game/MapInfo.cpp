@@ -32,6 +32,8 @@
 #include "Main.h"
 #include "MapInfo.h"
 #include "Archive/Archive.h"
+#include "DefinitionsCache.h"
+#include "ParallelParse.h"
 
 using namespace Game;
 
@@ -108,11 +110,12 @@ bool MapInfo::readMapInfo(Archive* archive)
 	vector<ArchiveEntry*> entries;
 	archive->getEntryTreeAsList(entries);
 
+	vector<ArchiveEntry*> zmapinfo_entries;
 	for (auto entry : entries)
 	{
 		// ZMapInfo
 		if (entry->getType()->id() == "zmapinfo")
-			parseZMapInfo(entry);
+			zmapinfo_entries.push_back(entry);
 
 		// TODO: EMapInfo
 		else if (entry->getType()->id() == "emapinfo")
@@ -125,12 +128,15 @@ bool MapInfo::readMapInfo(Archive* archive)
 			auto format = detectMapInfoType(entry);
 
 			if (format == Format::ZDoomNew)
-				parseZMapInfo(entry);
+				zmapinfo_entries.push_back(entry);
 			else
 				Log::info("MAPINFO not implemented");
 		}
 	}
 
+	// Parse ZMapInfo entries
+	parseZMapInfo(zmapinfo_entries);
+
 	return false;
 }
 
@@ -156,7 +162,7 @@ bool MapInfo::checkEqualsToken(Tokenizer& tz, const string& parsing) const
 // Converts a text colour definition [str] to a colour struct [col].
 // Returns false if the given definition was invalid
 // -----------------------------------------------------------------------------
-bool MapInfo::strToCol(const string& str, rgba_t& col)
+bool MapInfo::strToCol(const string& str, rgba_t& col) const
 {
 	wxColor wxcol;
 	if (!wxcol.Set(str))
@@ -190,10 +196,50 @@ bool MapInfo::strToCol(const string& str, rgba_t& col)
 // Parses ZMAPINFO-format definitions in [entry]
 // -----------------------------------------------------------------------------
 bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
+{
+	return parseZMapInfo(vector<ArchiveEntry*>{ entry });
+}
+
+// -----------------------------------------------------------------------------
+// Parses ZMAPINFO-format definitions in [entries], in order. The entries (and
+// any entries they include) are tokenized and parsed in parallel, then applied
+// in order. Returns false if any entry failed to parse
+// -----------------------------------------------------------------------------
+bool MapInfo::parseZMapInfo(const vector<ArchiveEntry*>& entries)
+{
+	// Parse all entries
+	std::map<ArchiveEntry*, ZMapInfoEntry> parsed;
+	auto parse_entry  = [this](ArchiveEntry* entry, ZMapInfoEntry& result) { parseZMapInfoEntry(entry, result); };
+	auto get_includes = [](const ZMapInfoEntry& result) {
+		vector<ArchiveEntry*> includes;
+		for (auto& block : result.blocks)
+			if (block.include)
+				includes.push_back(block.include);
+		return includes;
+	};
+	auto times = parseEntriesParallel(entries, parsed, parse_entry, get_includes);
+	Log::debug(2, S_FMT("ZMapInfo parse: %s", CHR(times.asString())));
+
+	// Apply parsed definitions
+	bool                  ok = true;
+	vector<ArchiveEntry*> stack;
+	for (auto entry : entries)
+		if (!applyZMapInfo(entry, parsed, stack))
+			ok = false;
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Parses ZMAPINFO-format definitions in [entry] into [parsed].
+// Only reads from [entry] so it can be run on a worker thread, the entry's data
+// must already be loaded
+// -----------------------------------------------------------------------------
+void MapInfo::parseZMapInfoEntry(ArchiveEntry* entry, ZMapInfoEntry& parsed) const
 {
 	Tokenizer tz;
 	tz.setReadLowerCase(true);
-	tz.openMem(entry->getMCData(), entry->getName());
+	tz.openMem(entry->getMCData(false), entry->getName());
 
 	while (!tz.atEnd())
 	{
@@ -211,22 +257,35 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 					CHR(tz.current().text),
 					tz.lineNo()));
 			}
-			else if (!parseZMapInfo(include_entry))
-				return false;
+			else
+			{
+				parsed.blocks.emplace_back();
+				parsed.blocks.back().include = include_entry;
+			}
 		}
 
 		// Map
 		else if (tz.check("map") || tz.check("defaultmap") || tz.check("adddefaultmap"))
 		{
-			if (!parseZMap(tz, tz.current().text))
-				return false;
+			parsed.blocks.emplace_back();
+			if (!parseZMap(tz, tz.current().text, parsed.blocks.back()))
+			{
+				parsed.blocks.pop_back();
+				parsed.ok = false;
+				return;
+			}
 		}
 
 		// DoomEdNums
 		else if (tz.check("doomednums"))
 		{
-			if (!parseDoomEdNums(tz))
-				return false;
+			parsed.blocks.emplace_back();
+			parsed.blocks.back().doomednums = true;
+			if (!parseDoomEdNums(tz, parsed.blocks.back().editor_nums))
+			{
+				parsed.ok = false;
+				return;
+			}
 		}
 
 		// Unknown block (skip it)
@@ -252,6 +311,63 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 
 		tz.adv();
 	}
+}
+
+// -----------------------------------------------------------------------------
+// Applies the definitions parsed from [entry] (and any entries it includes).
+// Returns false if [entry] or an included entry failed to parse, in which case
+// only the definitions before the error are applied
+// -----------------------------------------------------------------------------
+bool MapInfo::applyZMapInfo(
+	ArchiveEntry*                           entry,
+	std::map<ArchiveEntry*, ZMapInfoEntry>& parsed,
+	vector<ArchiveEntry*>&                  stack)
+{
+	auto& parsed_entry = parsed[entry];
+
+	stack.push_back(entry);
+	for (auto& block : parsed_entry.blocks)
+	{
+		// Include
+		if (block.include)
+		{
+			if (VECTOR_EXISTS(stack, block.include))
+			{
+				Log::warning(S_FMT(
+					"Warning - Parsing ZMapInfo \"%s\": Recursive include of \"%s\"",
+					CHR(entry->getName()),
+					CHR(block.include->getName())));
+			}
+			else if (!applyZMapInfo(block.include, parsed, stack))
+			{
+				stack.pop_back();
+				return false;
+			}
+		}
+
+		// Map
+		else if (!block.map_type.empty())
+		{
+			if (!applyZMap(block))
+			{
+				stack.pop_back();
+				return false;
+			}
+		}
+
+		// DoomEdNums
+		else if (block.doomednums)
+		{
+			for (auto& num : block.editor_nums)
+				editor_nums_[num.first] = num.second;
+
+			Log::info(2, "Parsed ZMapInfo DoomEdNums successfully");
+		}
+	}
+	stack.pop_back();
+
+	if (!parsed_entry.ok)
+		return false;
 
 	LOG_MESSAGE(2, "Parsed ZMapInfo entry %s successfully", entry->getName());
 
@@ -260,31 +376,38 @@ bool MapInfo::parseZMapInfo(ArchiveEntry* entry)
 
 // -----------------------------------------------------------------------------
 // Parses a ZMAPINFO map definition of [type] beginning at the current token in
-// tokenizer [tz]
+// tokenizer [tz] into [block]
 // -----------------------------------------------------------------------------
-bool MapInfo::parseZMap(Tokenizer& tz, string type)
+bool MapInfo::parseZMap(Tokenizer& tz, string type, ZMapInfoBlock& block) const
 {
-	// TODO: Handle adddefaultmap
-	Map map = default_map_;
+	block.map_type = type;
+
+	// Adds a setter for map [property] to [value]
+	auto set = [&block](auto property, auto value) {
+		block.map_setters.emplace_back([property, value](Map& map) {
+			map.*property = value;
+			return true;
+		});
+	};
 
 	// Normal map, get lump/name/etc
 	tz.adv();
 	if (type == "map")
 	{
 		// Entry name should be just after map keyword
-		map.entry_name = tz.current().text;
+		set(&Map::entry_name, tz.current().text);
 
 		// Parse map name
 		tz.adv();
 		if (tz.check("lookup"))
 		{
-			map.lookup_name = true;
-			map.name        = tz.next().text;
+			set(&Map::lookup_name, true);
+			set(&Map::name, tz.next().text);
 		}
 		else
 		{
-			map.lookup_name = false;
-			map.name        = tz.current().text;
+			set(&Map::lookup_name, false);
+			set(&Map::name, tz.current().text);
 		}
 
 		tz.adv();
@@ -311,7 +434,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 
 			// Parse number
 			// TODO: Checks
-			tz.next().toInt(map.level_num);
+			set(&Map::level_num, tz.next().asInt());
 		}
 
 		// Sky1
@@ -320,12 +443,12 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky1 = tz.next().text;
+			set(&Map::sky1, tz.next().text);
 
 			// Scroll speed
 			// TODO: Checks
 			if (tz.advIfNext(","))
-				tz.next().toFloat(map.sky1_scroll_speed);
+				set(&Map::sky1_scroll_speed, (float)tz.next().asFloat());
 		}
 
 		// Sky2
@@ -334,12 +457,12 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky2 = tz.next().text;
+			set(&Map::sky2, tz.next().text);
 
 			// Scroll speed
 			// TODO: Checks
 			if (tz.advIfNext(","))
-				tz.next().toFloat(map.sky2_scroll_speed);
+				set(&Map::sky2_scroll_speed, (float)tz.next().asFloat());
 		}
 
 		// Skybox
@@ -348,20 +471,20 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			map.sky1 = tz.next().text;
+			set(&Map::sky1, tz.next().text);
 		}
 
 		// DoubleSky
 		else if (tz.check("doublesky"))
-			map.sky_double = true;
+			set(&Map::sky_double, true);
 
 		// ForceNoSkyStretch
 		else if (tz.check("forcenoskystretch"))
-			map.sky_force_no_stretch = true;
+			set(&Map::sky_force_no_stretch, true);
 
 		// SkyStretch
 		else if (tz.check("skystretch"))
-			map.sky_stretch = true;
+			set(&Map::sky_stretch, true);
 
 		// Fade
 		else if (tz.check("fade"))
@@ -369,8 +492,9 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			if (!strToCol(tz.next().text, map.fade))
-				return false;
+			// Colour is converted when applied (wxColour isn't thread-safe)
+			string colour = tz.next().text;
+			block.map_setters.emplace_back([this, colour](Map& map) { return strToCol(colour, map.fade); });
 		}
 
 		// OutsideFog
@@ -379,20 +503,20 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 			if (!checkEqualsToken(tz, "ZMapInfo"))
 				return false;
 
-			if (!strToCol(tz.next().text, map.fade_outside))
-				return false;
+			string colour = tz.next().text;
+			block.map_setters.emplace_back([this, colour](Map& map) { return strToCol(colour, map.fade_outside); });
 		}
 
 		// EvenLighting
 		else if (tz.check("evenlighting"))
 		{
-			map.lighting_wallshade_h = 0;
-			map.lighting_wallshade_v = 0;
+			set(&Map::lighting_wallshade_h, 0);
+			set(&Map::lighting_wallshade_v, 0);
 		}
 
 		// SmoothLighting
 		else if (tz.check("smoothlighting"))
-			map.lighting_smooth = true;
+			set(&Map::lighting_smooth, true);
 
 		// VertWallShade
 		else if (tz.check("vertwallshade"))
@@ -401,7 +525,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 				return false;
 
 			// TODO: Checks
-			tz.next().toInt(map.lighting_wallshade_v);
+			set(&Map::lighting_wallshade_v, tz.next().asInt());
 		}
 
 		// HorzWallShade
@@ -411,17 +535,32 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 				return false;
 
 			// TODO: Checks
-			tz.next().toInt(map.lighting_wallshade_h);
+			set(&Map::lighting_wallshade_h, tz.next().asInt());
 		}
 
 		// ForceFakeContrast
 		else if (tz.check("forcefakecontrast"))
-			map.force_fake_contrast = true;
+			set(&Map::force_fake_contrast, true);
 
 		tz.adv();
 	}
 
-	if (type == "map")
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Applies the map definition in [block] (starting from the current default
+// map). Returns false if any property was invalid
+// -----------------------------------------------------------------------------
+bool MapInfo::applyZMap(ZMapInfoBlock& block)
+{
+	// TODO: Handle adddefaultmap
+	Map map = default_map_;
+	for (auto& setter : block.map_setters)
+		if (!setter(map))
+			return false;
+
+	if (block.map_type == "map")
 	{
 		LOG_MESSAGE(2, "Parsed ZMapInfo Map %s (%s) successfully", map.entry_name, map.name);
 
@@ -439,7 +578,7 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 		if (!updated)
 			maps_.push_back(map);
 	}
-	else if (type == "defaultmap")
+	else if (block.map_type == "defaultmap")
 		default_map_ = map;
 
 	return true;
@@ -447,8 +586,9 @@ bool MapInfo::parseZMap(Tokenizer& tz, string type)
 
 // -----------------------------------------------------------------------------
 // Parses a ZMAPINFO DoomEdNums block beginning at the current position in [tz]
+// into [editor_nums]
 // -----------------------------------------------------------------------------
-bool MapInfo::parseDoomEdNums(Tokenizer& tz)
+bool MapInfo::parseDoomEdNums(Tokenizer& tz, DoomEdNumMap& editor_nums) const
 {
 	// Opening brace
 	if (!tz.advIfNext("{", 2))
@@ -471,10 +611,10 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 		}
 
 		// Reset editor number values
-		auto number                  = tz.current().asInt();
-		editor_nums_[number].special = "";
+		auto number                 = tz.current().asInt();
+		editor_nums[number].special = "";
 		for (int a = 0; a < 5; a++)
-			editor_nums_[number].args[a] = 0;
+			editor_nums[number].args[a] = 0;
 
 		// =
 		if (!tz.advIfNext("="))
@@ -487,7 +627,7 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 		}
 
 		// Actor Class
-		editor_nums_[number].actor_class = tz.next().text;
+		editor_nums[number].actor_class = tz.next().text;
 
 		// Check for special/args definition
 		if (tz.advIfNext(",", 2))
@@ -496,9 +636,9 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 
 			// Check if special or arg
 			if (!tz.current().isInteger())
-				editor_nums_[number].special = tz.current().text;
+				editor_nums[number].special = tz.current().text;
 			else
-				editor_nums_[number].args[arg++] = tz.current().asInt();
+				editor_nums[number].args[arg++] = tz.current().asInt();
 
 			// Parse any further args
 			while (tz.advIfNext(",", 2))
@@ -513,15 +653,13 @@ bool MapInfo::parseDoomEdNums(Tokenizer& tz)
 				}
 
 				if (arg < 5 && !tz.check("+"))
-					editor_nums_[number].args[arg++] = tz.current().asInt();
+					editor_nums[number].args[arg++] = tz.current().asInt();
 			}
 		}
 
 		tz.adv();
 	}
 
-	Log::info(2, "Parsed ZMapInfo DoomEdNums successfully");
-
 	return true;
 }
 
@@ -590,6 +728,124 @@ void MapInfo::dumpDoomEdNums()
 }
 
 
+// -----------------------------------------------------------------------------
+// Writes all parsed MAPINFO information to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void MapInfo::writeCache(CacheWriter& writer) const
+{
+	auto write_map = [&writer](const Map& map) {
+		writer.write(map.name);
+		writer.write<bool>(map.lookup_name);
+		writer.write(map.entry_name);
+		writer.write<int32_t>(map.level_num);
+		writer.write(map.sky1);
+		writer.write<float>(map.sky1_scroll_speed);
+		writer.write(map.sky2);
+		writer.write<float>(map.sky2_scroll_speed);
+		writer.write<bool>(map.sky_double);
+		writer.write<bool>(map.sky_force_no_stretch);
+		writer.write<bool>(map.sky_stretch);
+		writer.write(map.fade);
+		writer.write(map.fade_outside);
+		writer.write(map.music);
+		writer.write<bool>(map.lighting_smooth);
+		writer.write<int32_t>(map.lighting_wallshade_v);
+		writer.write<int32_t>(map.lighting_wallshade_h);
+		writer.write<bool>(map.force_fake_contrast);
+		writer.write<int32_t>(map.fog_density);
+		writer.write<int32_t>(map.fog_density_outside);
+		writer.write<int32_t>(map.fog_density_sky);
+	};
+
+	// Maps
+	writer.write<uint32_t>(maps_.size());
+	for (auto& map : maps_)
+		write_map(map);
+	write_map(default_map_);
+
+	// DoomEdNums
+	writer.write<uint32_t>(editor_nums_.size());
+	for (auto& num : editor_nums_)
+	{
+		writer.write<int32_t>(num.first);
+		writer.write(num.second.actor_class);
+		writer.write(num.second.special);
+		for (auto arg : num.second.args)
+			writer.write<int32_t>(arg);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads all MAPINFO information from the definitions cache [reader], replacing
+// any existing information
+// -----------------------------------------------------------------------------
+bool MapInfo::readCache(CacheReader& reader)
+{
+	auto read_map = [&reader](Map& map) {
+		int32_t level_num = 0, wallshade_v = 0, wallshade_h = 0, fog = 0, fog_outside = 0, fog_sky = 0;
+		reader.read(map.name);
+		reader.read(map.lookup_name);
+		reader.read(map.entry_name);
+		reader.read(level_num);
+		reader.read(map.sky1);
+		reader.read(map.sky1_scroll_speed);
+		reader.read(map.sky2);
+		reader.read(map.sky2_scroll_speed);
+		reader.read(map.sky_double);
+		reader.read(map.sky_force_no_stretch);
+		reader.read(map.sky_stretch);
+		reader.read(map.fade);
+		reader.read(map.fade_outside);
+		reader.read(map.music);
+		reader.read(map.lighting_smooth);
+		reader.read(wallshade_v);
+		reader.read(wallshade_h);
+		reader.read(map.force_fake_contrast);
+		reader.read(fog);
+		reader.read(fog_outside);
+		reader.read(fog_sky);
+
+		map.level_num            = level_num;
+		map.lighting_wallshade_v = wallshade_v;
+		map.lighting_wallshade_h = wallshade_h;
+		map.fog_density          = fog;
+		map.fog_density_outside  = fog_outside;
+		map.fog_density_sky      = fog_sky;
+	};
+
+	clear();
+
+	// Maps
+	uint32_t count = 0;
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		maps_.emplace_back();
+		read_map(maps_.back());
+	}
+	read_map(default_map_);
+
+	// DoomEdNums
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		int32_t number = 0;
+		reader.read(number);
+
+		auto& num = editor_nums_[number];
+		reader.read(num.actor_class);
+		reader.read(num.special);
+		for (auto& arg : num.args)
+		{
+			int32_t value = 0;
+			reader.read(value);
+			arg = value;
+		}
+	}
+
+	return reader.ok();
+}
+
 
 // TEMP TESTING STUFF
 #include "General/Console/Console.h"
@@ -7,6 +7,9 @@ class ArchiveEntry;
 
 namespace Game
 {
+class CacheReader;
+class CacheWriter;
+
 class MapInfo
 {
 public:
@@ -91,12 +94,11 @@ public:
 
 	// General parsing helpers
 	bool checkEqualsToken(Tokenizer& tz, const string& parsing) const;
-	bool strToCol(const string& str, rgba_t& col);
+	bool strToCol(const string& str, rgba_t& col) const;
 
 	// ZDoom MAPINFO parsing
 	bool parseZMapInfo(ArchiveEntry* entry);
-	bool parseZMap(Tokenizer& tz, string type);
-	bool parseDoomEdNums(Tokenizer& tz);
+	bool parseZMapInfo(const vector<ArchiveEntry*>& entries);
 
 	// General
 	Format detectMapInfoType(ArchiveEntry* entry);
@@ -104,9 +106,41 @@ public:
 	// Debug info
 	void dumpDoomEdNums();
 
+	// Definitions cache
+	void writeCache(CacheWriter& writer) const;
+	bool readCache(CacheReader& reader);
+
 private:
 	vector<Map>  maps_;
 	Map          default_map_;
 	DoomEdNumMap editor_nums_;
+
+	// ZMAPINFO entries are parsed into a list of blocks first (independently
+	// of other entries, so they can be parsed in parallel), which are then
+	// applied in order. Map properties are recorded as setters since a map
+	// definition starts from whatever the default map is at that point
+	typedef std::function<bool(Map&)> MapSetter;
+	struct ZMapInfoBlock
+	{
+		ArchiveEntry*     include = nullptr;
+		string            map_type; // map/defaultmap/adddefaultmap
+		vector<MapSetter> map_setters;
+		bool              doomednums = false;
+		DoomEdNumMap      editor_nums;
+	};
+	struct ZMapInfoEntry
+	{
+		vector<ZMapInfoBlock> blocks;
+		bool                  ok = true; // False if parsing stopped due to an error
+	};
+
+	void parseZMapInfoEntry(ArchiveEntry* entry, ZMapInfoEntry& parsed) const;
+	bool parseZMap(Tokenizer& tz, string type, ZMapInfoBlock& block) const;
+	bool parseDoomEdNums(Tokenizer& tz, DoomEdNumMap& editor_nums) const;
+	bool applyZMapInfo(
+		ArchiveEntry*                           entry,
+		std::map<ArchiveEntry*, ZMapInfoEntry>& parsed,
+		vector<ArchiveEntry*>&                  stack);
+	bool applyZMap(ZMapInfoBlock& block);
 };
 } // namespace Game
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "App.h"
+#include "Archive/ArchiveEntry.h"
+#include "Utility/ThreadPool.h"
+
+namespace Game
+{
+// Time taken by each stage of parseEntriesParallel
+struct ParseTimes
+{
+	long     load    = 0; // Loading entry data (calling thread)
+	long     parse   = 0; // Tokenizing/parsing entries (worker threads)
+	unsigned entries = 0; // Number of entries parsed
+	unsigned passes  = 0; // Number of #include levels
+
+	string asString() const
+	{
+		return S_FMT("%u entries in %u passes, load %ldms, parse %ldms", entries, passes, load, parse);
+	}
+};
+
+// Records all entries parsed by parseEntriesParallel on the current thread
+// while it exists (used to get the source entries of cached definitions)
+class ParsedEntryRecorder
+{
+public:
+	ParsedEntryRecorder() { current() = this; }
+	~ParsedEntryRecorder() { current() = nullptr; }
+
+	const vector<ArchiveEntry*>& entries() const { return entries_; }
+
+	static void record(ArchiveEntry* entry)
+	{
+		if (current())
+			current()->entries_.push_back(entry);
+	}
+
+private:
+	vector<ArchiveEntry*> entries_;
+
+	static ParsedEntryRecorder*& current()
+	{
+		static thread_local ParsedEntryRecorder* recorder = nullptr;
+		return recorder;
+	}
+};
+
+// -----------------------------------------------------------------------------
+// Parses [roots] and all entries they #include into a [Result] per entry in
+// [results], using the global thread pool.
+//
+// [parse] (void(ArchiveEntry*, Result&)) is called on worker threads with an
+// entry and the result to write to. Entry data is loaded beforehand on the
+// calling thread, so [parse] must only read from the entry (via
+// getMCData(false)) and never modify it.
+// [includes] (vector<ArchiveEntry*>(const Result&)) is called on the calling
+// thread and returns the entries that a parsed result #includes, these are
+// parsed in the following pass.
+//
+// The results of each entry are independent, it's up to the caller to merge
+// them in order afterwards
+// -----------------------------------------------------------------------------
+template<typename Result, typename ParseFunc, typename IncludesFunc>
+ParseTimes parseEntriesParallel(
+	const vector<ArchiveEntry*>&     roots,
+	std::map<ArchiveEntry*, Result>& results,
+	const ParseFunc&                 parse,
+	const IncludesFunc&              includes)
+{
+	ParseTimes times;
+
+	vector<ArchiveEntry*> pending;
+	for (auto entry : roots)
+		if (entry && results.find(entry) == results.end())
+		{
+			results[entry];
+			pending.push_back(entry);
+		}
+
+	while (!pending.empty())
+	{
+		// Load entry data (can't be done on worker threads)
+		auto start = App::runTimer();
+		for (auto entry : pending)
+		{
+			entry->getMCData();
+			ParsedEntryRecorder::record(entry);
+		}
+		times.load += App::runTimer() - start;
+
+		// Get result slots now, [results] can't be modified while parsing
+		vector<Result*> slots;
+		for (auto entry : pending)
+			slots.push_back(&results[entry]);
+
+		// Parse
+		start = App::runTimer();
+		ThreadPool::global().parallelFor(pending.size(), [&](size_t index) { parse(pending[index], *slots[index]); });
+		times.parse += App::runTimer() - start;
+		times.entries += pending.size();
+		times.passes++;
+
+		// Get any newly #included entries for the next pass
+		vector<ArchiveEntry*> next;
+		for (auto entry : pending)
+			for (auto inc_entry : includes(results[entry]))
+				if (inc_entry && results.find(inc_entry) == results.end())
+				{
+					results[inc_entry];
+					next.push_back(inc_entry);
+				}
+
+		pending.swap(next);
+	}
+
+	return times;
+}
+} // namespace Game
@@ -31,6 +31,7 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "ThingType.h"
+#include "DefinitionsCache.h"
 #include "Game/Configuration.h"
 #include "Utility/Parser.h"
 
@@ -477,6 +478,88 @@ void ThingType::loadProps(PropertyList& props, bool decorate, bool zscript)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Writes the thing type to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void ThingType::writeCache(CacheWriter& writer) const
+{
+	writer.write(name_);
+	writer.write(group_);
+	writer.write(colour_);
+	writer.write<int32_t>(radius_);
+	writer.write<int32_t>(height_);
+	writer.write<double>(scale_.x);
+	writer.write<double>(scale_.y);
+	writer.write<bool>(angled_);
+	writer.write<bool>(hanging_);
+	writer.write<bool>(shrink_);
+	writer.write<bool>(fullbright_);
+	writer.write<bool>(decoration_);
+	writer.write<int32_t>(zeth_icon_);
+	writer.write(sprite_);
+	writer.write(icon_);
+	writer.write(translation_);
+	writer.write(palette_);
+	args_.writeCache(writer);
+	writer.write<bool>(decorate_);
+	writer.write<bool>(solid_);
+	writer.write<int32_t>(next_type_);
+	writer.write<int32_t>(next_args_);
+	writer.write<int32_t>(flags_);
+	writer.write<int32_t>((int)tagged_);
+	writer.write<int32_t>(number_);
+	writer.write(class_name_);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the thing type from the definitions cache [reader]
+// -----------------------------------------------------------------------------
+bool ThingType::readCache(CacheReader& reader)
+{
+	int32_t radius, height, zeth_icon, next_type, next_args, flags, tagged, number;
+
+	reader.read(name_);
+	reader.read(group_);
+	reader.read(colour_);
+	reader.read(radius);
+	reader.read(height);
+	reader.read(scale_.x);
+	reader.read(scale_.y);
+	reader.read(angled_);
+	reader.read(hanging_);
+	reader.read(shrink_);
+	reader.read(fullbright_);
+	reader.read(decoration_);
+	reader.read(zeth_icon);
+	reader.read(sprite_);
+	reader.read(icon_);
+	reader.read(translation_);
+	reader.read(palette_);
+	args_.readCache(reader);
+	reader.read(decorate_);
+	reader.read(solid_);
+	reader.read(next_type);
+	reader.read(next_args);
+	reader.read(flags);
+	reader.read(tagged);
+	reader.read(number);
+	reader.read(class_name_);
+
+	if (!reader.ok())
+		return false;
+
+	radius_    = radius;
+	height_    = height;
+	zeth_icon_ = zeth_icon;
+	next_type_ = next_type;
+	next_args_ = next_args;
+	flags_     = flags;
+	tagged_    = (TagType)tagged;
+	number_    = number;
+
+	return true;
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -8,6 +8,8 @@ class ParseTreeNode;
 namespace Game
 {
 enum class TagType;
+class CacheReader;
+class CacheWriter;
 
 class ThingType
 {
@@ -65,6 +67,9 @@ public:
 	string stringDesc() const;
 	void   loadProps(PropertyList& props, bool decorate = true, bool zscript = false);
 
+	void writeCache(CacheWriter& writer) const;
+	bool readCache(CacheReader& reader);
+
 	static const ThingType& unknown() { return unknown_; }
 	static void             initGlobal();
 
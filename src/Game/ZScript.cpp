@@ -33,6 +33,8 @@
 #include "ZScript.h"
 #include "Archive/Archive.h"
 #include "Archive/ArchiveManager.h"
+#include "DefinitionsCache.h"
+#include "ParallelParse.h"
 #include "Utility/Tokenizer.h"
 
 using namespace ZScript;
@@ -183,15 +185,29 @@ bool checkKeywordValueStatement(const vector<string>& tokens, unsigned index, co
 }
 
 // -----------------------------------------------------------------------------
-// Parses all statements/blocks in [entry], adding them to [parsed]
+// Statements/blocks parsed from a single entry. #include statements aren't
+// followed, instead the included entry and the statement index it is included
+// at are recorded, so entries can be parsed independently
 // -----------------------------------------------------------------------------
-void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed)
+struct ParsedEntry
+{
+	vector<ParsedStatement>                  statements;
+	vector<std::pair<size_t, ArchiveEntry*>> includes;
+	unsigned                                 expansions = 0;
+};
+
+// -----------------------------------------------------------------------------
+// Parses all statements/blocks in [entry] into [parsed].
+// Only reads from [entry] so it can be run on a worker thread, the entry's data
+// must already be loaded
+// -----------------------------------------------------------------------------
+void parseEntryBlocks(ArchiveEntry* entry, ParsedEntry& parsed)
 {
 	Tokenizer tz;
 	tz.setSpecialCharacters(CHR(Tokenizer::DEFAULT_SPECIAL_CHARACTERS + "()+-[]&!?."));
 	tz.enableDecorate(true);
 	tz.setCommentTypes(Tokenizer::CommentTypes::CPPStyle | Tokenizer::CommentTypes::CStyle);
-	tz.openMem(entry->getMCData(), "ZScript");
+	tz.openMem(entry->getMCData(false), "ZScript");
 
 	// Log::info(2, S_FMT("Parsing ZScript entry \"%s\"", entry->getPath(true)));
 
@@ -215,7 +231,7 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed)
 						tz.current().line_no));
 				}
 				else
-					parseBlocks(inc_entry, parsed);
+					parsed.includes.emplace_back(parsed.statements.size(), inc_entry);
 			}
 
 			tz.advToNextLine();
@@ -230,15 +246,119 @@ void parseBlocks(ArchiveEntry* entry, vector<ParsedStatement>& parsed)
 		}
 
 		// ZScript
-		parsed.push_back({});
-		parsed.back().entry = entry;
-		if (!parsed.back().parse(tz))
-			parsed.pop_back();
+		parsed.statements.push_back({});
+		parsed.statements.back().entry = entry;
+		if (!parsed.statements.back().parse(tz))
+			parsed.statements.pop_back();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Counts the number of times the statements in [entry] (and anything it
+// #includes) will be added by expandIncludes
+// -----------------------------------------------------------------------------
+void countExpansions(ArchiveEntry* entry, std::map<ArchiveEntry*, ParsedEntry>& parsed, vector<ArchiveEntry*>& stack)
+{
+	auto& parsed_entry = parsed[entry];
+	parsed_entry.expansions++;
+
+	for (auto& include : parsed_entry.includes)
+	{
+		if (VECTOR_EXISTS(stack, include.second))
+			continue;
+
+		stack.push_back(include.second);
+		countExpansions(include.second, parsed, stack);
+		stack.pop_back();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds the statements parsed from [entry] to [out], with the statements of any
+// #included entries inserted where they were #included (recursively).
+// The statements are moved rather than copied on the last expansion of an
+// entry
+// -----------------------------------------------------------------------------
+void expandIncludes(
+	ArchiveEntry*                         entry,
+	std::map<ArchiveEntry*, ParsedEntry>& parsed,
+	vector<ParsedStatement>&              out,
+	vector<ArchiveEntry*>&                stack)
+{
+	auto& parsed_entry = parsed[entry];
+	bool  last         = --parsed_entry.expansions == 0;
+
+	size_t include = 0;
+	for (size_t a = 0; a <= parsed_entry.statements.size(); ++a)
+	{
+		// Insert any entries #included before this statement
+		for (; include < parsed_entry.includes.size() && parsed_entry.includes[include].first == a; ++include)
+		{
+			auto inc_entry = parsed_entry.includes[include].second;
+			if (VECTOR_EXISTS(stack, inc_entry))
+			{
+				Log::warning(S_FMT(
+					"Warning parsing ZScript entry %s: Recursive #include of \"%s\", skipping",
+					CHR(entry->getName()),
+					CHR(inc_entry->getPath(true))));
+				continue;
+			}
+
+			stack.push_back(inc_entry);
+			expandIncludes(inc_entry, parsed, out, stack);
+			stack.pop_back();
+		}
+
+		if (a == parsed_entry.statements.size())
+			break;
+
+		if (last)
+			out.push_back(std::move(parsed_entry.statements[a]));
+		else
+			out.push_back(parsed_entry.statements[a]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Parses all statements/blocks in [entries] and anything they #include,
+// adding them to [parsed] (one list of statements per entry in [entries]).
+// Entries are tokenized and parsed in parallel, then merged in #include order
+// -----------------------------------------------------------------------------
+Game::ParseTimes parseBlocks(const vector<ArchiveEntry*>& entries, vector<vector<ParsedStatement>>& parsed)
+{
+	// Parse all entries (in parallel)
+	std::map<ArchiveEntry*, ParsedEntry> parsed_entries;
+	auto get_includes = [](const ParsedEntry& parsed_entry) {
+		vector<ArchiveEntry*> includes;
+		for (auto& include : parsed_entry.includes)
+			includes.push_back(include.second);
+		return includes;
+	};
+	auto times = Game::parseEntriesParallel(entries, parsed_entries, parseEntryBlocks, get_includes);
+
+	// Set entry types
+	if (etype_zscript)
+		for (auto& i : parsed_entries)
+			if (i.first->getType() != etype_zscript)
+				i.first->setType(etype_zscript);
+
+	// Merge
+	vector<ArchiveEntry*> stack;
+	for (auto entry : entries)
+	{
+		stack.push_back(entry);
+		countExpansions(entry, parsed_entries, stack);
+		stack.pop_back();
+	}
+	for (auto entry : entries)
+	{
+		parsed.emplace_back();
+		stack.push_back(entry);
+		expandIncludes(entry, parsed_entries, parsed.back(), stack);
+		stack.pop_back();
 	}
 
-	// Set entry type
-	if (etype_zscript && entry->getType() != etype_zscript)
-		entry->setType(etype_zscript);
+	return times;
 }
 
 // -----------------------------------------------------------------------------
@@ -483,6 +603,59 @@ bool Function::isFunction(ParsedStatement& statement)
 	return false;
 }
 
+// -----------------------------------------------------------------------------
+// Writes the function declaration to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void Function::writeCache(Game::CacheWriter& writer) const
+{
+	writer.write(name_);
+	writer.write<bool>(native_);
+	writer.write(deprecated_);
+	writer.write(version_);
+	writer.write(return_type_);
+	writer.write<bool>(virtual_);
+	writer.write<bool>(static_);
+	writer.write<bool>(action_);
+	writer.write<bool>(override_);
+
+	writer.write<uint32_t>(parameters_.size());
+	for (auto& param : parameters_)
+	{
+		writer.write(param.name);
+		writer.write(param.type);
+		writer.write(param.default_value);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads the function declaration from the definitions cache [reader]
+// -----------------------------------------------------------------------------
+bool Function::readCache(Game::CacheReader& reader)
+{
+	reader.read(name_);
+	reader.read(native_);
+	reader.read(deprecated_);
+	reader.read(version_);
+	reader.read(return_type_);
+	reader.read(virtual_);
+	reader.read(static_);
+	reader.read(action_);
+	reader.read(override_);
+
+	uint32_t count = 0;
+	reader.read(count);
+	parameters_.clear();
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		parameters_.emplace_back();
+		reader.read(parameters_.back().name);
+		reader.read(parameters_.back().type);
+		reader.read(parameters_.back().default_value);
+	}
+
+	return reader.ok();
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -776,6 +949,52 @@ void Class::toThingType(std::map<int, Game::ThingType>& types, vector<Game::Thin
 	def->loadProps(default_properties_, true, true);
 }
 
+// -----------------------------------------------------------------------------
+// Writes the class declaration and its functions to the definitions cache
+// [writer]. Other class info (properties, states etc.) is only needed for
+// ThingType export, which is cached separately
+// -----------------------------------------------------------------------------
+void Class::writeCache(Game::CacheWriter& writer) const
+{
+	writer.write<int32_t>((int)type_);
+	writer.write(name_);
+	writer.write<bool>(native_);
+	writer.write(deprecated_);
+	writer.write(version_);
+	writer.write(inherits_class_);
+
+	writer.write<uint32_t>(functions_.size());
+	for (auto& func : functions_)
+		func.writeCache(writer);
+}
+
+// -----------------------------------------------------------------------------
+// Reads the class declaration and its functions from the definitions cache
+// [reader]
+// -----------------------------------------------------------------------------
+bool Class::readCache(Game::CacheReader& reader)
+{
+	int32_t type = 0;
+	reader.read(type);
+	type_ = (Type)type;
+	reader.read(name_);
+	reader.read(native_);
+	reader.read(deprecated_);
+	reader.read(version_);
+	reader.read(inherits_class_);
+
+	uint32_t count = 0;
+	reader.read(count);
+	functions_.clear();
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		functions_.emplace_back();
+		functions_.back().readCache(reader);
+	}
+
+	return reader.ok();
+}
+
 // -----------------------------------------------------------------------------
 // Parses a class definition from statements in [block]
 // -----------------------------------------------------------------------------
@@ -917,70 +1136,7 @@ void Definitions::clear()
 // -----------------------------------------------------------------------------
 bool Definitions::parseZScript(ArchiveEntry* entry)
 {
-	// Parse into tree of expressions and blocks
-	auto                    start = App::runTimer();
-	vector<ParsedStatement> parsed;
-	parseBlocks(entry, parsed);
-	Log::debug(2, S_FMT("parseBlocks: %ldms", App::runTimer() - start));
-	start = App::runTimer();
-
-	for (auto& block : parsed)
-	{
-		if (block.tokens.empty())
-			continue;
-
-		if (dump_parsed_blocks)
-			block.dump();
-
-		// Class
-		if (S_CMPNOCASE(block.tokens[0], "class"))
-		{
-			Class nc(Class::Type::Class);
-
-			if (!nc.parse(block))
-				return false;
-
-			classes_.push_back(nc);
-		}
-
-		// Struct
-		else if (S_CMPNOCASE(block.tokens[0], "struct"))
-		{
-			Class nc(Class::Type::Struct);
-
-			if (!nc.parse(block))
-				return false;
-
-			classes_.push_back(nc);
-		}
-
-		// Extend Class
-		else if (
-			block.tokens.size() > 2 && S_CMPNOCASE(block.tokens[0], "extend") && S_CMPNOCASE(block.tokens[1], "class"))
-		{
-			for (auto& c : classes_)
-				if (S_CMPNOCASE(c.name(), block.tokens[2]))
-				{
-					c.extend(block);
-					break;
-				}
-		}
-
-		// Enum
-		else if (S_CMPNOCASE(block.tokens[0], "enum"))
-		{
-			Enumerator e;
-
-			if (!e.parse(block))
-				return false;
-
-			enumerators_.push_back(e);
-		}
-	}
-
-	Log::debug(2, S_FMT("ZScript: %ldms", App::runTimer() - start));
-
-	return true;
+	return parseZScriptEntries({ entry });
 }
 
 // -----------------------------------------------------------------------------
@@ -1004,10 +1160,106 @@ bool Definitions::parseZScript(Archive* archive)
 		etype_zscript = nullptr;
 
 	// Parse ZScript entries
+	return parseZScriptEntries(zscript_enries);
+}
+
+// -----------------------------------------------------------------------------
+// Parses ZScript in [entries], in order.
+// Returns false if parsing any of the entries failed
+// -----------------------------------------------------------------------------
+bool Definitions::parseZScriptEntries(const vector<ArchiveEntry*>& entries)
+{
+	// Parse into trees of expressions and blocks
+	vector<vector<ParsedStatement>> parsed;
+	auto                            times = parseBlocks(entries, parsed);
+	Log::debug(2, S_FMT("ZScript parseBlocks: %s", CHR(times.asString())));
+	auto start = App::runTimer();
+
+	// Find class/struct blocks
+	vector<ParsedStatement*> class_blocks;
+	vector<Class>            class_defs;
+	vector<size_t>           class_first(parsed.size());
+	for (unsigned a = 0; a < parsed.size(); a++)
+	{
+		class_first[a] = class_blocks.size();
+		for (auto& block : parsed[a])
+		{
+			if (block.tokens.empty())
+				continue;
+
+			if (S_CMPNOCASE(block.tokens[0], "class"))
+				class_defs.emplace_back(Class::Type::Class);
+			else if (S_CMPNOCASE(block.tokens[0], "struct"))
+				class_defs.emplace_back(Class::Type::Struct);
+			else
+				continue;
+
+			class_blocks.push_back(&block);
+		}
+	}
+
+	// Parse class/struct definitions (these are independent of each other)
+	vector<char> class_ok(class_blocks.size(), 0);
+	ThreadPool::global().parallelFor(
+		class_blocks.size(), [&](size_t index) { class_ok[index] = class_defs[index].parse(*class_blocks[index]); });
+	Log::debug(2, S_FMT("ZScript classes: %ldms", App::runTimer() - start));
+	start = App::runTimer();
+
+	// Add definitions in order
 	bool ok = true;
-	for (auto entry : zscript_enries)
-		if (!parseZScript(entry))
-			ok = false;
+	for (unsigned a = 0; a < parsed.size(); a++)
+	{
+		auto class_index = class_first[a];
+		for (auto& block : parsed[a])
+		{
+			if (block.tokens.empty())
+				continue;
+
+			if (dump_parsed_blocks)
+				block.dump();
+
+			// Class/Struct
+			if (S_CMPNOCASE(block.tokens[0], "class") || S_CMPNOCASE(block.tokens[0], "struct"))
+			{
+				if (!class_ok[class_index])
+				{
+					ok = false;
+					break;
+				}
+
+				classes_.push_back(std::move(class_defs[class_index++]));
+			}
+
+			// Extend Class
+			else if (
+				block.tokens.size() > 2 && S_CMPNOCASE(block.tokens[0], "extend")
+				&& S_CMPNOCASE(block.tokens[1], "class"))
+			{
+				for (auto& c : classes_)
+					if (S_CMPNOCASE(c.name(), block.tokens[2]))
+					{
+						c.extend(block);
+						break;
+					}
+			}
+
+			// Enum
+			else if (S_CMPNOCASE(block.tokens[0], "enum"))
+			{
+				Enumerator e;
+
+				if (!e.parse(block))
+				{
+					ok = false;
+					break;
+				}
+
+				enumerators_.push_back(e);
+			}
+		}
+	}
+
+	Log::debug(2, S_FMT("ZScript merge: %ldms", App::runTimer() - start));
 
 	return ok;
 }
@@ -1022,6 +1274,35 @@ void Definitions::exportThingTypes(std::map<int, Game::ThingType>& types, vector
 		cdef.toThingType(types, parsed);
 }
 
+// -----------------------------------------------------------------------------
+// Writes all classes to the definitions cache [writer]
+// -----------------------------------------------------------------------------
+void Definitions::writeCache(Game::CacheWriter& writer) const
+{
+	writer.write<uint32_t>(classes_.size());
+	for (auto& cdef : classes_)
+		cdef.writeCache(writer);
+}
+
+// -----------------------------------------------------------------------------
+// Reads all classes from the definitions cache [reader], replacing any
+// existing definitions
+// -----------------------------------------------------------------------------
+bool Definitions::readCache(Game::CacheReader& reader)
+{
+	clear();
+
+	uint32_t count = 0;
+	reader.read(count);
+	for (uint32_t a = 0; a < count && reader.ok(); ++a)
+	{
+		classes_.emplace_back(Class::Type::Class);
+		classes_.back().readCache(reader);
+	}
+
+	return reader.ok();
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -1208,12 +1489,14 @@ CONSOLE_COMMAND(test_parseblocks, 1, false)
 	if (!entry)
 		return;
 
-	auto                    start = App::runTimer();
-	vector<ParsedStatement> parsed;
+	auto                            start = App::runTimer();
+	vector<vector<ParsedStatement>> parsed;
 	for (auto a = 0; a < num; ++a)
 	{
-		parseBlocks(entry, parsed);
+		auto times = parseBlocks({ entry }, parsed);
 		parsed.clear();
+		if (a == 0)
+			Log::console(times.asString());
 	}
 	Log::console(S_FMT("Took %ldms", App::runTimer() - start));
 }
@@ -6,6 +6,11 @@
 class Archive;
 class ArchiveEntry;
 class Tokenizer;
+namespace Game
+{
+class CacheReader;
+class CacheWriter;
+} // namespace Game
 
 namespace ZScript
 {
@@ -97,6 +102,9 @@ public:
 
 	static bool isFunction(ParsedStatement& block);
 
+	void writeCache(Game::CacheWriter& writer) const;
+	bool readCache(Game::CacheReader& reader);
+
 private:
 	vector<Parameter> parameters_;
 	string            return_type_;
@@ -153,6 +161,9 @@ public:
 	bool extend(ParsedStatement& block);
 	void toThingType(std::map<int, Game::ThingType>& types, vector<Game::ThingType>& parsed);
 
+	void writeCache(Game::CacheWriter& writer) const;
+	bool readCache(Game::CacheReader& reader);
+
 private:
 	Type               type_;
 	string             inherits_class_;
@@ -182,10 +193,15 @@ public:
 
 	void exportThingTypes(std::map<int, Game::ThingType>& types, vector<Game::ThingType>& parsed);
 
+	void writeCache(Game::CacheWriter& writer) const;
+	bool readCache(Game::CacheReader& reader);
+
 private:
 	vector<Class>      classes_;
 	vector<Enumerator> enumerators_;
 	vector<Variable>   variables_;
 	vector<Function>   functions_; // needed? dunno if global functions are a thing
+
+	bool parseZScriptEntries(const vector<ArchiveEntry*>& entries);
 };
 } // namespace ZScript
@@ -31,7 +31,11 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "App.h"
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 
 // -----------------------------------------------------------------------------
@@ -41,10 +45,175 @@
 // -----------------------------------------------------------------------------
 namespace Log
 {
-vector<Message> log;
+// A logged message waiting to be added to the history by the writer
+struct PendingMessage
+{
+	Message         message;
+	PendingMessage* next;
+};
+
+// Messages can be logged from any thread, so they are first pushed onto a
+// lock-free stack (newest first) and moved to the history (and log file) by the
+// writer thread, or whenever the history is read
+std::atomic<PendingMessage*> pending{ nullptr };
+
+// The history is a ring buffer of the last log_history_size messages
+vector<Message> history_ring;
+size_t          history_next = 0; // Index of the next message added to the history
+std::mutex      history_mutex;
 std::ofstream   log_file;
+
+std::thread             writer_thread;
+std::mutex              writer_mutex;
+std::condition_variable writer_signal;
+bool                    writer_stop = false;
+std::atomic<bool>       writer_running{ false };
 } // namespace Log
 CVAR(Int, log_verbosity, 1, CVAR_SAVE)
+CVAR(Int, log_history_size, 10000, CVAR_SAVE)
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Resizes the history ring buffer to [size] messages, keeping the most recent
+// messages that still fit
+// -----------------------------------------------------------------------------
+void resizeHistory(size_t size)
+{
+	using namespace Log;
+
+	auto            kept = std::min({ history_next, history_ring.size(), size });
+	vector<Message> ring(size);
+	for (auto index = history_next - kept; index < history_next; ++index)
+		ring[index % size] = std::move(history_ring[index % history_ring.size()]);
+
+	history_ring.swap(ring);
+}
+
+// -----------------------------------------------------------------------------
+// Moves all pending log messages to the history, and writes them to the log
+// file
+// -----------------------------------------------------------------------------
+void processPending()
+{
+	using namespace Log;
+
+	std::lock_guard<std::mutex> lock(history_mutex);
+
+	// Take the pending messages, and reverse them to get them in the order
+	// they were logged
+	auto            list    = pending.exchange(nullptr, std::memory_order_acquire);
+	PendingMessage* ordered = nullptr;
+	while (list)
+	{
+		auto next  = list->next;
+		list->next = ordered;
+		ordered    = list;
+		list       = next;
+	}
+	if (!ordered)
+		return;
+
+	// Check history size
+	auto size = (size_t)std::max<int>(log_history_size, 100);
+	if (history_ring.size() != size)
+		resizeHistory(size);
+
+	while (ordered)
+	{
+		auto& msg = ordered->message;
+		msg.index = history_next++;
+
+		// Write to log file
+		if (log_file.is_open() && msg.type != MessageType::Console)
+			sf::err() << msg.formattedMessageLine() << "\n";
+
+		// Add to history
+		history_ring[msg.index % size] = std::move(msg);
+
+		auto next = ordered->next;
+		delete ordered;
+		ordered = next;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Adds a message [text] of [type] to the pending messages. If the writer thread
+// isn't running it is added to the history immediately
+// -----------------------------------------------------------------------------
+void queueMessage(Log::MessageType type, const char* text)
+{
+	using namespace Log;
+
+	auto pm  = new PendingMessage{ { text, type, wxDateTime::Now().GetTicks() }, nullptr };
+	auto top = pending.load(std::memory_order_relaxed);
+	do
+		pm->next = top;
+	while (!pending.compare_exchange_weak(top, pm, std::memory_order_release, std::memory_order_relaxed));
+
+	if (!writer_running)
+		processPending();
+	else if (!top)
+		writer_signal.notify_one();
+}
+
+// -----------------------------------------------------------------------------
+// Writer thread function, processes pending log messages until the log is
+// closed
+// -----------------------------------------------------------------------------
+void writeLog()
+{
+	using namespace Log;
+
+	std::unique_lock<std::mutex> lock(writer_mutex);
+	while (!writer_stop)
+	{
+		// Wait for messages (the timeout catches any missed signals)
+		writer_signal.wait_for(lock, std::chrono::milliseconds(100));
+
+		lock.unlock();
+		processPending();
+		if (log_file.is_open())
+		{
+			std::lock_guard<std::mutex> lock_history(history_mutex);
+			sf::err().flush();
+		}
+		lock.lock();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Stops the writer thread, if it is running
+// -----------------------------------------------------------------------------
+void stopWriter()
+{
+	using namespace Log;
+
+	if (!writer_running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+		writer_stop = true;
+	}
+	writer_signal.notify_one();
+	writer_thread.join();
+	writer_running = false;
+}
+
+// Makes sure the writer thread is stopped before the log variables are
+// destroyed, if the log wasn't closed normally
+struct WriterStopper
+{
+	~WriterStopper() { stopWriter(); }
+} writer_stopper;
+} // namespace
 
 
 // -----------------------------------------------------------------------------
@@ -119,14 +288,43 @@ void Log::init()
 
 	// Set up FreeImage to use our log:
 	FreeImage_SetOutputMessage(FreeImageErrorHandler);
+
+	// Start writer thread
+	if (!writer_running)
+	{
+		writer_stop    = false;
+		writer_running = true;
+		writer_thread  = std::thread(writeLog);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Stops the writer thread and writes any pending messages to the log file.
+// Anything logged after this is written immediately
+// -----------------------------------------------------------------------------
+void Log::close()
+{
+	stopWriter();
+	processPending();
+	if (log_file.is_open())
+		sf::err().flush();
 }
 
 // -----------------------------------------------------------------------------
-// Returns the log message history
+// Returns the log message history, from message index [first] onwards. Only
+// the most recent log_history_size messages are kept
 // -----------------------------------------------------------------------------
-const vector<Log::Message>& Log::history()
+vector<Log::Message> Log::history(size_t first)
 {
-	return log;
+	processPending();
+
+	std::lock_guard<std::mutex> lock(history_mutex);
+	vector<Message>             list;
+	auto                        start = history_next - std::min(history_next, history_ring.size());
+	for (auto index = std::max(start, first); index < history_next; ++index)
+		list.push_back(history_ring[index % history_ring.size()]);
+
+	return list;
 }
 
 // -----------------------------------------------------------------------------
@@ -151,12 +349,7 @@ void Log::setVerbosity(int verbosity)
 // -----------------------------------------------------------------------------
 void Log::message(MessageType type, const char* text)
 {
-	// Add log message
-	log.push_back({ text, type, wxDateTime::Now().GetTicks() });
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console)
-		sf::err() << log.back().formattedMessageLine() << "\n";
+	queueMessage(type, text);
 }
 void Log::message(MessageType type, const wxString& text)
 {
@@ -166,12 +359,12 @@ void Log::message(MessageType type, const wxString& text)
 // -----------------------------------------------------------------------------
 // Returns a list of log messages of [type] that have been recorded since [time]
 // -----------------------------------------------------------------------------
-vector<Log::Message*> Log::since(time_t time, MessageType type)
+vector<Log::Message> Log::since(time_t time, MessageType type)
 {
-	vector<Message*> list;
-	for (auto& msg : log)
+	vector<Message> list;
+	for (auto& msg : history())
 		if (msg.timestamp >= time && (type == MessageType::Any || msg.type == type))
-			list.push_back(&msg);
+			list.push_back(msg);
 	return list;
 }
 
@@ -209,12 +402,7 @@ void Log::message(MessageType type, int level, const char* text)
 	if (level > log_verbosity)
 		return;
 
-	// Add log message
-	log.push_back({ text, type, wxDateTime::Now().GetTicks() });
-
-	// Write to log file
-	if (log_file.is_open() && type != MessageType::Console)
-		sf::err() << log.back().formattedMessageLine() << "\n";
+	queueMessage(type, text);
 }
 void Log::message(MessageType type, int level, const wxString& text)
 {
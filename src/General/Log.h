@@ -18,15 +18,17 @@ struct Message
 	string      message;
 	MessageType type;
 	time_t      timestamp;
+	size_t      index = 0; // Position in the log, counting from the first message logged
 
 	string formattedMessageLine() const;
 };
 
-const vector<Message>& history();
-int                    verbosity();
-void                   setVerbosity(int verbosity);
-void                   init();
-vector<Message*>       since(time_t time, MessageType type = MessageType::Any);
+vector<Message> history(size_t first = 0);
+int             verbosity();
+void            setVerbosity(int verbosity);
+void            init();
+void            close();
+vector<Message> since(time_t time, MessageType type = MessageType::Any);
 
 void message(MessageType type, int level, const char* text);
 void message(MessageType type, int level, const wxString& text);
@@ -59,8 +61,21 @@ inline void	console(const wxString& text) { message(MessageType::Console, text);
 // clang-format on
 } // namespace Log
 
-// Try to avoid using these and use Log::message/error/warning with S_FMT instead
-#define LOG_MESSAGE(level, ...) Log::message(Log::MessageType::Info, level, wxString::Format(__VA_ARGS__))
-#define LOG_WARNING(level, ...) Log::message(Log::MessageType::Warning, level, wxString::Format(__VA_ARGS__))
-#define LOG_ERROR(level, ...) Log::message(Log::MessageType::Error, level, wxString::Format(__VA_ARGS__))
+// Messages logged via the macros below with a verbosity level higher than this
+// are compiled out entirely (define it lower for builds that don't need them)
+#ifndef SLADE_LOG_MAX_LEVEL
+#define SLADE_LOG_MAX_LEVEL 5
+#endif
+
+// Try to avoid using these and use Log::message/error/warning with S_FMT instead.
+// The message is only formatted if it would actually be logged
+#define LOG_LEVEL(type, level, ...)                                                     \
+	do                                                                                  \
+	{                                                                                   \
+		if ((level) <= SLADE_LOG_MAX_LEVEL && (level) <= Log::verbosity())              \
+			Log::message(Log::MessageType::type, level, wxString::Format(__VA_ARGS__)); \
+	} while (false)
+#define LOG_MESSAGE(level, ...) LOG_LEVEL(Info, level, __VA_ARGS__)
+#define LOG_WARNING(level, ...) LOG_LEVEL(Warning, level, __VA_ARGS__)
+#define LOG_ERROR(level, ...) LOG_LEVEL(Error, level, __VA_ARGS__)
 // move LOG_DEBUG here?
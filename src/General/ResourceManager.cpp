@@ -47,6 +47,42 @@ ResourceManager* ResourceManager::instance_ = nullptr;
 string           ResourceManager::doom64_hash_table_[65536];
 
 
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Returns the resource named [name] in [map], or nullptr if there isn't one
+// (unlike map[name], this doesn't add an empty resource)
+// -----------------------------------------------------------------------------
+template<class M> typename M::mapped_type* findResource(M& map, const string& name)
+{
+	auto i = map.find(name);
+	return i == map.end() ? nullptr : &i->second;
+}
+
+// -----------------------------------------------------------------------------
+// Returns all (name, resource) pairs in [map], sorted by name
+// -----------------------------------------------------------------------------
+template<class M> vector<typename M::value_type*> sortedResources(M& map)
+{
+	vector<typename M::value_type*> resources;
+	resources.reserve(map.size());
+	for (auto& i : map)
+		resources.push_back(&i);
+
+	std::sort(resources.begin(), resources.end(), [](const typename M::value_type* l, const typename M::value_type* r) {
+		return l->first < r->first;
+	});
+
+	return resources;
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // EntryResource Class Functions
@@ -55,12 +91,20 @@ string           ResourceManager::doom64_hash_table_[65536];
 
 
 // -----------------------------------------------------------------------------
-// Adds matching [entry] to the resource
+// Adds matching [entry] to the resource, after any entries in archives of the
+// same or higher priority
 // -----------------------------------------------------------------------------
 void EntryResource::add(ArchiveEntry::SPtr& entry)
 {
-	if (entry->getParent())
-		entries_.push_back(entry);
+	auto archive = entry->getParent();
+	if (!archive)
+		return;
+
+	auto priority = App::archiveManager().archiveIndex(archive);
+	auto pos      = std::find_if(entries_.begin(), entries_.end(), [priority](const Candidate& candidate) {
+		return App::archiveManager().archiveIndex(candidate.archive) < priority;
+	});
+	entries_.insert(pos, { entry, archive });
 }
 
 // -----------------------------------------------------------------------------
@@ -68,72 +112,71 @@ void EntryResource::add(ArchiveEntry::SPtr& entry)
 // -----------------------------------------------------------------------------
 void EntryResource::remove(ArchiveEntry::SPtr& entry)
 {
-	unsigned a = 0;
-	while (a < entries_.size())
-	{
-		if (entries_[a].lock() == entry)
-			entries_.erase(entries_.begin() + a);
-		else
-			++a;
-	}
+	entries_.erase(
+		std::remove_if(
+			entries_.begin(),
+			entries_.end(),
+			[&entry](const Candidate& candidate) { return candidate.entry.lock() == entry; }),
+		entries_.end());
+}
+
+// -----------------------------------------------------------------------------
+// Removes all entries in [archive] (and any expired entries) from the resource
+// -----------------------------------------------------------------------------
+void EntryResource::removeArchive(Archive* archive)
+{
+	entries_.erase(
+		std::remove_if(
+			entries_.begin(),
+			entries_.end(),
+			[archive](const Candidate& candidate) {
+				return candidate.archive == archive || candidate.entry.expired();
+			}),
+		entries_.end());
 }
 
 // -----------------------------------------------------------------------------
 // Gets the most relevant entry for this resource, depending on [priority] and
 // [nspace]. If [priority] is set, this will prioritize entries from the
 // priority archive. If [nspace] is not empty, this will prioritize entries
-// within that namespace, or if [ns_required] is true, ignore anything not in
-// [nspace]
+// within that namespace, and if [ns_required] is true, a [priority] archive
+// entry outside of [nspace] is ignored. Otherwise, entries from later archives
+// take priority (the entries are already sorted in that order)
 // -----------------------------------------------------------------------------
 ArchiveEntry* EntryResource::getEntry(Archive* priority, const string& nspace, bool ns_required)
 {
-	// Check resoure has any entries
-	if (entries_.empty())
-		return nullptr;
-
-	ArchiveEntry::SPtr best;
-	auto               i = entries_.end();
-	while (i != entries_.begin())
+	ArchiveEntry* first    = nullptr;
+	ArchiveEntry* first_ns = nullptr;
+	auto          i        = entries_.begin();
+	while (i != entries_.end())
 	{
-		--i;
 		// Check if expired
-		if (i->expired())
+		auto entry = i->entry.lock();
+		if (!entry)
 		{
 			i = entries_.erase(i);
 			continue;
 		}
+		++i;
 
-		auto entry = i->lock();
-
-		if (!best)
-			best = entry;
-
-		// Check namespace if required
-		if (ns_required && !nspace.IsEmpty())
-			if (!entry->isInNamespace(nspace))
-				continue;
+		bool in_ns = !nspace.IsEmpty() && entry->isInNamespace(nspace);
 
 		// Check if in priority archive (or its parent)
 		if (priority && (entry->getParent() == priority || entry->getParent()->parentArchive() == priority))
-		{
-			best = entry;
-			break;
-		}
+			if (in_ns || !ns_required || nspace.IsEmpty())
+				return entry.get();
 
-		// Check namespace
-		if (!ns_required && !nspace.IsEmpty() && !best->isInNamespace(nspace) && entry->isInNamespace(nspace))
-		{
-			best = entry;
-			continue;
-		}
+		if (!first)
+			first = entry.get();
+		if (in_ns && !first_ns)
+			first_ns = entry.get();
 
-		// Otherwise, if it's in a 'later' archive than the current resource entry, set it
-		if (App::archiveManager().archiveIndex(best->getParent())
-			<= App::archiveManager().archiveIndex(entry->getParent()))
-			best = entry;
+		// Nothing more to look for if no priority archive is given
+		if (!priority && (first_ns || nspace.IsEmpty()))
+			break;
 	}
 
-	return best.get();
+	return first_ns ? first_ns : first;
 }
 
 
@@ -145,7 +188,8 @@ ArchiveEntry* EntryResource::getEntry(Archive* priority, const string& nspace, b
 
 
 // -----------------------------------------------------------------------------
-// Adds a texture to this resource
+// Adds a texture to this resource, before any textures in archives of the same
+// or lower priority
 // -----------------------------------------------------------------------------
 void TextureResource::add(CTexture* tex, Archive* parent)
 {
@@ -153,7 +197,11 @@ void TextureResource::add(CTexture* tex, Archive* parent)
 	if (!tex || !parent)
 		return;
 
-	textures_.push_back(std::make_unique<Texture>(tex, parent));
+	auto priority = App::archiveManager().archiveIndex(parent);
+	auto pos      = std::find_if(textures_.begin(), textures_.end(), [priority](const std::unique_ptr<Texture>& texture) {
+		return App::archiveManager().archiveIndex(texture->parent) <= priority;
+	});
+	textures_.insert(pos, std::make_unique<Texture>(tex, parent));
 }
 
 // -----------------------------------------------------------------------------
@@ -172,6 +220,35 @@ void TextureResource::remove(Archive* parent)
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Returns the most relevant texture for this resource: the one in [priority]
+// if it has one, otherwise the one in the latest archive that isn't [ignore]
+// -----------------------------------------------------------------------------
+TextureResource::Texture* TextureResource::getTexture(Archive* priority, Archive* ignore)
+{
+	Texture* best = nullptr;
+	for (auto& texture : textures_)
+	{
+		// Skip if it's in the 'ignore' archive
+		if (texture->parent == ignore)
+			continue;
+
+		// If it's in the 'priority' archive, use it
+		if (priority && texture->parent == priority)
+			return texture.get();
+
+		// Otherwise the first is the latest (textures are sorted by priority)
+		if (!best)
+		{
+			best = texture.get();
+			if (!priority)
+				break;
+		}
+	}
+
+	return best;
+}
+
 
 // -----------------------------------------------------------------------------
 //
@@ -211,11 +288,34 @@ void ResourceManager::removeArchive(Archive* archive)
 	if (!archive)
 		return;
 
-	// Go through entries
-	vector<ArchiveEntry::SPtr> entries;
-	archive->getEntryTreeAsList(entries);
-	for (auto& entry : entries)
-		removeEntry(entry, false, true);
+	// Remove the archive's entries from all resources (and any resources left
+	// empty by that)
+	for (auto map : { &palettes_,
+					  &patches_,
+					  &patches_fp_,
+					  &patches_fp_only_,
+					  &graphics_,
+					  &flats_,
+					  &flats_fp_,
+					  &flats_fp_only_,
+					  &satextures_,
+					  &satextures_fp_,
+					  &pending_ })
+	{
+		auto i = map->begin();
+		while (i != map->end())
+		{
+			i->second.removeArchive(archive);
+			if (i->second.length() == 0)
+				i = map->erase(i);
+			else
+				++i;
+		}
+	}
+
+	// Remove the archive's composite textures
+	for (auto& i : textures_)
+		i.second.remove(archive);
 
 	// Announce resource update
 	announce("resources_updated");
@@ -246,13 +346,6 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 	if (!entry.get())
 		return;
 
-	// Detect type if unknown
-	if (entry->getType() == EntryType::unknownType())
-		EntryType::detectEntryType(entry.get());
-
-	// Get entry type
-	EntryType* type = entry->getType();
-
 	// Get resource name (extension cut, uppercase)
 	string lname = entry->getUpperNameNoExt();
 	string name  = entry->getUpperNameNoExt().Truncate(8);
@@ -262,6 +355,25 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 	if (log)
 		Log::debug(S_FMT("Adding entry %s to resource manager", path));
 
+	// If the entry's type hasn't been detected yet, only add it by name for now
+	// (it is added properly when a resource with its name is looked up).
+	// Texture definition lumps are always added, since composite textures
+	// aren't looked up by the lump name
+	if (entry->isTypeDeferred() && !name.StartsWith("TEXTURE"))
+	{
+		pending_[name].add(entry);
+		if (entry->isInNamespace("textures") || entry->isInNamespace("hires"))
+			ResourceManager::doom64_hash_table_[getTextureHash(name)] = name;
+		return;
+	}
+
+	// Detect type if unknown
+	if (entry->getType() == EntryType::unknownType())
+		EntryType::detectEntryType(entry.get());
+
+	// Get entry type
+	EntryType* type = entry->getType();
+
 	// Check for palette entry
 	if (type->id() == "palette")
 		palettes_[name].add(entry);
@@ -365,7 +477,7 @@ void ResourceManager::addEntry(ArchiveEntry::SPtr& entry, bool log)
 		for (unsigned a = 0; a < tx.nTextures(); a++)
 		{
 			tex = tx.getTexture(a);
-			textures_[tex->getName()].add(tex, entry->getParent());
+			textures_[tex->getName().Upper()].add(tex, entry->getParent());
 		}
 	}
 }
@@ -375,8 +487,8 @@ void removeEntryFromMap(EntryResourceMap& map, const string& name, ArchiveEntry:
 	if (full_check)
 		for (auto& i : map)
 			i.second.remove(entry);
-	else
-		map[name].remove(entry);
+	else if (auto res = findResource(map, name))
+		res->remove(entry);
 }
 
 // -----------------------------------------------------------------------------
@@ -394,6 +506,9 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 	if (log)
 		Log::debug(S_FMT("Removing entry %s from resource manager", path));
 
+	// Remove from pending entries
+	removeEntryFromMap(pending_, name, entry, full_check);
+
 	// Remove from palettes
 	removeEntryFromMap(palettes_, name, entry, full_check);
 
@@ -411,12 +526,16 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 	removeEntryFromMap(satextures_, name, entry, full_check);
 	removeEntryFromMap(satextures_fp_, path, entry, full_check);
 
-	// Check for TEXTUREx entry
+	// Check for TEXTUREx entry (if its type is still undetected, it was never
+	// added as one)
 	int txentry = 0;
-	if (entry->getType()->id() == "texturex")
-		txentry = 1;
-	else if (entry->getType()->id() == "zdtextures")
-		txentry = 2;
+	if (!entry->isTypeDeferred())
+	{
+		if (entry->getType()->id() == "texturex")
+			txentry = 1;
+		else if (entry->getType()->id() == "zdtextures")
+			txentry = 2;
+	}
 	if (txentry > 0)
 	{
 		// Read texture list
@@ -429,21 +548,65 @@ void ResourceManager::removeEntry(ArchiveEntry::SPtr& entry, bool log, bool full
 
 		// Remove all texture resources
 		for (unsigned a = 0; a < tx.nTextures(); a++)
-			textures_[tx.getTexture(a)->getName()].remove(entry->getParent());
+		{
+			auto res = findResource(textures_, tx.getTexture(a)->getName().Upper());
+			if (res)
+				res->remove(entry->getParent());
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Detects the types of any pending entries named [name] and adds them as
+// resources
+// -----------------------------------------------------------------------------
+void ResourceManager::resolvePending(const string& name)
+{
+	if (pending_.empty())
+		return;
+
+	auto i = pending_.find(name);
+	if (i == pending_.end())
+		return;
+
+	auto candidates = std::move(i->second.entries_);
+	pending_.erase(i);
+	for (auto& candidate : candidates)
+	{
+		auto entry = candidate.entry.lock();
+		if (!entry)
+			continue;
+
+		entry->getType(); // Detects the type if still deferred
+		addEntry(entry);
 	}
 }
 
+// -----------------------------------------------------------------------------
+// Resolves all pending entries
+// -----------------------------------------------------------------------------
+void ResourceManager::resolveAllPending()
+{
+	if (pending_.empty())
+		return;
+
+	vector<string> names;
+	for (auto& i : pending_)
+		names.push_back(i.first);
+
+	for (auto& name : names)
+		resolvePending(name);
+}
+
 // -----------------------------------------------------------------------------
 // Dumps all patch names and the number of matching entries for each
 // -----------------------------------------------------------------------------
 void ResourceManager::listAllPatches()
 {
-	EntryResourceMap::iterator i = patches_.begin();
-	while (i != patches_.end())
-	{
+	resolveAllPending();
+
+	for (auto i : sortedResources(patches_))
 		LOG_MESSAGE(1, "%s (%d)", i->first, i->second.length());
-		++i;
-	}
 }
 
 // -----------------------------------------------------------------------------
@@ -451,9 +614,11 @@ void ResourceManager::listAllPatches()
 // -----------------------------------------------------------------------------
 void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* priority, bool fullPath)
 {
-	for (auto& i : patches_)
+	resolveAllPending();
+
+	for (auto i : sortedResources(patches_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -461,9 +626,9 @@ void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* p
 	if (!fullPath)
 		return;
 
-	for (auto& i : patches_fp_only_)
+	for (auto i : sortedResources(patches_fp_only_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -475,35 +640,11 @@ void ResourceManager::getAllPatchEntries(vector<ArchiveEntry*>& list, Archive* p
 void ResourceManager::getAllTextures(vector<TextureResource::Texture*>& list, Archive* priority, Archive* ignore)
 {
 	// Add all primary textures to the list
-	for (auto& i : textures_)
+	for (auto i : sortedResources(textures_))
 	{
-		// Skip if no entries
-		if (i.second.length() == 0)
-			continue;
-
-		// Go through resource textures
-		TextureResource::Texture* res = i.second.textures_[0].get();
-		for (int a = 0; a < i.second.length(); a++)
-		{
-			res = i.second.textures_[a].get();
-
-			// Skip if it's in the 'ignore' archive
-			if (res->parent == ignore)
-				continue;
-
-			// If it's in the 'priority' archive, exit loop
-			if (priority && i.second.textures_[a]->parent == priority)
-				break;
-
-			// Otherwise, if it's in a 'later' archive than the current resource, set it
-			if (App::archiveManager().archiveIndex(res->parent)
-				<= App::archiveManager().archiveIndex(i.second.textures_[a]->parent))
-				res = i.second.textures_[a].get();
-		}
-
-		// Add texture resource to the list
-		if (res->parent != ignore)
-			list.push_back(res);
+		auto texture = i->second.getTexture(priority, ignore);
+		if (texture)
+			list.push_back(texture);
 	}
 }
 
@@ -513,9 +654,9 @@ void ResourceManager::getAllTextures(vector<TextureResource::Texture*>& list, Ar
 void ResourceManager::getAllTextureNames(vector<string>& list)
 {
 	// Add all primary textures to the list
-	for (auto& i : textures_)
-		if (i.second.length() > 0) // Ignore if no entries
-			list.push_back(i.first);
+	for (auto i : sortedResources(textures_))
+		if (i->second.length() > 0) // Ignore if no entries
+			list.push_back(i->first);
 }
 
 // -----------------------------------------------------------------------------
@@ -523,9 +664,11 @@ void ResourceManager::getAllTextureNames(vector<string>& list)
 // -----------------------------------------------------------------------------
 void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* priority, bool fullPath)
 {
-	for (auto& i : flats_)
+	resolveAllPending();
+
+	for (auto i : sortedResources(flats_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -533,9 +676,9 @@ void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* pr
 	if (!fullPath)
 		return;
 
-	for (auto& i : flats_fp_only_)
+	for (auto i : sortedResources(flats_fp_only_))
 	{
-		auto entry = i.second.getEntry(priority);
+		auto entry = i->second.getEntry(priority);
 		if (entry)
 			list.push_back(entry);
 	}
@@ -546,10 +689,12 @@ void ResourceManager::getAllFlatEntries(vector<ArchiveEntry*>& list, Archive* pr
 // -----------------------------------------------------------------------------
 void ResourceManager::getAllFlatNames(vector<string>& list)
 {
+	resolveAllPending();
+
 	// Add all primary flats to the list
-	for (auto& i : flats_)
-		if (i.second.length() > 0) // Ignore if no entries
-			list.push_back(i.first);
+	for (auto i : sortedResources(flats_))
+		if (i->second.length() > 0) // Ignore if no entries
+			list.push_back(i->first);
 }
 
 // -----------------------------------------------------------------------------
@@ -558,7 +703,11 @@ void ResourceManager::getAllFlatNames(vector<string>& list)
 // -----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getPaletteEntry(const string& palette, Archive* priority)
 {
-	return palettes_[palette.Upper()].getEntry(priority);
+	string name = palette.Upper();
+	resolvePending(name);
+
+	auto res = findResource(palettes_, name);
+	return res ? res->getEntry(priority) : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -575,13 +724,17 @@ ArchiveEntry* ResourceManager::getPatchEntry(const string& patch, const string&
 	if (!nspace.CmpNoCase("textures"))
 		return getTextureEntry(patch, "textures", priority);
 
-	ArchiveEntry* entry = patches_[patch.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	string name = patch.Upper();
+	resolvePending(name);
 
-	entry = patches_fp_[patch.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	auto res = findResource(patches_, name);
+	if (res)
+		if (auto entry = res->getEntry(priority, nspace, true))
+			return entry;
+
+	res = findResource(patches_fp_, name);
+	if (res)
+		return res->getEntry(priority, nspace, true);
 
 	return nullptr;
 }
@@ -592,17 +745,18 @@ ArchiveEntry* ResourceManager::getPatchEntry(const string& patch, const string&
 // -----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getFlatEntry(const string& flat, Archive* priority)
 {
-	// Check resource with matching name exists
-	EntryResource& res = flats_[flat.Upper()];
+	string name = flat.Upper();
+	resolvePending(name);
 
 	// Return most relevant entry
-	ArchiveEntry* entry = res.getEntry(priority);
-	if (entry)
-		return entry;
+	auto res = findResource(flats_, name);
+	if (res)
+		if (auto entry = res->getEntry(priority))
+			return entry;
 
-	entry = flats_fp_[flat.Upper()].getEntry(priority, "flats", true);
-	if (entry)
-		return entry;
+	res = findResource(flats_fp_, name);
+	if (res)
+		return res->getEntry(priority, "flats", true);
 
 	return nullptr;
 }
@@ -613,13 +767,17 @@ ArchiveEntry* ResourceManager::getFlatEntry(const string& flat, Archive* priorit
 // -----------------------------------------------------------------------------
 ArchiveEntry* ResourceManager::getTextureEntry(const string& texture, const string& nspace, Archive* priority)
 {
-	ArchiveEntry* entry = satextures_[texture.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	string name = texture.Upper();
+	resolvePending(name);
+
+	auto res = findResource(satextures_, name);
+	if (res)
+		if (auto entry = res->getEntry(priority, nspace, true))
+			return entry;
 
-	entry = satextures_fp_[texture.Upper()].getEntry(priority, nspace, true);
-	if (entry)
-		return entry;
+	res = findResource(satextures_fp_, name);
+	if (res)
+		return res->getEntry(priority, nspace, true);
 
 	return nullptr;
 }
@@ -630,37 +788,12 @@ ArchiveEntry* ResourceManager::getTextureEntry(const string& texture, const stri
 // -----------------------------------------------------------------------------
 CTexture* ResourceManager::getTexture(const string& texture, Archive* priority, Archive* ignore)
 {
-	// Check texture resource with matching name exists
-	TextureResource& res = textures_[texture.Upper()];
-	if (res.textures_.empty())
+	auto res = findResource(textures_, texture.Upper());
+	if (!res)
 		return nullptr;
 
-	// Go through resource textures
-	CTexture* tex    = &res.textures_[0].get()->tex;
-	Archive*  parent = res.textures_[0].get()->parent;
-	for (auto& res_tex : res.textures_)
-	{
-		// Skip if it's in the 'ignore' archive
-		if (res_tex->parent == ignore)
-			continue;
-
-		// If it's in the 'priority' archive, return it
-		if (priority && res_tex->parent == priority)
-			return &res_tex->tex;
-
-		// Otherwise, if it's in a 'later' archive than the current resource entry, set it
-		if (App::archiveManager().archiveIndex(parent) <= App::archiveManager().archiveIndex(res_tex->parent))
-		{
-			tex    = &res_tex->tex;
-			parent = res_tex->parent;
-		}
-	}
-
-	// Return the most relevant texture
-	if (parent != ignore)
-		return tex;
-	else
-		return nullptr;
+	auto tex = res->getTexture(priority, ignore);
+	return tex ? &tex->tex : nullptr;
 }
 
 // -----------------------------------------------------------------------------
@@ -747,3 +880,74 @@ CONSOLE_COMMAND(test_res_speed, 0, false)
 	float avg = float(times[0] + times[1] + times[2] + times[3] + times[4]) / 5.0f;
 	Log::console(S_FMT("Test took %dms avg", (int)avg));
 }
+
+#include "MapEditor/MapEditContext.h"
+CONSOLE_COMMAND(test_res_lookup, 0, false)
+{
+	// Args: [runs]
+	int runs = 100;
+	if (!args.empty())
+		runs = std::max(1, atoi(CHR(args[0])));
+
+	auto&    map     = MapEditor::editContext().map();
+	auto     head    = MapEditor::editContext().mapDesc().head;
+	Archive* archive = head ? head->getParent() : nullptr;
+
+	// Get all (unique) texture and flat names used in the current map
+	vector<string> textures, flats;
+	for (unsigned a = 0; a < map.nSides(); a++)
+	{
+		auto side = map.getSide(a);
+		textures.push_back(side->getTexUpper().Upper());
+		textures.push_back(side->getTexMiddle().Upper());
+		textures.push_back(side->getTexLower().Upper());
+	}
+	for (unsigned a = 0; a < map.nSectors(); a++)
+	{
+		flats.push_back(map.getSector(a)->getFloorTex().Upper());
+		flats.push_back(map.getSector(a)->getCeilingTex().Upper());
+	}
+	for (auto list : { &textures, &flats })
+	{
+		std::sort(list->begin(), list->end());
+		list->erase(std::unique(list->begin(), list->end()), list->end());
+	}
+	if (textures.empty() && flats.empty())
+	{
+		Log::console("No map open");
+		return;
+	}
+
+	// Resolve them all, in the same order as the map texture manager does
+	unsigned found = 0;
+	auto     start = App::runTimer();
+	for (int run = 0; run < runs; run++)
+	{
+		found = 0;
+		for (auto& name : textures)
+		{
+			if (theResourceManager->getTextureEntry(name, "hires", archive)
+				|| theResourceManager->getTextureEntry(name, "textures", archive)
+				|| theResourceManager->getTexture(name, archive)
+				|| theResourceManager->getPatchEntry(name, "patches", archive))
+				found++;
+		}
+		for (auto& name : flats)
+		{
+			if (theResourceManager->getTextureEntry(name, "hires", archive)
+				|| theResourceManager->getTextureEntry(name, "flats", archive)
+				|| theResourceManager->getFlatEntry(name, archive))
+				found++;
+		}
+	}
+	auto time = App::runTimer() - start;
+
+	Log::console(S_FMT(
+		"%d textures + %d flats (%d found) x%d: %dms (%.3fus per lookup)",
+		(int)textures.size(),
+		(int)flats.size(),
+		found,
+		runs,
+		(int)time,
+		(double)time * 1000.0 / ((double)(textures.size() + flats.size()) * runs)));
+}
@@ -4,6 +4,7 @@
 #include "General/ListenerAnnouncer.h"
 #include "Graphics/CTexture/CTexture.h"
 #include "common.h"
+#include <unordered_map>
 
 class ResourceManager;
 
@@ -32,13 +33,19 @@ public:
 
 	void add(ArchiveEntry::SPtr& entry);
 	void remove(ArchiveEntry::SPtr& entry);
+	void removeArchive(Archive* archive);
 
 	int length() override { return entries_.size(); }
 
 	ArchiveEntry* getEntry(Archive* priority = nullptr, const string& nspace = "", bool ns_required = false);
 
 private:
-	vector<std::weak_ptr<ArchiveEntry>> entries_;
+	struct Candidate
+	{
+		std::weak_ptr<ArchiveEntry> entry;
+		Archive*                    archive;
+	};
+	vector<Candidate> entries_; // Sorted by archive priority (highest first)
 };
 
 class TextureResource : public Resource
@@ -66,12 +73,15 @@ public:
 
 	int length() override { return textures_.size(); }
 
+	Texture* getTexture(Archive* priority = nullptr, Archive* ignore = nullptr);
+
 private:
-	vector<std::unique_ptr<Texture>> textures_;
+	vector<std::unique_ptr<Texture>> textures_; // Sorted by archive priority (highest first)
 };
 
-typedef std::map<string, EntryResource>   EntryResourceMap;
-typedef std::map<string, TextureResource> TextureResourceMap;
+// Resources by (uppercase) name
+typedef std::unordered_map<string, EntryResource, wxStringHash, wxStringEqual>   EntryResourceMap;
+typedef std::unordered_map<string, TextureResource, wxStringHash, wxStringEqual> TextureResourceMap;
 
 class ResourceManager : public Listener, public Announcer
 {
@@ -129,6 +139,10 @@ private:
 	EntryResourceMap satextures_fp_;
 	// EntryResourceMap	satextures_fp_only_; // Probably not needed
 	TextureResourceMap textures_; // Composite textures (defined in a TEXTUREx/TEXTURES lump)
+	EntryResourceMap   pending_;  // Entries with deferred type detection, added when first looked up
+
+	void resolvePending(const string& name);
+	void resolveAllPending();
 
 	static ResourceManager* instance_;
 	static string           doom64_hash_table_[65536];
@@ -32,9 +32,12 @@
 // -----------------------------------------------------------------------------
 #include "Main.h"
 #include "CTexture.h"
+#include "App.h"
 #include "Archive/ArchiveManager.h"
+#include "General/Console/Console.h"
 #include "General/Misc.h"
 #include "General/ResourceManager.h"
+#include "Graphics/Palette/PaletteManager.h"
 #include "Graphics/SImage/SImage.h"
 #include "TextureXList.h"
 #include "Utility/Tokenizer.h"
@@ -1120,3 +1123,80 @@ bool CTexture::loadPatchImage(unsigned pindex, SImage& image, Archive* parent, P
 
 	return false;
 }
+
+
+// -----------------------------------------------------------------------------
+//
+// Console Commands
+//
+// -----------------------------------------------------------------------------
+
+EXTERN_CVAR(Bool, gfx_blit_per_pixel)
+
+// -----------------------------------------------------------------------------
+// Composites all loaded textures [runs] times using both the per-pixel and
+// blitter image drawing paths, reporting the times taken and checking the
+// results match. If [rgba] is given, textures are composited as RGBA
+// -----------------------------------------------------------------------------
+CONSOLE_COMMAND(test_texture_composite, 0, false)
+{
+	// Args: [runs] [rgba]
+	int runs = 3;
+	if (!args.empty())
+		runs = std::max(1, atoi(CHR(args[0])));
+	bool force_rgba = args.size() > 1 && args[1] == "rgba";
+
+	vector<TextureResource::Texture*> textures;
+	theResourceManager->getAllTextures(textures, nullptr);
+	if (textures.empty())
+	{
+		Log::console("No textures loaded");
+		return;
+	}
+
+	// Composite all textures with the per-pixel path then the blitter
+	Palette* pal = App::paletteManager()->globalPalette();
+	bool per_pixel = gfx_blit_per_pixel;
+	vector<MemChunk> results[2];
+	long times[2];
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		gfx_blit_per_pixel = (pass == 0);
+
+		// (MemChunk can't be safely copied/moved, so don't let the vector grow)
+		results[pass].resize(textures.size());
+
+		auto start = App::runTimer();
+		SImage image;
+		for (int run = 0; run < runs; run++)
+		{
+			for (unsigned a = 0; a < textures.size(); a++)
+			{
+				textures[a]->tex.toImage(image, textures[a]->parent, pal, force_rgba);
+
+				// Keep the result of the first run to compare
+				if (run == 0)
+					image.getRGBAData(results[pass][a], pal);
+			}
+		}
+		times[pass] = App::runTimer() - start;
+	}
+	gfx_blit_per_pixel = per_pixel;
+
+	// Compare results
+	int mismatches = 0;
+	for (unsigned a = 0; a < textures.size(); a++)
+	{
+		if (results[0][a].getSize() != results[1][a].getSize()
+			|| memcmp(results[0][a].getData(), results[1][a].getData(), results[0][a].getSize()) != 0)
+		{
+			if (mismatches < 10)
+				Log::console(S_FMT("Texture %s differs", CHR(textures[a]->tex.getName())));
+			mismatches++;
+		}
+	}
+
+	Log::console(S_FMT(
+		"%d textures x%d: per-pixel %dms, blitter %dms, %d mismatches",
+		(int)textures.size(), runs, (int)times[0], (int)times[1], mismatches));
+}
@@ -0,0 +1,158 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    GfxConvert.cpp
+// Description: Batch image format conversion, split into a main thread setup
+//              step and a conversion step that can be run on worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "GfxConvert.h"
+#include "Archive/ArchiveEntry.h"
+#include "General/Misc.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// GfxConvert Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Sets up [job] to convert [entry]. The entry data is copied to the job so it
+// can be decoded on another thread, other than fonts and Jaguar images which
+// need the entry (or its archive) to load, so are decoded here instead
+// -----------------------------------------------------------------------------
+bool GfxConvert::prepare(Job& job, ArchiveEntry* entry, Palette* pal_current, Palette* pal_target)
+{
+	if (!entry)
+		return false;
+
+	// Detect entry type if it isn't already
+	if (entry->getType() == EntryType::unknownType())
+		EntryType::detectEntryType(entry);
+
+	auto type = entry->getType();
+	if (!type->extraProps().propertyExists("image"))
+	{
+		job.error = "Entry type is not a valid image";
+		return false;
+	}
+
+	// Copy palettes
+	if (pal_current)
+		job.pal_current.copyPalette(pal_current);
+	if (pal_target)
+		job.pal_target.copyPalette(pal_target);
+
+	// Fonts and Jaguar images are loaded manually
+	string format = type->formatId();
+	if (format.StartsWith("font_") || format.StartsWith("img_jaguar_"))
+	{
+		if (!Misc::loadImageFromEntry(&job.image, entry))
+		{
+			job.error = Global::error;
+			return false;
+		}
+
+		return true;
+	}
+
+	// Otherwise copy the entry data to decode later
+	if (type->extraProps().propertyExists("image_format"))
+		job.format_hint = type->extraProps()["image_format"].getStringValue();
+	job.try_raw = (format == "img_raw");
+	job.data.importMem(entry->getData(), entry->getSize());
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decodes the image in [job] (if needed), converts it to be writable in
+// [format] and writes it to the job's output data
+// -----------------------------------------------------------------------------
+bool GfxConvert::convert(Job& job, SIFormat* format, SIFormat::ConvertOptions opt)
+{
+	sf::Clock clock;
+
+	// Decode image if needed (the same way as Misc::loadImageFromEntry)
+	if (!job.image.isValid())
+	{
+		bool loaded = job.image.open(job.data, 0, job.format_hint);
+		if (!loaded && job.try_raw && SIFormat::rawFormat()->isThisFormat(job.data))
+			loaded = SIFormat::rawFormat()->loadImage(job.image, job.data);
+		else if (!loaded && SIFormat::generalFormat()->isThisFormat(job.data))
+			loaded = SIFormat::generalFormat()->loadImage(job.image, job.data);
+		job.data.clear();
+
+		if (!loaded)
+		{
+			job.error = "Entry is not a known image format";
+			return false;
+		}
+	}
+
+	// Check the image can be written in the target format
+	if (format->canWrite(job.image) == SIFormat::NOTWRITABLE
+		|| (opt.col_format >= 0 && !format->canWriteType((SIType)opt.col_format)))
+	{
+		job.writable = false;
+		job.error    = S_FMT("Can't be converted to %s", format->getName());
+		return false;
+	}
+
+	// Convert
+	opt.pal_current = &job.pal_current;
+	opt.pal_target  = &job.pal_target;
+	format->convertWritable(job.image, opt);
+
+	// Write
+	if (!format->saveImage(job.image, job.out, &job.pal_target))
+	{
+		job.error = S_FMT("Error writing %s data", format->getName());
+		return false;
+	}
+
+	job.ok   = true;
+	job.time = clock.getElapsedTime().asMilliseconds();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the image colour type matching [name], or -1 if unknown
+// -----------------------------------------------------------------------------
+int GfxConvert::colourType(const string& name)
+{
+	if (S_CMPNOCASE(name, "paletted"))
+		return PALMASK;
+	else if (S_CMPNOCASE(name, "truecolour") || S_CMPNOCASE(name, "rgba"))
+		return RGBA;
+	else if (S_CMPNOCASE(name, "alphamap"))
+		return ALPHAMAP;
+
+	return -1;
+}
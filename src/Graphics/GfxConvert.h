@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Graphics/Palette/Palette.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "Graphics/SImage/SImage.h"
+#include <functional>
+
+class ArchiveEntry;
+
+// Batch image format conversion.
+//
+// Each image to convert is set up as a Job on the main thread with prepare()
+// (which copies everything needed from the entry), after which convert() can
+// be run on any thread to decode, convert (palette mapping, transparency) and
+// encode the image. Committing the result back to the entry is left to the
+// caller, on the main thread
+namespace GfxConvert
+{
+struct Job
+{
+	MemChunk data;            // Source image data (empty if already decoded)
+	string   format_hint;     // Image format id from the entry type, if any
+	bool     try_raw = false; // Try reading as a raw image if the format can't be detected
+	SImage   image;
+	Palette  pal_current;
+	Palette  pal_target;
+	MemChunk out; // Converted image data
+	bool     ok       = false;
+	bool     writable = true; // False if the image can't be written in the target format
+	string   error;
+	long     time = 0; // Time taken to convert in ms
+};
+
+// Gets the conversion options (including palettes) to use for an entry
+typedef std::function<void(ArchiveEntry*, SIFormat::ConvertOptions&)> OptionsFunc;
+
+// Sets up [job] to convert [entry], with [pal_current] and [pal_target] as the
+// source/target palettes (copied, if given). Must be called on the main thread.
+// Returns false if [entry] isn't an image
+bool prepare(Job& job, ArchiveEntry* entry, Palette* pal_current, Palette* pal_target);
+
+// Converts the image in [job] to [format] with [opt] (palettes are taken from
+// the job). Can be called from a worker thread
+bool convert(Job& job, SIFormat* format, SIFormat::ConvertOptions opt);
+
+// Returns the image colour type matching [name] ('paletted', 'truecolour' or
+// 'alphamap'), or -1 if unknown
+int colourType(const string& name);
+} // namespace GfxConvert
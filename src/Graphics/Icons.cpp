@@ -34,6 +34,8 @@
 #include "App.h"
 #include "Archive/ArchiveManager.h"
 #include "General/UI.h"
+#include "Utility/ThreadPool.h"
+#include <wx/mstream.h>
 
 
 // -----------------------------------------------------------------------------
@@ -112,87 +114,78 @@ bool loadIconsDir(int type, ArchiveTreeNode* dir)
 	if (icon_set_dir != "Default" && dir->getChild(icon_set_dir))
 		dir = (ArchiveTreeNode*)dir->getChild(icon_set_dir);
 
-	vector<Icon>& icons    = iconList(type);
-	string        tempfile = App::path("sladetemp", App::Dir::Temp);
+	vector<Icon>& icons = iconList(type);
 
-	// Go through each entry in the directory
-	for (size_t a = 0; a < dir->numEntries(false); a++)
+	// Get icon png entries (and make sure their data is loaded, since the
+	// images are decoded on worker threads)
+	auto get_png_entries = [](ArchiveTreeNode* dir) {
+		vector<ArchiveEntry*> entries;
+		for (size_t a = 0; dir && a < dir->numEntries(false); a++)
+		{
+			auto entry = dir->entryAt(a);
+			if (entry->getName().EndsWith("png"))
+			{
+				entry->getMCData();
+				entries.push_back(entry);
+			}
+		}
+		return entries;
+	};
+	auto entries       = get_png_entries(dir);
+	auto entries_large = get_png_entries((ArchiveTreeNode*)dir->getChild("large"));
+
+	// Decode all icon images from entry data
+	vector<wxImage> images(entries.size() + entries_large.size());
+	ThreadPool::global().parallelFor(images.size(), [&](size_t index) {
+		auto                entry = index < entries.size() ? entries[index] : entries_large[index - entries.size()];
+		wxMemoryInputStream stream(entry->getData(), entry->getSize());
+		images[index].LoadFile(stream, wxBITMAP_TYPE_PNG);
+	});
+
+	// Add icons
+	for (size_t a = 0; a < entries.size(); a++)
 	{
-		ArchiveEntry* entry = dir->entryAt(a);
-
-		// Ignore anything not png format
-		if (!entry->getName().EndsWith("png"))
-			continue;
-
-		// Export entry data to a temporary file
-		entry->exportFile(tempfile);
-
-		// Create / setup icon
 		Icon n_icon;
-		n_icon.image.LoadFile(tempfile);              // Load image from temp file
-		n_icon.name           = entry->getName(true); // Set icon name
-		n_icon.resource_entry = entry;
-
-		// Add the icon
+		n_icon.image          = images[a];
+		n_icon.name           = entries[a]->getName(true);
+		n_icon.resource_entry = entries[a];
 		icons.push_back(n_icon);
-
-		// Delete the temporary file
-		wxRemoveFile(tempfile);
 	}
 
-	// Go through large icons
-	ArchiveTreeNode* dir_large = (ArchiveTreeNode*)dir->getChild("large");
-	if (dir_large)
+	// Add large icons
+	for (size_t a = 0; a < entries_large.size(); a++)
 	{
-		for (size_t a = 0; a < dir_large->numEntries(false); a++)
+		auto&  image = images[entries.size() + a];
+		bool   found = false;
+		string name  = entries_large[a]->getName(true);
+		for (unsigned i = 0; i < icons.size(); i++)
 		{
-			ArchiveEntry* entry = dir_large->entryAt(a);
-
-			// Ignore anything not png format
-			if (!entry->getName().EndsWith("png"))
-				continue;
-
-			// Export entry data to a temporary file
-			entry->exportFile(tempfile);
-
-			// Create / setup icon
-			bool   found = false;
-			string name  = entry->getName(true);
-			for (unsigned i = 0; i < icons.size(); i++)
-			{
-				if (icons[i].name == name)
-				{
-					icons[i].image_large.LoadFile(tempfile);
-					found = true;
-					break;
-				}
-			}
-
-			if (!found)
+			if (icons[i].name == name)
 			{
-				Icon n_icon;
-				n_icon.image_large.LoadFile(tempfile);        // Load image from temp file
-				n_icon.name           = entry->getName(true); // Set icon name
-				n_icon.resource_entry = entry;
-
-				// Add the icon
-				icons.push_back(n_icon);
+				icons[i].image_large = image;
+				found                = true;
+				break;
 			}
+		}
 
-			// Delete the temporary file
-			wxRemoveFile(tempfile);
+		if (!found)
+		{
+			Icon n_icon;
+			n_icon.image_large    = image;
+			n_icon.name           = name;
+			n_icon.resource_entry = entries_large[a];
+			icons.push_back(n_icon);
 		}
 	}
 
 	// Generate any missing large icons
-	for (unsigned a = 0; a < icons.size(); a++)
-	{
+	ThreadPool::global().parallelFor(icons.size(), [&](size_t a) {
 		if (!icons[a].image_large.IsOk())
 		{
 			icons[a].image_large = icons[a].image.Copy();
 			icons[a].image_large.Rescale(32, 32, wxIMAGE_QUALITY_BICUBIC);
 		}
-	}
+	});
 
 	return true;
 }
@@ -203,8 +196,6 @@ bool loadIconsDir(int type, ArchiveTreeNode* dir)
 // -----------------------------------------------------------------------------
 bool Icons::loadIcons()
 {
-	string tempfile = App::path("sladetemp", App::Dir::Temp);
-
 	// Get slade.pk3
 	Archive* res_archive = App::archiveManager().programResourceArchive();
 
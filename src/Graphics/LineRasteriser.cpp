@@ -0,0 +1,224 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    LineRasteriser.cpp
+// Description: LineRasteriser class, draws anti-aliased lines into an image
+//              on the CPU, split into tiles drawn across worker threads
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "LineRasteriser.h"
+#include "Graphics/SImage/SImage.h"
+#include "Utility/ThreadPool.h"
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// -----------------------------------------------------------------------------
+// Blends [colour] over the RGBA [pixel] with [alpha] (0-1)
+// -----------------------------------------------------------------------------
+inline void blendPixel(uint8_t* pixel, const rgba_t& colour, double alpha)
+{
+	pixel[0] = (uint8_t)(pixel[0] + (colour.r - pixel[0]) * alpha + 0.5);
+	pixel[1] = (uint8_t)(pixel[1] + (colour.g - pixel[1]) * alpha + 0.5);
+	pixel[2] = (uint8_t)(pixel[2] + (colour.b - pixel[2]) * alpha + 0.5);
+	pixel[3] = (uint8_t)(pixel[3] + (255 - pixel[3]) * alpha + 0.5);
+}
+
+// -----------------------------------------------------------------------------
+// Returns the distance from [px,py] to the line segment [x1,y1]-[x2,y2]
+// -----------------------------------------------------------------------------
+inline double distanceToSegment(double px, double py, double x1, double y1, double x2, double y2)
+{
+	double dx   = x2 - x1;
+	double dy   = y2 - y1;
+	double len2 = dx * dx + dy * dy;
+	double u    = len2 > 0 ? ((px - x1) * dx + (py - y1) * dy) / len2 : 0;
+	u           = std::max(0.0, std::min(1.0, u));
+
+	double ex = px - (x1 + u * dx);
+	double ey = py - (y1 + u * dy);
+	return sqrt(ex * ex + ey * ey);
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// LineRasteriser Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// LineRasteriser class constructor
+// -----------------------------------------------------------------------------
+LineRasteriser::LineRasteriser(int width, int height) : width_{ width }, height_{ height } {}
+
+// -----------------------------------------------------------------------------
+// Adds a line from [x1,y1] to [x2,y2] (in pixels, from the top-left of the
+// image) to be drawn in [colour]
+// -----------------------------------------------------------------------------
+void LineRasteriser::addLine(double x1, double y1, double x2, double y2, rgba_t colour, double thickness)
+{
+	lines_.push_back({ x1, y1, x2, y2, thickness * 0.5, colour });
+}
+
+// -----------------------------------------------------------------------------
+// Draws all added lines over a [background] filled image, and writes it to
+// [image] as RGBA. If [parallel] is true, tiles are drawn on the global thread
+// pool, otherwise on the calling thread
+// -----------------------------------------------------------------------------
+bool LineRasteriser::render(SImage& image, rgba_t background, bool parallel) const
+{
+	if (width_ <= 0 || height_ <= 0)
+		return false;
+
+	// Fill background
+	size_t   n_pixels = (size_t)width_ * height_;
+	uint8_t* pixels   = new uint8_t[n_pixels * 4];
+	for (size_t a = 0; a < n_pixels; a++)
+	{
+		pixels[a * 4]     = background.r;
+		pixels[a * 4 + 1] = background.g;
+		pixels[a * 4 + 2] = background.b;
+		pixels[a * 4 + 3] = background.a;
+	}
+
+	// Bin lines into the tiles they cross, keeping them in order
+	int                      tiles_x = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+	int                      tiles_y = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+	vector<vector<unsigned>> tiles(tiles_x * tiles_y);
+	double                   tile_radius = TILE_SIZE * 0.7072; // Half tile diagonal
+	for (unsigned a = 0; a < lines_.size(); a++)
+	{
+		auto&  line   = lines_[a];
+		double extent = line.radius + 1.0;
+
+		// Get range of tiles covered by the line's bounding box
+		int tx1 = (int)floor((std::min(line.x1, line.x2) - extent) / TILE_SIZE);
+		int ty1 = (int)floor((std::min(line.y1, line.y2) - extent) / TILE_SIZE);
+		int tx2 = (int)floor((std::max(line.x1, line.x2) + extent) / TILE_SIZE);
+		int ty2 = (int)floor((std::max(line.y1, line.y2) + extent) / TILE_SIZE);
+		if (tx2 < 0 || ty2 < 0 || tx1 >= tiles_x || ty1 >= tiles_y)
+			continue;
+		tx1 = std::max(tx1, 0);
+		ty1 = std::max(ty1, 0);
+		tx2 = std::min(tx2, tiles_x - 1);
+		ty2 = std::min(ty2, tiles_y - 1);
+
+		// Add to each tile in range that the line actually passes near
+		for (int ty = ty1; ty <= ty2; ty++)
+			for (int tx = tx1; tx <= tx2; tx++)
+			{
+				double cx = (tx + 0.5) * TILE_SIZE;
+				double cy = (ty + 0.5) * TILE_SIZE;
+				if (distanceToSegment(cx, cy, line.x1, line.y1, line.x2, line.y2) <= tile_radius + extent)
+					tiles[ty * tiles_x + tx].push_back(a);
+			}
+	}
+
+	// Draw tiles
+	auto draw_tile = [&](size_t index) {
+		int x1 = (int)(index % tiles_x) * TILE_SIZE;
+		int y1 = (int)(index / tiles_x) * TILE_SIZE;
+		int x2 = std::min(x1 + TILE_SIZE, width_);
+		int y2 = std::min(y1 + TILE_SIZE, height_);
+		for (auto line : tiles[index])
+			drawLine(lines_[line], pixels, x1, y1, x2, y2);
+	};
+	if (parallel)
+		ThreadPool::global().parallelFor(tiles.size(), draw_tile);
+	else
+		for (size_t a = 0; a < tiles.size(); a++)
+			draw_tile(a);
+
+	image.setImageData(pixels, width_, height_, RGBA);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Draws [line] into [pixels], only within the clip rectangle [clip_x1,clip_y1]
+// to [clip_x2,clip_y2] (exclusive). Each pixel's coverage is worked out from
+// its distance to the line, so lines are anti-aliased and capped at the ends
+// -----------------------------------------------------------------------------
+void LineRasteriser::drawLine(
+	const Line& line,
+	uint8_t*    pixels,
+	int         clip_x1,
+	int         clip_y1,
+	int         clip_x2,
+	int         clip_y2) const
+{
+	// Distance from the line at which coverage reaches 0
+	double extent = line.radius + 0.5;
+
+	// Step along the major axis (a), drawing a short run of pixels across the
+	// minor axis (b) at each step
+	bool   steep   = fabs(line.y2 - line.y1) > fabs(line.x2 - line.x1);
+	double a1      = steep ? line.y1 : line.x1;
+	double b1      = steep ? line.x1 : line.y1;
+	double a2      = steep ? line.y2 : line.x2;
+	double b2      = steep ? line.x2 : line.y2;
+	int    clip_a1 = steep ? clip_y1 : clip_x1;
+	int    clip_a2 = steep ? clip_y2 : clip_x2;
+	int    clip_b1 = steep ? clip_x1 : clip_y1;
+	int    clip_b2 = steep ? clip_x2 : clip_y2;
+	double da      = a2 - a1;
+	double db      = b2 - b1;
+
+	// Half the width of the run across the minor axis, at most extent * sqrt(2)
+	double run = extent * (da != 0 ? sqrt(da * da + db * db) / fabs(da) : 1.0) + 1.0;
+
+	int start = std::max(clip_a1, (int)floor(std::min(a1, a2) - extent));
+	int end   = std::min(clip_a2 - 1, (int)ceil(std::max(a1, a2) + extent));
+	for (int a = start; a <= end; a++)
+	{
+		// Get the line's position on the minor axis at this pixel
+		double pa = a + 0.5;
+		double t  = da != 0 ? std::max(0.0, std::min(1.0, (pa - a1) / da)) : 0.0;
+		double bc = b1 + t * db;
+
+		int run_start = std::max(clip_b1, (int)floor(bc - run));
+		int run_end   = std::min(clip_b2 - 1, (int)ceil(bc + run));
+		for (int b = run_start; b <= run_end; b++)
+		{
+			double coverage = extent - distanceToSegment(pa, b + 0.5, a1, b1, a2, b2);
+			if (coverage <= 0)
+				continue;
+
+			int x = steep ? b : a;
+			int y = steep ? a : b;
+			blendPixel(
+				pixels + ((size_t)y * width_ + x) * 4, line.colour, line.colour.a / 255.0 * std::min(coverage, 1.0));
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+class SImage;
+
+// Draws anti-aliased lines into an RGBA image on the CPU, for when rendering
+// via OpenGL isn't possible (eg. no GL context). Lines are drawn in the order
+// they were added. The image is split into tiles which are drawn in parallel
+// on the global thread pool, each tile only drawing the lines that cross it
+class LineRasteriser
+{
+public:
+	LineRasteriser(int width, int height);
+	~LineRasteriser() = default;
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+
+	void addLine(double x1, double y1, double x2, double y2, rgba_t colour, double thickness = 1.0);
+	void clear() { lines_.clear(); }
+
+	bool render(SImage& image, rgba_t background, bool parallel = true) const;
+
+private:
+	static const int TILE_SIZE = 64;
+
+	struct Line
+	{
+		double x1, y1, x2, y2;
+		double radius; // Half thickness
+		rgba_t colour;
+	};
+
+	int          width_;
+	int          height_;
+	vector<Line> lines_;
+
+	void drawLine(const Line& line, uint8_t* pixels, int clip_x1, int clip_y1, int clip_x2, int clip_y2) const;
+};
@@ -0,0 +1,910 @@
+
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    PNGOptimiser.cpp
+// Description: Lossless PNG optimiser, re-encodes PNG data in the smallest
+//              lossless pixel format with the best filter/compression
+//              settings found
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "PNGOptimiser.h"
+#include "External/zlib/zlib.h"
+#include "General/Misc.h"
+#include "Utility/MemChunk.h"
+#include "Utility/ThreadPool.h"
+#include <unordered_map>
+
+
+// -----------------------------------------------------------------------------
+//
+// Constants
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+const uint8_t PNG_SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+enum ColourType
+{
+	Grey      = 0,
+	RGB       = 2,
+	Paletted  = 3,
+	GreyAlpha = 4,
+	RGBA      = 6
+};
+
+// Adam7 interlacing passes
+const uint32_t ADAM7_X[7]  = { 0, 4, 0, 2, 0, 1, 0 };
+const uint32_t ADAM7_Y[7]  = { 0, 0, 4, 0, 2, 0, 1 };
+const uint32_t ADAM7_DX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+const uint32_t ADAM7_DY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+// Scanline filter heuristics tried (0-4 are the PNG filter types used for all
+// rows, ADAPTIVE picks the filter with the minimum sum of absolute differences
+// for each row)
+const int N_FILTERS = 6;
+const int ADAPTIVE  = 5;
+
+// zlib level/strategy combinations tried
+struct DeflateSettings
+{
+	int level;
+	int strategy;
+};
+const DeflateSettings DEFLATE_SETTINGS[] = {
+	{ 9, Z_DEFAULT_STRATEGY },
+	{ 9, Z_FILTERED },
+	{ 9, Z_RLE },
+	{ 6, Z_DEFAULT_STRATEGY },
+};
+const int N_DEFLATE_SETTINGS = sizeof(DEFLATE_SETTINGS) / sizeof(DeflateSettings);
+
+// Maximum number of pixels in an image that will be optimised
+const size_t MAX_PIXELS = 1 << 24;
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Structs
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// An ancillary chunk copied from the original PNG
+struct Chunk
+{
+	char            type[4];
+	vector<uint8_t> data;
+	int             position; // 0 = before PLTE, 1 = after PLTE, 2 = after IDAT
+};
+
+// A parsed and decoded PNG
+struct PNGImage
+{
+	uint32_t         width       = 0;
+	uint32_t         height      = 0;
+	uint8_t          depth       = 0;
+	uint8_t          colour_type = 0;
+	uint8_t          interlace   = 0;
+	vector<uint8_t>  palette;
+	vector<uint8_t>  trans;
+	vector<uint8_t>  idat;
+	vector<Chunk>    chunks;
+	vector<uint16_t> samples; // Decoded samples (channels(colour_type) per pixel)
+};
+
+// A lossless pixel format (and the image's scanlines in it) to try encoding
+struct Format
+{
+	uint8_t         colour_type = 0;
+	uint8_t         depth       = 0;
+	vector<uint8_t> palette;
+	vector<uint8_t> trans;
+	vector<uint8_t> rows;   // Unfiltered scanlines
+	size_t          stride; // Bytes per scanline
+	unsigned        bpp;    // Bytes per complete pixel (at least 1), for filtering
+};
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+uint32_t readUInt32(const uint8_t* data)
+{
+	return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+void writeUInt32(uint8_t* data, uint32_t value)
+{
+	data[0] = value >> 24;
+	data[1] = value >> 16;
+	data[2] = value >> 8;
+	data[3] = value;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the number of samples per pixel for [colour_type]
+// -----------------------------------------------------------------------------
+unsigned channels(uint8_t colour_type)
+{
+	switch (colour_type)
+	{
+	case RGB: return 3;
+	case GreyAlpha: return 2;
+	case RGBA: return 4;
+	default: return 1;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Returns sample [index] from scanline [row] with a bit [depth]
+// -----------------------------------------------------------------------------
+uint16_t readSample(const uint8_t* row, size_t index, uint8_t depth)
+{
+	if (depth == 8)
+		return row[index];
+	if (depth == 16)
+		return row[index * 2] << 8 | row[index * 2 + 1];
+
+	size_t bit = index * depth;
+	return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+}
+
+// -----------------------------------------------------------------------------
+// Writes sample [index] to scanline [row] with a bit [depth]. Rows with a
+// depth less than 8 must be zeroed beforehand
+// -----------------------------------------------------------------------------
+void writeSample(uint8_t* row, size_t index, uint8_t depth, uint16_t value)
+{
+	if (depth == 8)
+		row[index] = value;
+	else if (depth == 16)
+	{
+		row[index * 2]     = value >> 8;
+		row[index * 2 + 1] = value & 0xFF;
+	}
+	else
+	{
+		size_t bit = index * depth;
+		row[bit >> 3] |= value << (8 - depth - (bit & 7));
+	}
+}
+
+uint8_t paeth(int a, int b, int c)
+{
+	int p  = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+// -----------------------------------------------------------------------------
+// Reverses filter [type] on scanline [row] of [length] bytes, given the
+// previous (unfiltered) scanline [prev]. Returns false if [type] is invalid
+// -----------------------------------------------------------------------------
+bool unfilterRow(uint8_t* row, const uint8_t* prev, size_t length, unsigned bpp, uint8_t type)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		int a = i >= bpp ? row[i - bpp] : 0;
+		int b = prev[i];
+		int c = i >= bpp ? prev[i - bpp] : 0;
+		switch (type)
+		{
+		case 0: break;
+		case 1: row[i] += a; break;
+		case 2: row[i] += b; break;
+		case 3: row[i] += (a + b) >> 1; break;
+		case 4: row[i] += paeth(a, b, c); break;
+		default: return false;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Applies filter [type] to scanline [row] of [length] bytes, given the previous
+// scanline [prev], writing the result to [out]
+// -----------------------------------------------------------------------------
+void filterRow(uint8_t* out, const uint8_t* row, const uint8_t* prev, size_t length, unsigned bpp, uint8_t type)
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		int a = i >= bpp ? row[i - bpp] : 0;
+		int b = prev[i];
+		int c = i >= bpp ? prev[i - bpp] : 0;
+		switch (type)
+		{
+		case 1: out[i] = row[i] - a; break;
+		case 2: out[i] = row[i] - b; break;
+		case 3: out[i] = row[i] - ((a + b) >> 1); break;
+		case 4: out[i] = row[i] - paeth(a, b, c); break;
+		default: out[i] = row[i]; break;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Reads the chunks of PNG [data] into [png].
+// Returns false and sets [error] if the PNG is invalid or can't be optimised
+// -----------------------------------------------------------------------------
+bool parsePNG(const uint8_t* data, size_t size, PNGImage& png, string& error)
+{
+	if (size < 8 || memcmp(data, PNG_SIGNATURE, 8) != 0)
+	{
+		error = "Not a PNG";
+		return false;
+	}
+
+	size_t pos      = 8;
+	int    position = 0;
+	bool   ihdr     = false;
+	while (pos + 12 <= size)
+	{
+		uint32_t       length = readUInt32(data + pos);
+		const uint8_t* type   = data + pos + 4;
+		const uint8_t* cdata  = data + pos + 8;
+		if (length > size - pos - 12)
+		{
+			error = "Invalid chunk size";
+			return false;
+		}
+		pos += length + 12;
+
+		if (memcmp(type, "IHDR", 4) == 0)
+		{
+			if (length != 13)
+			{
+				error = "Invalid IHDR chunk";
+				return false;
+			}
+			png.width       = readUInt32(cdata);
+			png.height      = readUInt32(cdata + 4);
+			png.depth       = cdata[8];
+			png.colour_type = cdata[9];
+			png.interlace   = cdata[12];
+			if (cdata[10] != 0 || cdata[11] != 0 || png.interlace > 1)
+			{
+				error = "Unsupported compression, filter or interlace method";
+				return false;
+			}
+			ihdr = true;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			png.palette.assign(cdata, cdata + length);
+			position = 1;
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+			png.trans.assign(cdata, cdata + length);
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			png.idat.insert(png.idat.end(), cdata, cdata + length);
+			position = 2;
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+			break;
+		else if (memcmp(type, "acTL", 4) == 0)
+		{
+			error = "Animated PNGs are not supported";
+			return false;
+		}
+		else if (!(type[0] & 0x20))
+		{
+			error = S_FMT("Unknown critical chunk %c%c%c%c", type[0], type[1], type[2], type[3]);
+			return false;
+		}
+		else
+		{
+			// Ancillary chunk, keep it
+			png.chunks.emplace_back();
+			auto& chunk = png.chunks.back();
+			memcpy(chunk.type, type, 4);
+			chunk.data.assign(cdata, cdata + length);
+			chunk.position = position;
+		}
+	}
+
+	// Check the header is valid
+	if (!ihdr || png.width == 0 || png.height == 0 || png.idat.empty())
+	{
+		error = "Missing IHDR or IDAT chunk";
+		return false;
+	}
+	auto d  = png.depth;
+	auto ct = png.colour_type;
+	if (!((ct == Grey && (d == 1 || d == 2 || d == 4 || d == 8 || d == 16))
+		  || (ct == Paletted && (d == 1 || d == 2 || d == 4 || d == 8))
+		  || ((ct == RGB || ct == GreyAlpha || ct == RGBA) && (d == 8 || d == 16))))
+	{
+		error = "Invalid colour type/bit depth";
+		return false;
+	}
+	if (ct == Paletted && (png.palette.empty() || png.palette.size() % 3 != 0 || png.palette.size() > 768))
+	{
+		error = "Invalid palette";
+		return false;
+	}
+	if ((ct == Grey && !png.trans.empty() && png.trans.size() != 2)
+		|| (ct == RGB && !png.trans.empty() && png.trans.size() != 6)
+		|| (ct == Paletted && png.trans.size() * 3 > png.palette.size()))
+	{
+		error = "Invalid tRNS chunk";
+		return false;
+	}
+	if ((size_t)png.width * png.height > MAX_PIXELS)
+	{
+		error = "Image is too large";
+		return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Decompresses and unfilters the image data of [png] into its samples.
+// Returns false and sets [error] if the image data is invalid
+// -----------------------------------------------------------------------------
+bool decodePNG(PNGImage& png, string& error)
+{
+	unsigned n_channels = channels(png.colour_type);
+	unsigned bits       = n_channels * png.depth;
+	unsigned bpp        = std::max(1u, bits / 8);
+	unsigned passes     = png.interlace ? 7 : 1;
+
+	// Determine size of each interlace pass
+	uint32_t pass_width[7], pass_height[7];
+	size_t   raw_size = 0;
+	for (unsigned p = 0; p < passes; ++p)
+	{
+		auto x0 = png.interlace ? ADAM7_X[p] : 0;
+		auto y0 = png.interlace ? ADAM7_Y[p] : 0;
+		auto dx = png.interlace ? ADAM7_DX[p] : 1;
+		auto dy = png.interlace ? ADAM7_DY[p] : 1;
+
+		pass_width[p]  = png.width > x0 ? (png.width - x0 + dx - 1) / dx : 0;
+		pass_height[p] = png.height > y0 ? (png.height - y0 + dy - 1) / dy : 0;
+		if (pass_width[p] > 0 && pass_height[p] > 0)
+			raw_size += pass_height[p] * (((size_t)pass_width[p] * bits + 7) / 8 + 1);
+	}
+
+	// Decompress
+	vector<uint8_t> raw(raw_size);
+	uLongf          raw_length = raw_size;
+	if (uncompress(raw.data(), &raw_length, png.idat.data(), png.idat.size()) != Z_OK || raw_length != raw_size)
+	{
+		error = "Invalid image data";
+		return false;
+	}
+
+	// Unfilter and read samples
+	png.samples.resize((size_t)png.width * png.height * n_channels);
+	uint8_t* row = raw.data();
+	for (unsigned p = 0; p < passes; ++p)
+	{
+		if (pass_width[p] == 0 || pass_height[p] == 0)
+			continue;
+
+		size_t          length = ((size_t)pass_width[p] * bits + 7) / 8;
+		vector<uint8_t> zero(length, 0);
+		const uint8_t*  prev = zero.data();
+		for (uint32_t y = 0; y < pass_height[p]; ++y)
+		{
+			if (!unfilterRow(row + 1, prev, length, bpp, row[0]))
+			{
+				error = "Invalid filter type";
+				return false;
+			}
+
+			auto py = png.interlace ? ADAM7_Y[p] + y * ADAM7_DY[p] : y;
+			for (uint32_t x = 0; x < pass_width[p]; ++x)
+			{
+				auto   px  = png.interlace ? ADAM7_X[p] + x * ADAM7_DX[p] : x;
+				size_t out = ((size_t)py * png.width + px) * n_channels;
+				for (unsigned c = 0; c < n_channels; ++c)
+					png.samples[out + c] = readSample(row + 1, (size_t)x * n_channels + c, png.depth);
+			}
+
+			prev = row + 1;
+			row += length + 1;
+		}
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Sets up the scanlines of [format] for an image [width] pixels wide, and
+// returns a pointer to the start of them
+// -----------------------------------------------------------------------------
+uint8_t* initRows(Format& format, uint32_t width, uint32_t height)
+{
+	unsigned bits = channels(format.colour_type) * format.depth;
+	format.stride = ((size_t)width * bits + 7) / 8;
+	format.bpp    = std::max(1u, bits / 8);
+	format.rows.assign(format.stride * height, 0);
+	return format.rows.data();
+}
+
+// -----------------------------------------------------------------------------
+// Returns the lossless pixel formats to try encoding [png] in
+// -----------------------------------------------------------------------------
+vector<Format> buildFormats(const PNGImage& png)
+{
+	vector<Format> formats;
+	size_t         n_pixels = (size_t)png.width * png.height;
+
+	// Paletted images keep their palette (and bit depth, since the palette
+	// size depends on it)
+	if (png.colour_type == Paletted)
+	{
+		formats.emplace_back();
+		auto& format       = formats.back();
+		format.colour_type = Paletted;
+		format.depth       = png.depth;
+		format.palette     = png.palette;
+		format.trans       = png.trans;
+
+		// Trailing opaque tRNS entries aren't needed
+		while (!format.trans.empty() && format.trans.back() == 255)
+			format.trans.pop_back();
+
+		auto rows = initRows(format, png.width, png.height);
+		for (size_t p = 0; p < n_pixels; ++p)
+			writeSample(rows + (p / png.width) * format.stride, p % png.width, format.depth, png.samples[p]);
+
+		return formats;
+	}
+
+	// Convert to RGBA
+	unsigned         n_channels = channels(png.colour_type);
+	uint16_t         max_value  = (1 << png.depth) - 1;
+	vector<uint16_t> rgba(n_pixels * 4);
+	for (size_t p = 0; p < n_pixels; ++p)
+	{
+		auto in  = &png.samples[p * n_channels];
+		auto out = &rgba[p * 4];
+		switch (png.colour_type)
+		{
+		case Grey:
+			out[0] = out[1] = out[2] = in[0];
+			out[3] = !png.trans.empty() && in[0] == readSample(png.trans.data(), 0, 16) ? 0 : max_value;
+			break;
+		case RGB:
+			out[0] = in[0];
+			out[1] = in[1];
+			out[2] = in[2];
+			out[3] = !png.trans.empty() && in[0] == readSample(png.trans.data(), 0, 16)
+							 && in[1] == readSample(png.trans.data(), 1, 16)
+							 && in[2] == readSample(png.trans.data(), 2, 16) ?
+						 0 :
+						 max_value;
+			break;
+		case GreyAlpha:
+			out[0] = out[1] = out[2] = in[0];
+			out[3]                   = in[1];
+			break;
+		default:
+			out[0] = in[0];
+			out[1] = in[1];
+			out[2] = in[2];
+			out[3] = in[3];
+			break;
+		}
+	}
+
+	// Reduce to 8-bit samples if possible
+	bool wide = png.depth == 16;
+	if (wide)
+	{
+		wide = false;
+		for (auto v : rgba)
+			if ((v >> 8) != (v & 0xFF))
+			{
+				wide = true;
+				break;
+			}
+
+		if (!wide)
+			for (auto& v : rgba)
+				v >>= 8;
+	}
+	else if (png.depth < 8)
+	{
+		for (auto& v : rgba)
+			v *= 255 / max_value;
+	}
+	max_value = wide ? 65535 : 255;
+
+	// Check for alpha and colour
+	bool opaque = true;
+	bool grey   = true;
+	for (size_t p = 0; p < n_pixels; ++p)
+	{
+		auto col = &rgba[p * 4];
+		if (col[3] != max_value)
+			opaque = false;
+		if (col[0] != col[1] || col[0] != col[2])
+			grey = false;
+	}
+
+	// Check if transparency can be done with a single fully transparent colour
+	bool     key_trans = false;
+	uint16_t key[3]    = { 0, 0, 0 };
+	if (!opaque)
+	{
+		key_trans    = true;
+		bool have_key = false;
+		for (size_t p = 0; p < n_pixels && key_trans; ++p)
+		{
+			auto col = &rgba[p * 4];
+			if (col[3] == 0)
+			{
+				if (!have_key)
+				{
+					key[0]   = col[0];
+					key[1]   = col[1];
+					key[2]   = col[2];
+					have_key = true;
+				}
+				else if (col[0] != key[0] || col[1] != key[1] || col[2] != key[2])
+					key_trans = false;
+			}
+			else if (col[3] != max_value)
+				key_trans = false;
+		}
+		for (size_t p = 0; p < n_pixels && key_trans; ++p)
+		{
+			auto col = &rgba[p * 4];
+			if (col[3] != 0 && col[0] == key[0] && col[1] == key[1] && col[2] == key[2])
+				key_trans = false;
+		}
+	}
+	bool alpha = !opaque && !key_trans;
+
+	// Truecolour/greyscale format
+	{
+		formats.emplace_back();
+		auto& format       = formats.back();
+		format.colour_type = grey ? (alpha ? GreyAlpha : Grey) : (alpha ? RGBA : RGB);
+		format.depth       = wide ? 16 : 8;
+
+		// Use the lowest bit depth possible for greyscale
+		uint16_t scale = 1;
+		if (format.colour_type == Grey && !wide)
+		{
+			for (uint8_t depth = 1; depth < 8; depth *= 2)
+			{
+				uint16_t s     = 255 / ((1 << depth) - 1);
+				bool     exact = true;
+				for (size_t p = 0; p < n_pixels && exact; ++p)
+					exact = rgba[p * 4] % s == 0;
+
+				if (exact)
+				{
+					format.depth = depth;
+					scale        = s;
+					break;
+				}
+			}
+		}
+
+		// Transparent colour
+		if (key_trans)
+		{
+			unsigned n_key = grey ? 1 : 3;
+			format.trans.assign(n_key * 2, 0);
+			for (unsigned c = 0; c < n_key; ++c)
+				writeSample(format.trans.data(), c, 16, key[c] / scale);
+		}
+
+		auto     rows        = initRows(format, png.width, png.height);
+		unsigned out_channels = channels(format.colour_type);
+		for (size_t p = 0; p < n_pixels; ++p)
+		{
+			auto row = rows + (p / png.width) * format.stride;
+			auto x   = p % png.width;
+			auto col = &rgba[p * 4];
+			switch (format.colour_type)
+			{
+			case Grey: writeSample(row, x, format.depth, col[0] / scale); break;
+			case GreyAlpha:
+				writeSample(row, x * 2, format.depth, col[0]);
+				writeSample(row, x * 2 + 1, format.depth, col[3]);
+				break;
+			default:
+				for (unsigned c = 0; c < out_channels; ++c)
+					writeSample(row, x * out_channels + c, format.depth, col[c]);
+				break;
+			}
+		}
+	}
+
+	// Paletted format, if there are few enough colours (not worth it for
+	// plain greyscale)
+	if (wide || (grey && !alpha))
+		return formats;
+
+	std::unordered_map<uint32_t, unsigned> colour_index;
+	vector<uint32_t>                       colours;
+	vector<uint32_t>                       pixel_colours(n_pixels);
+	for (size_t p = 0; p < n_pixels; ++p)
+	{
+		auto     col = &rgba[p * 4];
+		uint32_t key = (uint32_t)col[0] << 24 | col[1] << 16 | col[2] << 8 | col[3];
+		if (colour_index.emplace(key, 0).second)
+		{
+			colours.push_back(key);
+			if (colours.size() > 256)
+				return formats;
+		}
+		pixel_colours[p] = key;
+	}
+
+	formats.emplace_back();
+	auto& format       = formats.back();
+	format.colour_type = Paletted;
+	format.depth       = colours.size() <= 2 ? 1 : colours.size() <= 4 ? 2 : colours.size() <= 16 ? 4 : 8;
+
+	// Put translucent colours first so the tRNS chunk is as short as possible
+	std::stable_partition(colours.begin(), colours.end(), [](uint32_t c) { return (c & 0xFF) != 255; });
+	for (unsigned a = 0; a < colours.size(); ++a)
+	{
+		colour_index[colours[a]] = a;
+		format.palette.push_back(colours[a] >> 24);
+		format.palette.push_back(colours[a] >> 16);
+		format.palette.push_back(colours[a] >> 8);
+		if ((colours[a] & 0xFF) != 255)
+			format.trans.push_back(colours[a] & 0xFF);
+	}
+
+	auto rows = initRows(format, png.width, png.height);
+	for (size_t p = 0; p < n_pixels; ++p)
+		writeSample(rows + (p / png.width) * format.stride, p % png.width, format.depth, colour_index[pixel_colours[p]]);
+
+	return formats;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the scanlines of [format] filtered using [heuristic] (a PNG filter
+// type or ADAPTIVE), each prefixed with its filter type
+// -----------------------------------------------------------------------------
+vector<uint8_t> filterRows(const Format& format, int heuristic)
+{
+	size_t          height = format.rows.size() / format.stride;
+	vector<uint8_t> out(height * (format.stride + 1));
+	vector<uint8_t> zero(format.stride, 0);
+	vector<uint8_t> trial(format.stride);
+
+	for (size_t y = 0; y < height; ++y)
+	{
+		auto row  = format.rows.data() + y * format.stride;
+		auto prev = y > 0 ? row - format.stride : zero.data();
+		auto dest = out.data() + y * (format.stride + 1);
+
+		uint8_t type = heuristic;
+		if (heuristic == ADAPTIVE)
+		{
+			// Pick the filter with the smallest sum of absolute (signed) values
+			size_t best = SIZE_MAX;
+			for (uint8_t t = 0; t < 5; ++t)
+			{
+				filterRow(trial.data(), row, prev, format.stride, format.bpp, t);
+				size_t sum = 0;
+				for (auto v : trial)
+					sum += v < 128 ? v : 256 - v;
+				if (sum < best)
+				{
+					best = sum;
+					type = t;
+				}
+			}
+		}
+
+		dest[0] = type;
+		filterRow(dest + 1, row, prev, format.stride, format.bpp, type);
+	}
+
+	return out;
+}
+
+// -----------------------------------------------------------------------------
+// Compresses [in] with zlib [settings], writing the result to [out].
+// Returns false if compression failed
+// -----------------------------------------------------------------------------
+bool deflateData(const vector<uint8_t>& in, const DeflateSettings& settings, vector<uint8_t>& out)
+{
+	z_stream strm;
+	memset(&strm, 0, sizeof(z_stream));
+	if (deflateInit2(&strm, settings.level, Z_DEFLATED, 15, 9, settings.strategy) != Z_OK)
+		return false;
+
+	out.resize(deflateBound(&strm, in.size()));
+	strm.next_in   = (Bytef*)in.data();
+	strm.avail_in  = in.size();
+	strm.next_out  = out.data();
+	strm.avail_out = out.size();
+	bool ok        = deflate(&strm, Z_FINISH) == Z_STREAM_END;
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+
+	return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Adds a chunk of [type] with [data] to the end of [png]
+// -----------------------------------------------------------------------------
+void writeChunk(vector<uint8_t>& png, const char* type, const vector<uint8_t>& data)
+{
+	size_t start = png.size();
+	png.resize(start + data.size() + 12);
+	writeUInt32(&png[start], data.size());
+	memcpy(&png[start + 4], type, 4);
+	if (!data.empty())
+		memcpy(&png[start + 8], data.data(), data.size());
+	writeUInt32(&png[start + 8 + data.size()], Misc::crc(&png[start + 4], data.size() + 4));
+}
+
+// -----------------------------------------------------------------------------
+// Returns a PNG file for [png] in [format] with compressed image data [idat]
+// -----------------------------------------------------------------------------
+vector<uint8_t> writePNG(const PNGImage& png, const Format& format, const vector<uint8_t>& idat)
+{
+	vector<uint8_t> out(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+
+	// Header
+	vector<uint8_t> ihdr(13, 0);
+	writeUInt32(&ihdr[0], png.width);
+	writeUInt32(&ihdr[4], png.height);
+	ihdr[8] = format.depth;
+	ihdr[9] = format.colour_type;
+	writeChunk(out, "IHDR", ihdr);
+
+	// Chunks that depend on the pixel format are dropped if it changed
+	bool same_format = format.colour_type == png.colour_type && format.depth == png.depth;
+	auto write_chunks = [&](int position) {
+		for (auto& chunk : png.chunks)
+		{
+			if (chunk.position != position)
+				continue;
+			if (!same_format && (memcmp(chunk.type, "bKGD", 4) == 0 || memcmp(chunk.type, "sBIT", 4) == 0))
+				continue;
+			if (format.colour_type != Paletted && memcmp(chunk.type, "hIST", 4) == 0)
+				continue;
+
+			char type[5] = { chunk.type[0], chunk.type[1], chunk.type[2], chunk.type[3], 0 };
+			writeChunk(out, type, chunk.data);
+		}
+	};
+
+	write_chunks(0);
+	if (format.colour_type == Paletted)
+		writeChunk(out, "PLTE", format.palette);
+	if (!format.trans.empty())
+		writeChunk(out, "tRNS", format.trans);
+	write_chunks(1);
+	writeChunk(out, "IDAT", idat);
+	write_chunks(2);
+	writeChunk(out, "IEND", {});
+
+	return out;
+}
+} // namespace
+
+
+// -----------------------------------------------------------------------------
+//
+// PNGOptimiser Namespace Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Optimises PNG data [in], writing the optimised PNG to [out] if a smaller
+// encoding was found (otherwise [out] is left as-is)
+// -----------------------------------------------------------------------------
+PNGOptimiser::Result PNGOptimiser::optimise(const MemChunk& in, MemChunk& out, bool parallel)
+{
+	sf::Clock clock;
+	Result    result;
+	result.old_size = result.new_size = in.getSize();
+
+	// Read and decode
+	PNGImage png;
+	if (!parsePNG(in.getData(), in.getSize(), png, result.error) || !decodePNG(png, result.error))
+		return result;
+
+	// Get formats to try
+	auto formats = buildFormats(png);
+	png.samples.clear();
+	png.samples.shrink_to_fit();
+
+	auto run = [parallel](size_t count, const std::function<void(size_t)>& func) {
+		if (parallel)
+			ThreadPool::global().parallelFor(count, func);
+		else
+			for (size_t a = 0; a < count; ++a)
+				func(a);
+	};
+
+	// Filter each format with each heuristic
+	vector<vector<uint8_t>> filtered(formats.size() * N_FILTERS);
+	run(filtered.size(), [&](size_t a) { filtered[a] = filterRows(formats[a / N_FILTERS], a % N_FILTERS); });
+
+	// Compress each with each zlib setting
+	vector<vector<uint8_t>> compressed(filtered.size() * N_DEFLATE_SETTINGS);
+	run(compressed.size(), [&](size_t a) {
+		if (!deflateData(filtered[a / N_DEFLATE_SETTINGS], DEFLATE_SETTINGS[a % N_DEFLATE_SETTINGS], compressed[a]))
+			compressed[a].clear();
+	});
+
+	// Find the smallest result (including the size of the format's PLTE/tRNS)
+	size_t best      = SIZE_MAX;
+	size_t best_size = SIZE_MAX;
+	for (size_t a = 0; a < compressed.size(); ++a)
+	{
+		if (compressed[a].empty())
+			continue;
+
+		auto& format = formats[a / (N_FILTERS * N_DEFLATE_SETTINGS)];
+		auto  size   = compressed[a].size() + format.trans.size()
+					+ (format.colour_type == Paletted ? format.palette.size() : 0);
+		if (size < best_size)
+		{
+			best      = a;
+			best_size = size;
+		}
+	}
+	if (best == SIZE_MAX)
+	{
+		result.error = "Compression failed";
+		return result;
+	}
+
+	// Write it if it's smaller than the original
+	auto optimised = writePNG(png, formats[best / (N_FILTERS * N_DEFLATE_SETTINGS)], compressed[best]);
+	if (optimised.size() < in.getSize())
+	{
+		out.importMem(optimised.data(), optimised.size());
+		result.new_size = optimised.size();
+	}
+
+	result.ok   = true;
+	result.time = clock.getElapsedTime().asMilliseconds();
+	return result;
+}
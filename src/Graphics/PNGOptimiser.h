@@ -0,0 +1,29 @@
+#pragma once
+
+class MemChunk;
+
+// Lossless in-process PNG optimiser.
+//
+// The image is decoded and re-encoded in the smallest lossless format it fits
+// (eg. truecolour with few colours to paletted, opaque RGBA to RGB, 16-bit
+// to 8-bit where no precision is lost). Each scanline filter heuristic is
+// tried with multiple zlib strategies/levels, and the smallest result kept.
+// Paletted images keep their palette as-is, since palette indices can be
+// significant. Ancillary chunks (grAb, alPh, etc.) are preserved, other than
+// those that depend on the pixel format when it changes
+namespace PNGOptimiser
+{
+struct Result
+{
+	bool   ok       = false; // True if the PNG could be processed
+	size_t old_size = 0;
+	size_t new_size = 0; // Same as old_size if no smaller encoding was found
+	long   time     = 0; // Time taken in ms
+	string error;
+};
+
+// Optimises PNG data [in], writing the optimised PNG to [out] if it is smaller.
+// If [parallel] is true, encoding trials are spread across the global thread
+// pool (this can be called from a worker thread)
+Result optimise(const MemChunk& in, MemChunk& out, bool parallel = true);
+} // namespace PNGOptimiser
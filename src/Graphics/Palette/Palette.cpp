@@ -663,8 +663,9 @@ void Palette::applyTranslation(Translation* trans)
 	temp.copyPalette(this);
 
 	// Translate colors
+	auto& lut = trans->compile(this);
 	for (size_t i = 0; i < 256; ++i)
-		temp.setColour(i, trans->translate(colours_[i], this));
+		temp.setColour(i, lut.colour[i]);
 
 	// Load translated palette
 	copyPalette(&temp);
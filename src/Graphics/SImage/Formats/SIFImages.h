@@ -501,22 +501,24 @@ protected:
 		// Flip the image
 		FreeImage_FlipVertical(bm);
 
-		// Write the image to a temp file
-		FreeImage_Save(FIF_PNG, bm, CHR(App::path("temp.png", App::Dir::Temp)));
-
-		// Load it into a memchunk
-		MemChunk png;
-		png.importFile(App::path("temp.png", App::Dir::Temp));
+		// Write the image to memory (not a temp file, so images can be
+		// written from multiple threads at once)
+		FIMEMORY* png      = FreeImage_OpenMemory();
+		BYTE*     png_data = nullptr;
+		DWORD     png_size = 0;
+		FreeImage_SaveToMemory(FIF_PNG, bm, png, 0);
+		FreeImage_Unload(bm);
+		FreeImage_AcquireMemory(png, &png_data, &png_size);
 
-		// Check it loaded ok
-		if (png.getSize() == 0)
+		// Check it was written ok
+		if (png_size <= 33)
 		{
-			LOG_MESSAGE(1, "Error reading temporary file");
+			LOG_MESSAGE(1, "Error writing PNG data");
+			FreeImage_CloseMemory(png);
 			return false;
 		}
 
 		// Write PNG header and IHDR
-		const uint8_t* png_data = png.getData();
 		data.clear();
 		data.write(png_data, 33);
 
@@ -538,10 +540,10 @@ protected:
 		}
 
 		// Write remaining PNG data
-		data.write(png_data + 33, png.getSize() - 33);
+		data.write(png_data + 33, png_size - 33);
 
 		// Clean up
-		wxRemoveFile(App::path("temp.png", App::Dir::Temp));
+		FreeImage_CloseMemory(png);
 
 		// Success
 		return true;
@@ -36,10 +36,24 @@
 #include "Graphics/Translation.h"
 #include "SIFormat.h"
 #include "Utility/MathStuff.h"
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMAGE_SSE2
+#include <emmintrin.h>
+#endif
 
 #undef BOOL
 
 
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Bool, gfx_blit_per_pixel, false, CVAR_SECRET) // Use the (slower) per-pixel drawImage path, for testing
+
+
 // -----------------------------------------------------------------------------
 //
 // External Variables
@@ -50,6 +64,307 @@ EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
 
 
+// -----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// -----------------------------------------------------------------------------
+namespace
+{
+// Raw pixel data of an image, for blitting
+struct BlitImage
+{
+	uint8_t* data;
+	uint8_t* mask;
+	int      width;
+	int      height;
+};
+
+// -----------------------------------------------------------------------------
+// Blends [colour] on to [d_colour] with blend mode [BLEND], where [alpha] is
+// the alpha of [colour] as a 0-1 float.
+// Used for both SImage::drawPixel and SImage::drawImage, so they always give
+// the same result
+// -----------------------------------------------------------------------------
+template<SIBlendType BLEND> void blendColour(rgba_t& d_colour, const rgba_t& colour, float alpha)
+{
+	// Normal blending (or unknown blend type)
+	float inv_alpha = 1.0f - alpha;
+	d_colour.set(
+		d_colour.r * inv_alpha + colour.r * alpha,
+		d_colour.g * inv_alpha + colour.g * alpha,
+		d_colour.b * inv_alpha + colour.b * alpha,
+		MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+}
+template<> void blendColour<ADD>(rgba_t& d_colour, const rgba_t& colour, float alpha)
+{
+	d_colour.set(
+		MathStuff::clamp(d_colour.r + colour.r * alpha, 0, 255),
+		MathStuff::clamp(d_colour.g + colour.g * alpha, 0, 255),
+		MathStuff::clamp(d_colour.b + colour.b * alpha, 0, 255),
+		MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+}
+template<> void blendColour<SUBTRACT>(rgba_t& d_colour, const rgba_t& colour, float alpha)
+{
+	d_colour.set(
+		MathStuff::clamp(d_colour.r - colour.r * alpha, 0, 255),
+		MathStuff::clamp(d_colour.g - colour.g * alpha, 0, 255),
+		MathStuff::clamp(d_colour.b - colour.b * alpha, 0, 255),
+		MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+}
+template<> void blendColour<REVERSE_SUBTRACT>(rgba_t& d_colour, const rgba_t& colour, float alpha)
+{
+	d_colour.set(
+		MathStuff::clamp((-d_colour.r) + colour.r * alpha, 0, 255),
+		MathStuff::clamp((-d_colour.g) + colour.g * alpha, 0, 255),
+		MathStuff::clamp((-d_colour.b) + colour.b * alpha, 0, 255),
+		MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+}
+template<> void blendColour<MODULATE>(rgba_t& d_colour, const rgba_t& colour, float alpha)
+{
+	d_colour.set(
+		MathStuff::clamp(colour.r * d_colour.r / 255, 0, 255),
+		MathStuff::clamp(colour.g * d_colour.g / 255, 0, 255),
+		MathStuff::clamp(colour.b * d_colour.b / 255, 0, 255),
+		MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+}
+
+// -----------------------------------------------------------------------------
+// Blends [colour] on to the RGBA pixel at [dest] with blend mode [BLEND]
+// -----------------------------------------------------------------------------
+template<SIBlendType BLEND> void blendRGBA(uint8_t* dest, const rgba_t& colour, float alpha)
+{
+	rgba_t d_colour(dest[0], dest[1], dest[2], dest[3]);
+	blendColour<BLEND>(d_colour, colour, alpha);
+	d_colour.write(dest);
+}
+
+#ifdef SIMAGE_SSE2
+// SSE2 versions of the above for add, subtract and modulate blending. These
+// do the same (single precision) float and integer operations as blendColour
+// on all colour channels at once, so the results are identical
+__m128 loadRGBAf(const uint8_t* pixel)
+{
+	int value;
+	memcpy(&value, pixel, 4);
+	__m128i zero = _mm_setzero_si128();
+	__m128i px   = _mm_cvtsi32_si128(value);
+	px           = _mm_unpacklo_epi8(px, zero);
+	px           = _mm_unpacklo_epi16(px, zero);
+	return _mm_cvtepi32_ps(px);
+}
+void storeRGBAf(uint8_t* dest, __m128 colour, uint8_t alpha)
+{
+	colour     = _mm_min_ps(_mm_max_ps(colour, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+	__m128i px = _mm_cvttps_epi32(colour);
+	px         = _mm_packs_epi32(px, px);
+	px         = _mm_packus_epi16(px, px);
+	int value  = _mm_cvtsi128_si32(px);
+	memcpy(dest, &value, 4);
+	dest[3] = alpha;
+}
+uint8_t addAlpha(uint8_t dest, uint8_t src)
+{
+	return dest + src > 255 ? 255 : dest + src;
+}
+
+template<> void blendRGBA<ADD>(uint8_t* dest, const rgba_t& colour, float alpha)
+{
+	__m128 src = _mm_mul_ps(_mm_set_ps(0.0f, colour.b, colour.g, colour.r), _mm_set1_ps(alpha));
+	storeRGBAf(dest, _mm_add_ps(loadRGBAf(dest), src), addAlpha(dest[3], colour.a));
+}
+template<> void blendRGBA<SUBTRACT>(uint8_t* dest, const rgba_t& colour, float alpha)
+{
+	__m128 src = _mm_mul_ps(_mm_set_ps(0.0f, colour.b, colour.g, colour.r), _mm_set1_ps(alpha));
+	storeRGBAf(dest, _mm_sub_ps(loadRGBAf(dest), src), addAlpha(dest[3], colour.a));
+}
+template<> void blendRGBA<MODULATE>(uint8_t* dest, const rgba_t& colour, float alpha)
+{
+	// (src * dest) / 255 with integer division, in 16-bit lanes
+	int value;
+	memcpy(&value, dest, 4);
+	__m128i zero = _mm_setzero_si128();
+	__m128i one  = _mm_set1_epi16(1);
+	__m128i d    = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+	__m128i s    = _mm_unpacklo_epi8(_mm_cvtsi32_si128(colour.r | (colour.g << 8) | (colour.b << 16)), zero);
+	__m128i x    = _mm_add_epi16(_mm_mullo_epi16(d, s), one);
+	x            = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	uint8_t a    = addAlpha(dest[3], colour.a);
+	value        = _mm_cvtsi128_si32(_mm_packus_epi16(x, x));
+	memcpy(dest, &value, 4);
+	dest[3] = a;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// Draws [src] on to [dest] at [x_pos],[y_pos], clipped to [dest]. The source
+// and destination formats and blend mode are resolved at compile time, so the
+// inner loop doesn't need to check them for each pixel.
+// Gives the same result as drawing each pixel of [src] with SImage::drawPixel
+// (the destination can't be an alpha map)
+// -----------------------------------------------------------------------------
+template<SIType SRC, SIType DEST, SIBlendType BLEND>
+void blitImage(
+	const BlitImage&      src,
+	BlitImage&            dest,
+	int                   x_pos,
+	int                   y_pos,
+	const si_drawprops_t& properties,
+	Palette*              pal_src,
+	Palette*              pal_dest)
+{
+	const int s_bpp = SRC == RGBA ? 4 : 1;
+	const int d_bpp = DEST == RGBA ? 4 : 1;
+
+	// Clip to destination
+	int x1 = std::max(x_pos, 0);
+	int y1 = std::max(y_pos, 0);
+	int x2 = std::min(x_pos + src.width, dest.width);
+	int y2 = std::min(y_pos + src.height, dest.height);
+	if (x1 >= x2 || y1 >= y2)
+		return;
+
+	// Get resulting alpha for each source alpha value
+	uint8_t alpha_table[256];
+	for (unsigned a = 0; a < 256; a++)
+	{
+		rgba_t colour(0, 0, 0, a);
+		if (properties.src_alpha)
+			colour.a *= properties.alpha;
+		else
+			colour.a = 255 * properties.alpha;
+		alpha_table[a] = colour.a;
+	}
+
+	// Nearest destination palette colour for each (opaque) source palette
+	// index, looked up as needed
+	short nearest[256];
+	if (SRC == PALMASK && DEST == PALMASK)
+		memset(nearest, -1, sizeof(nearest));
+
+	for (int y = y1; y < y2; y++)
+	{
+		unsigned s_row  = (y - y_pos) * src.width + (x1 - x_pos);
+		unsigned d_row  = y * dest.width + x1;
+		uint8_t* s_data = src.data + s_row * s_bpp;
+		uint8_t* d_data = dest.data + d_row * d_bpp;
+		for (int a = 0; a < x2 - x1; a++)
+		{
+			// Get source pixel colour (skip if fully transparent)
+			rgba_t colour;
+			if (SRC == PALMASK)
+			{
+				if (src.mask[s_row + a] == 0)
+					continue;
+				colour   = pal_src->colour(s_data[a]);
+				colour.a = src.mask[s_row + a];
+			}
+			else if (SRC == RGBA)
+			{
+				uint8_t* pixel = s_data + a * 4;
+				if (pixel[3] == 0)
+					continue;
+				colour = rgba_t(pixel[0], pixel[1], pixel[2], pixel[3]);
+			}
+			else
+			{
+				if (s_data[a] == 0)
+					continue;
+				colour = rgba_t(s_data[a], s_data[a], s_data[a], s_data[a]);
+			}
+
+			// Apply alpha
+			colour.a = alpha_table[colour.a];
+			if (colour.a == 0)
+				continue;
+
+			// Simple case (normal blending, no transparency involved)
+			if (colour.a == 255 && BLEND == NORMAL)
+			{
+				if (DEST == RGBA)
+					colour.write(d_data + a * 4);
+				else
+				{
+					if (SRC == PALMASK)
+					{
+						if (nearest[s_data[a]] < 0)
+							nearest[s_data[a]] = pal_dest->nearestColour(colour);
+						d_data[a] = nearest[s_data[a]];
+					}
+					else
+						d_data[a] = pal_dest->nearestColour(colour);
+					dest.mask[d_row + a] = colour.a;
+				}
+
+				continue;
+			}
+
+			// Blend
+			float alpha = (float)colour.a / 255.0f;
+			if (DEST == RGBA)
+				blendRGBA<BLEND>(d_data + a * 4, colour, alpha);
+			else
+			{
+				rgba_t d_colour = pal_dest->colour(d_data[a]);
+				blendColour<BLEND>(d_colour, colour, alpha);
+				d_data[a]            = pal_dest->nearestColour(d_colour);
+				dest.mask[d_row + a] = d_colour.a;
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Calls blitImage for [SRC] and [DEST] formats, with the blend mode from
+// [properties]
+// -----------------------------------------------------------------------------
+template<SIType SRC, SIType DEST>
+void blitImageBlend(
+	const BlitImage&      src,
+	BlitImage&            dest,
+	int                   x_pos,
+	int                   y_pos,
+	const si_drawprops_t& properties,
+	Palette*              pal_src,
+	Palette*              pal_dest)
+{
+	switch (properties.blend)
+	{
+	case ADD: blitImage<SRC, DEST, ADD>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	case SUBTRACT: blitImage<SRC, DEST, SUBTRACT>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	case REVERSE_SUBTRACT:
+		blitImage<SRC, DEST, REVERSE_SUBTRACT>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest);
+		break;
+	case MODULATE: blitImage<SRC, DEST, MODULATE>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	default: blitImage<SRC, DEST, NORMAL>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Calls blitImage for [DEST] format, with source format [src_type]
+// -----------------------------------------------------------------------------
+template<SIType DEST>
+void blitImageSource(
+	const BlitImage&      src,
+	SIType                src_type,
+	BlitImage&            dest,
+	int                   x_pos,
+	int                   y_pos,
+	const si_drawprops_t& properties,
+	Palette*              pal_src,
+	Palette*              pal_dest)
+{
+	switch (src_type)
+	{
+	case PALMASK: blitImageBlend<PALMASK, DEST>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	case RGBA: blitImageBlend<RGBA, DEST>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	case ALPHAMAP: blitImageBlend<ALPHAMAP, DEST>(src, dest, x_pos, y_pos, properties, pal_src, pal_dest); break;
+	default: break;
+	}
+}
+} // namespace
+
+
 // -----------------------------------------------------------------------------
 //
 // SImage Class Functions
@@ -1378,6 +1693,13 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 	else
 		newdata = data_;
 
+	// Compile translation for the palette
+	auto& lut = tr->compile(pal);
+
+	// Palette indices of truecolour pixels (the same colours usually appear
+	// many times in an image)
+	std::unordered_map<uint32_t, short> rgba_index;
+
 	// Go through pixels
 	for (int p = 0; p < width_ * height_; p++)
 	{
@@ -1385,32 +1707,43 @@ bool SImage::applyTranslation(Translation* tr, Palette* pal, bool truecolor)
 		if (mask_ && mask_[p] == 0)
 			continue;
 
-		rgba_t col;
-		int    q = p * bpp;
+		uint8_t index;
+		uint8_t alpha = 255;
+		int     q     = p * bpp;
 		if (type_ == PALMASK)
-			col.set(pal->colour(data_[p]));
-		else if (type_ == RGBA)
+			index = data_[p];
+		else
 		{
-			col.set(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
+			rgba_t col(data_[q], data_[q + 1], data_[q + 2], data_[q + 3]);
+			alpha = col.a;
 
-			// skip colours that don't match exactly to the palette
-			col.index = pal->nearestColour(col);
-			if (!col.equals(pal->colour(col.index)))
+			auto key   = (uint32_t)col.r << 16 | (uint32_t)col.g << 8 | col.b;
+			auto found = rgba_index.find(key);
+			if (found == rgba_index.end())
+			{
+				// Skip colours that don't match exactly to the palette
+				short i = pal->nearestColour(col);
+				if (!col.equals(pal->colour(i)))
+					i = -1;
+				found = rgba_index.emplace(key, i).first;
+			}
+			if (found->second < 0)
 				continue;
-		}
 
-		col = tr->translate(col, pal);
+			index = found->second;
+		}
 
 		if (truecolor)
 		{
+			auto& col      = lut.colour[index];
 			q              = p * 4;
 			newdata[q + 0] = col.r;
 			newdata[q + 1] = col.g;
 			newdata[q + 2] = col.b;
-			newdata[q + 3] = mask_ ? mask_[p] : col.a;
+			newdata[q + 3] = mask_ ? mask_[p] : (lut.keep_alpha[index] ? alpha : col.a);
 		}
 		else
-			data_[p] = col.index;
+			data_[p] = lut.index[index];
 	}
 
 	if (truecolor && type_ == PALMASK)
@@ -1485,55 +1818,14 @@ bool SImage::drawPixel(int x, int y, rgba_t colour, si_drawprops_t& properties,
 		d_colour.set(data_[p], data_[p + 1], data_[p + 2], data_[p + 3]);
 	float alpha = (float)colour.a / 255.0f;
 
-	// Additive blending
-	if (properties.blend == ADD)
-	{
-		d_colour.set(
-			MathStuff::clamp(d_colour.r + colour.r * alpha, 0, 255),
-			MathStuff::clamp(d_colour.g + colour.g * alpha, 0, 255),
-			MathStuff::clamp(d_colour.b + colour.b * alpha, 0, 255),
-			MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Subtractive blending
-	else if (properties.blend == SUBTRACT)
-	{
-		d_colour.set(
-			MathStuff::clamp(d_colour.r - colour.r * alpha, 0, 255),
-			MathStuff::clamp(d_colour.g - colour.g * alpha, 0, 255),
-			MathStuff::clamp(d_colour.b - colour.b * alpha, 0, 255),
-			MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Reverse-Subtractive blending
-	else if (properties.blend == REVERSE_SUBTRACT)
-	{
-		d_colour.set(
-			MathStuff::clamp((-d_colour.r) + colour.r * alpha, 0, 255),
-			MathStuff::clamp((-d_colour.g) + colour.g * alpha, 0, 255),
-			MathStuff::clamp((-d_colour.b) + colour.b * alpha, 0, 255),
-			MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// 'Modulate' blending
-	else if (properties.blend == MODULATE)
-	{
-		d_colour.set(
-			MathStuff::clamp(colour.r * d_colour.r / 255, 0, 255),
-			MathStuff::clamp(colour.g * d_colour.g / 255, 0, 255),
-			MathStuff::clamp(colour.b * d_colour.b / 255, 0, 255),
-			MathStuff::clamp(d_colour.a + colour.a, 0, 255));
-	}
-
-	// Normal blending (or unknown blend type)
-	else
+	// Blend
+	switch (properties.blend)
 	{
-		float inv_alpha = 1.0f - alpha;
-		d_colour.set(
-			d_colour.r * inv_alpha + colour.r * alpha,
-			d_colour.g * inv_alpha + colour.g * alpha,
-			d_colour.b * inv_alpha + colour.b * alpha,
-			MathStuff::clamp(d_colour.a + colour.a, 0, 255));
+	case ADD: blendColour<ADD>(d_colour, colour, alpha); break;
+	case SUBTRACT: blendColour<SUBTRACT>(d_colour, colour, alpha); break;
+	case REVERSE_SUBTRACT: blendColour<REVERSE_SUBTRACT>(d_colour, colour, alpha); break;
+	case MODULATE: blendColour<MODULATE>(d_colour, colour, alpha); break;
+	default: blendColour<NORMAL>(d_colour, colour, alpha); break;
 	}
 
 	// Apply new colour
@@ -1573,7 +1865,20 @@ bool SImage::drawImage(
 	if (has_palette_ || !pal_dest)
 		pal_dest = &palette_;
 
-	// Go through pixels
+	// Blit rows if possible
+	if (type_ != ALPHAMAP && !gfx_blit_per_pixel)
+	{
+		BlitImage src  = { img.data_, img.mask_, img.width_, img.height_ };
+		BlitImage dest = { data_, mask_, width_, height_ };
+		if (type_ == RGBA)
+			blitImageSource<RGBA>(src, img.type_, dest, x_pos, y_pos, properties, pal_src, pal_dest);
+		else
+			blitImageSource<PALMASK>(src, img.type_, dest, x_pos, y_pos, properties, pal_src, pal_dest);
+
+		return true;
+	}
+
+	// Otherwise draw each pixel
 	unsigned s_stride = img.getStride();
 	uint8_t  s_bpp    = img.getBpp();
 	unsigned sp       = 0;
@@ -54,6 +54,8 @@
 EXTERN_CVAR(Float, col_greyscale_r)
 EXTERN_CVAR(Float, col_greyscale_g)
 EXTERN_CVAR(Float, col_greyscale_b)
+EXTERN_CVAR(Int, col_match)
+unsigned TransRange::revision_ = 0;
 
 
 // -----------------------------------------------------------------------------
@@ -111,6 +113,8 @@ Translation::~Translation()
 // -----------------------------------------------------------------------------
 void Translation::parse(string def)
 {
+	compiled_.clear();
+
 	// Test for ZDoom built-in translation
 	string test = def.Lower();
 	string temp;
@@ -181,6 +185,8 @@ void Translation::parse(string def)
 // -----------------------------------------------------------------------------
 void Translation::parseRange(string range)
 {
+	compiled_.clear();
+
 	// Open definition string for processing w/tokenizer
 	Tokenizer tz;
 	tz.setSpecialCharacters("[]:%,=#@$");
@@ -416,6 +422,8 @@ void Translation::parseRange(string range)
 // -----------------------------------------------------------------------------
 void Translation::read(const uint8_t* data)
 {
+	compiled_.clear();
+
 	int     i = 0;
 	uint8_t val, o_start, o_end, d_start, d_end;
 	o_start = 0;
@@ -483,6 +491,7 @@ void Translation::clear()
 	translations_.clear();
 	built_in_name_ = "";
 	desat_amount_  = 0;
+	compiled_.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -785,6 +794,63 @@ rgba_t Translation::specialBlend(rgba_t col, uint8_t type, Palette* pal)
 	return colour;
 }
 
+// -----------------------------------------------------------------------------
+// Returns the translation compiled to lookup tables for [pal], so it can be
+// applied to paletted pixels with a single lookup each. Compiled translations
+// are cached for the last few palettes used, until the translation (or any of
+// the colour matching settings) changes
+// -----------------------------------------------------------------------------
+const Translation::Compiled& Translation::compile(Palette* pal)
+{
+	if (pal == nullptr)
+		pal = MainEditor::currentPalette();
+
+	// Check for a cached compile for the palette
+	for (auto& cached : compiled_)
+	{
+		if (cached.revision != TransRange::revision() || cached.col_match != col_match
+			|| cached.greyscale[0] != col_greyscale_r || cached.greyscale[1] != col_greyscale_g
+			|| cached.greyscale[2] != col_greyscale_b)
+			continue;
+
+		bool same = true;
+		for (unsigned a = 0; a < 256 && same; a++)
+			same = cached.palette[a].equals(pal->colour(a), true);
+
+		if (same)
+			return cached.lut;
+	}
+
+	// Not cached, compile for the palette (replacing the oldest if there are
+	// too many)
+	if (compiled_.size() >= 4)
+		compiled_.erase(compiled_.begin());
+	compiled_.emplace_back();
+	auto& cached        = compiled_.back();
+	cached.revision     = TransRange::revision();
+	cached.col_match    = col_match;
+	cached.greyscale[0] = col_greyscale_r;
+	cached.greyscale[1] = col_greyscale_g;
+	cached.greyscale[2] = col_greyscale_b;
+
+	for (unsigned a = 0; a < 256; a++)
+	{
+		rgba_t col        = pal->colour(a);
+		cached.palette[a] = col;
+
+		auto translated      = translate(col, pal);
+		cached.lut.index[a]  = translated.index;
+		cached.lut.colour[a] = translated;
+
+		// Check if the alpha of the original colour is kept (translating a
+		// truecolour pixel keeps its alpha unless the range replaces it)
+		col.a                    = 255 - col.a;
+		cached.lut.keep_alpha[a] = translate(col, pal).a == col.a && translated.a != col.a;
+	}
+
+	return cached.lut;
+}
+
 // -----------------------------------------------------------------------------
 // Adds a new translation range of [type] at [pos] in the list
 // -----------------------------------------------------------------------------
@@ -807,6 +873,8 @@ void Translation::addRange(int type, int pos)
 		translations_.push_back(tr);
 	else
 		translations_.insert(translations_.begin() + pos, tr);
+
+	compiled_.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -823,6 +891,7 @@ void Translation::removeRange(int pos)
 	// Remove it
 	delete translations_[pos];
 	translations_.erase(translations_.begin() + pos);
+	compiled_.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -838,6 +907,7 @@ void Translation::swapRanges(int pos1, int pos2)
 	TransRange* temp    = translations_[pos1];
 	translations_[pos1] = translations_[pos2];
 	translations_[pos2] = temp;
+	compiled_.clear();
 }
 
 // -----------------------------------------------------------------------------
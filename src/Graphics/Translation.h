@@ -30,15 +30,23 @@ public:
 	uint8_t oStart() { return o_start_; }
 	uint8_t oEnd() { return o_end_; }
 
-	void setOStart(uint8_t val) { o_start_ = val; }
-	void setOEnd(uint8_t val) { o_end_ = val; }
+	void setOStart(uint8_t val) { o_start_ = val; changed(); }
+	void setOEnd(uint8_t val) { o_end_ = val; changed(); }
 
 	virtual string asText() { return ""; }
 
+	// Incremented whenever any translation range is modified
+	static unsigned revision() { return revision_; }
+
 protected:
 	Type    type_;
 	uint8_t o_start_;
 	uint8_t o_end_;
+
+	static void changed() { ++revision_; }
+
+private:
+	static unsigned revision_;
 };
 
 class TransRangePalette : public TransRange
@@ -58,8 +66,8 @@ public:
 	uint8_t dStart() { return d_start_; }
 	uint8_t dEnd() { return d_end_; }
 
-	void setDStart(uint8_t val) { d_start_ = val; }
-	void setDEnd(uint8_t val) { d_end_ = val; }
+	void setDStart(uint8_t val) { d_start_ = val; changed(); }
+	void setDEnd(uint8_t val) { d_end_ = val; changed(); }
 
 	string asText() { return S_FMT("%d:%d=%d:%d", o_start_, o_end_, d_start_, d_end_); }
 
@@ -88,8 +96,8 @@ public:
 	rgba_t dStart() { return d_start_; }
 	rgba_t dEnd() { return d_end_; }
 
-	void setDStart(rgba_t col) { d_start_.set(col); }
-	void setDEnd(rgba_t col) { d_end_.set(col); }
+	void setDStart(rgba_t col) { d_start_.set(col); changed(); }
+	void setDEnd(rgba_t col) { d_end_.set(col); changed(); }
 
 	string asText()
 	{
@@ -142,12 +150,14 @@ public:
 		d_sr_ = r;
 		d_sg_ = g;
 		d_sb_ = b;
+		changed();
 	}
 	void setDEnd(float r, float g, float b)
 	{
 		d_er_ = r;
 		d_eg_ = g;
 		d_eb_ = b;
+		changed();
 	}
 
 	string asText()
@@ -174,7 +184,7 @@ public:
 	}
 
 	rgba_t getColour() { return col_; }
-	void   setColour(rgba_t c) { col_ = c; }
+	void   setColour(rgba_t c) { col_ = c; changed(); }
 
 	string asText() { return S_FMT("%d:%d=#[%d,%d,%d]", o_start_, o_end_, col_.r, col_.g, col_.b); }
 
@@ -201,8 +211,8 @@ public:
 
 	rgba_t  getColour() { return col_; }
 	uint8_t getAmount() { return amount_; }
-	void    setColour(rgba_t c) { col_ = c; }
-	void    setAmount(uint8_t a) { amount_ = a; }
+	void    setColour(rgba_t c) { col_ = c; changed(); }
+	void    setAmount(uint8_t a) { amount_ = a; changed(); }
 
 	string asText() { return S_FMT("%d:%d=@%d[%d,%d,%d]", o_start_, o_end_, amount_, col_.r, col_.g, col_.b); }
 
@@ -224,7 +234,7 @@ public:
 	}
 
 	string getSpecial() { return special_; }
-	void   setSpecial(string sp) { special_ = sp; }
+	void   setSpecial(string sp) { special_ = sp; changed(); }
 
 	string asText() { return S_FMT("%d:%d=$%s", o_start_, o_end_, special_); }
 
@@ -236,6 +246,14 @@ class Palette;
 class Translation
 {
 public:
+	// The translation compiled to lookup tables for a specific palette
+	struct Compiled
+	{
+		uint8_t index[256];      // Translated palette index for each palette index
+		rgba_t  colour[256];     // Translated colour for each palette index
+		bool    keep_alpha[256]; // Translated colour keeps the alpha of the original colour
+	};
+
 	Translation();
 	~Translation();
 
@@ -250,10 +268,11 @@ public:
 	unsigned    nRanges() { return translations_.size(); }
 	TransRange* getRange(unsigned index);
 	string      builtInName() { return built_in_name_; }
-	void        setDesaturationAmount(uint8_t amount) { desat_amount_ = amount; }
+	void        setDesaturationAmount(uint8_t amount) { desat_amount_ = amount; compiled_.clear(); }
 
-	rgba_t translate(rgba_t col, Palette* pal = nullptr);
-	rgba_t specialBlend(rgba_t col, uint8_t type, Palette* pal = nullptr);
+	rgba_t          translate(rgba_t col, Palette* pal = nullptr);
+	rgba_t          specialBlend(rgba_t col, uint8_t type, Palette* pal = nullptr);
+	const Compiled& compile(Palette* pal = nullptr);
 
 	void addRange(int type, int pos);
 	void removeRange(int pos);
@@ -262,7 +281,18 @@ public:
 	static string getPredefined(string def);
 
 private:
-	vector<TransRange*> translations_;
-	string              built_in_name_;
-	uint8_t             desat_amount_;
+	// A compiled translation, and what it was compiled with
+	struct CompiledCache
+	{
+		Compiled lut;
+		rgba_t   palette[256];
+		unsigned revision;
+		int      col_match;
+		float    greyscale[3];
+	};
+
+	vector<TransRange*>   translations_;
+	string                built_in_name_;
+	uint8_t               desat_amount_;
+	vector<CompiledCache> compiled_;
 };
@@ -36,6 +36,11 @@
 #include "External/mus2mid/mus2mid.h"
 #include "External/zreaders/i_music.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define CONVERSIONS_SSE2
+#include <emmintrin.h>
+#endif
+
 
 // -----------------------------------------------------------------------------
 //
@@ -52,9 +57,12 @@ const int16_t BIAS       = 0x84; // Bias for linear code.
 const uint8_t WAV_PCM    = 1;
 const uint8_t WAV_ALAW   = 6;
 const uint8_t WAV_ULAW   = 7;
+const uint32_t WAV_RATE_MIN = 1000;   // Lowest sample rate accepted for conversion
+const uint32_t WAV_RATE_MAX = 768000; // Highest sample rate accepted for conversion
 } // namespace Conversions
 CVAR(Bool, dmx_padding, true, CVAR_SAVE)
 CVAR(Int, wolfsnd_rate, 7042, CVAR_SAVE)
+CVAR(Int, dsnd_rate, 0, CVAR_SAVE) // Sample rate for sounds converted to doom format (0 = keep original)
 
 
 // -----------------------------------------------------------------------------
@@ -131,60 +139,141 @@ struct SunSndHeader
 namespace Conversions
 {
 // -----------------------------------------------------------------------------
-// Converts a 16-bit signed sample to an 8-bit unsigned one.
+// Basic info about the sample data in a WAV file
 // -----------------------------------------------------------------------------
-uint8_t pcm16to8bits(int16_t val)
+struct WavInfo
 {
-	// Value is in the [-32768, 32767] range.
-	// Shift it eight bits to [-128, 127] range,
-	// and add 128 to put it in [0, 255] range.
-	uint8_t ret = 128 + (val >> 8);
-	// Round value up or down depending on value
-	// of shifted-off bits.
-	if ((val & 0x80FF) > 127)
-		ret++;
-	else if ((val & 0x80FF) < -128)
-		ret--;
-	// Send it.
-	return ret;
-}
+	uint8_t  format;     // WAV_PCM, WAV_ALAW or WAV_ULAW
+	uint16_t channels;   // 1 or 2
+	uint32_t samplerate;
+	uint8_t  bytes;      // Bytes per sample
+	size_t   data_ofs;   // Offset of sample data
+	size_t   data_size;  // Size of sample data in bytes
+};
 
 // -----------------------------------------------------------------------------
-// Converts a 24-bit signed sample to an 8-bit unsigned one.
+// Reads the format info from WAV data [in] into [info], checking it is a
+// format that can be converted to doom sound
 // -----------------------------------------------------------------------------
-uint8_t pcm24to8bits(int32_t val)
+bool readWavInfo(MemChunk& in, WavInfo& info)
 {
-	int16_t ret = (val >> 8);
-	if ((val & 0x8000FF) > 127)
-		ret++;
-	else if ((val & 0x8000FF) < -128)
-		ret--;
-	return pcm16to8bits(ret);
+	WavChunk chunk;
+
+	// Read header
+	in.seek(0, SEEK_SET);
+	in.read(&chunk, 8);
+
+	// Check header
+	if (chunk.id[0] != 'R' || chunk.id[1] != 'I' || chunk.id[2] != 'F' || chunk.id[3] != 'F')
+	{
+		Global::error = "Invalid WAV";
+		return false;
+	}
+
+	// Read format
+	char format[4];
+	in.read(format, 4);
+
+	// Check format
+	if (format[0] != 'W' || format[1] != 'A' || format[2] != 'V' || format[3] != 'E')
+	{
+		Global::error = "Invalid WAV format";
+		return false;
+	}
+
+	// Find fmt chunk
+	size_t ofs = 12;
+	while (ofs + 8 <= in.getSize())
+	{
+		if (in[ofs] == 'f' && in[ofs + 1] == 'm' && in[ofs + 2] == 't' && in[ofs + 3] == ' ')
+			break;
+		ofs += 8 + READ_L32(in, (ofs + 4));
+	}
+
+	// Read fmt chunk
+	if (ofs + sizeof(WavFmtChunk) > in.getSize())
+	{
+		Global::error = "Invalid WAV: no 'fmt ' chunk";
+		return false;
+	}
+	in.seek(ofs, SEEK_SET);
+	WavFmtChunk fmtchunk;
+	in.read(&fmtchunk, sizeof(WavFmtChunk));
+
+	// Get format
+	info.format     = fmtchunk.tag == 0xFFFE ? READ_L32(in, ofs + 32) : fmtchunk.tag;
+	info.channels   = fmtchunk.channels;
+	info.samplerate = fmtchunk.samplerate;
+	info.bytes      = fmtchunk.bps / 8;
+
+	// Check fmt chunk values
+	if (info.channels < 1 || info.channels > 2 || fmtchunk.bps % 8 || info.bytes < 1 || info.bytes > 4
+		|| (info.format != WAV_PCM && info.format != WAV_ALAW && info.format != WAV_ULAW)
+		|| (info.format != WAV_PCM && info.bytes != 1))
+	{
+		Global::error = "Cannot convert WAV file, only stereo or monophonic sounds in PCM format can be converted";
+		return false;
+	}
+
+	// Check sample rate (also keeps any resampling filter to a sane size)
+	if (info.samplerate < WAV_RATE_MIN || info.samplerate > WAV_RATE_MAX)
+	{
+		Global::error = S_FMT("Invalid WAV: unsupported sample rate %u", info.samplerate);
+		return false;
+	}
+
+	// Find data chunk
+	ofs += 8 + wxUINT32_SWAP_ON_BE(fmtchunk.header.size);
+	while (ofs + 8 <= in.getSize())
+	{
+		if (in[ofs] == 'd' && in[ofs + 1] == 'a' && in[ofs + 2] == 't' && in[ofs + 3] == 'a')
+			break;
+		ofs += 8 + READ_L32(in, (ofs + 4));
+	}
+	if (ofs + 8 > in.getSize())
+	{
+		Global::error = "Invalid WAV: no 'data' chunk";
+		return false;
+	}
+
+	// Get sample data (whole frames only)
+	size_t frame_size = info.bytes * info.channels;
+	info.data_ofs     = ofs + 8;
+	info.data_size    = std::min<size_t>(READ_L32(in, (ofs + 4)), in.getSize() - info.data_ofs);
+	info.data_size -= info.data_size % frame_size;
+	if (info.data_size == 0)
+	{
+		Global::error = "Invalid WAV: no sample data";
+		return false;
+	}
+
+	return true;
 }
 
 // -----------------------------------------------------------------------------
-// Converts a 32-bit signed sample to an 8-bit unsigned one.
+// Returns the sample rate to use for a doom sound converted from a sound at
+// [rate], from the dsnd_rate cvar. Doom sound sample rates are 16-bit, so
+// anything higher is resampled to 44.1kHz if no rate is set. Very low rates
+// set in the cvar are raised to WAV_RATE_MIN
 // -----------------------------------------------------------------------------
-uint8_t pcm32to8bits(int32_t val)
+unsigned doomSndRate(unsigned rate)
 {
-	int32_t ret = (val >> 8);
-	if ((val & 0x800000FF) > 127)
-		ret++;
-	else if ((val & 0x800000FF) < -128)
-		ret--;
-	return pcm24to8bits(ret);
+	if (dsnd_rate > 0)
+		return std::max<unsigned>(WAV_RATE_MIN, std::min<unsigned>(dsnd_rate, 65535));
+	if (rate > 65535)
+		return 44100;
+
+	return rate;
 }
 
 // -----------------------------------------------------------------------------
-// Averages the values of two eight-bit unsigned samples into one.
+// Returns true if converting the wav described by [info] to doom sound format
+// will lose audio quality
 // -----------------------------------------------------------------------------
-uint8_t stereoToMono(uint8_t left, uint8_t right)
+bool isLossy(const WavInfo& info)
 {
-	uint16_t val = left + right;
-	val /= 2;
-	if (val > 255)
-		val = 255;
-	return (uint8_t)val;
+	return info.bytes > 1 || info.format != WAV_PCM || info.channels == 2
+		   || doomSndRate(info.samplerate) != info.samplerate;
 }
 
 // The following two functions are adapted from Sun Microsystem's g711.cpp code.
@@ -230,6 +319,199 @@ int16_t mulawToLinear(uint8_t ulaw)
 
 	return ((ulaw & SIGN_BIT) ? (BIAS - t) : (t - BIAS));
 }
+
+// -----------------------------------------------------------------------------
+// Decodes [count] samples in WAV [format] with [bytes] per sample from [data]
+// to 16-bit signed samples in [out]. Samples with more than 16 bits are
+// truncated to their top 16
+// -----------------------------------------------------------------------------
+void decodeSamples(const uint8_t* data, size_t count, uint8_t format, uint8_t bytes, int16_t* out)
+{
+	// A-law/µ-law (via lookup table)
+	if (format == WAV_ALAW || format == WAV_ULAW)
+	{
+		static const vector<int16_t> tables = []() {
+			vector<int16_t> t(512);
+			for (unsigned a = 0; a < 256; a++)
+			{
+				t[a]       = alawToLinear(a);
+				t[256 + a] = mulawToLinear(a);
+			}
+			return t;
+		}();
+
+		const int16_t* table = tables.data() + (format == WAV_ULAW ? 256 : 0);
+		for (size_t i = 0; i < count; ++i)
+			out[i] = table[data[i]];
+
+		return;
+	}
+
+	size_t i = 0;
+	switch (bytes)
+	{
+	// 8-bit unsigned
+	case 1:
+#ifdef CONVERSIONS_SSE2
+		for (; i + 16 <= count; i += 16)
+		{
+			// Flip to signed and move into the high byte of each 16-bit sample
+			__m128i px = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(data + i)), _mm_set1_epi8((char)0x80));
+			_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(_mm_setzero_si128(), px));
+			_mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(_mm_setzero_si128(), px));
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = (int16_t)((data[i] - 128) * 256);
+		break;
+
+	// 16-bit signed
+	case 2:
+		for (; i < count; ++i)
+			out[i] = (int16_t)(data[i * 2] | (data[i * 2 + 1] << 8));
+		break;
+
+	// 24/32-bit signed (top 16 bits)
+	default:
+		for (; i < count; ++i)
+		{
+			const uint8_t* s = data + i * bytes + bytes - 2;
+			out[i]           = (int16_t)(s[0] | (s[1] << 8));
+		}
+		break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Averages each pair of interleaved stereo samples in [in] into a single mono
+// sample, for [frames] frames, written to [out]
+// -----------------------------------------------------------------------------
+void stereoToMono(const int16_t* in, size_t frames, int16_t* out)
+{
+	size_t i = 0;
+#ifdef CONVERSIONS_SSE2
+	__m128i ones = _mm_set1_epi16(1);
+	for (; i + 8 <= frames; i += 8)
+	{
+		// Add left+right pairs into 32-bit sums, halve and pack back to 16-bit
+		__m128i lo = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(in + i * 2)), ones);
+		__m128i hi = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(in + i * 2 + 8)), ones);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_srai_epi32(lo, 1), _mm_srai_epi32(hi, 1)));
+	}
+#endif
+	for (; i < frames; ++i)
+		out[i] = (int16_t)((in[i * 2] + in[i * 2 + 1]) >> 1);
+}
+
+// -----------------------------------------------------------------------------
+// Converts [count] 16-bit signed samples in [in] to 8-bit unsigned samples in
+// [out], rounding to nearest
+// -----------------------------------------------------------------------------
+void pcm16to8bits(const int16_t* in, size_t count, uint8_t* out)
+{
+	size_t i = 0;
+#ifdef CONVERSIONS_SSE2
+	__m128i round = _mm_set1_epi16(0x80);
+	for (; i + 16 <= count; i += 16)
+	{
+		// Round (saturating at the top) and shift to the [-128,127] range,
+		// then pack to signed bytes and flip to unsigned
+		__m128i a  = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128((const __m128i*)(in + i)), round), 8);
+		__m128i b  = _mm_srai_epi16(_mm_adds_epi16(_mm_loadu_si128((const __m128i*)(in + i + 8)), round), 8);
+		__m128i px = _mm_xor_si128(_mm_packs_epi16(a, b), _mm_set1_epi8((char)0x80));
+		_mm_storeu_si128((__m128i*)(out + i), px);
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = (uint8_t)(std::min((in[i] + 0x80) >> 8, 127) + 128);
+}
+
+// -----------------------------------------------------------------------------
+// Resamples [in] from [in_rate] to [out_rate] with a windowed sinc filter
+// (Blackman window, 16 zero crossings either side). When downsampling, the
+// filter cutoff is lowered to the output's Nyquist frequency to avoid aliasing
+// -----------------------------------------------------------------------------
+vector<int16_t> resample(const vector<int16_t>& in, unsigned in_rate, unsigned out_rate)
+{
+	const int    PHASES         = 256;
+	const int    ZERO_CROSSINGS = 16;
+	const double PI             = 3.14159265358979323846;
+
+	double ratio   = (double)out_rate / in_rate;
+	double cutoff  = std::min(1.0, ratio);
+	int    half    = (int)ceil(ZERO_CROSSINGS / cutoff);
+	int    taps    = ((half * 2) + 3) & ~3; // Multiple of 4 for SIMD
+	size_t n_in    = in.size();
+	size_t n_out   = (size_t)(n_in * ratio);
+	vector<int16_t> out(n_out);
+	if (n_out == 0)
+		return out;
+
+	// Build filter table, one row of taps for each fractional phase. Each row
+	// is normalised so the filter has unity gain
+	vector<float> table(PHASES * taps);
+	for (int p = 0; p < PHASES; p++)
+	{
+		float* row = table.data() + p * taps;
+		double sum = 0;
+		for (int k = 0; k < taps; k++)
+		{
+			double t = (k - half + 1) - (double)p / PHASES;
+			double h = 0;
+			if (fabs(t) < half)
+			{
+				double x    = cutoff * t;
+				double sinc = (x == 0) ? 1.0 : sin(PI * x) / (PI * x);
+				double w    = 0.42 + 0.5 * cos(PI * t / half) + 0.08 * cos(2 * PI * t / half);
+				h           = sinc * w;
+			}
+			row[k] = (float)h;
+			sum += h;
+		}
+		for (int k = 0; k < taps; k++)
+			row[k] = (float)(row[k] / sum);
+	}
+
+	// Convert input to float, padded with silence either side
+	vector<float> src(n_in + taps + half + 8, 0.0f);
+	for (size_t i = 0; i < n_in; ++i)
+		src[half + i] = in[i];
+
+	// Filter
+	for (size_t n = 0; n < n_out; ++n)
+	{
+		// Get position in input and filter phase
+		double x  = n / ratio;
+		size_t i0 = (size_t)x;
+		int    p  = (int)((x - i0) * PHASES + 0.5);
+		if (p == PHASES)
+		{
+			p = 0;
+			i0++;
+		}
+
+		// Apply filter to input samples around the position
+		const float* s   = src.data() + i0 + 1;
+		const float* row = table.data() + p * taps;
+		float        value;
+#ifdef CONVERSIONS_SSE2
+		__m128 sum = _mm_setzero_ps();
+		for (int k = 0; k < taps; k += 4)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(s + k), _mm_loadu_ps(row + k)));
+		float parts[4];
+		_mm_storeu_ps(parts, sum);
+		value = parts[0] + parts[1] + parts[2] + parts[3];
+#else
+		value = 0.0f;
+		for (int k = 0; k < taps; k++)
+			value += s[k] * row[k];
+#endif
+
+		out[n] = (int16_t)std::max(-32768.0f, std::min(32767.0f, floorf(value + 0.5f)));
+	}
+
+	return out;
+}
 } // namespace Conversions
 
 // -----------------------------------------------------------------------------
@@ -337,69 +619,34 @@ bool Conversions::doomSndToWav(MemChunk& in, MemChunk& out)
 }
 
 // -----------------------------------------------------------------------------
-// Converts wav data [in] to doom sound format, written to [out]
+// Returns true if converting wav data [in] to doom sound format would lose
+// audio quality (ie. it isn't already 8-bit mono PCM at a usable sample rate)
 // -----------------------------------------------------------------------------
-bool Conversions::wavToDoomSnd(MemChunk& in, MemChunk& out)
+bool Conversions::wavToDoomSndIsLossy(MemChunk& in)
 {
-	// --- Read WAV ---
-	WavChunk chunk;
-
-	// Read header
-	in.seek(0, SEEK_SET);
-	in.read(&chunk, 8);
-
-	// Check header
-	if (chunk.id[0] != 'R' || chunk.id[1] != 'I' || chunk.id[2] != 'F' || chunk.id[3] != 'F')
-	{
-		Global::error = "Invalid WAV";
+	WavInfo info;
+	if (!readWavInfo(in, info))
 		return false;
-	}
 
-	// Read format
-	char format[4];
-	in.read(format, 4);
-
-	// Check format
-	if (format[0] != 'W' || format[1] != 'A' || format[2] != 'V' || format[3] != 'E')
-	{
-		Global::error = "Invalid WAV format";
-		return false;
-	}
-
-	// Find fmt chunk
-	size_t ofs = 12;
-	while (ofs < in.getSize())
-	{
-		if (in[ofs] == 'f' && in[ofs + 1] == 'm' && in[ofs + 2] == 't' && in[ofs + 3] == ' ')
-			break;
-		ofs += 8 + READ_L32(in, (ofs + 4));
-	}
-
-	// Read fmt chunk
-	if (ofs + sizeof(WavFmtChunk) > in.getSize())
-	{
-		Global::error = "Invalid WAV: no 'fmt ' chunk";
-		return false;
-	}
-	in.seek(ofs, SEEK_SET);
-	WavFmtChunk fmtchunk;
-	in.read(&fmtchunk, sizeof(WavFmtChunk));
-
-	// Get format
-	uint8_t wavfmt = fmtchunk.tag == 0xFFFE ? READ_L32(in, ofs + 32) : fmtchunk.tag;
-	// Get byte per samples (from bits per sample)
-	uint8_t wavbps = fmtchunk.bps / 8;
+	return isLossy(info);
+}
 
-	// Check fmt chunk values
-	if (fmtchunk.channels > 2 || fmtchunk.bps % 8 || wavbps > 4
-		|| (wavfmt != WAV_PCM && wavfmt != WAV_ALAW && wavfmt != WAV_ULAW))
-	{
-		Global::error = "Cannot convert WAV file, only stereo or monophonic sounds in PCM format can be converted";
+// -----------------------------------------------------------------------------
+// Converts wav data [in] to doom sound format, written to [out]. If
+// [confirm_loss] is true, the user is asked to confirm first if the conversion
+// will lose audio quality.
+// Samples are decoded to 16-bit, mixed to mono and resampled (if the dsnd_rate
+// cvar is set) before being converted to 8-bit
+// -----------------------------------------------------------------------------
+bool Conversions::wavToDoomSnd(MemChunk& in, MemChunk& out, bool confirm_loss)
+{
+	// --- Read WAV ---
+	WavInfo info;
+	if (!readWavInfo(in, info))
 		return false;
-	}
 
 	// Warn
-	if (wavbps > 1 || wavfmt != WAV_PCM || fmtchunk.channels == 2)
+	if (confirm_loss && isLossy(info))
 	{
 		if (!(wxMessageBox(
 				  S_FMT(
@@ -413,96 +660,58 @@ bool Conversions::wavToDoomSnd(MemChunk& in, MemChunk& out)
 		}
 	}
 
-	// Find data chunk
-	ofs += 8 + wxUINT32_SWAP_ON_BE(fmtchunk.header.size);
-	while (ofs < in.getSize())
-	{
-		if (in[ofs] == 'd' && in[ofs + 1] == 'a' && in[ofs + 2] == 't' && in[ofs + 3] == 'a')
-			break;
-		ofs += 8 + READ_L32(in, (ofs + 4));
-	}
+	// Decode samples to 16-bit
+	size_t          count = info.data_size / info.bytes;
+	vector<int16_t> samples(count);
+	decodeSamples(in.getData() + info.data_ofs, count, info.format, info.bytes, samples.data());
 
-	// Read data
-	if (ofs + sizeof(WavFmtChunk) > in.getSize())
-	{
-		Global::error = "Invalid WAV: no 'data' chunk";
-		return false;
-	}
-	in.seek(ofs, SEEK_SET);
-	in.read(&chunk, 8);
-
-	if (wavbps > 1)
-		chunk.size /= wavbps;
-
-	uint8_t* data = new uint8_t[chunk.size];
-	uint8_t  padding[16];
-
-	// Store sample data. A simple read for 8 bits per sample.
-	if (fmtchunk.bps == 8)
-		in.read(data, chunk.size);
-	// For 16, 24, or 32 bits per sample, downsample to 8.
-	else
+	// Merge stereo channels into a single mono one
+	if (info.channels == 2)
 	{
-		int32_t val = 0;
-		for (size_t i = 0; i < chunk.size; ++i)
-		{
-			in.read(&val, wavbps);
-			if (wavbps == 4)
-				data[i] = pcm32to8bits(val);
-			else if (wavbps == 3)
-				data[i] = pcm24to8bits(val);
-			else if (wavbps == 2)
-				data[i] = pcm16to8bits((int16_t)val);
-		}
+		count /= 2;
+		stereoToMono(samples.data(), count, samples.data());
+		samples.resize(count);
 	}
 
-	// Convert A-law or µ-law to 8-bit linear
-	if (wavfmt == WAV_ALAW || wavfmt == WAV_ULAW)
+	// Resample if needed
+	unsigned rate = doomSndRate(info.samplerate);
+	if (rate != info.samplerate)
+		samples = resample(samples, info.samplerate, rate);
+	if (samples.empty())
 	{
-		for (size_t i = 0; i < chunk.size; ++i)
-		{
-			int16_t val = (wavfmt == WAV_ALAW) ? alawToLinear(data[i]) : mulawToLinear(data[i]);
-			data[i]     = pcm16to8bits(val);
-		}
+		Global::error = "Invalid WAV: no sample data";
+		return false;
 	}
 
-	// Merge stereo channels into a single mono one
-	if (fmtchunk.channels == 2)
-	{
-		chunk.size /= 2;
-		for (size_t i = 0; i < chunk.size; ++i)
-		{
-			size_t j = 2 * i;
-			data[i]  = stereoToMono(data[j], data[j + 1]);
-		}
-	}
+	// Convert to 8-bit
+	vector<uint8_t> data(samples.size());
+	pcm16to8bits(samples.data(), samples.size(), data.data());
 
 	// --- Write Doom Sound ---
 
 	// Write header
 	DSndHeader ds_hdr;
 	ds_hdr.three      = 3;
-	ds_hdr.samplerate = fmtchunk.samplerate;
-	ds_hdr.samples    = chunk.size;
+	ds_hdr.samplerate = rate;
+	ds_hdr.samples    = data.size();
 	if (dmx_padding)
 		ds_hdr.samples += 32;
 	out.write(&ds_hdr, 8);
 
 	// Write data
+	uint8_t padding[16];
 	if (dmx_padding)
 	{
-		memset(padding, data[0], 16);
+		memset(padding, data.front(), 16);
 		out.write(padding, 16);
 	}
-	out.write(data, chunk.size);
+	out.write(data.data(), data.size());
 	if (dmx_padding)
 	{
-		memset(padding, data[chunk.size - 1], 16);
+		memset(padding, data.back(), 16);
 		out.write(padding, 16);
 	}
 
-	delete[] data;
-
 	return true;
 }
 
@@ -888,6 +1097,8 @@ bool Conversions::jagSndToWav(MemChunk& in, MemChunk& out)
 	if (header.samples % 2 != 0)
 		out.write("\0", 1);
 
+	delete[] samples;
+
 	return true;
 }
 
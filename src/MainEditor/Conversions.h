@@ -4,7 +4,8 @@ class ArchiveEntry;
 
 namespace Conversions
 {
-bool wavToDoomSnd(MemChunk& in, MemChunk& out);
+bool wavToDoomSnd(MemChunk& in, MemChunk& out, bool confirm_loss = true);
+bool wavToDoomSndIsLossy(MemChunk& in);
 bool spkSndToWav(MemChunk& in, MemChunk& out, bool audioT = false);
 bool doomSndToWav(MemChunk& in, MemChunk& out);
 bool wolfSndToWav(MemChunk& in, MemChunk& out);
@@ -41,6 +41,7 @@
 #include "Dialogs/Preferences/PreferencesDialog.h"
 #include "General/Console/Console.h"
 #include "General/Misc.h"
+#include "Graphics/PNGOptimiser.h"
 #include "MainEditor/MainEditor.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "UI/TextureXEditor/TextureXEditor.h"
@@ -1433,9 +1434,11 @@ bool EntryOperations::exportAsPNG(ArchiveEntry* entry, string filename)
 }
 
 // -----------------------------------------------------------------------------
-// Attempts to optimize [entry] using external PNG optimizers.
+// Attempts to optimize [entry] using the built-in PNG optimizer, followed by
+// any external PNG optimizers that are configured. If [builtin] is false, only
+// the external optimizers are run
 // -----------------------------------------------------------------------------
-bool EntryOperations::optimizePNG(ArchiveEntry* entry)
+bool EntryOperations::optimizePNG(ArchiveEntry* entry, bool builtin)
 {
 	// Check entry was given
 	if (!entry)
@@ -1452,15 +1455,45 @@ bool EntryOperations::optimizePNG(ArchiveEntry* entry)
 		return false;
 	}
 
+	// Run built-in optimizer
+	bool optimized = false;
+	if (builtin)
+	{
+		MemChunk png;
+		auto     result = PNGOptimiser::optimise(entry->getMCData(), png);
+		if (result.ok)
+		{
+			if (result.new_size < result.old_size)
+			{
+				auto type = entry->getType();
+				entry->importMemChunk(png);
+				entry->setType(type);
+			}
+
+			LOG_MESSAGE(
+				1,
+				"PNG %s size %d => %d (%dms)",
+				entry->getName(),
+				(int)result.old_size,
+				(int)result.new_size,
+				(int)result.time);
+			optimized = true;
+		}
+		else
+			Log::warning(S_FMT("Unable to optimize PNG %s: %s", entry->getName(), result.error));
+	}
+
 	// Check if the PNG tools path are set up, at least one of them should be
+	// (if not, the built-in optimizer is all that's run)
 	string pngpathc = path_pngcrush;
 	string pngpatho = path_pngout;
 	string pngpathd = path_deflopt;
 	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) && (pngpatho.IsEmpty() || !wxFileExists(pngpatho))
 		&& (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
 	{
-		LOG_MESSAGE(1, "PNG tool paths not defined or invalid, no optimization done.");
-		return false;
+		if (!builtin)
+			LOG_MESSAGE(1, "PNG tool paths not defined or invalid, no optimization done.");
+		return optimized;
 	}
 
 	// Save special chunks
@@ -1636,7 +1669,7 @@ bool EntryOperations::optimizePNG(ArchiveEntry* entry)
 		entry->getSize());
 
 
-	if (!crushed && !outed && !errormessages.IsEmpty())
+	if (!crushed && !outed && !optimized && !errormessages.IsEmpty())
 	{
 		ExtMessageDialog dlg(nullptr, "Optimizing Report");
 		dlg.setMessage("The following issues were encountered while optimizing:");
@@ -22,7 +22,7 @@ bool convertTextures(vector<ArchiveEntry*> entries);
 bool findTextureErrors(vector<ArchiveEntry*> entries);
 bool compileACS(ArchiveEntry* entry, bool hexen = false, ArchiveEntry* target = nullptr, wxFrame* parent = nullptr);
 bool exportAsPNG(ArchiveEntry* entry, string filename);
-bool optimizePNG(ArchiveEntry* entry);
+bool optimizePNG(ArchiveEntry* entry, bool builtin = true);
 
 // ANIMATED/SWITCHES
 bool convertAnimated(ArchiveEntry* entry, MemChunk* animdata, bool animdefs);
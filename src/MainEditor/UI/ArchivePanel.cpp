@@ -37,6 +37,7 @@
 #include "Archive/ArchiveManager.h"
 #include "Archive/Formats/ZipArchive.h"
 #include "ArchiveManagerPanel.h"
+#include "Dialogs/ExtMessageDialog.h"
 #include "Dialogs/GfxConvDialog.h"
 #include "Dialogs/MapEditorConfigDialog.h"
 #include "Dialogs/MapReplaceDialog.h"
@@ -62,6 +63,7 @@
 #include "General/Misc.h"
 #include "General/UI.h"
 #include "Graphics/Icons.h"
+#include "Graphics/PNGOptimiser.h"
 #include "Graphics/Palette/PaletteManager.h"
 #include "MainEditor/ArchiveOperations.h"
 #include "MainEditor/Conversions.h"
@@ -74,6 +76,7 @@
 #include "UI/Controls/PaletteChooser.h"
 #include "UI/Controls/SIconButton.h"
 #include "Utility/SFileDialog.h"
+#include "Utility/ThreadPool.h"
 
 
 // -----------------------------------------------------------------------------
@@ -1894,22 +1897,19 @@ bool ArchivePanel::gfxConvert()
 	// Run the gcd
 	gcd.ShowModal();
 
-	// Show splash window
-	UI::showSplash("Writing converted image data...", true);
-
 	// Begin recording undo level
 	undo_manager_->beginRecord("Gfx Format Conversion");
 
-	// Write any changes
+	// Write any changes made in the dialog (entries after that are converted
+	// in a batch, if 'Convert All' was clicked)
+	unsigned count = gcd.batchConvert() ? gcd.batchStart() : selection.size();
+	UI::showSplash("Writing converted image data...", true);
 	entry_list_->setEntriesAutoUpdate(false);
-	for (unsigned a = 0; a < selection.size(); a++)
+	for (unsigned a = 0; a < count; a++)
 	{
-		if (a == selection.size() - 1)
-			entry_list_->setEntriesAutoUpdate(true);
-
 		// Update splash window
 		UI::setSplashProgressMessage(selection[a]->getName());
-		UI::setSplashProgress((float)a / (float)selection.size());
+		UI::setSplashProgress((float)a / (float)count);
 
 		// Skip if the image wasn't converted
 		if (!gcd.itemModified(a))
@@ -1922,22 +1922,124 @@ bool ArchivePanel::gfxConvert()
 		// Write converted image back to entry
 		MemChunk mc;
 		format->saveImage(*image, mc, gcd.getItemPalette(a));
+		undo_manager_->recordUndoStep(new EntryDataUS(selection[a]));
 		selection[a]->importMemChunk(mc);
 		EntryType::detectEntryType(selection[a]);
 		selection[a]->setExtensionByType();
 	}
 	entry_list_->setEntriesAutoUpdate(true);
+	UI::hideSplash();
+
+	// Convert remaining entries
+	if (gcd.batchConvert())
+	{
+		vector<ArchiveEntry*> batch(selection.begin() + count, selection.end());
+		gfxConvertEntries(batch, gcd.batchFormat(), [&](ArchiveEntry* entry, SIFormat::ConvertOptions& opt) {
+			gcd.getBatchConvertOptions(entry, opt);
+		});
+	}
 
 	// Finish recording undo level
 	undo_manager_->endRecord(true);
 
-	// Hide splash window
-	UI::hideSplash();
 	MainEditor::currentEntryPanel()->callRefresh();
 
 	return true;
 }
 
+// -----------------------------------------------------------------------------
+// Converts [entries] to gfx [format], with the conversion options for each
+// entry given by [get_options]. Entries are decoded, converted and encoded in
+// batches across worker threads, then written back in order (undo steps are
+// recorded to the current undo level, if any). If [show_report] is true, a
+// dialog listing any entries that couldn't be converted is shown.
+// Returns the number of entries converted
+// -----------------------------------------------------------------------------
+int ArchivePanel::gfxConvertEntries(
+	const vector<ArchiveEntry*>&   entries,
+	SIFormat*                      format,
+	const GfxConvert::OptionsFunc& get_options,
+	bool                           show_report)
+{
+	if (entries.empty() || !format)
+		return 0;
+
+	UI::showSplash("Converting Gfx...", true);
+	entry_list_->setEntriesAutoUpdate(false);
+
+	auto&     pool      = ThreadPool::global();
+	size_t    batch     = pool.numThreads() * 2;
+	int       converted = 0;
+	string    report;
+	sf::Clock clock;
+	for (size_t start = 0; start < entries.size(); start += batch)
+	{
+		auto end = std::min(start + batch, entries.size());
+
+		UI::setSplashProgressMessage(entries[start]->getName(true));
+		UI::setSplashProgress(float(start) / float(entries.size()));
+
+		// Set up conversion jobs (entry data and palettes have to be loaded
+		// on this thread)
+		vector<std::unique_ptr<GfxConvert::Job>> jobs;
+		vector<SIFormat::ConvertOptions>         options(end - start);
+		vector<uint8_t>                          ready(end - start);
+		for (auto a = start; a < end; ++a)
+		{
+			auto& opt = options[a - start];
+			get_options(entries[a], opt);
+			jobs.push_back(std::make_unique<GfxConvert::Job>());
+			ready[a - start] = GfxConvert::prepare(*jobs.back(), entries[a], opt.pal_current, opt.pal_target);
+		}
+
+		pool.parallelFor(end - start, [&](size_t index) {
+			if (ready[index])
+				GfxConvert::convert(*jobs[index], format, options[index]);
+		});
+
+		// Write converted data back to entries
+		for (auto a = start; a < end; ++a)
+		{
+			auto& job = *jobs[a - start];
+			if (!job.ok)
+			{
+				report += S_FMT("%s: %s\n", entries[a]->getName(), job.error);
+				continue;
+			}
+
+			if (undo_manager_->currentlyRecording())
+				undo_manager_->recordUndoStep(new EntryDataUS(entries[a]));
+			entries[a]->importMemChunk(job.out);
+			EntryType::detectEntryType(entries[a]);
+			entries[a]->setExtensionByType();
+			converted++;
+		}
+	}
+	auto time = clock.getElapsedTime().asMilliseconds();
+
+	entry_list_->setEntriesAutoUpdate(true);
+	UI::hideSplash();
+
+	auto summary = S_FMT(
+		"Converted %d of %d entries to %s in %dms",
+		converted,
+		(int)entries.size(),
+		format->getName(),
+		(int)time);
+	Log::info(summary);
+
+	// Show report if any entries couldn't be converted
+	if (show_report && !report.empty())
+	{
+		ExtMessageDialog dlg(this, "Gfx Format Conversion");
+		dlg.setMessage(summary);
+		dlg.setExt(report);
+		dlg.ShowModal();
+	}
+
+	return converted;
+}
+
 // -----------------------------------------------------------------------------
 // Opens the Translation editor dialog to remap colours on selected gfx entries
 // -----------------------------------------------------------------------------
@@ -2414,45 +2516,16 @@ bool ArchivePanel::palConvert()
 // -----------------------------------------------------------------------------
 bool ArchivePanel::wavDSndConvert()
 {
-	// Get selected entries
-	vector<ArchiveEntry*> selection = entry_list_->getSelectedEntries();
+	// Get selected wav entries
+	vector<ArchiveEntry*> entries;
+	for (auto entry : entry_list_->getSelectedEntries())
+		if (SndConvert::canConvert(entry, SndConvert::Target::DoomSound))
+			entries.push_back(entry);
 
-	// Begin recording undo level
+	// Convert
 	undo_manager_->beginRecord("Convert Wav -> Doom Sound");
-
-	// Go through selection
-	bool errors = false;
-	entry_list_->setEntriesAutoUpdate(false);
-	for (unsigned a = 0; a < selection.size(); a++)
-	{
-		if (a == selection.size() - 1)
-			entry_list_->setEntriesAutoUpdate(true);
-
-		// Convert WAV -> Doom Sound if the entry is WAV format
-		if (selection[a]->getType()->formatId() == "snd_wav")
-		{
-			MemChunk dsnd;
-			// Attempt conversion
-			if (!Conversions::wavToDoomSnd(selection[a]->getMCData(), dsnd))
-			{
-				LOG_MESSAGE(1, "Error: Unable to convert entry %s: %s", selection[a]->getName(), Global::error);
-				errors = true;
-				continue;
-			}
-			undo_manager_->recordUndoStep(new EntryDataUS(selection[a])); // Create undo step
-			selection[a]->importMemChunk(dsnd);                           // Load doom sound data
-			EntryType::detectEntryType(selection[a]);                     // Update entry type
-			selection[a]->setExtensionByType();                           // Update extension if necessary
-		}
-	}
-	entry_list_->setEntriesAutoUpdate(true);
-
-	// Finish recording undo level
-	undo_manager_->endRecord(true);
-
-	// Show message if errors occurred
-	if (errors)
-		wxMessageBox("Some entries could not be converted, see console log for details", "SLADE", wxICON_INFORMATION);
+	auto count = sndConvertEntries(entries, SndConvert::Target::DoomSound);
+	undo_manager_->endRecord(count > 0);
 
 	return true;
 }
@@ -2462,65 +2535,126 @@ bool ArchivePanel::wavDSndConvert()
 // -----------------------------------------------------------------------------
 bool ArchivePanel::dSndWavConvert()
 {
-	// Get selected entries
-	vector<ArchiveEntry*> selection = entry_list_->getSelectedEntries();
+	// Get selected convertible sound entries
+	vector<ArchiveEntry*> entries;
+	for (auto entry : entry_list_->getSelectedEntries())
+		if (SndConvert::canConvert(entry, SndConvert::Target::Wav))
+			entries.push_back(entry);
 
-	// Begin recording undo level
+	// Convert
 	undo_manager_->beginRecord("Convert Doom Sound -> Wav");
+	auto count = sndConvertEntries(entries, SndConvert::Target::Wav);
+	undo_manager_->endRecord(count > 0);
 
-	// Go through selection
-	bool errors = false;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Converts [entries] to [target] sound format, in batches run across the
+// global thread pool. An undo step is recorded for each converted entry if an
+// undo level is being recorded. If [show_report] is true and any entries
+// failed, a dialog listing them is shown. Each entry's conversion time is
+// logged. Returns the number of entries converted
+// -----------------------------------------------------------------------------
+int ArchivePanel::sndConvertEntries(
+	const vector<ArchiveEntry*>& entries,
+	SndConvert::Target           target,
+	bool                         show_report)
+{
+	if (entries.empty())
+		return 0;
+
+	// Ask once for the whole batch if converting will lose quality
+	if (target == SndConvert::Target::DoomSound)
+	{
+		int lossy = 0;
+		for (auto entry : entries)
+			if (SndConvert::canConvert(entry, target) && Conversions::wavToDoomSndIsLossy(entry->getMCData()))
+				lossy++;
+
+		if (lossy > 0
+			&& wxMessageBox(
+				   S_FMT(
+					   "Warning: conversion of %d entries will result in loss of metadata and audio quality. "
+					   "Do you wish to proceed?",
+					   lossy),
+				   "Conversion warning",
+				   wxOK | wxCANCEL)
+				   != wxOK)
+			return 0;
+	}
+
+	UI::showSplash("Converting Sounds...", true);
 	entry_list_->setEntriesAutoUpdate(false);
-	for (unsigned a = 0; a < selection.size(); a++)
+
+	auto&     pool      = ThreadPool::global();
+	size_t    batch     = pool.numThreads() * 4;
+	int       converted = 0;
+	string    report;
+	sf::Clock clock;
+	for (size_t start = 0; start < entries.size(); start += batch)
 	{
-		if (a == selection.size() - 1)
-			entry_list_->setEntriesAutoUpdate(true);
+		auto end = std::min(start + batch, entries.size());
+
+		UI::setSplashProgressMessage(entries[start]->getName(true));
+		UI::setSplashProgress(float(start) / float(entries.size()));
 
-		bool     worked = false;
-		MemChunk wav;
-		// Convert Doom Sound -> WAV if the entry is Doom Sound format
-		if (selection[a]->getType()->formatId() == "snd_doom" || selection[a]->getType()->formatId() == "snd_doom_mac")
-			worked = Conversions::doomSndToWav(selection[a]->getMCData(), wav);
-		// Or Doom Speaker sound format
-		else if (selection[a]->getType()->formatId() == "snd_speaker")
-			worked = Conversions::spkSndToWav(selection[a]->getMCData(), wav);
-		// Or Jaguar Doom sound format
-		else if (selection[a]->getType()->formatId() == "snd_jaguar")
-			worked = Conversions::jagSndToWav(selection[a]->getMCData(), wav);
-		// Or Wolfenstein 3D sound format
-		else if (selection[a]->getType()->formatId() == "snd_wolf")
-			worked = Conversions::wolfSndToWav(selection[a]->getMCData(), wav);
-		// Or Creative Voice File format
-		else if (selection[a]->getType()->formatId() == "snd_voc")
-			worked = Conversions::vocToWav(selection[a]->getMCData(), wav);
-		// Or Blood SFX format (this one needs to be given the entry, not just the mem chunk)
-		else if (selection[a]->getType()->formatId() == "snd_bloodsfx")
-			worked = Conversions::bloodToWav(selection[a], wav);
-		// If successfully converted, update the entry
-		if (worked)
+		// Set up conversion jobs (entry data has to be loaded on this thread)
+		vector<std::unique_ptr<SndConvert::Job>> jobs;
+		vector<uint8_t>                          ready(end - start);
+		for (auto a = start; a < end; ++a)
 		{
-			undo_manager_->recordUndoStep(new EntryDataUS(selection[a])); // Create undo step
-			selection[a]->importMemChunk(wav);                            // Load wav data
-			EntryType::detectEntryType(selection[a]);                     // Update entry type
-			selection[a]->setExtensionByType();                           // Update extension if necessary
+			jobs.push_back(std::make_unique<SndConvert::Job>());
+			ready[a - start] = SndConvert::prepare(*jobs.back(), entries[a], target);
 		}
-		else
+
+		pool.parallelFor(end - start, [&](size_t index) {
+			if (ready[index])
+				SndConvert::convert(*jobs[index], target);
+		});
+
+		// Write converted data back to entries
+		for (auto a = start; a < end; ++a)
 		{
-			LOG_MESSAGE(1, "Error: Unable to convert entry %s: %s", selection[a]->getName(), Global::error);
-			errors = true;
-			continue;
+			auto& job = *jobs[a - start];
+			if (!job.ok)
+			{
+				report += S_FMT("%s: %s\n", entries[a]->getName(), job.error);
+				continue;
+			}
+
+			if (undo_manager_->currentlyRecording())
+				undo_manager_->recordUndoStep(new EntryDataUS(entries[a]));
+			entries[a]->importMemChunk(job.out);
+			EntryType::detectEntryType(entries[a]);
+			entries[a]->setExtensionByType();
+			Log::info(2, S_FMT("Converted %s in %dms", entries[a]->getName(), (int)job.time));
+			converted++;
 		}
 	}
+	auto time = clock.getElapsedTime().asMilliseconds();
+
 	entry_list_->setEntriesAutoUpdate(true);
+	UI::hideSplash();
 
-	// Finish recording undo level
-	undo_manager_->endRecord(true);
+	auto summary = S_FMT(
+		"Converted %d of %d entries to %s in %dms",
+		converted,
+		(int)entries.size(),
+		SndConvert::targetName(target),
+		(int)time);
+	Log::info(summary);
 
-	// Show message if errors occurred
-	if (errors)
-		wxMessageBox("Some entries could not be converted, see console log for details", "SLADE", wxICON_INFORMATION);
+	// Show report if any entries couldn't be converted
+	if (show_report && !report.empty())
+	{
+		ExtMessageDialog dlg(this, "Sound Format Conversion");
+		dlg.setMessage(summary);
+		dlg.setExt(report);
+		dlg.ShowModal();
+	}
 
-	return true;
+	return converted;
 }
 
 // -----------------------------------------------------------------------------
@@ -2589,53 +2723,124 @@ bool ArchivePanel::compileACS(bool hexen)
 }
 
 // -----------------------------------------------------------------------------
-// Compiles any selected text entries as ACS scripts
+// Optimizes any selected PNG entries. The built-in optimizer is run on all of
+// them across worker threads, followed by any configured external PNG tools
 // -----------------------------------------------------------------------------
 bool ArchivePanel::optimizePNG()
 {
-	// Check if the PNG tools path are set up, at least one of them should be
-	string pngpathc = path_pngcrush;
-	string pngpatho = path_pngout;
-	string pngpathd = path_deflopt;
-	if ((pngpathc.IsEmpty() || !wxFileExists(pngpathc)) && (pngpatho.IsEmpty() || !wxFileExists(pngpatho))
-		&& (pngpathd.IsEmpty() || !wxFileExists(pngpathd)))
-	{
-		wxMessageBox(
-			"Error: PNG tool paths not defined or invalid, please configure in SLADE preferences",
-			"Error",
-			wxOK | wxCENTRE | wxICON_ERROR);
+	// Get selected PNG entries
+	vector<ArchiveEntry*> selection;
+	for (auto entry : entry_list_->getSelectedEntries())
+		if (entry->getType()->formatId() == "img_png")
+			selection.push_back(entry);
+	if (selection.empty())
 		return false;
-	}
 
-	// Get selected entries
-	vector<ArchiveEntry*> selection = entry_list_->getSelectedEntries();
-
-	UI::showSplash("Running external programs, please wait...", true);
+	UI::showSplash("Optimizing PNGs, please wait...", true);
 
 	// Begin recording undo level
 	undo_manager_->beginRecord("Optimize PNG");
-
-	// Go through selection
 	entry_list_->setEntriesAutoUpdate(false);
-	for (unsigned a = 0; a < selection.size(); a++)
+
+	// Optimize entries in batches spread across worker threads (entry data
+	// has to be loaded and imported on this thread)
+	auto&                        pool  = ThreadPool::global();
+	size_t                       batch = pool.numThreads() * 2;
+	vector<MemChunk>             data(selection.size());
+	vector<MemChunk>             optimized(selection.size());
+	vector<PNGOptimiser::Result> results(selection.size());
+	sf::Clock                    clock;
+	for (size_t start = 0; start < selection.size(); start += batch)
 	{
-		if (a == selection.size() - 1)
-			entry_list_->setEntriesAutoUpdate(true);
+		auto end = std::min(start + batch, selection.size());
+
+		UI::setSplashProgressMessage(selection[start]->getName(true));
+		UI::setSplashProgress(float(start) / float(selection.size()));
 
-		UI::setSplashProgressMessage(selection[a]->getName(true));
-		UI::setSplashProgress(float(a) / float(selection.size()));
-		if (selection[a]->getType()->formatId() == "img_png")
+		for (auto a = start; a < end; ++a)
+			data[a].importMem(selection[a]->getData(), selection[a]->getSize());
+
+		// Only spread the trials for each entry across threads if there are
+		// fewer entries than threads
+		bool parallel_trials = end - start < pool.numThreads();
+		pool.parallelFor(end - start, [&](size_t index) {
+			auto a     = start + index;
+			results[a] = PNGOptimiser::optimise(data[a], optimized[a], parallel_trials);
+		});
+
+		for (auto a = start; a < end; ++a)
 		{
+			data[a].clear();
+			if (results[a].ok && results[a].new_size < results[a].old_size)
+			{
+				undo_manager_->recordUndoStep(new EntryDataUS(selection[a]));
+				auto type = selection[a]->getType();
+				selection[a]->importMemChunk(optimized[a]);
+				selection[a]->setType(type);
+			}
+			optimized[a].clear();
+		}
+	}
+	auto time = clock.getElapsedTime().asMilliseconds();
+
+	// Run any external tools configured
+	string pngpathc = path_pngcrush;
+	string pngpatho = path_pngout;
+	string pngpathd = path_deflopt;
+	if ((!pngpathc.IsEmpty() && wxFileExists(pngpathc)) || (!pngpatho.IsEmpty() && wxFileExists(pngpatho))
+		|| (!pngpathd.IsEmpty() && wxFileExists(pngpathd)))
+	{
+		UI::setSplashMessage("Running external programs, please wait...");
+		for (unsigned a = 0; a < selection.size(); a++)
+		{
+			UI::setSplashProgressMessage(selection[a]->getName(true));
+			UI::setSplashProgress(float(a) / float(selection.size()));
 			undo_manager_->recordUndoStep(new EntryDataUS(selection[a]));
-			EntryOperations::optimizePNG(selection[a]);
+			EntryOperations::optimizePNG(selection[a], false);
 		}
 	}
+
 	entry_list_->setEntriesAutoUpdate(true);
 	UI::hideSplash();
 
 	// Finish recording undo level
 	undo_manager_->endRecord(true);
 
+	// Show report
+	string report;
+	size_t total_old = 0, total_new = 0;
+	for (unsigned a = 0; a < selection.size(); a++)
+	{
+		auto& result = results[a];
+		if (result.ok)
+			report += S_FMT(
+				"%s: %d => %d bytes (%d saved, %dms)\n",
+				selection[a]->getName(),
+				(int)result.old_size,
+				(int)result.new_size,
+				(int)(result.old_size - result.new_size),
+				(int)result.time);
+		else
+			report += S_FMT("%s: %s\n", selection[a]->getName(), result.error);
+
+		total_old += result.old_size;
+		total_new += result.new_size;
+	}
+
+	auto summary = S_FMT(
+		"Optimized %d PNG entries in %dms, %d bytes saved (%d => %d bytes)",
+		(int)selection.size(),
+		(int)time,
+		(int)(total_old - total_new),
+		(int)total_old,
+		(int)total_new);
+	Log::info(summary);
+
+	ExtMessageDialog dlg(this, "Optimize PNG");
+	dlg.setMessage(summary);
+	dlg.setExt(report);
+	dlg.ShowModal();
+
 	return true;
 }
 
@@ -4277,3 +4482,75 @@ CONSOLE_COMMAND(cd, 1, true)
 		}
 	}
 }
+
+CONSOLE_COMMAND(gfx_convert, 1, true)
+{
+	ArchivePanel* panel = CH::getCurrentArchivePanel();
+	if (!panel)
+		return;
+
+	// Get target format
+	SIFormat* format = SIFormat::getFormat(args[0]);
+	if (format == SIFormat::unknownFormat())
+	{
+		Log::console(S_FMT("Unknown image format \"%s\"", args[0]));
+		return;
+	}
+
+	// Get target colour type (paletted if supported, unless specified)
+	int coltype = format->canWriteType(PALMASK) ? PALMASK : RGBA;
+	if (args.size() > 1)
+	{
+		coltype = GfxConvert::colourType(args[1]);
+		if (coltype < 0)
+		{
+			Log::console("Usage: gfx_convert <format> [paletted|truecolour|alphamap]");
+			return;
+		}
+	}
+
+	// Convert selected entries, using the current palette
+	auto pal_chooser = theMainWindow->getPaletteChooser();
+	panel->undoManager()->beginRecord("Gfx Format Conversion");
+	auto count = panel->gfxConvertEntries(
+		panel->currentEntries(),
+		format,
+		[&](ArchiveEntry* entry, SIFormat::ConvertOptions& opt) {
+			opt.col_format  = coltype;
+			opt.pal_current = pal_chooser->getSelectedPalette(entry);
+			opt.pal_target  = opt.pal_current;
+		},
+		false);
+	panel->undoManager()->endRecord(count > 0);
+	panel->reloadCurrentPanel();
+}
+
+CONSOLE_COMMAND(snd_convert, 1, true)
+{
+	ArchivePanel* panel = CH::getCurrentArchivePanel();
+	if (!panel)
+		return;
+
+	// Get target format
+	SndConvert::Target target;
+	if (S_CMPNOCASE(args[0], "wav"))
+		target = SndConvert::Target::Wav;
+	else if (S_CMPNOCASE(args[0], "doom"))
+		target = SndConvert::Target::DoomSound;
+	else
+	{
+		Log::console("Usage: snd_convert <wav|doom>");
+		return;
+	}
+
+	// Convert selected entries that can be converted
+	vector<ArchiveEntry*> entries;
+	for (auto entry : panel->currentEntries())
+		if (SndConvert::canConvert(entry, target))
+			entries.push_back(entry);
+
+	panel->undoManager()->beginRecord("Sound Format Conversion");
+	auto count = panel->sndConvertEntries(entries, target, false);
+	panel->undoManager()->endRecord(count > 0);
+	panel->reloadCurrentPanel();
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "Audio/SndConvert.h"
 #include "General/ListenerAnnouncer.h"
 #include "General/SAction.h"
 #include "General/UndoRedo.h"
+#include "Graphics/GfxConvert.h"
 #include "MainEditor/ExternalEditManager.h"
 #include "UI/Lists/ArchiveEntryList.h"
 
@@ -58,6 +60,11 @@ public:
 
 	// Other entry actions
 	bool gfxConvert();
+	int  gfxConvertEntries(
+		const vector<ArchiveEntry*>&   entries,
+		SIFormat*                      format,
+		const GfxConvert::OptionsFunc& get_options,
+		bool                           show_report = true);
 	bool gfxRemap();
 	bool gfxColourise();
 	bool gfxTint();
@@ -69,6 +76,10 @@ public:
 	bool reloadCurrentPanel();
 	bool wavDSndConvert();
 	bool dSndWavConvert();
+	int  sndConvertEntries(
+		const vector<ArchiveEntry*>& entries,
+		SndConvert::Target           target,
+		bool                         show_report = true);
 	bool musMidiConvert();
 	bool optimizePNG();
 	bool compileACS(bool hexen = false);
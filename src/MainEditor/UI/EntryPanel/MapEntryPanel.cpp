@@ -165,16 +165,9 @@ bool MapEntryPanel::createImage()
 	if (entry_ == nullptr)
 		return false;
 
+	// Create image (drawn in software if OpenGL can't render to one)
 	ArchiveEntry temp;
-
-	// Stupid OpenGL grumble grumble grumble
-	if (GLEW_ARB_framebuffer_object)
-		map_canvas_->createImage(temp, map_image_width, map_image_height);
-	else
-		map_canvas_->createImage(
-			temp,
-			min<int>(map_image_width, map_canvas_->GetSize().x),
-			min<int>(map_image_height, map_canvas_->GetSize().y));
+	map_canvas_->createImage(temp, map_image_width, map_image_height);
 
 	string     name = S_FMT("%s_%s", entry_->getParent()->filename(false), entry_->getName());
 	wxFileName fn(name);
@@ -287,6 +287,20 @@ bool TextEntryPanel::redo()
 	return false;
 }
 
+// -----------------------------------------------------------------------------
+// Moves the cursor to the start of [line] (first line is 1) and scrolls to it
+// -----------------------------------------------------------------------------
+void TextEntryPanel::goToLine(int line)
+{
+	if (line < 1 || line > text_area_->GetNumberOfLines())
+		return;
+
+	int pos = text_area_->PositionFromLine(line - 1);
+	text_area_->GotoPos(pos);
+	text_area_->EnsureVisibleEnforcePolicy(line - 1);
+	text_area_->SetFocus();
+}
+
 // -----------------------------------------------------------------------------
 // Handles the action [id].
 // Returns true if the action was handled, false otherwise
@@ -38,6 +38,7 @@
 #include "ArchivePanel.h"
 #include "Dialogs/Preferences/BaseResourceArchivesPanel.h"
 #include "Dialogs/Preferences/PreferencesDialog.h"
+#include "Dialogs/TextSearchDialog.h"
 #include "General/Misc.h"
 #include "Graphics/Icons.h"
 #include "MapEditor/MapEditor.h"
@@ -318,6 +319,7 @@ void MainWindow::setupLayout()
 	// Tools menu
 	wxMenu* tools_menu = new wxMenu("");
 	SAction::fromId("main_runscript")->addToMenu(tools_menu);
+	SAction::fromId("main_textsearch")->addToMenu(tools_menu);
 	menu->Append(tools_menu, "&Tools");
 
 	// Help menu
@@ -644,6 +646,13 @@ bool MainWindow::handleAction(string id)
 		return true;
 	}
 
+	// Tools->Search Text in Archives
+	if (id == "main_textsearch")
+	{
+		TextSearchDialog::open(this);
+		return true;
+	}
+
 	// Help->About
 	if (id == "main_about")
 	{
@@ -2156,6 +2156,73 @@ CONSOLE_COMMAND(m_n_polys, 0, false)
 	Log::console(S_FMT("%d polygons total", npoly));
 }
 
+CONSOLE_COMMAND(m_test_vbo_data, 0, false)
+{
+	sf::Clock clock;
+	bool ok = MapEditor::editContext().renderer().renderer2D().checkVBOData();
+	long ms = clock.getElapsedTime().asMilliseconds();
+
+	if (ok)
+		Log::console(S_FMT("2d VBO data matches full rebuild (took %ldms)", ms));
+	else
+		Log::console("2d VBO data differs from full rebuild, see log for details");
+}
+
+CONSOLE_COMMAND(m_test_map_objects, 0, false)
+{
+	auto& context = MapEditor::editContext();
+	if (!context.mapDesc().head)
+	{
+		Log::console("Current map has not been saved");
+		return;
+	}
+
+	int runs = 5;
+	if (!args.empty())
+		runs = max(1, atoi(CHR(args[0])));
+
+	long time_load = 0;
+	long time_iterate = 0;
+	long time_clear = 0;
+	double total = 0;
+	for (int run = 0; run < runs; run++)
+	{
+		SLADEMap map;
+
+		// Load
+		sf::Clock clock;
+		map.readMap(context.mapDesc());
+		time_load += clock.getElapsedTime().asMicroseconds();
+
+		// Iterate (follow line->vertex and side->sector references)
+		clock.restart();
+		for (unsigned a = 0; a < map.nLines(); a++)
+		{
+			MapLine* line = map.getLine(a);
+			total += line->x1() + line->y2();
+			if (line->s1() && line->s1()->getSector())
+				total += line->s1()->getSector()->getFloorHeight();
+		}
+		for (unsigned a = 0; a < map.nThings(); a++)
+			total += map.getThing(a)->xPos();
+		time_iterate += clock.getElapsedTime().asMicroseconds();
+
+		// Clear
+		clock.restart();
+		map.clearMap();
+		time_clear += clock.getElapsedTime().asMicroseconds();
+	}
+
+	Log::console(S_FMT(
+		"Average over %d runs: load %1.2fms, iterate %1.3fms, clear %1.2fms (%1.0f)",
+		runs,
+		(double)time_load / runs / 1000.0,
+		(double)time_iterate / runs / 1000.0,
+		(double)time_clear / runs / 1000.0,
+		total
+	));
+}
+
 CONSOLE_COMMAND(mobj_info, 1, false)
 {
 	long id;
@@ -0,0 +1,864 @@
+
+/*******************************************************************
+ * SLADE - It's a Doom Editor
+ * Copyright (C) 2008-2014 Simon Judd
+ *
+ * Email:       sirjuddington@gmail.com
+ * Web:         http://slade.mancubus.net
+ * Filename:    MapPreviewData.cpp
+ * Description: MapPreviewData class, reads the basic features of a
+ *              map for previewing, and can draw them to an image
+ *              without OpenGL
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *******************************************************************/
+
+
+/*******************************************************************
+ * INCLUDES
+ *******************************************************************/
+#include "Main.h"
+#include "MapPreviewData.h"
+#include "Archive/Formats/WadArchive.h"
+#include "General/ColourConfiguration.h"
+#include "Graphics/LineRasteriser.h"
+#include "Graphics/SImage/SImage.h"
+#include "MapEditor/SLADEMap/MapLine.h"
+#include "MapEditor/SLADEMap/MapThing.h"
+#include "MapEditor/SLADEMap/MapVertex.h"
+#include "Utility/Tokenizer.h"
+
+
+/*******************************************************************
+ * VARIABLES
+ *******************************************************************/
+CVAR(Float, map_image_thickness, 1.5, CVAR_SAVE)
+
+
+/*******************************************************************
+ * MAPPREVIEWDATA CLASS FUNCTIONS
+ *******************************************************************/
+
+/* MapPreviewData::MapPreviewData
+ * MapPreviewData class constructor
+ *******************************************************************/
+MapPreviewData::MapPreviewData()
+{
+	n_sides = 0;
+	n_sectors = 0;
+}
+
+/* MapPreviewData::addVertex
+ * Adds a vertex to the map data
+ *******************************************************************/
+void MapPreviewData::addVertex(double x, double y)
+{
+	verts.push_back(mep_vertex_t(x, y));
+}
+
+/* MapPreviewData::addLine
+ * Adds a line to the map data
+ *******************************************************************/
+void MapPreviewData::addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro)
+{
+	mep_line_t line(v1, v2);
+	line.twosided = twosided;
+	line.special = special;
+	line.macro = macro;
+	lines.push_back(line);
+}
+
+/* MapPreviewData::addThing
+ * Adds a thing to the map data
+ *******************************************************************/
+void MapPreviewData::addThing(double x, double y)
+{
+	mep_thing_t thing;
+	thing.x = x;
+	thing.y = y;
+	things.push_back(thing);
+}
+
+/* MapPreviewData::openMap
+ * Opens a map from a mapdesc_t
+ *******************************************************************/
+bool MapPreviewData::openMap(Archive::MapDesc map)
+{
+	// All errors = invalid map
+	Global::error = "Invalid map";
+
+	// Check if this map is a pk3 map
+	bool map_archive = false;
+	std::unique_ptr<WadArchive> temp_archive;
+	if (map.archive)
+	{
+		map_archive = true;
+
+		// Attempt to open entry as wad archive
+		temp_archive.reset(new WadArchive());
+		if (!temp_archive->open(map.head))
+			return false;
+
+		// Detect maps
+		vector<Archive::MapDesc> maps = temp_archive->detectMaps();
+
+		// Set map if there are any in the archive
+		if (maps.size() > 0)
+			map = maps[0];
+		else
+			return false;
+	}
+
+	// Parse UDMF map
+	if (map.format == MAP_UDMF)
+	{
+		ArchiveEntry* udmfdata = nullptr;
+		for (ArchiveEntry* mapentry = map.head; mapentry != map.end; mapentry = mapentry->nextEntry())
+		{
+			// Check entry type
+			if (mapentry->getType() == EntryType::fromId("udmf_textmap"))
+			{
+				udmfdata = mapentry;
+				break;
+			}
+		}
+		if (udmfdata == nullptr)
+			return false;
+
+		// Start parsing
+		Tokenizer tz;
+		tz.openMem(udmfdata->getMCData(), map.head->getName());
+
+		// Get first token
+		string token = tz.getToken();
+		size_t vertcounter = 0, linecounter = 0, thingcounter = 0;
+		while (!token.IsEmpty())
+		{
+			if (!token.CmpNoCase("namespace"))
+			{
+				//  skip till we reach the ';'
+				do { token = tz.getToken(); }
+				while (token.Cmp(";"));
+			}
+			else if (!token.CmpNoCase("vertex"))
+			{
+				// Get X and Y properties
+				bool gotx = false;
+				bool goty = false;
+				double x = 0.;
+				double y = 0.;
+				do
+				{
+					token = tz.getToken();
+					if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
+					{
+						bool isx = !token.CmpNoCase("x");
+						token = tz.getToken();
+						if (token.Cmp("="))
+						{
+							LOG_MESSAGE(1, "Bad syntax for vertex %i in UDMF map data", vertcounter);
+							return false;
+						}
+						if (isx) x = tz.getDouble(), gotx = true;
+						else y = tz.getDouble(), goty = true;
+						// skip to end of declaration after each key
+						do { token = tz.getToken(); }
+						while (token.Cmp(";"));
+					}
+				}
+				while (token.Cmp("}"));
+				if (gotx && goty)
+					addVertex(x, y);
+				else
+				{
+					LOG_MESSAGE(1, "Wrong vertex %i in UDMF map data", vertcounter);
+					return false;
+				}
+				vertcounter++;
+			}
+			else if (!token.CmpNoCase("linedef"))
+			{
+				bool special = false;
+				bool twosided = false;
+				bool gotv1 = false, gotv2 = false;
+				size_t v1 = 0, v2 = 0;
+				do
+				{
+					token = tz.getToken();
+					if (!token.CmpNoCase("v1") || !token.CmpNoCase("v2"))
+					{
+						bool isv1 = !token.CmpNoCase("v1");
+						token = tz.getToken();
+						if (token.Cmp("="))
+						{
+							LOG_MESSAGE(1, "Bad syntax for linedef %i in UDMF map data", linecounter);
+							return false;
+						}
+						if (isv1) v1 = tz.getInteger(), gotv1 = true;
+						else v2 = tz.getInteger(), gotv2 = true;
+						// skip to end of declaration after each key
+						do { token = tz.getToken(); }
+						while (token.Cmp(";"));
+					}
+					else if (!token.CmpNoCase("special"))
+					{
+						special = true;
+						// skip to end of declaration after each key
+						do { token = tz.getToken(); }
+						while (token.Cmp(";"));
+					}
+					else if (!token.CmpNoCase("sideback"))
+					{
+						twosided = true;
+						// skip to end of declaration after each key
+						do { token = tz.getToken(); }
+						while (token.Cmp(";"));
+					}
+				}
+				while (token.Cmp("}"));
+				if (gotv1 && gotv2)
+					addLine(v1, v2, twosided, special);
+				else
+				{
+					LOG_MESSAGE(1, "Wrong line %i in UDMF map data", linecounter);
+					return false;
+				}
+				linecounter++;
+			}
+			else if (S_CMPNOCASE(token, "thing"))
+			{
+				// Get X and Y properties
+				bool gotx = false;
+				bool goty = false;
+				double x = 0.;
+				double y = 0.;
+				do
+				{
+					token = tz.getToken();
+					if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
+					{
+						bool isx = !token.CmpNoCase("x");
+						token = tz.getToken();
+						if (token.Cmp("="))
+						{
+							LOG_MESSAGE(1, "Bad syntax for thing %i in UDMF map data", vertcounter);
+							return false;
+						}
+						if (isx) x = tz.getDouble(), gotx = true;
+						else y = tz.getDouble(), goty = true;
+						// skip to end of declaration after each key
+						do { token = tz.getToken(); } while (token.Cmp(";"));
+					}
+				} while (token.Cmp("}"));
+				if (gotx && goty)
+					addThing(x, y);
+				else
+				{
+					LOG_MESSAGE(1, "Wrong thing %i in UDMF map data", vertcounter);
+					return false;
+				}
+				vertcounter++;
+			}
+			else
+			{
+				// Check for side or sector definition (increase counts)
+				if (S_CMPNOCASE(token, "sidedef"))
+					n_sides++;
+				else if (S_CMPNOCASE(token, "sector"))
+					n_sectors++;
+
+				// map preview ignores sidedefs, sectors, comments,
+				// unknown fields, etc. so skip to end of block
+				do { token = tz.getToken(); }
+				while (token.Cmp("}") && !token.empty());
+			}
+			// Iterate to next token
+			token = tz.getToken();
+		}
+	}
+
+	// Non-UDMF map
+	if (map.format != MAP_UDMF)
+	{
+		// Read vertices (required)
+		if (!readVertices(map.head, map.end, map.format))
+			return false;
+
+		// Read linedefs (required)
+		if (!readLines(map.head, map.end, map.format))
+			return false;
+
+		// Read things
+		if (map.format != MAP_UDMF)
+			readThings(map.head, map.end, map.format);
+
+		// Read sides & sectors (count only)
+		ArchiveEntry* sidedefs = nullptr;
+		ArchiveEntry* sectors = nullptr;
+		while (map.head)
+		{
+			// Check entry type
+			if (map.head->getType() == EntryType::fromId("map_sidedefs"))
+				sidedefs = map.head;
+			if (map.head->getType() == EntryType::fromId("map_sectors"))
+				sectors = map.head;
+
+			// Exit loop if we've reached the end of the map entries
+			if (map.head == map.end)
+				break;
+			else
+				map.head = map.head->nextEntry();
+		}
+		if (sidedefs && sectors)
+		{
+			// Doom64 map
+			if (map.format != MAP_DOOM64)
+			{
+				n_sides = sidedefs->getSize() / 30;
+				n_sectors = sectors->getSize() / 26;
+			}
+
+			// Doom/Hexen map
+			else
+			{
+				n_sides = sidedefs->getSize() / 12;
+				n_sectors = sectors->getSize() / 16;
+			}
+		}
+	}
+
+	// Clean up
+	if (map_archive)
+		temp_archive->close();
+
+	return true;
+}
+
+/* MapPreviewData::readVertices
+ * Reads non-UDMF vertex data
+ *******************************************************************/
+bool MapPreviewData::readVertices(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
+{
+	// Find VERTEXES entry
+	ArchiveEntry* vertexes = nullptr;
+	while (map_head)
+	{
+		// Check entry type
+		if (map_head->getType() == EntryType::fromId("map_vertexes"))
+		{
+			vertexes = map_head;
+			break;
+		}
+
+		// Exit loop if we've reached the end of the map entries
+		if (map_head == map_end)
+			break;
+		else
+			map_head = map_head->nextEntry();
+	}
+
+	// Can't open a map without vertices
+	if (!vertexes)
+		return false;
+
+	// Read vertex data
+	MemChunk& mc = vertexes->getMCData();
+	mc.seek(0, SEEK_SET);
+
+	if (map_format == MAP_DOOM64)
+	{
+		doom64vertex_t v;
+		while (1)
+		{
+			// Read vertex
+			if (!mc.read(&v, 8))
+				break;
+
+			// Add vertex
+			addVertex((double)v.x/65536, (double)v.y/65536);
+		}
+	}
+	else
+	{
+		doomvertex_t v;
+		while (1)
+		{
+			// Read vertex
+			if (!mc.read(&v, 4))
+				break;
+
+			// Add vertex
+			addVertex((double)v.x, (double)v.y);
+		}
+	}
+
+	return true;
+}
+
+/* MapPreviewData::readLines
+ * Reads non-UDMF line data
+ *******************************************************************/
+bool MapPreviewData::readLines(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
+{
+	// Find LINEDEFS entry
+	ArchiveEntry* linedefs = nullptr;
+	while (map_head)
+	{
+		// Check entry type
+		if (map_head->getType() == EntryType::fromId("map_linedefs"))
+		{
+			linedefs = map_head;
+			break;
+		}
+
+		// Exit loop if we've reached the end of the map entries
+		if (map_head == map_end)
+			break;
+		else
+			map_head = map_head->nextEntry();
+	}
+
+	// Can't open a map without linedefs
+	if (!linedefs)
+		return false;
+
+	// Read line data
+	MemChunk& mc = linedefs->getMCData();
+	mc.seek(0, SEEK_SET);
+	if (map_format == MAP_DOOM)
+	{
+		while (1)
+		{
+			// Read line
+			doomline_t l;
+			if (!mc.read(&l, sizeof(doomline_t)))
+				break;
+
+			// Check properties
+			bool special = false;
+			bool twosided = false;
+			if (l.side2 != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+				special = true;
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special);
+		}
+	}
+	else if (map_format == MAP_DOOM64)
+	{
+		while (1)
+		{
+			// Read line
+			doom64line_t l;
+			if (!mc.read(&l, sizeof(doom64line_t)))
+				break;
+
+			// Check properties
+			bool macro = false;
+			bool special = false;
+			bool twosided = false;
+			if (l.side2  != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+			{
+				if (l.type & 0x100)
+					macro = true;
+				else special = true;
+			}
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special, macro);
+		}
+	}
+	else if (map_format == MAP_HEXEN)
+	{
+		while (1)
+		{
+			// Read line
+			hexenline_t l;
+			if (!mc.read(&l, sizeof(hexenline_t)))
+				break;
+
+			// Check properties
+			bool special = false;
+			bool twosided = false;
+			if (l.side2 != 0xFFFF)
+				twosided = true;
+			if (l.type > 0)
+				special = true;
+
+			// Add line
+			addLine(l.vertex1, l.vertex2, twosided, special);
+		}
+	}
+
+	return true;
+}
+
+/* MapPreviewData::readThings
+ * Reads non-UDMF thing data
+ *******************************************************************/
+bool MapPreviewData::readThings(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
+{
+	// Find THINGS entry
+	ArchiveEntry* things = nullptr;
+	while (map_head)
+	{
+		// Check entry type
+		if (map_head->getType() == EntryType::fromId("map_things"))
+		{
+			things = map_head;
+			break;
+		}
+
+		// Exit loop if we've reached the end of the map entries
+		if (map_head == map_end)
+			break;
+		else
+			map_head = map_head->nextEntry();
+	}
+
+	// No things
+	if (!things)
+		return false;
+
+	// Read things data
+	if (map_format == MAP_DOOM)
+	{
+		doomthing_t* thng_data = (doomthing_t*)things->getData(true);
+		unsigned nt = things->getSize() / sizeof(doomthing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+	else if (map_format == MAP_DOOM64)
+	{
+		doom64thing_t* thng_data = (doom64thing_t*)things->getData(true);
+		unsigned nt = things->getSize() / sizeof(doom64thing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+	else if (map_format == MAP_HEXEN)
+	{
+		hexenthing_t* thng_data = (hexenthing_t*)things->getData(true);
+		unsigned nt = things->getSize() / sizeof(hexenthing_t);
+		for (size_t a = 0; a < nt; a++)
+			addThing(thng_data[a].x, thng_data[a].y);
+	}
+
+	return true;
+}
+
+/* MapPreviewData::clear
+ * Clears map data
+ *******************************************************************/
+void MapPreviewData::clear()
+{
+	verts.clear();
+	lines.clear();
+	things.clear();
+	n_sides = 0;
+	n_sectors = 0;
+}
+
+
+/* MapPreviewData::getImageSize
+ * Resolves the size of an image of the map. A [width] or [height] of
+ * 0 or less means the map size divided by that amount (5 if 0)
+ *******************************************************************/
+void MapPreviewData::getImageSize(int& width, int& height)
+{
+	if (width == 0) width = -5;
+	if (height == 0) height = -5;
+	if (width < 0)
+		width = getWidth() / abs(width);
+	if (height < 0)
+		height = getHeight() / abs(height);
+}
+
+/* MapPreviewData::renderImage
+ * Draws the map lines to [image] ([width]x[height] pixels) using the
+ * software line rasteriser, the same way MapPreviewCanvas::createImage
+ * does with OpenGL. Returns false if there is nothing to draw
+ *******************************************************************/
+bool MapPreviewData::renderImage(SImage& image, int width, int height)
+{
+	if (verts.empty() || width <= 0 || height <= 0)
+		return false;
+
+	// Find extents of map
+	mep_vertex_t m_min(999999.0, 999999.0);
+	mep_vertex_t m_max(-999999.0, -999999.0);
+	for (unsigned a = 0; a < verts.size(); a++)
+	{
+		if (verts[a].x < m_min.x)
+			m_min.x = verts[a].x;
+		if (verts[a].x > m_max.x)
+			m_max.x = verts[a].x;
+		if (verts[a].y < m_min.y)
+			m_min.y = verts[a].y;
+		if (verts[a].y > m_max.y)
+			m_max.y = verts[a].y;
+	}
+	double mapwidth = m_max.x - m_min.x;
+	double mapheight = m_max.y - m_min.y;
+
+	// Setup colours
+	rgba_t col_save_background = ColourConfiguration::getColour("map_image_background");
+	rgba_t col_save_line_1s = ColourConfiguration::getColour("map_image_line_1s");
+	rgba_t col_save_line_2s = ColourConfiguration::getColour("map_image_line_2s");
+	rgba_t col_save_line_special = ColourConfiguration::getColour("map_image_line_special");
+	rgba_t col_save_line_macro = ColourConfiguration::getColour("map_image_line_macro");
+
+	// Zoom/offset to show full map
+	double offset_x = m_min.x + (mapwidth * 0.5);
+	double offset_y = m_min.y + (mapheight * 0.5);
+	double zoom = MIN((double)width / mapwidth, (double)height / mapheight) * 0.95;
+
+	// Add lines, 2s lines first so 1s lines are drawn over them. Image
+	// y is flipped since it goes down from the top
+	LineRasteriser rasteriser(width, height);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (unsigned a = 0; a < lines.size(); a++)
+		{
+			mep_line_t& line = lines[a];
+			if (line.twosided != (pass == 0))
+				continue;
+
+			// Check ends
+			if (line.v1 >= verts.size() || line.v2 >= verts.size())
+				continue;
+
+			// Get colour
+			rgba_t colour = col_save_line_1s;
+			if (line.special)
+				colour = col_save_line_special;
+			else if (line.macro)
+				colour = col_save_line_macro;
+			else if (line.twosided)
+				colour = col_save_line_2s;
+
+			mep_vertex_t& v1 = verts[line.v1];
+			mep_vertex_t& v2 = verts[line.v2];
+			rasteriser.addLine(
+				(v1.x - offset_x) * zoom + (width >> 1),
+				height - ((v1.y - offset_y) * zoom + (height >> 1)),
+				(v2.x - offset_x) * zoom + (width >> 1),
+				height - ((v2.y - offset_y) * zoom + (height >> 1)),
+				colour,
+				map_image_thickness);
+		}
+	}
+
+	return rasteriser.render(image, col_save_background);
+}
+
+/* MapPreviewData::nVertices
+ * Returns the number of (attached) vertices in the map
+ *******************************************************************/
+unsigned MapPreviewData::nVertices()
+{
+	// Get list of used vertices
+	vector<bool> v_used;
+	for (unsigned a = 0; a < verts.size(); a++)
+		v_used.push_back(false);
+	for (unsigned a = 0; a < lines.size(); a++)
+	{
+		v_used[lines[a].v1] = true;
+		v_used[lines[a].v2] = true;
+	}
+
+	// Get count of used vertices
+	unsigned count = 0;
+	for (unsigned a = 0; a < v_used.size(); a++)
+	{
+		if (v_used[a])
+			count++;
+	}
+
+	return count;
+}
+
+/* MapPreviewData::nSides
+ * Returns the number of sides in the map
+ *******************************************************************/
+unsigned MapPreviewData::nSides()
+{
+	return n_sides;
+}
+
+/* MapPreviewData::nLines
+ * Returns the number of lines in the map
+ *******************************************************************/
+unsigned MapPreviewData::nLines()
+{
+	return lines.size();
+}
+
+/* MapPreviewData::nSectors
+ * Returns the number of sectors in the map
+ *******************************************************************/
+unsigned MapPreviewData::nSectors()
+{
+	return n_sectors;
+}
+
+/* MapPreviewData::nThings
+ * Returns the number of things in the map
+ *******************************************************************/
+unsigned MapPreviewData::nThings()
+{
+	return things.size();
+}
+
+/* MapPreviewData::getWidth
+ * Returns the width (in map units) of the map
+ *******************************************************************/
+unsigned MapPreviewData::getWidth()
+{
+	int min_x = wxINT32_MAX;
+	int max_x = wxINT32_MIN;
+
+	for (unsigned a = 0; a < verts.size(); a++)
+	{
+		if (verts[a].x < min_x)
+			min_x = verts[a].x;
+		if (verts[a].x > max_x)
+			max_x = verts[a].x;
+	}
+
+	return max_x - min_x;
+}
+
+/* MapPreviewData::getHeight
+ * Returns the height (in map units) of the map
+ *******************************************************************/
+unsigned MapPreviewData::getHeight()
+{
+	int min_y = wxINT32_MAX;
+	int max_y = wxINT32_MIN;
+
+	for (unsigned a = 0; a < verts.size(); a++)
+	{
+		if (verts[a].y < min_y)
+			min_y = verts[a].y;
+		if (verts[a].y > max_y)
+			max_y = verts[a].y;
+	}
+
+	return max_y - min_y;
+}
+
+
+
+/*******************************************************************
+ * CONSOLE COMMANDS
+ *******************************************************************/
+#include "App.h"
+#include "Archive/ArchiveManager.h"
+#include "General/Console/Console.h"
+#include "Graphics/SImage/SIFormat.h"
+#include "MainEditor/MainEditor.h"
+
+EXTERN_CVAR(Int, map_image_width)
+EXTERN_CVAR(Int, map_image_height)
+
+/* Console command: map_images
+ * Saves a PNG image of every map in the given archive files (or the
+ * current archive if none given) to the directory [args[0]], drawn
+ * with the software rasteriser so no OpenGL context is needed
+ *******************************************************************/
+CONSOLE_COMMAND(map_images, 1, true)
+{
+	string dir = args[0];
+	if (!wxDirExists(dir) && !wxMkdir(dir))
+	{
+		Log::console(S_FMT("Unable to create directory \"%s\"", dir));
+		return;
+	}
+
+	// Get archives to image maps from
+	vector<string> filenames(args.begin() + 1, args.end());
+	vector<Archive*> archives;
+	if (filenames.empty())
+		archives.push_back(MainEditor::currentArchive());
+	else
+	{
+		for (auto& filename : filenames)
+		{
+			// Open archive if it isn't already (and close it when done)
+			Archive* archive = App::archiveManager().getArchive(filename);
+			if (!archive)
+			{
+				archive = App::archiveManager().openArchive(filename, false, true);
+				if (!archive)
+				{
+					Log::console(S_FMT("Unable to open \"%s\": %s", filename, Global::error));
+					continue;
+				}
+			}
+			archives.push_back(archive);
+		}
+	}
+
+	SIFormat* fmt_png = SIFormat::getFormat("png");
+	long start = App::runTimer();
+	int count = 0, failed = 0;
+	for (unsigned a = 0; a < archives.size(); a++)
+	{
+		Archive* archive = archives[a];
+		if (!archive)
+			continue;
+
+		vector<Archive::MapDesc> maps = archive->detectMaps();
+		for (auto& map : maps)
+		{
+			// Read map and draw image
+			MapPreviewData data;
+			SImage image;
+			MemChunk png;
+			int width = map_image_width;
+			int height = map_image_height;
+			if (data.openMap(map))
+				data.getImageSize(width, height);
+			if (!data.renderImage(image, width, height) || !fmt_png->saveImage(image, png))
+			{
+				Log::console(S_FMT("Unable to create image of map %s in %s", map.name, archive->filename(false)));
+				failed++;
+				continue;
+			}
+
+			// Save it
+			string filename = S_FMT("%s/%s_%s.png", dir, archive->filename(false), map.name);
+			if (png.exportFile(filename))
+				count++;
+			else
+				failed++;
+		}
+
+		// Close the archive if it was opened here
+		if (!filenames.empty() && !App::archiveManager().getArchive(archive->filename()))
+			delete archive;
+	}
+
+	Log::console(S_FMT(
+		"Saved %d map images to %s in %dms (%d failed)",
+		count,
+		dir,
+		(int)(App::runTimer() - start),
+		failed));
+}
@@ -0,0 +1,76 @@
+
+#ifndef __MAP_PREVIEW_DATA_H__
+#define __MAP_PREVIEW_DATA_H__
+
+#include "Archive/Archive.h"
+
+// Structs for basic map features
+struct mep_vertex_t
+{
+	double x;
+	double y;
+	mep_vertex_t(double x, double y) { this->x = x; this->y = y; }
+};
+
+struct mep_line_t
+{
+	unsigned	v1;
+	unsigned	v2;
+	bool		twosided;
+	bool		special;
+	bool		macro;
+	bool		segment;
+	mep_line_t(unsigned v1, unsigned v2) { this->v1 = v1; this->v2 = v2; }
+};
+
+struct mep_thing_t
+{
+	double	x;
+	double	y;
+};
+
+/* MapPreviewData
+ * The basic features of a map (vertices, lines and things) read from
+ * its entries, for previewing. Doesn't need any UI or OpenGL, so can
+ * also be used to create map images without them
+ *******************************************************************/
+class SImage;
+class MapPreviewData
+{
+private:
+	vector<mep_vertex_t>	verts;
+	vector<mep_line_t>		lines;
+	vector<mep_thing_t>		things;
+	unsigned				n_sides;
+	unsigned				n_sectors;
+
+public:
+	MapPreviewData();
+	~MapPreviewData() {}
+
+	const vector<mep_vertex_t>&	getVertices() const { return verts; }
+	const vector<mep_line_t>&	getLines() const { return lines; }
+	const vector<mep_thing_t>&	getThings() const { return things; }
+
+	void addVertex(double x, double y);
+	void addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false);
+	void addThing(double x, double y);
+	bool openMap(Archive::MapDesc map);
+	bool readVertices(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
+	bool readLines(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
+	bool readThings(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
+	void clear();
+
+	void getImageSize(int& width, int& height);
+	bool renderImage(SImage& image, int width, int height);
+
+	unsigned	nVertices();
+	unsigned	nSides();
+	unsigned	nLines();
+	unsigned	nSectors();
+	unsigned	nThings();
+	unsigned	getWidth();
+	unsigned	getHeight();
+};
+
+#endif//__MAP_PREVIEW_DATA_H__
@@ -108,6 +108,10 @@ MapRenderer2D::MapRenderer2D(SLADEMap* map)
 	this->n_vertices = 0;
 	this->n_lines = 0;
 	this->n_things = 0;
+	this->vertices_updated = 0;
+	this->lines_updated = 0;
+	this->flats_updated = 0;
+	this->lines_alpha = 1.0f;
 }
 
 /* MapRenderer2D::~MapRenderer2D
@@ -248,8 +252,10 @@ void MapRenderer2D::renderVerticesVBO()
 		return;
 
 	// Update vertices VBO if required
-	if (vbo_vertices == 0 || map->nVertices() != n_vertices || map->geometryUpdated() > vertices_updated)
+	if (vbo_vertices == 0 || map->nVertices() != n_vertices)
 		updateVerticesVBO();
+	else if (map->geometryUpdated() >= vertices_updated)
+		updateVerticesVBO(false);
 
 	// Set VBO arrays to use
 	glEnableClientState(GL_VERTEX_ARRAY);
@@ -474,12 +480,10 @@ void MapRenderer2D::renderLinesVBO(bool show_direction, float alpha)
 		return;
 
 	// Update lines VBO if required
-	if (vbo_lines == 0 ||
-		show_direction != lines_dirs ||
-		map->nLines() != n_lines ||
-		map->geometryUpdated() > lines_updated ||
-		map->modifiedSince(lines_updated, MOBJ_LINE))
+	if (vbo_lines == 0 || show_direction != lines_dirs || map->nLines() != n_lines)
 		updateLinesVBO(show_direction, alpha);
+	else if (map->geometryUpdated() >= lines_updated || map->modifiedSince(lines_updated - 1, MOBJ_LINE))
+		updateLinesVBO(show_direction, alpha, false);
 
 	// Disable any blending
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -1939,8 +1943,6 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 	using Game::Feature;
 	using Game::UDMFFeature;
 
-	bool vbo_updated = false;
-
 	if (flat_ignore_light)
 		glColor4f(flat_brightness, flat_brightness, flat_brightness, alpha);
 
@@ -1961,27 +1963,10 @@ void MapRenderer2D::renderFlatsVBO(int type, bool texture, float alpha)
 		last_flat_type = type;
 	}
 
-	// First, check if any polygon vertex data has changed (in this case we need to refresh the entire vbo)
-	for (unsigned a = 0; a < map->nSectors(); a++)
-	{
-		Polygon2D* poly = map->getSector(a)->getPolygon();
-		if (poly && poly->vboUpdate() > 1)
-		{
-			//LOG_MESSAGE(1, "Updating sector %d polygon vbo data", a);
-			updateFlatsVBO();
-			vbo_updated = true;
-		}
-	}
-
-	// Create VBO if necessary
-	if (!vbo_updated && vbo_flats == 0)
-	{
+	// First, write any re-triangulated polygons to their space in the vbo
+	// (the entire vbo is rebuilt if any changed size)
+	if (vbo_flats == 0 || !updateFlatsVBOSlots())
 		updateFlatsVBO();
-		vbo_updated = true;
-	}
-
-	//if (vbo_updated)
-	//	LOG_MESSAGE(1, "Updated vbo");
 
 	// Setup opengl state
 	if (texture) glEnable(GL_TEXTURE_2D);
@@ -2802,105 +2787,294 @@ void MapRenderer2D::renderObjectEditGroup(ObjectEditGroup* group)
 	}
 }
 
-/* MapRenderer2D::updateVerticesVBO
- * (Re)builds the map vertices VBO
+/* MapRenderer2D::updateVerticesData
+ * Updates the vertices VBO data for any vertices modified since it
+ * was last updated, or regenerates all of it if [full] is true.
+ * Returns true if any data was changed
  *******************************************************************/
-void MapRenderer2D::updateVerticesVBO()
+bool MapRenderer2D::updateVerticesData(bool full)
 {
-	// Create VBO if needed
-	if (vbo_vertices == 0)
-		glGenBuffers(1, &vbo_vertices);
+	unsigned n = map->nVertices();
+	long update_time = App::runTimer();
 
-	// Fill vertices VBO
-	int nfloats = map->nVertices()*2;
-	GLfloat* verts = new GLfloat[nfloats];
-	unsigned i = 0;
-	for (unsigned a = 0; a < map->nVertices(); a++)
+	// Regenerate everything if the number of vertices changed
+	if (vertices_ids.size() != n)
+		full = true;
+	if (full)
 	{
-		verts[i++] = map->getVertex(a)->xPos();
-		verts[i++] = map->getVertex(a)->yPos();
+		vertices_data.resize(n * 2);
+		vertices_ids.resize(n);
+		vertices_dirty.clear();
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_vertices);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*nfloats, verts, GL_STATIC_DRAW);
 
-	// Clean up
-	delete[] verts;
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	bool updated = full;
+	for (unsigned a = 0; a < n; a++)
+	{
+		MapVertex* vertex = map->getVertex(a);
 
-	n_vertices = map->nVertices();
-	vertices_updated = App::runTimer();
+		// Skip if unchanged
+		if (!full && vertices_ids[a] == vertex->getId() && vertex->modifiedTime() < vertices_updated)
+			continue;
+
+		vertices_data[a * 2] = vertex->xPos();
+		vertices_data[a * 2 + 1] = vertex->yPos();
+		vertices_ids[a] = vertex->getId();
+		updated = true;
+
+		// Add to dirty ranges (joined with the previous range if close enough)
+		if (!full)
+		{
+			if (!vertices_dirty.empty() && a >= vertices_dirty.back().start && a <= vertices_dirty.back().end + 16)
+				vertices_dirty.back().end = max(vertices_dirty.back().end, a + 1);
+			else
+				vertices_dirty.push_back({ a, a + 1 });
+		}
+	}
+
+	if (full)
+		vertices_dirty.push_back({ 0, n });
+
+	vertices_updated = update_time;
+	return updated;
 }
 
-/* MapRenderer2D::updateLinesVBO
- * (Re)builds the map lines VBO
+/* MapRenderer2D::writeLineData
+ * Writes the VBO data for [line] to [verts] (2 vertices, or 4 if
+ * [show_direction] is true)
  *******************************************************************/
-void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha)
+void MapRenderer2D::writeLineData(MapLine* line, glvert_t* verts, bool show_direction, float base_alpha)
 {
-	LOG_MESSAGE(3, "Updating lines VBO");
+	// Get line colour
+	rgba_t col = lineColour(line);
+	float alpha = base_alpha*col.fa();
+
+	// Set line vertices
+	verts[0].x = line->v1()->xPos();
+	verts[0].y = line->v1()->yPos();
+	verts[1].x = line->v2()->xPos();
+	verts[1].y = line->v2()->yPos();
+
+	// Set line colour(s)
+	verts[0].r = verts[1].r = col.fr();
+	verts[0].g = verts[1].g = col.fg();
+	verts[0].b = verts[1].b = col.fb();
+	verts[0].a = verts[1].a = alpha;
+
+	// Direction tab if needed
+	if (show_direction)
+	{
+		fpoint2_t mid = line->getPoint(MOBJ_POINT_MID);
+		fpoint2_t tab = line->dirTabPoint();
+		verts[2].x = mid.x;
+		verts[2].y = mid.y;
+		verts[3].x = tab.x;
+		verts[3].y = tab.y;
 
-	// Create VBO if needed
-	if (vbo_lines == 0)
-		glGenBuffers(1, &vbo_lines);
+		// Colours
+		verts[2].r = verts[3].r = col.fr();
+		verts[2].g = verts[3].g = col.fg();
+		verts[2].b = verts[3].b = col.fb();
+		verts[2].a = verts[3].a = alpha*0.6f;
+	}
+}
 
-	// Determine the number of vertices per line
-	int vpl = 2;
-	if (show_direction) vpl = 4;
+/* MapRenderer2D::updateLinesData
+ * Updates the lines VBO data for any lines modified (or with moved
+ * vertices) since it was last updated, or regenerates all of it if
+ * [full] is true. Returns true if any data was changed
+ *******************************************************************/
+bool MapRenderer2D::updateLinesData(bool show_direction, float alpha, bool full)
+{
+	unsigned n = map->nLines();
+	unsigned vpl = show_direction ? 4 : 2;
+	long update_time = App::runTimer();
 
-	// Fill lines VBO
-	int nverts = map->nLines()*vpl;
-	glvert_t* lines = new glvert_t[nverts];
-	unsigned v = 0;
-	rgba_t col;
-	float alpha;
-	for (unsigned a = 0; a < map->nLines(); a++)
+	// Regenerate everything if the number of lines or the vertex layout
+	// changed, or if the line alpha changed
+	if (lines_slots.size() != n || show_direction != lines_dirs || alpha != lines_alpha)
+		full = true;
+	if (full)
+	{
+		lines_data.resize(n * vpl);
+		lines_slots.resize(n);
+		lines_dirty.clear();
+		lines_dirs = show_direction;
+		lines_alpha = alpha;
+	}
+
+	bool updated = full;
+	for (unsigned a = 0; a < n; a++)
 	{
 		MapLine* line = map->getLine(a);
+		glvert_t* verts = &lines_data[a * vpl];
+
+		// Get line state that affects its colour but doesn't necessarily
+		// update its modified time
+		uint8_t flags = 0;
+		if (line->isFiltered()) flags |= LS_FILTERED;
+		if (line->s1()) flags |= LS_FRONT;
+		if (line->s2()) flags |= LS_BACK;
+
+		// Skip if unchanged
+		if (!full &&
+			lines_slots[a].id == line->getId() &&
+			lines_slots[a].flags == flags &&
+			line->modifiedTime() < lines_updated &&
+			verts[0].x == (float)line->v1()->xPos() &&
+			verts[0].y == (float)line->v1()->yPos() &&
+			verts[1].x == (float)line->v2()->xPos() &&
+			verts[1].y == (float)line->v2()->yPos())
+			continue;
 
-		// Get line colour
-		col = lineColour(line);
-		alpha = base_alpha*col.fa();
+		writeLineData(line, verts, show_direction, lines_alpha);
+		lines_slots[a].id = line->getId();
+		lines_slots[a].flags = flags;
+		updated = true;
 
-		// Set line vertices
-		lines[v].x = line->v1()->xPos();
-		lines[v].y = line->v1()->yPos();
-		lines[v+1].x = line->v2()->xPos();
-		lines[v+1].y = line->v2()->yPos();
+		// Add to dirty ranges (joined with the previous range if close enough)
+		if (!full)
+		{
+			if (!lines_dirty.empty() && a >= lines_dirty.back().start && a <= lines_dirty.back().end + 16)
+				lines_dirty.back().end = max(lines_dirty.back().end, a + 1);
+			else
+				lines_dirty.push_back({ a, a + 1 });
+		}
+	}
 
-		// Set line colour(s)
-		lines[v].r = lines[v+1].r = col.fr();
-		lines[v].g = lines[v+1].g = col.fg();
-		lines[v].b = lines[v+1].b = col.fb();
-		lines[v].a = lines[v+1].a = alpha;
+	if (full)
+		lines_dirty.push_back({ 0, n });
 
-		// Direction tab if needed
-		if (show_direction)
+	lines_updated = update_time;
+	return updated;
+}
+
+/* MapRenderer2D::uploadVBO
+ * Uploads the [dirty] ranges of [data] (made up of [n_slots] slots
+ * of [slot_size] bytes each) to [vbo], creating it if needed. The
+ * whole buffer is reallocated if everything is dirty
+ *******************************************************************/
+void MapRenderer2D::uploadVBO(unsigned& vbo, const void* data, unsigned slot_size, unsigned n_slots, vector<vbo_range_t>& dirty)
+{
+	if (dirty.empty())
+		return;
+
+	// Create VBO if needed
+	if (vbo == 0)
+		glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	if (dirty[0].start == 0 && dirty[0].end >= n_slots)
+	{
+		// Everything changed, (re)allocate the buffer
+		glBufferData(GL_ARRAY_BUFFER, slot_size*n_slots, data, GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		// Upload changed ranges only
+		for (auto& range : dirty)
 		{
-			fpoint2_t mid = line->getPoint(MOBJ_POINT_MID);
-			fpoint2_t tab = line->dirTabPoint();
-			lines[v+2].x = mid.x;
-			lines[v+2].y = mid.y;
-			lines[v+3].x = tab.x;
-			lines[v+3].y = tab.y;
-
-			// Colours
-			lines[v+2].r = lines[v+3].r = col.fr();
-			lines[v+2].g = lines[v+3].g = col.fg();
-			lines[v+2].b = lines[v+3].b = col.fb();
-			lines[v+2].a = lines[v+3].a = alpha*0.6f;
-		}
+			unsigned end = min(range.end, n_slots);
+			if (range.start >= end)
+				continue;
 
-		// Next line
-		v += vpl;
+			glBufferSubData(
+				GL_ARRAY_BUFFER,
+				range.start*slot_size,
+				(end - range.start)*slot_size,
+				(const uint8_t*)data + range.start*slot_size
+			);
+		}
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, vbo_lines);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glvert_t)*nverts, lines, GL_STATIC_DRAW);
 
 	// Clean up
-	delete[] lines;
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	dirty.clear();
+}
+
+/* MapRenderer2D::checkVBOData
+ * Brings the vertices and lines VBO data up to date and checks it
+ * matches a full rebuild, and that all sector polygons match their
+ * space in the flats VBO. Doesn't need an OpenGL context.
+ * Returns false (and logs the differences) if anything is wrong
+ *******************************************************************/
+bool MapRenderer2D::checkVBOData()
+{
+	bool ok = true;
+
+	// Vertices
+	updateVerticesData(false);
+	for (unsigned a = 0; a < map->nVertices(); a++)
+	{
+		MapVertex* vertex = map->getVertex(a);
+		if (vertices_data[a * 2] != (float)vertex->xPos() || vertices_data[a * 2 + 1] != (float)vertex->yPos())
+		{
+			LOG_MESSAGE(1, "Vertex %d VBO data differs from full rebuild", a);
+			ok = false;
+		}
+	}
+
+	// Lines
+	updateLinesData(lines_dirs, lines_alpha, false);
+	unsigned vpl = lines_dirs ? 4 : 2;
+	glvert_t verts[4];
+	for (unsigned a = 0; a < map->nLines(); a++)
+	{
+		writeLineData(map->getLine(a), verts, lines_dirs, lines_alpha);
+		if (memcmp(verts, &lines_data[a * vpl], sizeof(glvert_t) * vpl) != 0)
+		{
+			LOG_MESSAGE(1, "Line %d VBO data differs from full rebuild", a);
+			ok = false;
+		}
+	}
+
+	// Flats (only if the flats VBO has been built)
+	if (flats_slots.size() == map->nSectors())
+	{
+		unsigned end = 0;
+		for (unsigned a = 0; a < map->nSectors(); a++)
+		{
+			MapSector* sector = map->getSector(a);
+			Polygon2D* poly = sector->getPolygon();
+			if (flats_slots[a].id != sector->getId() ||
+				flats_slots[a].offset != end ||
+				(poly->vboUpdate() < 2 && poly->vboDataSize() != flats_slots[a].size))
+			{
+				LOG_MESSAGE(1, "Sector %d polygon doesn't match its VBO space", a);
+				ok = false;
+			}
+			end = flats_slots[a].offset + flats_slots[a].size;
+		}
+	}
+
+	return ok;
+}
+
+/* MapRenderer2D::updateVerticesVBO
+ * Updates the map vertices VBO, rebuilding it entirely if [full] is
+ * true or only uploading data for modified vertices otherwise
+ *******************************************************************/
+void MapRenderer2D::updateVerticesVBO(bool full)
+{
+	updateVerticesData(full || vbo_vertices == 0);
+	uploadVBO(vbo_vertices, vertices_data.data(), sizeof(float) * 2, vertices_ids.size(), vertices_dirty);
+
+	n_vertices = map->nVertices();
+}
+
+/* MapRenderer2D::updateLinesVBO
+ * Updates the map lines VBO, rebuilding it entirely if [full] is
+ * true or only uploading data for modified lines otherwise
+ *******************************************************************/
+void MapRenderer2D::updateLinesVBO(bool show_direction, float base_alpha, bool full)
+{
+	if (full || vbo_lines == 0)
+		LOG_MESSAGE(3, "Updating lines VBO");
+
+	updateLinesData(show_direction, base_alpha, full || vbo_lines == 0);
+	unsigned vpl = lines_dirs ? 4 : 2;
+	uploadVBO(vbo_lines, lines_data.data(), sizeof(glvert_t) * vpl, lines_slots.size(), lines_dirty);
 
 	n_lines = map->nLines();
-	lines_updated = App::runTimer();
 }
 
 /* MapRenderer2D::updateFlatsVBO
@@ -2915,27 +3089,27 @@ void MapRenderer2D::updateFlatsVBO()
 	if (vbo_flats == 0)
 		glGenBuffers(1, &vbo_flats);
 
-	// Get total size needed
+	// Get space for each polygon. Polygons are packed in sector order,
+	// since the polygon VBO offsets are shared with the 3d renderer,
+	// which uses the same layout
 	unsigned totalsize = 0;
+	flats_slots.resize(map->nSectors());
 	for (unsigned a = 0; a < map->nSectors(); a++)
 	{
-		Polygon2D* poly = map->getSector(a)->getPolygon();
-		totalsize += poly->vboDataSize();
+		MapSector* sector = map->getSector(a);
+		flats_slots[a].id = sector->getId();
+		flats_slots[a].offset = totalsize;
+		flats_slots[a].size = sector->getPolygon()->vboDataSize();
+		totalsize += flats_slots[a].size;
 	}
 
 	// Allocate buffer data
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_flats);
-	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, totalsize, nullptr, GL_DYNAMIC_DRAW);
 
 	// Write polygon data to VBO
-	unsigned offset = 0;
-	unsigned index = 0;
 	for (unsigned a = 0; a < map->nSectors(); a++)
-	{
-		Polygon2D* poly = map->getSector(a)->getPolygon();
-		offset = poly->writeToVBO(offset, index);
-		index += poly->totalVertices();
-	}
+		map->getSector(a)->getPolygon()->writeToVBO(flats_slots[a].offset, flats_slots[a].offset / 20);
 
 	// Clean up
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -2943,6 +3117,53 @@ void MapRenderer2D::updateFlatsVBO()
 	flats_updated = App::runTimer();
 }
 
+/* MapRenderer2D::updateFlatsVBOSlots
+ * Writes any re-triangulated sector polygons to their space in the
+ * flats VBO. Returns false if the VBO needs to be rebuilt instead
+ * (sectors changed or a polygon changed size)
+ *******************************************************************/
+bool MapRenderer2D::updateFlatsVBOSlots()
+{
+	if (flats_slots.size() != map->nSectors())
+		return false;
+
+	bool bound = false;
+	bool ok = true;
+	for (unsigned a = 0; a < map->nSectors(); a++)
+	{
+		MapSector* sector = map->getSector(a);
+		if (flats_slots[a].id != sector->getId())
+		{
+			ok = false;
+			break;
+		}
+
+		// Check if the polygon needs writing
+		Polygon2D* poly = sector->getPolygon();
+		if (poly->vboUpdate() < 2)
+			continue;
+
+		// Check it's still the same size
+		if (poly->vboDataSize() != flats_slots[a].size)
+		{
+			ok = false;
+			break;
+		}
+
+		if (!bound)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo_flats);
+			bound = true;
+		}
+		poly->writeToVBO(flats_slots[a].offset, flats_slots[a].offset / 20);
+	}
+
+	if (bound)
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return ok;
+}
+
 /* MapRenderer2D::updateVisibility
  * Updates map object visibility info depending on the current view
  *******************************************************************/
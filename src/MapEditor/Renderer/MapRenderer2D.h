@@ -58,6 +58,42 @@ private:
 		glvert_t dv1, dv2;	// Direction tab
 	};
 
+	// VBO data, kept so only the parts for modified objects need to be
+	// regenerated and uploaded
+	struct vbo_range_t
+	{
+		unsigned	start;	// First slot
+		unsigned	end;	// One past the last slot
+	};
+	enum
+	{
+		LS_FILTERED	= 1,
+		LS_FRONT	= 2,
+		LS_BACK		= 4,
+	};
+	struct line_slot_t
+	{
+		unsigned	id;		// Line object id
+		uint8_t		flags;	// LS_* flags the line data was generated with
+	};
+	struct flat_slot_t
+	{
+		unsigned	id;			// Sector object id
+		unsigned	offset;		// Offset of polygon data in the VBO (bytes)
+		unsigned	size;		// Size of polygon data in the VBO (bytes)
+	};
+	vector<float>		vertices_data;
+	vector<unsigned>	vertices_ids;
+	vector<vbo_range_t>	vertices_dirty;
+	vector<glvert_t>	lines_data;
+	vector<line_slot_t>	lines_slots;
+	vector<vbo_range_t>	lines_dirty;
+	float				lines_alpha;
+	vector<flat_slot_t>	flats_slots;
+
+	void	writeLineData(MapLine* line, glvert_t* verts, bool show_direction, float alpha);
+	void	uploadVBO(unsigned& vbo, const void* data, unsigned slot_size, unsigned n_slots, vector<vbo_range_t>& dirty);
+
 	// Other
 	bool	lines_dirs;
 	int		n_vertices;
@@ -179,9 +215,13 @@ public:
 
 
 	// VBOs
-	void	updateVerticesVBO();
-	void	updateLinesVBO(bool show_direction, float alpha);
+	bool	updateVerticesData(bool full);
+	bool	updateLinesData(bool show_direction, float alpha, bool full);
+	bool	checkVBOData();
+	void	updateVerticesVBO(bool full = true);
+	void	updateLinesVBO(bool show_direction, float alpha, bool full = true);
 	void	updateFlatsVBO();
+	bool	updateFlatsVBOSlots();
 
 	// Misc
 	void	setScale(double scale) { view_scale = scale; view_scale_inv = 1.0 / scale; }
@@ -42,6 +42,7 @@
 #include "OpenGL/OpenGL.h"
 #include "UI/Controls/PaletteChooser.h"
 #include "Utility/MathStuff.h"
+#include "Utility/ThreadPool.h"
 
 
 /*******************************************************************
@@ -61,6 +62,7 @@ CVAR(Float, render_3d_brightness, 1, CVAR_SAVE)
 CVAR(Float, render_fog_distance, 1500, CVAR_SAVE)
 CVAR(Bool, render_fog_new_formula, true, CVAR_SAVE)
 CVAR(Bool, render_shade_orthogonal_lines, true, CVAR_SAVE)
+CVAR(Bool, render_portal_culling, true, CVAR_SAVE)
 CVAR(Bool, mlook_invert_y, false, CVAR_SAVE)
 CVAR(Float, camera_3d_sensitivity_x, 1.0f, CVAR_SAVE)
 CVAR(Float, camera_3d_sensitivity_y, 1.0f, CVAR_SAVE)
@@ -99,6 +101,15 @@ MapRenderer3D::MapRenderer3D(SLADEMap* map)
 	this->flat_last = 0;
 	this->render_hilight = true;
 	this->render_selection = true;
+	this->cam_sector = -1;
+	this->fov_tan = 1.0;
+	this->pick_x = 0;
+	this->pick_y = 0;
+	this->pick_cell_size = 64;
+	this->pick_cols = 0;
+	this->pick_rows = 0;
+	this->pick_ray = 0;
+	this->pick_updated = 0;
 
 	// Build skybox circle
 	buildSkyCircle();
@@ -187,6 +198,7 @@ void MapRenderer3D::clearData()
 	things.clear();
 	floors.clear();
 	ceilings.clear();
+	pick_updated = 0;
 
 	// Clear everything else
 	refresh();
@@ -444,6 +456,7 @@ void MapRenderer3D::setupView(int width, int height)
 	// Calculate aspect ratio
 	float aspect = (1.6f / 1.333333f) * ((float)width / (float)height);
 	float fovy = 2 * MathStuff::radToDeg(atan(tan(MathStuff::degToRad(90) / 2) / aspect));
+	fov_tan = tan(MathStuff::degToRad(90) / 2) / aspect;
 
 	// Setup projection
 	glMatrixMode(GL_PROJECTION);
@@ -538,6 +551,9 @@ void MapRenderer3D::renderMap()
 	// Init
 	tex_last = nullptr;
 
+	// Triangulate any sector polygons that need it up-front
+	updatePolygons();
+
 	// Init VBO stuff
 	if (OpenGL::vboSupport())
 	{
@@ -794,6 +810,23 @@ void MapRenderer3D::renderSky()
 	glEnable(GL_TEXTURE_2D);
 }
 
+/* MapRenderer3D::updatePolygons
+ * Triangulates any sector polygons that need updating, spread across
+ * worker threads (polygons are otherwise built one at a time when
+ * first needed)
+ *******************************************************************/
+void MapRenderer3D::updatePolygons()
+{
+	vector<MapSector*> update;
+	for (unsigned a = 0; a < map->nSectors(); a++)
+	{
+		if (map->getSector(a)->polygonNeedsUpdate())
+			update.push_back(map->getSector(a));
+	}
+
+	ThreadPool::global().parallelFor(update.size(), [&](size_t a) { update[a]->getPolygon(); });
+}
+
 /* MapRenderer3D::updateFlatTexCoords
  * Updates the vertex texture coordinates of all polygons for sector
  * [index]
@@ -1199,36 +1232,112 @@ void MapRenderer3D::setupQuadTexCoords(MapRenderer3D::quad_3d_t* quad, int lengt
 	quad->points[3].ty = (y1 * y_mult) + ((h_top - quad->points[3].z) * y_mult);
 }
 
-/* MapRenderer3D::updateLine
- * Updates cached rendering data for line [index]
+/* MapRenderer3D::prepareLine
+ * Gets everything needed to build the quads for the line in [build]
+ * that can't be done on a worker thread: the textures for each quad
+ * the line will have (which may need to be loaded), the sector
+ * colours and any line/side info that may fall back to the game
+ * configuration (which isn't safe to look up concurrently)
  *******************************************************************/
-void MapRenderer3D::updateLine(unsigned index)
+void MapRenderer3D::prepareLine(line_build_t& build)
 {
-	using Game::Feature;
-	using Game::UDMFFeature;
+	MapLine* line = build.line;
+	for (unsigned a = 0; a < 6; a++)
+		build.textures[a] = nullptr;
+	if (!line->s1())
+		return;
 
-	// Check index
-	if (index > lines.size())
+	// Get sector colours and side light levels
+	build.colour[0] = line->frontSector()->getColour(0, true);
+	build.fogcolour[0] = line->frontSector()->getFogColour();
+	build.light[0] = line->s1()->getLight();
+	if (line->s2())
+	{
+		build.colour[1] = line->backSector()->getColour(0, true);
+		build.fogcolour[1] = line->backSector()->getFogColour();
+		build.light[1] = line->s2()->getLight();
+	}
+
+	// Get line flags
+	int map_format = MapEditor::editContext().mapDesc().format;
+	build.upeg = Game::configuration().lineBasicFlagSet("dontpegtop", line, map_format);
+	build.lpeg = Game::configuration().lineBasicFlagSet("dontpegbottom", line, map_format);
+	build.wrap_midtex = (map->currentFormat() == MAP_DOOM64) || (map->currentFormat() == MAP_UDMF &&
+		Game::configuration().featureSupported(Game::UDMFFeature::SideMidtexWrapping) &&
+		line->boolProperty("wrapmidtex"));
+
+	// One-sided line, just a middle texture
+	bool mixed = Game::configuration().featureSupported(Game::Feature::MixTexFlats);
+	if (!line->s2())
+	{
+		build.textures[TEX_FRONT_MIDDLE] = MapEditor::textureManager().getTexture(line->s1()->getTexMiddle(), mixed);
 		return;
+	}
+
+	// Two-sided line, get textures for the quads needed
+	plane_t fp1 = line->frontSector()->getFloorPlane();
+	plane_t cp1 = line->frontSector()->getCeilingPlane();
+	plane_t fp2 = line->backSector()->getFloorPlane();
+	plane_t cp2 = line->backSector()->getCeilingPlane();
+	string hidden_tex = map->currentFormat() == MAP_DOOM64 ? "?" : "-";
+	bool show_midtex = (map->currentFormat() != MAP_DOOM64) || (line->intProperty("flags") & 512);
+
+	// Heights at both endpoints, for both planes, on both sides
+	double f1h1 = fp1.height_at(line->x1(), line->y1());
+	double f1h2 = fp1.height_at(line->x2(), line->y2());
+	double f2h1 = fp2.height_at(line->x1(), line->y1());
+	double f2h2 = fp2.height_at(line->x2(), line->y2());
+	double c1h1 = cp1.height_at(line->x1(), line->y1());
+	double c1h2 = cp1.height_at(line->x2(), line->y2());
+	double c2h1 = cp2.height_at(line->x1(), line->y1());
+	double c2h2 = cp2.height_at(line->x2(), line->y2());
+
+	// Front lower
+	if (f2h1 > f1h1 || f2h2 > f1h2)
+		build.textures[TEX_FRONT_LOWER] = MapEditor::textureManager().getTexture(line->s1()->getTexLower(), mixed);
 
-	// Clear current line data
-	lines[index].quads.clear();
+	// Front middle
+	string midtex1 = line->stringProperty("side1.texturemiddle");
+	if (!midtex1.IsEmpty() && midtex1 != hidden_tex && show_midtex)
+		build.textures[TEX_FRONT_MIDDLE] = MapEditor::textureManager().getTexture(midtex1, mixed);
+
+	// Front upper
+	if (c1h1 > c2h1 || c1h2 > c2h2)
+		build.textures[TEX_FRONT_UPPER] = MapEditor::textureManager().getTexture(line->s1()->getTexUpper(), mixed);
+
+	// Back lower
+	if (f1h1 > f2h1 || f1h2 > f2h2)
+		build.textures[TEX_BACK_LOWER] = MapEditor::textureManager().getTexture(line->s2()->getTexLower(), mixed);
+
+	// Back middle
+	string midtex2 = line->stringProperty("side2.texturemiddle");
+	if (!midtex2.IsEmpty() && midtex2 != hidden_tex && show_midtex)
+		build.textures[TEX_BACK_MIDDLE] = MapEditor::textureManager().getTexture(midtex2, mixed);
+
+	// Back upper
+	if (c2h1 > c1h1 || c2h2 > c1h2)
+		build.textures[TEX_BACK_UPPER] = MapEditor::textureManager().getTexture(line->s2()->getTexUpper(), mixed);
+}
+
+/* MapRenderer3D::buildLineQuads
+ * Builds the quads for the line in [build], using the textures and
+ * colours from prepareLine. Doesn't touch any OpenGL or renderer
+ * state, so can be run on a worker thread
+ *******************************************************************/
+void MapRenderer3D::buildLineQuads(line_build_t& build)
+{
+	using Game::UDMFFeature;
 
 	// Skip invalid line
-	MapLine* line = map->getLine(index);
+	MapLine* line = build.line;
+	build.quads.clear();
 	if (!line->s1())
 		return;
 
-	// Process line special
-	map->mapSpecials()->processLineSpecial(line);
-
 	// Get relevant line info
-	int map_format = MapEditor::editContext().mapDesc().format;
-	bool upeg = Game::configuration().lineBasicFlagSet("dontpegtop", line, map_format);
-	bool lpeg = Game::configuration().lineBasicFlagSet("dontpegbottom", line, map_format);
+	bool upeg = build.upeg;
+	bool lpeg = build.lpeg;
 	double xoff, yoff, sx, sy, lsx, lsy;
-	bool mixed = Game::configuration().featureSupported(Feature::MixTexFlats);
-	lines[index].line = line;
 	double alpha = 1.0;
 	if (line->hasProp("alpha"))
 		alpha = line->floatProperty("alpha");
@@ -1238,9 +1347,9 @@ void MapRenderer3D::updateLine(unsigned index)
 	int ceiling1 = line->frontSector()->getCeilingHeight();
 	plane_t fp1 = line->frontSector()->getFloorPlane();
 	plane_t cp1 = line->frontSector()->getCeilingPlane();
-	rgba_t colour1 = line->frontSector()->getColour(0, true);
-	rgba_t fogcolour1 = line->frontSector()->getFogColour();
-	int light1 = line->s1()->getLight();
+	rgba_t colour1 = build.colour[0];
+	rgba_t fogcolour1 = build.fogcolour[0];
+	int light1 = build.light[0];
 	int xoff1 = line->s1()->getOffsetX();
 	int yoff1 = line->s1()->getOffsetY();
 
@@ -1285,7 +1394,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexMiddle(), mixed);
+		quad.texture = build.textures[TEX_FRONT_MIDDLE];
 		sx = quad.texture->getScaleX();
 		sy = quad.texture->getScaleY();
 		if (Game::configuration().featureSupported(UDMFFeature::TextureScaling))
@@ -1312,8 +1421,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		setupQuadTexCoords(&quad, length, xoff, yoff, ceiling1, floor1, lpeg, sx, sy);
 
 		// Add middle quad and finish
-		lines[index].quads.push_back(quad);
-		lines[index].updated_time = App::runTimer();
+		build.quads.push_back(quad);
 		return;
 	}
 
@@ -1324,25 +1432,14 @@ void MapRenderer3D::updateLine(unsigned index)
 	int ceiling2 = line->backSector()->getCeilingHeight();
 	plane_t fp2 = line->backSector()->getFloorPlane();
 	plane_t cp2 = line->backSector()->getCeilingPlane();
-	rgba_t colour2 = line->backSector()->getColour(0, true);
-	rgba_t fogcolour2 = line->backSector()->getFogColour();
-	int light2 = line->s2()->getLight();
+	rgba_t colour2 = build.colour[1];
+	rgba_t fogcolour2 = build.fogcolour[1];
+	int light2 = build.light[1];
 	int xoff2 = line->s2()->getOffsetX();
 	int yoff2 = line->s2()->getOffsetY();
 	int lowceil = min(ceiling1, ceiling2);
 	int highfloor = max(floor1, floor2);
 	string sky_flat = Game::configuration().skyFlat();
-	string hidden_tex = map->currentFormat() == MAP_DOOM64 ? "?" : "-";
-	bool show_midtex = (map->currentFormat() != MAP_DOOM64) || (line->intProperty("flags") & 512);
-	// Heights at both endpoints, for both planes, on both sides
-	double f1h1 = fp1.height_at(line->x1(), line->y1());
-	double f1h2 = fp1.height_at(line->x2(), line->y2());
-	double f2h1 = fp2.height_at(line->x1(), line->y1());
-	double f2h2 = fp2.height_at(line->x2(), line->y2());
-	double c1h1 = cp1.height_at(line->x1(), line->y1());
-	double c1h2 = cp1.height_at(line->x2(), line->y2());
-	double c2h1 = cp2.height_at(line->x1(), line->y1());
-	double c2h2 = cp2.height_at(line->x2(), line->y2());
 
 	if (render_shade_orthogonal_lines)
 	{
@@ -1368,7 +1465,7 @@ void MapRenderer3D::updateLine(unsigned index)
 	// Front lower
 	lsx = 1;
 	lsy = 1;
-	if (f2h1 > f1h1 || f2h2 > f1h2)
+	if (build.textures[TEX_FRONT_LOWER])
 	{
 		quad_3d_t quad;
 
@@ -1385,7 +1482,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexLower(), mixed);
+		quad.texture = build.textures[TEX_FRONT_LOWER];
 		sx = quad.texture->getScaleX();
 		sy = quad.texture->getScaleY();
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
@@ -1418,19 +1515,18 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.flags |= LOWER;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
 
 	// Front middle
 	lsx = 1;
 	lsy = 1;
-	string midtex1 = line->stringProperty("side1.texturemiddle");
-	if (!midtex1.IsEmpty() && midtex1 != hidden_tex && show_midtex)
+	if (build.textures[TEX_FRONT_MIDDLE])
 	{
 		quad_3d_t quad;
 
 		// Get texture
-		quad.texture = MapEditor::textureManager().getTexture(midtex1, mixed);
+		quad.texture = build.textures[TEX_FRONT_MIDDLE];
 
 		// Determine offsets
 		xoff = xoff1;
@@ -1465,9 +1561,7 @@ void MapRenderer3D::updateLine(unsigned index)
 
 		// Setup quad coordinates
 		double top, bottom;
-		if ((map->currentFormat() == MAP_DOOM64) || ((map->currentFormat() == MAP_UDMF &&
-			Game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping) &&
-			line->boolProperty("wrapmidtex"))))
+		if (build.wrap_midtex)
 		{
 			top = lowceil;
 			bottom = highfloor;
@@ -1507,13 +1601,13 @@ void MapRenderer3D::updateLine(unsigned index)
 			quad.flags |= TRANSADD;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
 
 	// Front upper
 	lsx = 1;
 	lsy = 1;
-	if (c1h1 > c2h1 || c1h2 > c2h2)
+	if (build.textures[TEX_FRONT_UPPER])
 	{
 		quad_3d_t quad;
 
@@ -1530,7 +1624,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		quad.texture = MapEditor::textureManager().getTexture(line->s1()->getTexUpper(), mixed);
+		quad.texture = build.textures[TEX_FRONT_UPPER];
 		sx = quad.texture->getScaleX();
 		sy = quad.texture->getScaleY();
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
@@ -1560,13 +1654,13 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.flags |= UPPER;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
 
 	// Back lower
 	lsx = 1;
 	lsy = 1;
-	if (f1h1 > f2h1 || f1h2 > f2h2)
+	if (build.textures[TEX_BACK_LOWER])
 	{
 		quad_3d_t quad;
 
@@ -1583,7 +1677,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		quad.texture = MapEditor::textureManager().getTexture(line->s2()->getTexLower(), mixed);
+		quad.texture = build.textures[TEX_BACK_LOWER];
 		sx = quad.texture->getScaleX();
 		sy = quad.texture->getScaleY();
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
@@ -1616,19 +1710,18 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.flags |= LOWER;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
 
 	// Back middle
 	lsx = 1;
 	lsy = 1;
-	string midtex2 = line->stringProperty("side2.texturemiddle");
-	if (!midtex2.IsEmpty() && midtex2 != hidden_tex && show_midtex)
+	if (build.textures[TEX_BACK_MIDDLE])
 	{
 		quad_3d_t quad;
 
 		// Get texture
-		quad.texture = MapEditor::textureManager().getTexture(midtex2, mixed);
+		quad.texture = build.textures[TEX_BACK_MIDDLE];
 
 		// Determine offsets
 		xoff = xoff2;
@@ -1663,8 +1756,7 @@ void MapRenderer3D::updateLine(unsigned index)
 
 		// Setup quad coordinates
 		double top, bottom;
-		if ((map->currentFormat() == MAP_DOOM64) || (map->currentFormat() == MAP_UDMF &&
-			Game::configuration().featureSupported(UDMFFeature::SideMidtexWrapping) && line->boolProperty("wrapmidtex")))
+		if (build.wrap_midtex)
 		{
 			top = lowceil;
 			bottom = highfloor;
@@ -1705,13 +1797,13 @@ void MapRenderer3D::updateLine(unsigned index)
 			quad.flags |= TRANSADD;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
 
 	// Back upper
 	lsx = 1;
 	lsy = 1;
-	if (c2h1 > c1h1 || c2h2 > c1h2)
+	if (build.textures[TEX_BACK_UPPER])
 	{
 		quad_3d_t quad;
 
@@ -1728,7 +1820,7 @@ void MapRenderer3D::updateLine(unsigned index)
 		}
 
 		// Texture scale
-		quad.texture = MapEditor::textureManager().getTexture(line->s2()->getTexUpper(), mixed);
+		quad.texture = build.textures[TEX_BACK_UPPER];
 		sx = quad.texture->getScaleX();
 		sy = quad.texture->getScaleY();
 		if (map->currentFormat() == MAP_UDMF && Game::configuration().featureSupported(UDMFFeature::TextureScaling))
@@ -1758,13 +1850,72 @@ void MapRenderer3D::updateLine(unsigned index)
 		quad.flags |= UPPER;
 
 		// Add quad
-		lines[index].quads.push_back(quad);
+		build.quads.push_back(quad);
 	}
+}
 
-	// Finished
+/* MapRenderer3D::updateLine
+ * Updates cached rendering data for line [index]
+ *******************************************************************/
+void MapRenderer3D::updateLine(unsigned index)
+{
+	// Check index
+	if (index >= lines.size())
+		return;
+
+	// Process line special
+	line_build_t build;
+	build.index = index;
+	build.line = map->getLine(index);
+	if (build.line->s1())
+		map->mapSpecials()->processLineSpecial(build.line);
+
+	// Build quads
+	prepareLine(build);
+	buildLineQuads(build);
+
+	lines[index].quads.swap(build.quads);
+	lines[index].line = build.line;
 	lines[index].updated_time = App::runTimer();
 }
 
+/* MapRenderer3D::updateLines
+ * Updates cached rendering data for all lines in [indices]. The
+ * quads for each line are built across worker threads
+ *******************************************************************/
+void MapRenderer3D::updateLines(const vector<unsigned>& indices)
+{
+	// Process line specials first, since they can modify sectors used by
+	// other lines
+	for (auto index : indices)
+	{
+		MapLine* line = map->getLine(index);
+		if (line->s1())
+			map->mapSpecials()->processLineSpecial(line);
+	}
+
+	// Get textures and colours
+	vector<line_build_t> builds(indices.size());
+	for (unsigned a = 0; a < indices.size(); a++)
+	{
+		builds[a].index = indices[a];
+		builds[a].line = map->getLine(indices[a]);
+		prepareLine(builds[a]);
+	}
+
+	// Build quads
+	ThreadPool::global().parallelFor(builds.size(), [&](size_t a) { buildLineQuads(builds[a]); });
+
+	// Apply
+	long time = App::runTimer();
+	for (auto& build : builds)
+	{
+		lines[build.index].quads.swap(build.quads);
+		lines[build.index].line = build.line;
+		lines[build.index].updated_time = time;
+	}
+}
+
 /* MapRenderer3D::renderQuad
  * Renders [quad]
  *******************************************************************/
@@ -2105,6 +2256,11 @@ void MapRenderer3D::renderThings()
 				break;
 		}
 
+		// Skip if the thing's sector is hidden
+		if (things[a].sector && things[a].sector->getIndex() < dist_sectors.size() &&
+			dist_sectors[things[a].sector->getIndex()] < 0)
+			continue;
+
 		// Skip if not shown
 		if (!things[a].type->decoration() && render_3d_things == 2)
 			continue;
@@ -2526,6 +2682,246 @@ void MapRenderer3D::quickVisDiscard()
 		else
 			lines[map->getSide(a)->getParentLine()->getIndex()].visible = true;
 	}
+
+	// Hide anything that can't be seen through portals from the camera
+	if (render_portal_culling)
+		portalVisDiscard();
+}
+
+/* MapRenderer3D::portalVisDiscard
+ * Flood-fills outward from the sector the camera is in, through any
+ * open two-sided lines (portals) within the view. The view 'window'
+ * of each sector reached is narrowed to the portals it was seen
+ * through. Any sectors and lines that weren't reached are hidden.
+ * Heights are only used to check for closed portals (eg. doors), so
+ * this can only hide things that really aren't visible
+ *******************************************************************/
+void MapRenderer3D::portalVisDiscard()
+{
+	// Find the sector the camera is in
+	fpoint2_t cam = cam_position.get2d();
+	if (cam_sector < 0 || cam_sector >= (int)map->nSectors() || !map->getSector(cam_sector)->isWithin(cam))
+		cam_sector = map->sectorAt(cam);
+	if (cam_sector < 0)
+		return;
+
+	// Determine the horizontal view angle, widened to include the frustum
+	// corners when looking up or down. If looking too far up or down,
+	// don't clip portals to the view at all
+	double pitch = fabs(cam_pitch);
+	double denom = cos(pitch) - sin(pitch) * fov_tan;
+	bool clip = denom > 0.05;
+	double half_fov = clip ? atan(1.0 / denom) + 0.05 : PI;
+	fpoint2_t dir = cam_direction;
+
+	// Init flood state
+	unsigned n_sectors = map->nSectors();
+	portal_state.assign(n_sectors, 0);
+	portal_left.resize(n_sectors);
+	portal_right.resize(n_sectors);
+	portal_lines.assign(map->nLines(), 0);
+	portal_queue.clear();
+
+	// Start from the camera sector with the full view
+	portal_state[cam_sector] = 2;
+	portal_left[cam_sector] = -half_fov;
+	portal_right[cam_sector] = half_fov;
+	portal_queue.push_back(cam_sector);
+
+	string sky_flat = Game::configuration().skyFlat();
+	while (!portal_queue.empty())
+	{
+		unsigned index = portal_queue.back();
+		portal_queue.pop_back();
+		portal_state[index] = 1;
+
+		MapSector* sector = map->getSector(index);
+		double w_left = portal_left[index];
+		double w_right = portal_right[index];
+		for (auto side : sector->connectedSides())
+		{
+			MapLine* line = side->getParentLine();
+			fpoint2_t p1 = line->point1();
+			fpoint2_t p2 = line->point2();
+
+			// Get the part of the sector's view window the line covers
+			// (lines right next to the camera cover all of it)
+			double left = w_left;
+			double right = w_right;
+			if (clip && MathStuff::distanceToLine(cam, line->seg()) > 1)
+			{
+				fpoint2_t v1 = p1 - cam;
+				fpoint2_t v2 = p2 - cam;
+				double a1 = atan2(dir.x * v1.y - dir.y * v1.x, dir.x * v1.x + dir.y * v1.y);
+				double a2 = atan2(dir.x * v2.y - dir.y * v2.x, dir.x * v2.x + dir.y * v2.y);
+				double a_min = min(a1, a2);
+				double a_max = max(a1, a2);
+
+				if (a_max - a_min <= PI)
+				{
+					// Line is in front of the camera
+					left = max(left, a_min);
+					right = min(right, a_max);
+				}
+				else
+				{
+					// Line crosses behind the camera, so covers [a_max, PI]
+					// and [-PI, a_min]
+					bool in_max = a_max <= right;
+					bool in_min = a_min >= left;
+					if (in_max && !in_min)
+						left = max(left, a_max);
+					else if (in_min && !in_max)
+						right = min(right, a_min);
+					else if (!in_max && !in_min)
+						continue;
+				}
+
+				if (left > right)
+					continue;
+			}
+
+			// Line is visible
+			portal_lines[line->getIndex()] = 1;
+
+			// Check for a portal to another visible sector
+			MapSector* other = (side == line->s1()) ? line->backSector() : line->frontSector();
+			if (!other || other == sector)
+				continue;
+			unsigned o = other->getIndex();
+			if (dist_sectors[o] < 0 || (render_max_dist > 0 && dist_sectors[o] > render_max_dist))
+				continue;
+
+			// Check the portal isn't closed (unless there's sky above it,
+			// in which case upper textures aren't drawn)
+			plane_t f1 = sector->getFloorPlane();
+			plane_t f2 = other->getFloorPlane();
+			plane_t c1 = sector->getCeilingPlane();
+			plane_t c2 = other->getCeilingPlane();
+			if (min(c1.height_at(p1), c2.height_at(p1)) <= max(f1.height_at(p1), f2.height_at(p1)) &&
+				min(c1.height_at(p2), c2.height_at(p2)) <= max(f1.height_at(p2), f2.height_at(p2)) &&
+				!(S_CMPNOCASE(sector->getCeilingTex(), sky_flat) && S_CMPNOCASE(other->getCeilingTex(), sky_flat)))
+				continue;
+
+			// Add (or widen) the other sector's view window
+			if (portal_state[o] == 0)
+			{
+				portal_left[o] = left;
+				portal_right[o] = right;
+			}
+			else if (left < portal_left[o] || right > portal_right[o])
+			{
+				portal_left[o] = min(portal_left[o], left);
+				portal_right[o] = max(portal_right[o], right);
+				if (portal_state[o] == 2)
+					continue;
+			}
+			else
+				continue;
+
+			portal_state[o] = 2;
+			portal_queue.push_back(o);
+		}
+	}
+
+	// Hide sectors and lines that weren't reached
+	for (unsigned a = 0; a < n_sectors; a++)
+	{
+		if (portal_state[a] == 0)
+			dist_sectors[a] = -1.0f;
+	}
+	for (unsigned a = 0; a < portal_lines.size(); a++)
+	{
+		if (!portal_lines[a])
+			lines[a].visible = false;
+	}
+}
+
+/* MapRenderer3D::benchmarkVisibility
+ * Runs the visibility checks from up to [samples] thing positions in
+ * the map (facing 8 directions from each), with and without portal
+ * culling, and logs the average number of visible sectors and lines
+ * and the time taken per frame. Doesn't need an OpenGL context
+ *******************************************************************/
+void MapRenderer3D::benchmarkVisibility(unsigned samples)
+{
+	// Get camera positions to test from things in sectors
+	vector<fpoint3_t> positions;
+	unsigned step = samples > 0 ? max<unsigned>(1, map->nThings() / samples) : 1;
+	for (unsigned a = 0; a < map->nThings() && positions.size() < samples; a += step)
+	{
+		MapThing* thing = map->getThing(a);
+		int sector = map->sectorAt(thing->point());
+		if (sector >= 0)
+			positions.push_back(fpoint3_t(thing->xPos(), thing->yPos(), map->getSector(sector)->getFloorHeight() + 41));
+	}
+	if (positions.empty())
+	{
+		Log::console("No things within sectors to test from");
+		return;
+	}
+
+	// Save current state
+	fpoint3_t pos = cam_position;
+	fpoint2_t dir = cam_direction;
+	double pitch = cam_pitch;
+	bool portal = render_portal_culling;
+
+	if (lines.size() != map->nLines())
+		lines.resize(map->nLines());
+
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		render_portal_culling = (pass == 1);
+
+		double n_sectors = 0;
+		double n_lines = 0;
+		long time = 0;
+		unsigned n_frames = 0;
+		for (auto& position : positions)
+		{
+			for (unsigned d = 0; d < 8; d++)
+			{
+				cam_position = position;
+				cam_direction = MathStuff::vectorAngle(d * PI * 0.25);
+				cam_pitch = 0;
+				cameraUpdateVectors();
+
+				sf::Clock clock;
+				quickVisDiscard();
+				time += clock.getElapsedTime().asMicroseconds();
+				n_frames++;
+
+				// Count visible sectors/lines
+				for (unsigned a = 0; a < dist_sectors.size(); a++)
+				{
+					if (dist_sectors[a] >= 0 && (render_max_dist <= 0 || dist_sectors[a] <= render_max_dist))
+						n_sectors++;
+				}
+				for (unsigned a = 0; a < lines.size(); a++)
+				{
+					if (lines[a].visible)
+						n_lines++;
+				}
+			}
+		}
+
+		Log::console(S_FMT(
+			"%s: %1.1f sectors, %1.1f lines visible on average, %1.3fms per frame (%d views)",
+			pass == 0 ? "Distance only" : "Portal culling",
+			n_sectors / n_frames,
+			n_lines / n_frames,
+			(double)time / n_frames / 1000.0,
+			n_frames
+		));
+	}
+
+	// Restore state
+	render_portal_culling = portal;
+	cam_position = pos;
+	cam_direction = dir;
+	cam_pitch = pitch;
+	cameraUpdateVectors();
 }
 
 /* MapRenderer3D::calcDistFade
@@ -2557,8 +2953,8 @@ void MapRenderer3D::checkVisibleQuads()
 	MapLine* line;
 	float distfade;
 	n_quads = 0;
-	unsigned updates = 0;
-	bool update = false;
+	lines_visible.clear();
+	lines_update.clear();
 	fseg2_t strafe(cam_position.get2d(), (cam_position + cam_strafe).get2d());
 	for (unsigned a = 0; a < lines.size(); a++)
 	{
@@ -2576,14 +2972,10 @@ void MapRenderer3D::checkVisibleQuads()
 				continue;
 		}
 
-		// Check for distance fade
-		if (render_max_dist > 0)
-			distfade = calcDistFade(MathStuff::distanceToLine(cam_position.get2d(), line->seg()), render_max_dist);
-		else
-			distfade = 1.0f;
+		lines_visible.push_back(a);
 
-		// Update line if needed
-		update = false;
+		// Check if line needs updating
+		bool update = false;
 		if (lines[a].updated_time < line->modifiedTime())	// Check line modified
 			update = true;
 		if (lines[a].line != line)
@@ -2605,14 +2997,26 @@ void MapRenderer3D::checkVisibleQuads()
 				update = true;
 		}
 		if (update)
-		{
-			updateLine(a);
-			//updates++;
-			//if (updates > 500)
-			//	break;
-		}
+			lines_update.push_back(a);
+	}
+
+	// Update lines that need it (all at once, across worker threads)
+	if (lines_update.size() == 1)
+		updateLine(lines_update[0]);
+	else if (!lines_update.empty())
+		updateLines(lines_update);
+
+	// Determine quads to be drawn
+	for (auto a : lines_visible)
+	{
+		line = map->getLine(a);
+
+		// Check for distance fade
+		if (render_max_dist > 0)
+			distfade = calcDistFade(MathStuff::distanceToLine(cam_position.get2d(), line->seg()), render_max_dist);
+		else
+			distfade = 1.0f;
 
-		// Determine quads to be drawn
 		quad_3d_t* quad;
 		for (unsigned q = 0; q < lines[a].quads.size(); q++)
 		{
@@ -2691,87 +3095,296 @@ void MapRenderer3D::checkVisibleFlats()
 	}
 }
 
-/* MapRenderer3D::determineHilight
- * Finds the closest wall/flat/thing to the camera along the view
- * vector
+/* MapRenderer3D::updatePickGrid
+ * Rebuilds the grid of lines used to accelerate ray picking, if the
+ * map geometry has changed since it was last built
  *******************************************************************/
-MapEditor::Item MapRenderer3D::determineHilight()
+void MapRenderer3D::updatePickGrid()
+{
+	// Check if the grid needs rebuilding
+	if (pick_updated > 0 && pick_stamp.size() == map->nLines() && map->geometryUpdated() < pick_updated)
+		return;
+	pick_updated = App::runTimer();
+
+	pick_cells.clear();
+	pick_lines.clear();
+	pick_stamp.assign(map->nLines(), 0);
+	pick_ray = 0;
+	pick_cols = pick_rows = 0;
+	if (map->nLines() == 0)
+		return;
+
+	// Get bounds of all lines
+	double min_x = 9999999, min_y = 9999999, max_x = -9999999, max_y = -9999999;
+	for (unsigned a = 0; a < map->nLines(); a++)
+	{
+		MapLine* line = map->getLine(a);
+		min_x = min(min_x, min(line->x1(), line->x2()));
+		min_y = min(min_y, min(line->y1(), line->y2()));
+		max_x = max(max_x, max(line->x1(), line->x2()));
+		max_y = max(max_y, max(line->y1(), line->y2()));
+	}
+
+	// Size cells to hold a few lines each on average
+	double area = max(1.0, (max_x - min_x) * (max_y - min_y));
+	pick_cell_size = sqrt(area / map->nLines()) * 2;
+	if (pick_cell_size < 64) pick_cell_size = 64;
+	pick_x = min_x - 1;
+	pick_y = min_y - 1;
+	pick_cols = (int)((max_x + 1 - pick_x) / pick_cell_size) + 1;
+	pick_rows = (int)((max_y + 1 - pick_y) / pick_cell_size) + 1;
+
+	// Calls [func] for each cell [line] passes through. Cells are padded
+	// slightly so a ray hitting the line is sure to pass through one of them
+	// even with rounding errors
+	const double pad = 1.0;
+	auto forCells = [&](MapLine* line, std::function<void(unsigned)> func)
+	{
+		double x1 = line->x1(), y1 = line->y1(), x2 = line->x2(), y2 = line->y2();
+		int c1 = max(0, (int)((min(x1, x2) - pad - pick_x) / pick_cell_size));
+		int c2 = min(pick_cols - 1, (int)((max(x1, x2) + pad - pick_x) / pick_cell_size));
+		int r1 = max(0, (int)((min(y1, y2) - pad - pick_y) / pick_cell_size));
+		int r2 = min(pick_rows - 1, (int)((max(y1, y2) + pad - pick_y) / pick_cell_size));
+		double nx = y1 - y2;
+		double ny = x2 - x1;
+		for (int r = r1; r <= r2; r++)
+		{
+			for (int c = c1; c <= c2; c++)
+			{
+				// Check the line actually crosses the (padded) cell
+				double bx1 = pick_x + c * pick_cell_size - pad;
+				double by1 = pick_y + r * pick_cell_size - pad;
+				double bx2 = bx1 + pick_cell_size + pad * 2;
+				double by2 = by1 + pick_cell_size + pad * 2;
+				double s1 = nx * (bx1 - x1) + ny * (by1 - y1);
+				double s2 = nx * (bx2 - x1) + ny * (by1 - y1);
+				double s3 = nx * (bx1 - x1) + ny * (by2 - y1);
+				double s4 = nx * (bx2 - x1) + ny * (by2 - y1);
+				if (min(min(s1, s2), min(s3, s4)) > 0 || max(max(s1, s2), max(s3, s4)) < 0)
+					continue;
+
+				func(r * pick_cols + c);
+			}
+		}
+	};
+
+	// Count lines in each cell
+	pick_cells.assign(pick_cols * pick_rows + 1, 0);
+	for (unsigned a = 0; a < map->nLines(); a++)
+		forCells(map->getLine(a), [&](unsigned cell) { pick_cells[cell + 1]++; });
+	for (unsigned a = 1; a < pick_cells.size(); a++)
+		pick_cells[a] += pick_cells[a - 1];
+
+	// Add lines to cells
+	vector<unsigned> fill(pick_cells.begin(), pick_cells.end() - 1);
+	pick_lines.resize(pick_cells.back());
+	for (unsigned a = 0; a < map->nLines(); a++)
+		forCells(map->getLine(a), [&](unsigned cell) { pick_lines[fill[cell]++] = a; });
+}
+
+/* MapRenderer3D::pickLine
+ * Checks if the ray from [origin] along [dir] hits a wall quad of
+ * line [index] closer than [min_dist] (or equally close, if
+ * [index] is lower than [min_line]). If it does, [item], [min_dist]
+ * and [min_line] are updated to the hit
+ *******************************************************************/
+void MapRenderer3D::pickLine(unsigned index, fpoint3_t origin, fpoint3_t dir, double& min_dist, unsigned& min_line, MapEditor::Item& item)
+{
+	// Ignore if not visible
+	if (!lines[index].visible)
+		return;
+
+	MapLine* line = map->getLine(index);
+
+	// Find (2d) distance to line
+	double dist = MathStuff::distanceRayLine(
+		origin.get2d(), (origin + dir).get2d(),
+		line->point1(), line->point2());
+
+	// Ignore if no intersection or something was closer
+	if (dist < 0 || dist > min_dist || (dist == min_dist && index > min_line))
+		return;
+
+	// Find quad intersect if any
+	fpoint3_t intersection = origin + dir * dist;
+	quad_3d_t* quad;
+	for (unsigned q = 0; q < lines[index].quads.size(); q++)
+	{
+		quad = &lines[index].quads[q];
+
+		// Check side of origin
+		if (MathStuff::lineSide(origin.get2d(), fseg2_t(quad->points[0].x, quad->points[0].y, quad->points[2].x, quad->points[2].y)) < 0)
+			continue;
+
+		// Check intersection height
+		// Need to handle slopes by finding the floor and ceiling height of
+		// the quad at the intersection point
+		fpoint2_t seg_left = fpoint2_t(quad->points[1].x, quad->points[1].y);
+		fpoint2_t seg_right = fpoint2_t(quad->points[2].x, quad->points[2].y);
+		double dist_along_segment =
+			(intersection.get2d() - seg_left).magnitude() /
+			(seg_right - seg_left).magnitude();
+		double top = quad->points[0].z + (quad->points[3].z - quad->points[0].z) * dist_along_segment;
+		double bottom = quad->points[1].z + (quad->points[2].z - quad->points[1].z) * dist_along_segment;
+		if (bottom <= intersection.z && intersection.z <= top)
+		{
+			// Determine selected item from quad flags
+
+			// Side index
+			if (quad->flags & BACK)
+				item.index = line->s2Index();
+			else
+				item.index = line->s1Index();
+
+			// Side part
+			if (quad->flags & UPPER)
+				item.type = MapEditor::ItemType::WallTop;
+			else if (quad->flags & LOWER)
+				item.type = MapEditor::ItemType::WallBottom;
+			else
+				item.type = MapEditor::ItemType::WallMiddle;
+
+			min_dist = dist;
+			min_line = index;
+		}
+	}
+}
+
+/* MapRenderer3D::castRay
+ * Finds the closest visible wall or flat hit by the ray from [origin]
+ * along [dir], and sets [min_dist] to the distance along the ray to
+ * it (9999999 if nothing was hit). Walls are found by walking the
+ * ray through the line grid, unless [linear] is true, in which case
+ * all lines are checked (for testing)
+ *******************************************************************/
+MapEditor::Item MapRenderer3D::castRay(fpoint3_t origin, fpoint3_t dir, double& min_dist, bool linear)
 {
 	// Init
-	double min_dist = 9999999;
+	min_dist = 9999999;
 	MapEditor::Item current;
-	fseg2_t strafe(cam_position.get2d(), (cam_position + cam_strafe).get2d());
 
 	// Check for required map structures
 	if (!map || lines.size() != map->nLines() ||
 	        floors.size() != map->nSectors() ||
-	        things.size() != map->nThings())
+	        dist_sectors.size() != map->nSectors())
 		return current;
 
 	// Check lines
-	double height, dist;
-	quad_3d_t* quad;
-	for (unsigned a = 0; a < map->nLines(); a++)
+	unsigned min_line = 0;
+	if (linear)
 	{
-		// Ignore if not visible
-		if (!lines[a].visible)
-			continue;
-
-		MapLine* line = map->getLine(a);
+		for (unsigned a = 0; a < map->nLines(); a++)
+			pickLine(a, origin, dir, min_dist, min_line, current);
+	}
+	else if (dir.x != 0 || dir.y != 0)
+	{
+		updatePickGrid();
 
-		// Find (2d) distance to line
-		dist = MathStuff::distanceRayLine(
-			cam_position.get2d(), (cam_position + cam_dir3d).get2d(),
-			line->point1(), line->point2());
+		// Clip ray to grid bounds
+		double t_min = 0;
+		double t_max = 9999999;
+		double grid_min[2] = { pick_x, pick_y };
+		double grid_max[2] = { pick_x + pick_cols * pick_cell_size, pick_y + pick_rows * pick_cell_size };
+		double ray_o[2] = { origin.x, origin.y };
+		double ray_d[2] = { dir.x, dir.y };
+		for (unsigned axis = 0; axis < 2; axis++)
+		{
+			if (ray_d[axis] == 0)
+			{
+				if (ray_o[axis] < grid_min[axis] || ray_o[axis] > grid_max[axis])
+					t_min = t_max + 1;
+				continue;
+			}
 
-		// Ignore if no intersection or something was closer
-		if (dist < 0 || dist >= min_dist)
-			continue;
+			double t1 = (grid_min[axis] - ray_o[axis]) / ray_d[axis];
+			double t2 = (grid_max[axis] - ray_o[axis]) / ray_d[axis];
+			if (t1 > t2) std::swap(t1, t2);
+			t_min = max(t_min, t1);
+			t_max = min(t_max, t2);
+		}
 
-		// Find quad intersect if any
-		fpoint3_t intersection = cam_position + cam_dir3d * dist;
-		for (unsigned q = 0; q < lines[a].quads.size(); q++)
+		if (t_min <= t_max && pick_cols > 0)
 		{
-			quad = &lines[a].quads[q];
+			// Get starting cell
+			int col = (int)((origin.x + dir.x * t_min - pick_x) / pick_cell_size);
+			int row = (int)((origin.y + dir.y * t_min - pick_y) / pick_cell_size);
+			col = max(0, min(pick_cols - 1, col));
+			row = max(0, min(pick_rows - 1, row));
 
-			// Check side of camera
-			if (MathStuff::lineSide(cam_position.get2d(), fseg2_t(quad->points[0].x, quad->points[0].y, quad->points[2].x, quad->points[2].y)) < 0)
-				continue;
+			// Setup DDA
+			int step_col = dir.x > 0 ? 1 : -1;
+			int step_row = dir.y > 0 ? 1 : -1;
+			double next_col = 9999999 * 2;
+			double next_row = 9999999 * 2;
+			double delta_col = 0, delta_row = 0;
+			if (dir.x != 0)
+			{
+				next_col = (pick_x + (col + (dir.x > 0 ? 1 : 0)) * pick_cell_size - origin.x) / dir.x;
+				delta_col = pick_cell_size / fabs(dir.x);
+			}
+			if (dir.y != 0)
+			{
+				next_row = (pick_y + (row + (dir.y > 0 ? 1 : 0)) * pick_cell_size - origin.y) / dir.y;
+				delta_row = pick_cell_size / fabs(dir.y);
+			}
 
-			// Check intersection height
-			// Need to handle slopes by finding the floor and ceiling height of
-			// the quad at the intersection point
-			fpoint2_t seg_left = fpoint2_t(quad->points[1].x, quad->points[1].y);
-			fpoint2_t seg_right = fpoint2_t(quad->points[2].x, quad->points[2].y);
-			double dist_along_segment =
-				(intersection.get2d() - seg_left).magnitude() /
-				(seg_right - seg_left).magnitude();
-			double top = quad->points[0].z + (quad->points[3].z - quad->points[0].z) * dist_along_segment;
-			double bottom = quad->points[1].z + (quad->points[2].z - quad->points[1].z) * dist_along_segment;
-			if (bottom <= intersection.z && intersection.z <= top)
+			// Walk cells along the ray until past the closest hit
+			pick_ray++;
+			if (pick_ray == 0)
 			{
-				// Determine selected item from quad flags
+				std::fill(pick_stamp.begin(), pick_stamp.end(), 0);
+				pick_ray = 1;
+			}
+			double t_cell = t_min;
+			while (col >= 0 && col < pick_cols && row >= 0 && row < pick_rows && t_cell <= min_dist)
+			{
+				unsigned cell = row * pick_cols + col;
+				for (unsigned a = pick_cells[cell]; a < pick_cells[cell + 1]; a++)
+				{
+					unsigned index = pick_lines[a];
+					if (pick_stamp[index] == pick_ray)
+						continue;
+					pick_stamp[index] = pick_ray;
 
-				// Side index
-				if (quad->flags & BACK)
-					current.index = line->s2Index();
-				else
-					current.index = line->s1Index();
+					pickLine(index, origin, dir, min_dist, min_line, current);
+				}
 
-				// Side part
-				if (quad->flags & UPPER)
-					current.type = MapEditor::ItemType::WallTop;
-				else if (quad->flags & LOWER)
-					current.type = MapEditor::ItemType::WallBottom;
+				// Next cell
+				if (next_col < next_row)
+				{
+					t_cell = next_col;
+					next_col += delta_col;
+					col += step_col;
+				}
 				else
-					current.type = MapEditor::ItemType::WallMiddle;
-
-				min_dist = dist;
+				{
+					t_cell = next_row;
+					next_row += delta_row;
+					row += step_row;
+				}
 			}
 		}
 	}
 
 	// Check sectors
+	// Plane distance and sector bbox checks are cheap, so get all flats
+	// that could be hit first, and only do the (slower) within sector
+	// check on the closest ones until one is hit
+	struct flat_hit_t
+	{
+		double		dist;
+		unsigned	sector;
+		bool		ceiling;
+
+		bool operator<(const flat_hit_t& r) const
+		{
+			if (dist != r.dist) return dist < r.dist;
+			if (sector != r.sector) return sector < r.sector;
+			return !ceiling && r.ceiling;
+		}
+	};
+	vector<flat_hit_t> flat_hits;
+	double dist;
 	for (unsigned a = 0; a < map->nSectors(); a++)
 	{
 		// Ignore if not visible
@@ -2779,40 +3392,115 @@ MapEditor::Item MapRenderer3D::determineHilight()
 			continue;
 
 		// Check distance to floor plane
-		dist = MathStuff::distanceRayPlane(cam_position, cam_dir3d, floors[a].plane);
+		MapSector* sector = map->getSector(a);
+		dist = MathStuff::distanceRayPlane(origin, dir, floors[a].plane);
 		if (dist >= 0 && dist < min_dist)
 		{
-			// Check if on the correct side of the plane
-			if (cam_position.z > floors[a].plane.height_at(cam_position.x, cam_position.y))
-			{
-				// Check if intersection is within sector
-				if (map->getSector(a)->isWithin((cam_position + cam_dir3d * dist).get2d()))
-				{
-					current.index = a;
-					current.type = MapEditor::ItemType::Floor;
-					min_dist = dist;
-				}
-			}
+			// Check if on the correct side of the plane and within sector bbox
+			if (origin.z > floors[a].plane.height_at(origin.x, origin.y) &&
+				sector->boundingBox().contains((origin + dir * dist).get2d()))
+				flat_hits.push_back({ dist, a, false });
 		}
 
 		// Check distance to ceiling plane
-		dist = MathStuff::distanceRayPlane(cam_position, cam_dir3d, ceilings[a].plane);
+		dist = MathStuff::distanceRayPlane(origin, dir, ceilings[a].plane);
 		if (dist >= 0 && dist < min_dist)
 		{
-			// Check if on the correct side of the plane
-			if (cam_position.z < ceilings[a].plane.height_at(cam_position.x, cam_position.y))
-			{
-				// Check if intersection is within sector
-				if (map->getSector(a)->isWithin((cam_position + cam_dir3d * dist).get2d()))
-				{
-					current.index = a;
-					current.type = MapEditor::ItemType::Ceiling;
-					min_dist = dist;
-				}
-			}
+			// Check if on the correct side of the plane and within sector bbox
+			if (origin.z < ceilings[a].plane.height_at(origin.x, origin.y) &&
+				sector->boundingBox().contains((origin + dir * dist).get2d()))
+				flat_hits.push_back({ dist, a, true });
+		}
+	}
+	std::sort(flat_hits.begin(), flat_hits.end());
+	for (auto& hit : flat_hits)
+	{
+		// Check if intersection is within sector
+		if (map->getSector(hit.sector)->isWithin((origin + dir * hit.dist).get2d()))
+		{
+			current.index = hit.sector;
+			current.type = hit.ceiling ? MapEditor::ItemType::Ceiling : MapEditor::ItemType::Floor;
+			min_dist = hit.dist;
+			break;
 		}
 	}
 
+	return current;
+}
+
+/* MapRenderer3D::checkPicking
+ * Compares ray picking via the line grid against checking all lines
+ * for [samples] rays across the current view, and logs the results
+ *******************************************************************/
+void MapRenderer3D::checkPicking(unsigned samples)
+{
+	if (!map || lines.size() != map->nLines() || dist_sectors.size() != map->nSectors())
+	{
+		Log::console("3d view has not been rendered yet");
+		return;
+	}
+
+	// Build grid first so it isn't included in the timing
+	pick_updated = 0;
+	sf::Clock clock;
+	updatePickGrid();
+	long time_build = clock.getElapsedTime().asMicroseconds();
+
+	long time_grid = 0;
+	long time_linear = 0;
+	unsigned mismatches = 0;
+	for (unsigned a = 0; a < samples; a++)
+	{
+		// Get ray direction (spread over the view)
+		fpoint3_t dir = cam_dir3d;
+		double sx = ((double)rand() / RAND_MAX - 0.5) * 2;
+		double sy = ((double)rand() / RAND_MAX - 0.5) * 1.5;
+		dir = dir + cam_strafe * sx + cam_dir3d.cross(cam_strafe) * sy;
+
+		double dist_grid, dist_linear;
+		clock.restart();
+		MapEditor::Item grid = castRay(cam_position, dir, dist_grid);
+		time_grid += clock.getElapsedTime().asMicroseconds();
+		clock.restart();
+		MapEditor::Item linear = castRay(cam_position, dir, dist_linear, true);
+		time_linear += clock.getElapsedTime().asMicroseconds();
+
+		if (grid.index != linear.index || grid.type != linear.type || dist_grid != dist_linear)
+			mismatches++;
+	}
+
+	Log::console(S_FMT(
+		"Line grid %dx%d (%1.0f units, %d entries) built in %1.3fms",
+		pick_cols, pick_rows, pick_cell_size, (int)pick_lines.size(), (double)time_build / 1000.0));
+	Log::console(S_FMT(
+		"%d rays: %1.4fms per ray with grid, %1.4fms checking all lines, %d mismatches",
+		samples,
+		samples > 0 ? (double)time_grid / samples / 1000.0 : 0.0,
+		samples > 0 ? (double)time_linear / samples / 1000.0 : 0.0,
+		mismatches
+	));
+}
+
+/* MapRenderer3D::determineHilight
+ * Finds the closest wall/flat/thing to the camera along the view
+ * vector
+ *******************************************************************/
+MapEditor::Item MapRenderer3D::determineHilight()
+{
+	// Init
+	double min_dist = 9999999;
+	MapEditor::Item current;
+	fseg2_t strafe(cam_position.get2d(), (cam_position + cam_strafe).get2d());
+
+	// Check for required map structures
+	if (!map || lines.size() != map->nLines() ||
+	        floors.size() != map->nSectors() ||
+	        things.size() != map->nThings())
+		return current;
+
+	// Check walls and flats
+	current = castRay(cam_position, cam_dir3d, min_dist);
+
 	// Update item distance
 	if (min_dist >= 9999999 || min_dist < 0)
 		item_dist = -1;
@@ -2822,7 +3510,7 @@ MapEditor::Item MapRenderer3D::determineHilight()
 	// Check things (if visible)
 	if (render_3d_things == 0)
 		return current;
-	double halfwidth, theight;
+	double halfwidth, theight, height, dist;
 	for (unsigned a = 0; a < map->nThings(); a++)
 	{
 		// Ignore if no sprite
@@ -3087,3 +3775,27 @@ void MapRenderer3D::onAnnouncement(Announcer* announcer, string event_name, MemC
 		}
 	}
 }
+
+
+/*******************************************************************
+ * CONSOLE COMMANDS
+ *******************************************************************/
+#include "General/Console/Console.h"
+
+CONSOLE_COMMAND(m_test_vis3d, 0, false)
+{
+	unsigned samples = 100;
+	if (!args.empty())
+		samples = atoi(CHR(args[0]));
+
+	MapEditor::editContext().renderer().renderer3D().benchmarkVisibility(samples);
+}
+
+CONSOLE_COMMAND(m_test_pick3d, 0, false)
+{
+	unsigned samples = 10000;
+	if (!args.empty())
+		samples = atoi(CHR(args[0]));
+
+	MapEditor::editContext().renderer().renderer3D().checkPicking(samples);
+}
@@ -156,6 +156,7 @@ public:
 	void	renderSky();
 
 	// Flats
+	void	updatePolygons();
 	void	updateFlatTexCoords(unsigned index, bool floor);
 	void	updateSector(unsigned index);
 	void	renderFlat(flat_3d_t* flat);
@@ -167,6 +168,7 @@ public:
 	void	setupQuad(quad_3d_t* quad, double x1, double y1, double x2, double y2, plane_t top, plane_t bottom);
 	void	setupQuadTexCoords(quad_3d_t* quad, int length, double o_left, double o_top, double h_top, double h_bottom, bool pegbottom = false, double sx = 1, double sy = 1);
 	void	updateLine(unsigned index);
+	void	updateLines(const vector<unsigned>& indices);
 	void	renderQuad(quad_3d_t* quad, float alpha = 1.0f);
 	void	renderWalls();
 	void	renderTransparentWalls();
@@ -183,11 +185,15 @@ public:
 
 	// Visibility checking
 	void	quickVisDiscard();
+	void	portalVisDiscard();
+	void	benchmarkVisibility(unsigned samples);
 	float	calcDistFade(double distance, double max = -1);
 	void	checkVisibleQuads();
 	void	checkVisibleFlats();
 
 	// Hilight
+	MapEditor::Item	castRay(fpoint3_t origin, fpoint3_t dir, double& min_dist, bool linear = false);
+	void				checkPicking(unsigned samples);
 	MapEditor::Item	determineHilight();
 	void				renderHilight(MapEditor::Item hilight, float alpha = 1.0f);
 
@@ -208,7 +214,29 @@ private:
 	float		fog_depth_last;
 
 	// Visibility
-	vector<float>	dist_sectors;
+	vector<float>		dist_sectors;
+	int					cam_sector;		// Sector the camera was last found in
+	double				fov_tan;		// Tangent of half the vertical field of view
+	vector<uint8_t>		portal_state;	// Per-sector portal flood state (0 = not reached)
+	vector<double>		portal_left;	// Per-sector view window (angles relative to camera direction)
+	vector<double>		portal_right;
+	vector<uint8_t>		portal_lines;	// Per-line, 1 if reached by the portal flood
+	vector<unsigned>	portal_queue;
+
+	// Ray picking
+	double				pick_x;			// Bottom-left of the line grid
+	double				pick_y;
+	double				pick_cell_size;
+	int					pick_cols;
+	int					pick_rows;
+	vector<unsigned>	pick_cells;		// Start of each cell's lines in pick_lines (plus end)
+	vector<unsigned>	pick_lines;		// Lines passing through each cell
+	vector<unsigned>	pick_stamp;		// Per-line, last ray the line was checked against
+	unsigned			pick_ray;
+	long				pick_updated;
+
+	void	updatePickGrid();
+	void	pickLine(unsigned index, fpoint3_t origin, fpoint3_t dir, double& min_dist, unsigned& min_line, MapEditor::Item& item);
 
 	// Camera
 	fpoint3_t	cam_position;
@@ -222,6 +250,8 @@ private:
 
 	// Map Structures
 	vector<line_3d_t>	lines;
+	vector<unsigned>	lines_visible;	// Lines to check for visible quads this frame
+	vector<unsigned>	lines_update;	// Visible lines that need updating this frame
 	quad_3d_t**			quads;
 	vector<quad_3d_t*>	quads_transparent;
 	vector<thing_3d_t>	things;
@@ -234,6 +264,33 @@ private:
 	unsigned	vbo_ceilings;
 	unsigned	vbo_walls;
 
+	// Line geometry building
+	enum
+	{
+		TEX_FRONT_LOWER = 0,
+		TEX_FRONT_MIDDLE,
+		TEX_FRONT_UPPER,
+		TEX_BACK_LOWER,
+		TEX_BACK_MIDDLE,
+		TEX_BACK_UPPER,
+	};
+	struct line_build_t
+	{
+		unsigned			index;
+		MapLine*			line;
+		GLTexture*			textures[6];	// Texture for each quad the line has (TEX_*), null if none
+		rgba_t				colour[2];
+		rgba_t				fogcolour[2];
+		int					light[2];		// Light level of each side
+		bool				upeg;
+		bool				lpeg;
+		bool				wrap_midtex;
+		vector<quad_3d_t>	quads;
+	};
+
+	void	prepareLine(line_build_t& build);
+	void	buildLineQuads(line_build_t& build);
+
 	// Sky
 	struct gl_vertex_ex_t
 	{
@@ -118,7 +118,14 @@ void MapObject::setModified()
 		backup(obj_backup);
 	}
 
-	modified_time = App::runTimer();
+	// Update modified time (and the parent map's modification journal)
+	long time = App::runTimer();
+	if (time != modified_time)
+	{
+		modified_time = time;
+		if (parent_map)
+			parent_map->objectModified(this);
+	}
 }
 
 /* MapObject::copy
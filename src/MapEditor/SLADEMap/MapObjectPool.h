@@ -0,0 +1,92 @@
+
+#ifndef __MAP_OBJECT_POOL_H__
+#define __MAP_OBJECT_POOL_H__
+
+/* MapObjectPool
+ * Allocates map objects of type T in large blocks, so creating the
+ * objects of a map doesn't need an allocation per object, and objects
+ * of the same type are (mostly) contiguous in memory. Objects never
+ * move once created, and are only freed all at once by clear()
+ *******************************************************************/
+template<class T> class MapObjectPool
+{
+public:
+	MapObjectPool(unsigned block_size = 1024)
+	{
+		this->block_size = block_size;
+		this->count = 0;
+	}
+	~MapObjectPool() { clear(); }
+
+	MapObjectPool(const MapObjectPool&) = delete;
+	MapObjectPool& operator=(const MapObjectPool&) = delete;
+
+	unsigned	size() const { return count; }
+
+	/* MapObjectPool::reserve
+	 * Makes sure the next [n] objects created will fit in the current
+	 * block, starting a new block big enough for them if needed (eg.
+	 * when the number of objects to be read from a map is known)
+	 ***************************************************************/
+	void reserve(unsigned n)
+	{
+		if (!blocks.empty() && blocks.back().size - blocks.back().used >= n)
+			return;
+
+		addBlock(n > block_size ? n : block_size);
+	}
+
+	/* MapObjectPool::create
+	 * Creates a new object in the pool, passing [args] to its
+	 * constructor
+	 ***************************************************************/
+	template<typename... Args> T* create(Args&&... args)
+	{
+		// Start a new block if the current one is full
+		if (blocks.empty() || blocks.back().used == blocks.back().size)
+			addBlock(block_size);
+
+		Block& block = blocks.back();
+		T* object = new (block.objects + block.used) T(std::forward<Args>(args)...);
+		block.used++;
+		count++;
+
+		return object;
+	}
+
+	/* MapObjectPool::clear
+	 * Destroys all objects in the pool and frees its memory
+	 ***************************************************************/
+	void clear()
+	{
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			for (unsigned a = 0; a < blocks[b].used; a++)
+				blocks[b].objects[a].~T();
+
+			::operator delete(blocks[b].objects);
+		}
+
+		blocks.clear();
+		count = 0;
+	}
+
+private:
+	struct Block
+	{
+		T*			objects;
+		unsigned	size;
+		unsigned	used;
+	};
+
+	vector<Block>	blocks;
+	unsigned		block_size;
+	unsigned		count;
+
+	void addBlock(unsigned size)
+	{
+		blocks.push_back({ static_cast<T*>(::operator new(sizeof(T) * size)), size, 0 });
+	}
+};
+
+#endif//__MAP_OBJECT_POOL_H__
@@ -111,6 +111,7 @@ public:
 	bbox_t				boundingBox();
 	vector<MapSide*>&	connectedSides() { return connected_sides; }
 	void				resetPolygon() { poly_needsupdate = true; }
+	bool				polygonNeedsUpdate() const { return poly_needsupdate; }
 	Polygon2D*			getPolygon();
 	bool				isWithin(fpoint2_t point);
 	double				distanceTo(fpoint2_t point, double maxdist = -1);
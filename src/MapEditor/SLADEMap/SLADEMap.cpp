@@ -38,6 +38,8 @@
 #include "SLADEMap.h"
 #include "Utility/MathStuff.h"
 #include "Utility/Parser.h"
+#include "Utility/ThreadPool.h"
+#include <unordered_map>
 
 #define IDEQ(x) (((x) != 0) && ((x) == id))
 
@@ -48,6 +50,132 @@
 CVAR(Bool, map_split_auto_offset, true, CVAR_SAVE)
 
 
+/*******************************************************************
+ * LOCAL CLASSES
+ *******************************************************************/
+namespace
+{
+	/* LumpProgress
+	 * Updates the splash window progress while reading records from a
+	 * map lump (which covers 20% of the progress bar). Only updates
+	 * every [interval] records rather than on every one
+	 *******************************************************************/
+	class LumpProgress
+	{
+	public:
+		LumpProgress(unsigned count, unsigned interval = 1024)
+		{
+			this->start = UI::getSplashProgress();
+			this->count = count;
+			this->interval = interval;
+		}
+
+		void update(unsigned index)
+		{
+			if (index % interval == 0)
+				UI::setSplashProgress(start + ((float)index / count) * 0.2f);
+		}
+
+	private:
+		float		start;
+		unsigned	count;
+		unsigned	interval;
+	};
+
+	/* TexNameCache
+	 * Converts 8-character texture/flat names read from map lumps to
+	 * strings, only converting each distinct name once. Also counts
+	 * how many times each name is used, so the map's texture usage
+	 * can be updated once per name after reading
+	 *******************************************************************/
+	class TexNameCache
+	{
+	public:
+		const string& get(const char* name)
+		{
+			uint64_t key;
+			memcpy(&key, name, 8);
+
+			Name& n = names[key];
+			if (n.count++ == 0)
+				n.name = wxString::FromAscii(name, 8);
+
+			return n.name;
+		}
+
+		void addUsage(std::map<string, int>& usage)
+		{
+			for (auto& n : names)
+				usage[n.second.name.Upper()] += n.second.count;
+		}
+
+	private:
+		struct Name
+		{
+			string	name;
+			int		count = 0;
+		};
+		std::unordered_map<uint64_t, Name>	names;
+	};
+
+	/* MapLump
+	 * A binary map lump to be written, with the function that encodes
+	 * its data
+	 *******************************************************************/
+	struct MapLump
+	{
+		string							name;
+		std::function<bool(MemChunk&)>	write;
+	};
+}
+
+
+/*******************************************************************
+ * LOCAL FUNCTIONS
+ *******************************************************************/
+namespace
+{
+	/* writeMapLumps
+	 * Encodes all [lumps] concurrently on the global thread pool, then
+	 * creates an entry for each (in order) and adds it to [map_entries].
+	 * Each lump only reads its own type of map object (plus the indices
+	 * of others), so the encoders are independent as long as object
+	 * indices are up to date
+	 *******************************************************************/
+	bool writeMapLumps(vector<ArchiveEntry*>& map_entries, const vector<MapLump>& lumps)
+	{
+		// Init entry list
+		map_entries.clear();
+
+		// Encode lumps
+		vector<MemChunk> data(lumps.size());
+		vector<int> ok(lumps.size());
+		vector<int> time(lumps.size());
+		ThreadPool::global().parallelFor(lumps.size(), [&](size_t index)
+		{
+			sf::Clock clock;
+			ok[index] = lumps[index].write(data[index]);
+			time[index] = clock.getElapsedTime().asMilliseconds();
+		});
+
+		// Create entries
+		bool success = true;
+		for (unsigned a = 0; a < lumps.size(); a++)
+		{
+			ArchiveEntry* entry = new ArchiveEntry(lumps[a].name);
+			entry->importMemChunk(data[a]);
+			map_entries.push_back(entry);
+
+			LOG_MESSAGE(2, "Wrote %s (%d bytes) in %dms", lumps[a].name, data[a].getSize(), time[a]);
+			if (!ok[a])
+				success = false;
+		}
+
+		return success;
+	}
+}
+
+
 /*******************************************************************
  * SLADEMAP CLASS FUNCTIONS
  *******************************************************************/
@@ -203,6 +331,7 @@ void SLADEMap::addMapObject(MapObject* object)
 	all_objects_.push_back(mobj_holder_t(object, true));
 	object->id = all_objects_.size() - 1;
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, true));
+	objectModified(object);
 }
 
 /* SLADEMap::removeMapObject
@@ -215,6 +344,60 @@ void SLADEMap::removeMapObject(MapObject* object)
 	created_deleted_objects_.push_back(mobj_cd_t(object->id, false));
 }
 
+/* SLADEMap::objectModified
+ * Called when [object]'s modified time has changed, adds it to the
+ * modification journal
+ *******************************************************************/
+void SLADEMap::objectModified(MapObject* object)
+{
+	mod_journal_.push_back(mobj_mod_t(object->id, object->modified_time));
+
+	// Compact the journal if it has grown much larger than the number of
+	// objects (or is somehow out of order)
+	unsigned n = mod_journal_.size();
+	if ((n > 4096 && n > all_objects_.size() * 2) ||
+		(n > 1 && mod_journal_[n - 1].time < mod_journal_[n - 2].time))
+		compactJournal();
+}
+
+/* SLADEMap::journalStart
+ * Returns the index of the first modification journal entry at or
+ * after [since]
+ *******************************************************************/
+unsigned SLADEMap::journalStart(long since)
+{
+	return std::lower_bound(
+		mod_journal_.begin(),
+		mod_journal_.end(),
+		since,
+		[](const mobj_mod_t& entry, long time) { return entry.time < time; }
+	) - mod_journal_.begin();
+}
+
+/* SLADEMap::compactJournal
+ * Removes all but the latest entry for each object from the
+ * modification journal
+ *******************************************************************/
+void SLADEMap::compactJournal()
+{
+	// The latest entry for an object is the (only) one with its current
+	// modified time
+	unsigned n = 0;
+	for (unsigned a = 0; a < mod_journal_.size(); a++)
+	{
+		MapObject* object = all_objects_[mod_journal_[a].id].mobj;
+		if (object && object->modified_time == mod_journal_[a].time)
+			mod_journal_[n++] = mod_journal_[a];
+	}
+	mod_journal_.erase(mod_journal_.begin() + n, mod_journal_.end());
+
+	std::stable_sort(
+		mod_journal_.begin(),
+		mod_journal_.end(),
+		[](const mobj_mod_t& left, const mobj_mod_t& right) { return left.time < right.time; }
+	);
+}
+
 /* SLADEMap::getObjectIdList
  * Adds all object ids of [type] currently in the map to [list]
  *******************************************************************/
@@ -396,7 +579,7 @@ bool SLADEMap::readMap(Archive::MapDesc map)
  *******************************************************************/
 bool SLADEMap::addVertex(doomvertex_t& v)
 {
-	MapVertex* nv = new MapVertex(v.x, v.y, this);
+	MapVertex* nv = pool_vertices_.create(v.x, v.y, this);
 	vertices_.push_back(nv);
 	return true;
 }
@@ -406,43 +589,18 @@ bool SLADEMap::addVertex(doomvertex_t& v)
  *******************************************************************/
 bool SLADEMap::addVertex(doom64vertex_t& v)
 {
-	MapVertex* nv = new MapVertex((double)v.x/65536, (double)v.y/65536, this);
+	MapVertex* nv = pool_vertices_.create((double)v.x/65536, (double)v.y/65536, this);
 	vertices_.push_back(nv);
 	return true;
 }
 
-/* SLADEMap::addSide
- * Adds a side to the map from a doom sidedef definition [s]
- *******************************************************************/
-bool SLADEMap::addSide(doomside_t& s)
-{
-	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
-
-	// Setup side properties
-	ns->tex_upper = wxString::FromAscii(s.tex_upper, 8);
-	ns->tex_lower = wxString::FromAscii(s.tex_lower, 8);
-	ns->tex_middle = wxString::FromAscii(s.tex_middle, 8);
-	ns->offset_x = s.x_offset;
-	ns->offset_y = s.y_offset;
-
-	// Update texture counts
-	usage_tex_[ns->tex_upper.Upper()] += 1;
-	usage_tex_[ns->tex_middle.Upper()] += 1;
-	usage_tex_[ns->tex_lower.Upper()] += 1;
-
-	// Add side
-	sides_.push_back(ns);
-	return true;
-}
-
 /* SLADEMap::addSide
  * Adds a side to the map from a doom64 sidedef definition [s]
  *******************************************************************/
 bool SLADEMap::addSide(doom64side_t& s)
 {
 	// Create side
-	MapSide* ns = new MapSide(getSector(s.sector), this);
+	MapSide* ns = pool_sides_.create(getSector(s.sector), this);
 
 	// Setup side properties
 	ns->tex_upper = theResourceManager->getTextureName(s.tex_upper);
@@ -493,7 +651,7 @@ bool SLADEMap::addLine(doomline_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = pool_sides_.create(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides_.push_back(s1);
@@ -503,14 +661,14 @@ bool SLADEMap::addLine(doomline_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = pool_sides_.create(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides_.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = pool_lines_.create(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.sector_tag;
@@ -555,7 +713,7 @@ bool SLADEMap::addLine(doom64line_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = pool_sides_.create(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides_.push_back(s1);
@@ -565,14 +723,14 @@ bool SLADEMap::addLine(doom64line_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = pool_sides_.create(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides_.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = pool_lines_.create(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.sector_tag;
@@ -588,30 +746,6 @@ bool SLADEMap::addLine(doom64line_t& l)
 	return true;
 }
 
-/* SLADEMap::addSector
- * Adds a sector to the map from a doom sector definition [s]
- *******************************************************************/
-bool SLADEMap::addSector(doomsector_t& s)
-{
-	// Create sector
-	MapSector* ns = new MapSector(wxString::FromAscii(s.f_tex, 8), wxString::FromAscii(s.c_tex, 8), this);
-
-	// Setup sector properties
-	ns->setFloorHeight(s.f_height);
-	ns->setCeilingHeight(s.c_height);
-	ns->light = s.light;
-	ns->special = s.special;
-	ns->tag = s.tag;
-
-	// Update texture counts
-	usage_flat_[ns->f_tex.Upper()] += 1;
-	usage_flat_[ns->c_tex.Upper()] += 1;
-
-	// Add sector
-	sectors_.push_back(ns);
-	return true;
-}
-
 /* SLADEMap::addSector
  * Adds a sector to the map from a doom64 sector definition [s]
  *******************************************************************/
@@ -619,7 +753,7 @@ bool SLADEMap::addSector(doom64sector_t& s)
 {
 	// Create sector
 	// We need to retrieve the texture name from the hash value
-	MapSector* ns = new MapSector(theResourceManager->getTextureName(s.f_tex),
+	MapSector* ns = pool_sectors_.create(theResourceManager->getTextureName(s.f_tex),
 								  theResourceManager->getTextureName(s.c_tex), this);
 
 	// Setup sector properties
@@ -650,7 +784,7 @@ bool SLADEMap::addSector(doom64sector_t& s)
 bool SLADEMap::addThing(doomthing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = pool_things_.create(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -667,7 +801,7 @@ bool SLADEMap::addThing(doomthing_t& t)
 bool SLADEMap::addThing(doom64thing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = pool_things_.create(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -680,6 +814,39 @@ bool SLADEMap::addThing(doom64thing_t& t)
 	return true;
 }
 
+/* SLADEMap::reserveLines
+ * Allocates space for [count] lines from [line_data], along with
+ * any extra sides that will be created for lines sharing a side
+ * (see addLine)
+ *******************************************************************/
+template<class L> void SLADEMap::reserveLines(L* line_data, unsigned count)
+{
+	// Count references to sides that are already used by another line
+	vector<bool> side_used(sides_.size());
+	unsigned n_dup = 0;
+	for (unsigned a = 0; a < count; a++)
+	{
+		unsigned short side1 = line_data[a].side1;
+		unsigned short side2 = line_data[a].side2;
+
+		if (side1 != 65535 && side1 < side_used.size())
+		{
+			if (side_used[side1]) n_dup++;
+			side_used[side1] = true;
+		}
+		if (side2 != 65535 && side2 < side_used.size())
+		{
+			if (side_used[side2]) n_dup++;
+			side_used[side2] = true;
+		}
+	}
+
+	pool_lines_.reserve(count);
+	lines_.reserve(lines_.size() + count);
+	pool_sides_.reserve(n_dup);
+	sides_.reserve(sides_.size() + n_dup);
+}
+
 /* SLADEMap::readDoomVertexes
  * Reads in doom format vertex definitions from [entry]
  *******************************************************************/
@@ -699,16 +866,22 @@ bool SLADEMap::readDoomVertexes(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	doomvertex_t* vert_data = (doomvertex_t*)entry->getData(true);
 	unsigned nv = entry->getSize() / sizeof(doomvertex_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < nv; a++)
+
+	// Allocate all vertices up front
+	pool_vertices_.reserve(nv);
+	vertices_.reserve(vertices_.size() + nv);
+
+	LumpProgress progress(nv);
+	for (unsigned a = 0; a < nv; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nv) * 0.2f);
+		progress.update(a);
 		addVertex(vert_data[a]);
 	}
 
-	LOG_MESSAGE(3, "Read %lu vertices", vertices_.size());
+	LOG_MESSAGE(2, "Read %d vertices in %ldms", (int)vertices_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -732,16 +905,38 @@ bool SLADEMap::readDoomSidedefs(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	doomside_t* side_data = (doomside_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomside_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
+
+	// Allocate all sides up front
+	pool_sides_.reserve(ns);
+	sides_.reserve(sides_.size() + ns);
+
+	TexNameCache textures;
+	LumpProgress progress(ns);
+	for (unsigned a = 0; a < ns; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		addSide(side_data[a]);
+		progress.update(a);
+		doomside_t& s = side_data[a];
+
+		// Create side
+		MapSide* side = pool_sides_.create(getSector(s.sector), this);
+
+		// Setup side properties
+		side->tex_upper = textures.get(s.tex_upper);
+		side->tex_lower = textures.get(s.tex_lower);
+		side->tex_middle = textures.get(s.tex_middle);
+		side->offset_x = s.x_offset;
+		side->offset_y = s.y_offset;
+
+		sides_.push_back(side);
 	}
 
-	LOG_MESSAGE(3, "Read %lu sides", sides_.size());
+	// Update texture counts
+	textures.addUsage(usage_tex_);
+
+	LOG_MESSAGE(2, "Read %d sides in %ldms", (int)sides_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -765,17 +960,22 @@ bool SLADEMap::readDoomLinedefs(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	doomline_t* line_data = (doomline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(doomline_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < nl; a++)
+
+	// Allocate all lines (and any sides they duplicate) up front
+	reserveLines(line_data, nl);
+
+	LumpProgress progress(nl);
+	for (unsigned a = 0; a < nl; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nl) * 0.2f);
+		progress.update(a);
 		if (!addLine(line_data[a]))
-			LOG_MESSAGE(2, "Line %lu invalid, not added", a);
+			LOG_MESSAGE(2, "Line %d invalid, not added", a);
 	}
 
-	LOG_MESSAGE(3, "Read %lu lines", lines_.size());
+	LOG_MESSAGE(2, "Read %d lines in %ldms", (int)lines_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -799,16 +999,38 @@ bool SLADEMap::readDoomSectors(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	doomsector_t* sect_data = (doomsector_t*)entry->getData(true);
 	unsigned ns = entry->getSize() / sizeof(doomsector_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < ns; a++)
+
+	// Allocate all sectors up front
+	pool_sectors_.reserve(ns);
+	sectors_.reserve(sectors_.size() + ns);
+
+	TexNameCache flats;
+	LumpProgress progress(ns);
+	for (unsigned a = 0; a < ns; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / ns) * 0.2f);
-		addSector(sect_data[a]);
+		progress.update(a);
+		doomsector_t& s = sect_data[a];
+
+		// Create sector
+		MapSector* sector = pool_sectors_.create(flats.get(s.f_tex), flats.get(s.c_tex), this);
+
+		// Setup sector properties
+		sector->setFloorHeight(s.f_height);
+		sector->setCeilingHeight(s.c_height);
+		sector->light = s.light;
+		sector->special = s.special;
+		sector->tag = s.tag;
+
+		sectors_.push_back(sector);
 	}
 
-	LOG_MESSAGE(3, "Read %lu sectors", sectors_.size());
+	// Update texture counts
+	flats.addUsage(usage_flat_);
+
+	LOG_MESSAGE(2, "Read %d sectors in %ldms", (int)sectors_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -832,16 +1054,22 @@ bool SLADEMap::readDoomThings(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	doomthing_t* thng_data = (doomthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(doomthing_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < nt; a++)
+
+	// Allocate all things up front
+	pool_things_.reserve(nt);
+	things_.reserve(things_.size() + nt);
+
+	LumpProgress progress(nt);
+	for (unsigned a = 0; a < nt; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nt) * 0.2f);
+		progress.update(a);
 		addThing(thng_data[a]);
 	}
 
-	LOG_MESSAGE(3, "Read %lu things", things_.size());
+	LOG_MESSAGE(2, "Read %d things in %ldms", (int)things_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -958,7 +1186,7 @@ bool SLADEMap::addLine(hexenline_t& l)
 	if (s1 && s1->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s1->sector, this);
+		MapSide* ns = pool_sides_.create(s1->sector, this);
 		ns->copy(s1);
 		s1 = ns;
 		sides_.push_back(s1);
@@ -968,14 +1196,14 @@ bool SLADEMap::addLine(hexenline_t& l)
 	if (s2 && s2->parent)
 	{
 		// Duplicate side
-		MapSide* ns = new MapSide(s2->sector, this);
+		MapSide* ns = pool_sides_.create(s2->sector, this);
 		ns->copy(s2);
 		s2 = ns;
 		sides_.push_back(s2);
 	}
 
 	// Create line
-	MapLine* nl = new MapLine(v1, v2, s1, s2, this);
+	MapLine* nl = pool_lines_.create(v1, v2, s1, s2, this);
 
 	// Setup line properties
 	nl->properties["arg0"] = l.args[0];
@@ -1012,7 +1240,7 @@ bool SLADEMap::addLine(hexenline_t& l)
 bool SLADEMap::addThing(hexenthing_t& t)
 {
 	// Create thing
-	MapThing* nt = new MapThing(t.x, t.y, t.type, this);
+	MapThing* nt = pool_things_.create(t.x, t.y, t.type, this);
 
 	// Setup thing properties
 	nt->angle = t.angle;
@@ -1049,16 +1277,21 @@ bool SLADEMap::readHexenLinedefs(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	hexenline_t* line_data = (hexenline_t*)entry->getData(true);
 	unsigned nl = entry->getSize() / sizeof(hexenline_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < nl; a++)
+
+	// Allocate all lines (and any sides they duplicate) up front
+	reserveLines(line_data, nl);
+
+	LumpProgress progress(nl);
+	for (unsigned a = 0; a < nl; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nl) * 0.2f);
+		progress.update(a);
 		addLine(line_data[a]);
 	}
 
-	LOG_MESSAGE(3, "Read %lu lines", lines_.size());
+	LOG_MESSAGE(2, "Read %d lines in %ldms", (int)lines_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -1081,16 +1314,22 @@ bool SLADEMap::readHexenThings(ArchiveEntry* entry)
 		return true;
 	}
 
+	long start = App::runTimer();
 	hexenthing_t* thng_data = (hexenthing_t*)entry->getData(true);
 	unsigned nt = entry->getSize() / sizeof(hexenthing_t);
-	float p = UI::getSplashProgress();
-	for (size_t a = 0; a < nt; a++)
+
+	// Allocate all things up front
+	pool_things_.reserve(nt);
+	things_.reserve(things_.size() + nt);
+
+	LumpProgress progress(nt);
+	for (unsigned a = 0; a < nt; a++)
 	{
-		UI::setSplashProgress(p + ((float)a / nt) * 0.2f);
+		progress.update(a);
 		addThing(thng_data[a]);
 	}
 
-	LOG_MESSAGE(3, "Read %lu things", things_.size());
+	LOG_MESSAGE(2, "Read %d things in %ldms", (int)things_.size(), App::runTimer() - start);
 
 	return true;
 }
@@ -1421,7 +1660,7 @@ bool SLADEMap::addVertex(ParseTreeNode* def)
 		return false;
 
 	// Create new vertex
-	MapVertex* nv = new MapVertex(prop_x->floatValue(), prop_y->floatValue(), this);
+	MapVertex* nv = pool_vertices_.create(prop_x->floatValue(), prop_y->floatValue(), this);
 
 	// Add extra vertex info
 	ParseTreeNode* prop = nullptr;
@@ -1458,7 +1697,7 @@ bool SLADEMap::addSide(ParseTreeNode* def)
 		return false;
 
 	// Create new side
-	MapSide* ns = new MapSide(sectors_[sector], this);
+	MapSide* ns = pool_sides_.create(sectors_[sector], this);
 
 	// Set defaults
 	ns->offset_x = 0;
@@ -1532,7 +1771,7 @@ bool SLADEMap::addLine(ParseTreeNode* def)
 	if (prop_s2) side2 = getSide(prop_s2->intValue());
 
 	// Create new line
-	MapLine* nl = new MapLine(vertices_[v1], vertices_[v2], sides_[s1], side2, this);
+	MapLine* nl = pool_lines_.create(vertices_[v1], vertices_[v2], sides_[s1], side2, this);
 
 	// Set defaults
 	nl->special = 0;
@@ -1574,7 +1813,7 @@ bool SLADEMap::addSector(ParseTreeNode* def)
 		return false;
 
 	// Create new sector
-	MapSector* ns = new MapSector(prop_ftex->stringValue(), prop_ctex->stringValue(), this);
+	MapSector* ns = pool_sectors_.create(prop_ftex->stringValue(), prop_ctex->stringValue(), this);
 	usage_flat_[ns->f_tex.Upper()] += 1;
 	usage_flat_[ns->c_tex.Upper()] += 1;
 
@@ -1628,7 +1867,7 @@ bool SLADEMap::addThing(ParseTreeNode* def)
 		return false;
 
 	// Create new thing
-	MapThing* nt = new MapThing(prop_x->floatValue(), prop_y->floatValue(), prop_type->intValue(), this);
+	MapThing* nt = pool_things_.create(prop_x->floatValue(), prop_y->floatValue(), prop_type->intValue(), this);
 
 	// Add extra thing info
 	ParseTreeNode* prop = nullptr;
@@ -1788,52 +2027,43 @@ bool SLADEMap::readUDMFMap(Archive::MapDesc map)
 }
 
 /* SLADEMap::writeDoomVertexes
- * Writes doom format vertex definitions to [entry]
+ * Writes doom format vertex definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoomVertexes(ArchiveEntry* entry)
+bool SLADEMap::writeDoomVertexes(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(vertices_.size() * 4, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (vertices_.empty())
+		return true;
+	data.reSize(vertices_.size() * sizeof(doomvertex_t), false);
+	doomvertex_t* vert_data = (doomvertex_t*)&data[0];
 
 	// Write vertex data
-	short x, y;
 	for (unsigned a = 0; a < vertices_.size(); a++)
 	{
-		x = vertices_[a]->xPos();
-		y = vertices_[a]->yPos();
-		entry->write(&x, 2);
-		entry->write(&y, 2);
+		vert_data[a].x = vertices_[a]->xPos();
+		vert_data[a].y = vertices_[a]->yPos();
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoomSidedefs
- * Writes doom format sidedef definitions to [entry]
+ * Writes doom format sidedef definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoomSidedefs(ArchiveEntry* entry)
+bool SLADEMap::writeDoomSidedefs(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sides_.size() * 30, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (sides_.empty())
+		return true;
+	data.reSize(sides_.size() * sizeof(doomside_t), false);
+	data.fillData(0);
+	doomside_t* side_data = (doomside_t*)&data[0];
 
 	// Write side data
-	doomside_t side;
 	string t_m, t_u, t_l;
 	for (unsigned a = 0; a < sides_.size(); a++)
 	{
-		memset(&side, 0, 30);
+		doomside_t& side = side_data[a];
 
 		// Offsets
 		side.x_offset = sides_[a]->offset_x;
@@ -1847,34 +2077,30 @@ bool SLADEMap::writeDoomSidedefs(ArchiveEntry* entry)
 		t_m = sides_[a]->tex_middle;
 		t_u = sides_[a]->tex_upper;
 		t_l = sides_[a]->tex_lower;
-		memcpy(side.tex_middle, CHR(t_m), t_m.Length());
-		memcpy(side.tex_upper, CHR(t_u), t_u.Length());
-		memcpy(side.tex_lower, CHR(t_l), t_l.Length());
-
-		entry->write(&side, 30);
+		memcpy(side.tex_middle, CHR(t_m), std::min<size_t>(t_m.Length(), 8));
+		memcpy(side.tex_upper, CHR(t_u), std::min<size_t>(t_u.Length(), 8));
+		memcpy(side.tex_lower, CHR(t_l), std::min<size_t>(t_l.Length(), 8));
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoomLinedefs
- * Writes doom format linedef definitions to [entry]
+ * Writes doom format linedef definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoomLinedefs(ArchiveEntry* entry)
+bool SLADEMap::writeDoomLinedefs(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(lines_.size() * 14, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (lines_.empty())
+		return true;
+	data.reSize(lines_.size() * sizeof(doomline_t), false);
+	doomline_t* line_data = (doomline_t*)&data[0];
 
 	// Write line data
-	doomline_t line;
 	for (unsigned a = 0; a < lines_.size(); a++)
 	{
+		doomline_t& line = line_data[a];
+
 		// Vertices
 		line.vertex1 = lines_[a]->v1Index();
 		line.vertex2 = lines_[a]->v2Index();
@@ -1889,70 +2115,61 @@ bool SLADEMap::writeDoomLinedefs(ArchiveEntry* entry)
 		line.side2 = -1;
 		if (lines_[a]->side1) line.side1 = lines_[a]->side1->getIndex();
 		if (lines_[a]->side2) line.side2 = lines_[a]->side2->getIndex();
-
-		entry->write(&line, 14);
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoomSectors
- * Writes doom format sector definitions to [entry]
+ * Writes doom format sector definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoomSectors(ArchiveEntry* entry)
+bool SLADEMap::writeDoomSectors(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sectors_.size() * 26, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (sectors_.empty())
+		return true;
+	data.reSize(sectors_.size() * sizeof(doomsector_t), false);
+	data.fillData(0);
+	doomsector_t* sect_data = (doomsector_t*)&data[0];
 
 	// Write sector data
-	doomsector_t sector;
 	for (unsigned a = 0; a < sectors_.size(); a++)
 	{
-		memset(&sector, 0, 26);
+		doomsector_t& sector = sect_data[a];
 
 		// Height
 		sector.f_height = sectors_[a]->f_height;
 		sector.c_height = sectors_[a]->c_height;
 
 		// Textures
-		memcpy(sector.f_tex, CHR(sectors_[a]->f_tex), sectors_[a]->f_tex.Length());
-		memcpy(sector.c_tex, CHR(sectors_[a]->c_tex), sectors_[a]->c_tex.Length());
+		memcpy(sector.f_tex, CHR(sectors_[a]->f_tex), std::min<size_t>(sectors_[a]->f_tex.Length(), 8));
+		memcpy(sector.c_tex, CHR(sectors_[a]->c_tex), std::min<size_t>(sectors_[a]->c_tex.Length(), 8));
 
 		// Properties
 		sector.light = sectors_[a]->light;
 		sector.special = sectors_[a]->special;
 		sector.tag = sectors_[a]->tag;
-
-		entry->write(&sector, 26);
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoomThings
- * Writes doom format thing definitions to [entry]
+ * Writes doom format thing definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoomThings(ArchiveEntry* entry)
+bool SLADEMap::writeDoomThings(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(things_.size() * 10, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (things_.empty())
+		return true;
+	data.reSize(things_.size() * sizeof(doomthing_t), false);
+	doomthing_t* thng_data = (doomthing_t*)&data[0];
 
 	// Write thing data
-	doomthing_t thing;
 	for (unsigned a = 0; a < things_.size(); a++)
 	{
+		doomthing_t& thing = thng_data[a];
+
 		// Position
 		thing.x = things_[a]->xPos();
 		thing.y = things_[a]->yPos();
@@ -1961,8 +2178,6 @@ bool SLADEMap::writeDoomThings(ArchiveEntry* entry)
 		thing.angle = things_[a]->getAngle();
 		thing.type = things_[a]->type;
 		thing.flags = things_[a]->intProperty("flags");
-
-		entry->write(&thing, 10);
 	}
 
 	return true;
@@ -1973,55 +2188,33 @@ bool SLADEMap::writeDoomThings(ArchiveEntry* entry)
  *******************************************************************/
 bool SLADEMap::writeDoomMap(vector<ArchiveEntry*>& map_entries)
 {
-	// Init entry list
-	map_entries.clear();
-
-	// Write THINGS
-	ArchiveEntry* entry = new ArchiveEntry("THINGS");
-	writeDoomThings(entry);
-	map_entries.push_back(entry);
-
-	// Write LINEDEFS
-	entry = new ArchiveEntry("LINEDEFS");
-	writeDoomLinedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write SIDEDEFS
-	entry = new ArchiveEntry("SIDEDEFS");
-	writeDoomSidedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write VERTEXES
-	entry = new ArchiveEntry("VERTEXES");
-	writeDoomVertexes(entry);
-	map_entries.push_back(entry);
-
-	// Write SECTORS
-	entry = new ArchiveEntry("SECTORS");
-	writeDoomSectors(entry);
-	map_entries.push_back(entry);
+	refreshIndices();
 
-	return true;
+	return writeMapLumps(map_entries, {
+		{ "THINGS", [this](MemChunk& data) { return writeDoomThings(data); } },
+		{ "LINEDEFS", [this](MemChunk& data) { return writeDoomLinedefs(data); } },
+		{ "SIDEDEFS", [this](MemChunk& data) { return writeDoomSidedefs(data); } },
+		{ "VERTEXES", [this](MemChunk& data) { return writeDoomVertexes(data); } },
+		{ "SECTORS", [this](MemChunk& data) { return writeDoomSectors(data); } }
+	});
 }
 
 /* SLADEMap::writeHexenLinedefs
- * Writes hexen format linedef definitions to [entry]
+ * Writes hexen format linedef definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeHexenLinedefs(ArchiveEntry* entry)
+bool SLADEMap::writeHexenLinedefs(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(lines_.size() * 16, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (lines_.empty())
+		return true;
+	data.reSize(lines_.size() * sizeof(hexenline_t), false);
+	hexenline_t* line_data = (hexenline_t*)&data[0];
 
 	// Write line data
-	hexenline_t line;
 	for (unsigned a = 0; a < lines_.size(); a++)
 	{
+		hexenline_t& line = line_data[a];
+
 		// Vertices
 		line.vertex1 = lines_[a]->v1Index();
 		line.vertex2 = lines_[a]->v2Index();
@@ -2039,31 +2232,27 @@ bool SLADEMap::writeHexenLinedefs(ArchiveEntry* entry)
 		line.side2 = -1;
 		if (lines_[a]->side1) line.side1 = lines_[a]->side1->getIndex();
 		if (lines_[a]->side2) line.side2 = lines_[a]->side2->getIndex();
-
-		entry->write(&line, 16);
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeHexenThings
- * Writes hexen format thing definitions to [entry]
+ * Writes hexen format thing definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeHexenThings(ArchiveEntry* entry)
+bool SLADEMap::writeHexenThings(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(things_.size() * 20, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (things_.empty())
+		return true;
+	data.reSize(things_.size() * sizeof(hexenthing_t), false);
+	hexenthing_t* thng_data = (hexenthing_t*)&data[0];
 
 	// Write thing data
-	hexenthing_t thing;
 	for (unsigned a = 0; a < things_.size(); a++)
 	{
+		hexenthing_t& thing = thng_data[a];
+
 		// Position
 		thing.x = things_[a]->xPos();
 		thing.y = things_[a]->yPos();
@@ -2079,8 +2268,6 @@ bool SLADEMap::writeHexenThings(ArchiveEntry* entry)
 		// Args
 		for (unsigned arg = 0; arg < 5; arg++)
 			thing.args[arg] = things_[a]->intProperty(S_FMT("arg%u", arg));
-
-		entry->write(&thing, 20);
 	}
 
 	return true;
@@ -2091,83 +2278,55 @@ bool SLADEMap::writeHexenThings(ArchiveEntry* entry)
  *******************************************************************/
 bool SLADEMap::writeHexenMap(vector<ArchiveEntry*>& map_entries)
 {
-	// Init entry list
-	map_entries.clear();
-
-	// Write THINGS
-	ArchiveEntry* entry = new ArchiveEntry("THINGS");
-	writeHexenThings(entry);
-	map_entries.push_back(entry);
-
-	// Write LINEDEFS
-	entry = new ArchiveEntry("LINEDEFS");
-	writeHexenLinedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write SIDEDEFS
-	entry = new ArchiveEntry("SIDEDEFS");
-	writeDoomSidedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write VERTEXES
-	entry = new ArchiveEntry("VERTEXES");
-	writeDoomVertexes(entry);
-	map_entries.push_back(entry);
-
-	// Write SECTORS
-	entry = new ArchiveEntry("SECTORS");
-	writeDoomSectors(entry);
-	map_entries.push_back(entry);
+	refreshIndices();
 
-	return true;
+	return writeMapLumps(map_entries, {
+		{ "THINGS", [this](MemChunk& data) { return writeHexenThings(data); } },
+		{ "LINEDEFS", [this](MemChunk& data) { return writeHexenLinedefs(data); } },
+		{ "SIDEDEFS", [this](MemChunk& data) { return writeDoomSidedefs(data); } },
+		{ "VERTEXES", [this](MemChunk& data) { return writeDoomVertexes(data); } },
+		{ "SECTORS", [this](MemChunk& data) { return writeDoomSectors(data); } }
+	});
 }
 
 /* SLADEMap::writeDoom64Vertexes
- * Writes doom64 format vertex definitions to [entry]
+ * Writes doom64 format vertex definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoom64Vertexes(ArchiveEntry* entry)
+bool SLADEMap::writeDoom64Vertexes(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(vertices_.size() * 8, false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (vertices_.empty())
+		return true;
+	data.reSize(vertices_.size() * sizeof(doom64vertex_t), false);
+	doom64vertex_t* vert_data = (doom64vertex_t*)&data[0];
 
 	// Write vertex data
-	int32_t x, y;	// Those are actually fixed_t, so shift by FRACBIT (16)
 	for (unsigned a = 0; a < vertices_.size(); a++)
 	{
-		x = vertices_[a]->xPos()*65536;
-		y = vertices_[a]->yPos()*65536;
-		entry->write(&x, 4);
-		entry->write(&y, 4);
+		// Those are actually fixed_t, so shift by FRACBIT (16)
+		vert_data[a].x = vertices_[a]->xPos()*65536;
+		vert_data[a].y = vertices_[a]->yPos()*65536;
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoom64Sidedefs
- * Writes doom64 format sidedef definitions to [entry]
+ * Writes doom64 format sidedef definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoom64Sidedefs(ArchiveEntry* entry)
+bool SLADEMap::writeDoom64Sidedefs(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sides_.size() * sizeof(doom64side_t), false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (sides_.empty())
+		return true;
+	data.reSize(sides_.size() * sizeof(doom64side_t), false);
+	data.fillData(0);
+	doom64side_t* side_data = (doom64side_t*)&data[0];
 
 	// Write side data
-	doom64side_t side;
 	for (unsigned a = 0; a < sides_.size(); a++)
 	{
-		memset(&side, 0, sizeof(doom64side_t));
+		doom64side_t& side = side_data[a];
 
 		// Offsets
 		side.x_offset = sides_[a]->offset_x;
@@ -2181,31 +2340,27 @@ bool SLADEMap::writeDoom64Sidedefs(ArchiveEntry* entry)
 		side.tex_middle	= theResourceManager->getTextureHash(sides_[a]->tex_middle);
 		side.tex_upper	= theResourceManager->getTextureHash(sides_[a]->tex_upper);
 		side.tex_lower	= theResourceManager->getTextureHash(sides_[a]->tex_lower);
-
-		entry->write(&side, sizeof(doom64side_t));
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoom64Linedefs
- * Writes doom64 format linedef definitions to [entry]
+ * Writes doom64 format linedef definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoom64Linedefs(ArchiveEntry* entry)
+bool SLADEMap::writeDoom64Linedefs(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(lines_.size() * sizeof(doom64line_t), false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (lines_.empty())
+		return true;
+	data.reSize(lines_.size() * sizeof(doom64line_t), false);
+	doom64line_t* line_data = (doom64line_t*)&data[0];
 
 	// Write line data
-	doom64line_t line;
 	for (unsigned a = 0; a < lines_.size(); a++)
 	{
+		doom64line_t& line = line_data[a];
+
 		// Vertices
 		line.vertex1 = lines_[a]->v1Index();
 		line.vertex2 = lines_[a]->v2Index();
@@ -2220,32 +2375,27 @@ bool SLADEMap::writeDoom64Linedefs(ArchiveEntry* entry)
 		line.side2 = -1;
 		if (lines_[a]->side1) line.side1 = lines_[a]->side1->getIndex();
 		if (lines_[a]->side2) line.side2 = lines_[a]->side2->getIndex();
-
-		entry->write(&line, sizeof(doom64line_t));
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoom64Sectors
- * Writes doom64 format sector definitions to [entry]
+ * Writes doom64 format sector definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoom64Sectors(ArchiveEntry* entry)
+bool SLADEMap::writeDoom64Sectors(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(sectors_.size() * sizeof(doom64sector_t), false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (sectors_.empty())
+		return true;
+	data.reSize(sectors_.size() * sizeof(doom64sector_t), false);
+	data.fillData(0);
+	doom64sector_t* sect_data = (doom64sector_t*)&data[0];
 
 	// Write sector data
-	doom64sector_t sector;
 	for (unsigned a = 0; a < sectors_.size(); a++)
 	{
-		memset(&sector, 0, sizeof(doom64sector_t));
+		doom64sector_t& sector = sect_data[a];
 
 		// Height
 		sector.f_height = sectors_[a]->f_height;
@@ -2266,31 +2416,27 @@ bool SLADEMap::writeDoom64Sectors(ArchiveEntry* entry)
 		sector.special = sectors_[a]->special;
 		sector.flags = sectors_[a]->intProperty("flags");
 		sector.tag = sectors_[a]->tag;
-
-		entry->write(&sector, sizeof(doom64sector_t));
 	}
 
 	return true;
 }
 
 /* SLADEMap::writeDoom64Things
- * Writes doom64 format thing definitions to [entry]
+ * Writes doom64 format thing definitions to [data]
  *******************************************************************/
-bool SLADEMap::writeDoom64Things(ArchiveEntry* entry)
+bool SLADEMap::writeDoom64Things(MemChunk& data)
 {
-	// Check entry was given
-	if (!entry)
-		return false;
-
-	// Init entry data
-	entry->clearData();
-	entry->resize(things_.size() * sizeof(doom64thing_t), false);
-	entry->seek(0, 0);
+	// Init lump data
+	if (things_.empty())
+		return true;
+	data.reSize(things_.size() * sizeof(doom64thing_t), false);
+	doom64thing_t* thng_data = (doom64thing_t*)&data[0];
 
 	// Write thing data
-	doom64thing_t thing;
 	for (unsigned a = 0; a < things_.size(); a++)
 	{
+		doom64thing_t& thing = thng_data[a];
+
 		// Position
 		thing.x = things_[a]->xPos();
 		thing.y = things_[a]->yPos();
@@ -2301,8 +2447,6 @@ bool SLADEMap::writeDoom64Things(ArchiveEntry* entry)
 		thing.type = things_[a]->type;
 		thing.flags = things_[a]->intProperty("flags");
 		thing.tid = things_[a]->intProperty("id");
-
-		entry->write(&thing, sizeof(doom64thing_t));
 	}
 
 	return true;
@@ -2313,37 +2457,16 @@ bool SLADEMap::writeDoom64Things(ArchiveEntry* entry)
  *******************************************************************/
 bool SLADEMap::writeDoom64Map(vector<ArchiveEntry*>& map_entries)
 {
-	// Init entry list
-	map_entries.clear();
-
-	// Write THINGS
-	ArchiveEntry* entry = new ArchiveEntry("THINGS");
-	writeDoom64Things(entry);
-	map_entries.push_back(entry);
-
-	// Write LINEDEFS
-	entry = new ArchiveEntry("LINEDEFS");
-	writeDoom64Linedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write SIDEDEFS
-	entry = new ArchiveEntry("SIDEDEFS");
-	writeDoom64Sidedefs(entry);
-	map_entries.push_back(entry);
-
-	// Write VERTEXES
-	entry = new ArchiveEntry("VERTEXES");
-	writeDoom64Vertexes(entry);
-	map_entries.push_back(entry);
-
-	// Write SECTORS
-	entry = new ArchiveEntry("SECTORS");
-	writeDoom64Sectors(entry);
-	map_entries.push_back(entry);
+	refreshIndices();
 
 	// TODO: Write LIGHTS and MACROS
-
-	return true;
+	return writeMapLumps(map_entries, {
+		{ "THINGS", [this](MemChunk& data) { return writeDoom64Things(data); } },
+		{ "LINEDEFS", [this](MemChunk& data) { return writeDoom64Linedefs(data); } },
+		{ "SIDEDEFS", [this](MemChunk& data) { return writeDoom64Sidedefs(data); } },
+		{ "VERTEXES", [this](MemChunk& data) { return writeDoom64Vertexes(data); } },
+		{ "SECTORS", [this](MemChunk& data) { return writeDoom64Sectors(data); } }
+	});
 }
 
 /* SLADEMap::writeUDMFMap
@@ -2528,12 +2651,13 @@ void SLADEMap::clearMap()
 	things_.clear();
 
 	// Clear map objects
-	for (unsigned a = 0; a < all_objects_.size(); a++)
-	{
-		if (all_objects_[a].mobj)
-			delete all_objects_[a].mobj;
-	}
 	all_objects_.clear();
+	mod_journal_.clear();
+	pool_vertices_.clear();
+	pool_lines_.clear();
+	pool_sides_.clear();
+	pool_sectors_.clear();
+	pool_things_.clear();
 
 	// Object id 0 is always null
 	all_objects_.push_back(mobj_holder_t(nullptr, false));
@@ -3157,30 +3281,33 @@ MapVertex* SLADEMap::lineCrossVertex(double x1, double y1, double x2, double y2)
  *******************************************************************/
 void SLADEMap::updateGeometryInfo(long modified_time)
 {
-	for (unsigned a = 0; a < vertices_.size(); a++)
+	// Go through vertices modified since [modified_time]
+	for (unsigned a = journalStart(modified_time + 1); a < mod_journal_.size(); a++)
 	{
-		if (vertices_[a]->modifiedTime() > modified_time)
+		mobj_holder_t& holder = all_objects_[mod_journal_[a].id];
+		if (!holder.in_map || holder.mobj->type != MOBJ_VERTEX || holder.mobj->modified_time != mod_journal_[a].time)
+			continue;
+
+		MapVertex* vertex = (MapVertex*)holder.mobj;
+		for (unsigned l = 0; l < vertex->connected_lines.size(); l++)
 		{
-			for (unsigned l = 0; l < vertices_[a]->connected_lines.size(); l++)
-			{
-				MapLine* line = vertices_[a]->connected_lines[l];
+			MapLine* line = vertex->connected_lines[l];
 
-				// Update line geometry
-				line->resetInternals();
+			// Update line geometry
+			line->resetInternals();
 
-				// Update front sector
-				if (line->frontSector())
-				{
-					line->frontSector()->resetPolygon();
-					line->frontSector()->updateBBox();
-				}
+			// Update front sector
+			if (line->frontSector())
+			{
+				line->frontSector()->resetPolygon();
+				line->frontSector()->updateBBox();
+			}
 
-				// Update back sector
-				if (line->backSector())
-				{
-					line->backSector()->resetPolygon();
-					line->backSector()->updateBBox();
-				}
+			// Update back sector
+			if (line->backSector())
+			{
+				line->backSector()->resetPolygon();
+				line->backSector()->updateBBox();
 			}
 		}
 	}
@@ -3899,55 +4026,26 @@ vector<MapObject*> SLADEMap::getModifiedObjects(long since, int type)
 {
 	vector<MapObject*> modified_objects;
 
-	// Vertices
-	if (type < 0 || type == MOBJ_VERTEX)
+	// Get objects from the modification journal (only the latest entry for
+	// each object has its current modified time)
+	for (unsigned a = journalStart(since); a < mod_journal_.size(); a++)
 	{
-		for (unsigned a = 0; a < vertices_.size(); a++)
-		{
-			if (vertices_[a]->modifiedTime() >= since)
-				modified_objects.push_back(vertices_[a]);
-		}
-	}
-
-	// Sides
-	if (type < 0 || type == MOBJ_SIDE)
-	{
-		for (unsigned a = 0; a < sides_.size(); a++)
-		{
-			if (sides_[a]->modifiedTime() >= since)
-				modified_objects.push_back(sides_[a]);
-		}
-	}
-
-	// Lines
-	if (type < 0 || type == MOBJ_LINE)
-	{
-		for (unsigned a = 0; a < lines_.size(); a++)
-		{
-			if (lines_[a]->modifiedTime() >= since)
-				modified_objects.push_back(lines_[a]);
-		}
-	}
+		mobj_holder_t& holder = all_objects_[mod_journal_[a].id];
+		if (!holder.in_map || holder.mobj->modified_time != mod_journal_[a].time)
+			continue;
 
-	// Sectors
-	if (type < 0 || type == MOBJ_SECTOR)
-	{
-		for (unsigned a = 0; a < sectors_.size(); a++)
-		{
-			if (sectors_[a]->modifiedTime() >= since)
-				modified_objects.push_back(sectors_[a]);
-		}
+		if (type < 0 || holder.mobj->type == type)
+			modified_objects.push_back(holder.mobj);
 	}
 
-	// Things
-	if (type < 0 || type == MOBJ_THING)
+	// Sort by type then index
+	static const int type_order[] = { 0, 0, 2, 1, 3, 4 };	// Indexed by MOBJ_* type
+	std::sort(modified_objects.begin(), modified_objects.end(), [](MapObject* left, MapObject* right)
 	{
-		for (unsigned a = 0; a < things_.size(); a++)
-		{
-			if (things_[a]->modifiedTime() >= since)
-				modified_objects.push_back(things_[a]);
-		}
-	}
+		if (left->type != right->type)
+			return type_order[left->type] < type_order[right->type];
+		return left->index < right->index;
+	});
 
 	return modified_objects;
 }
@@ -3960,12 +4058,19 @@ vector<MapObject*> SLADEMap::getAllModifiedObjects(long since)
 {
 	vector<MapObject*> modified_objects;
 
-	for (unsigned a = 0; a < all_objects_.size(); a++)
+	for (unsigned a = journalStart(since); a < mod_journal_.size(); a++)
 	{
-		if (all_objects_[a].mobj && all_objects_[a].mobj->modifiedTime() >= since)
-			modified_objects.push_back(all_objects_[a].mobj);
+		MapObject* object = all_objects_[mod_journal_[a].id].mobj;
+		if (object && object->modified_time == mod_journal_[a].time)
+			modified_objects.push_back(object);
 	}
 
+	// Sort by id
+	std::sort(modified_objects.begin(), modified_objects.end(), [](MapObject* left, MapObject* right)
+	{
+		return left->id < right->id;
+	});
+
 	return modified_objects;
 }
 
@@ -3974,15 +4079,10 @@ vector<MapObject*> SLADEMap::getAllModifiedObjects(long since)
  *******************************************************************/
 long SLADEMap::getLastModifiedTime()
 {
-	long mod_time = 0;
-
-	for (unsigned a = 0; a < all_objects_.size(); a++)
-	{
-		if (all_objects_[a].mobj && all_objects_[a].mobj->modifiedTime() > mod_time)
-			mod_time = all_objects_[a].mobj->modifiedTime();
-	}
+	if (mod_journal_.empty())
+		return 0;
 
-	return mod_time;
+	return mod_journal_.back().time;
 }
 
 /* SLADEMap::isModified
@@ -4015,54 +4115,16 @@ bool SLADEMap::modifiedSince(long since, int type)
 	if (type < 0)
 		return getLastModifiedTime() > since;
 
-	// Vertices
-	else if (type == MOBJ_VERTEX)
-	{
-		for (unsigned a = 0; a < vertices_.size(); a++)
-		{
-			if (vertices_[a]->modified_time > since)
-				return true;
-		}
-	}
-
-	// Lines
-	else if (type == MOBJ_LINE)
+	// Check journal entries after [since], newest first
+	for (unsigned a = mod_journal_.size(); a > 0; a--)
 	{
-		for (unsigned a = 0; a < lines_.size(); a++)
-		{
-			if (lines_[a]->modified_time > since)
-				return true;
-		}
-	}
-
-	// Sides
-	else if (type == MOBJ_SIDE)
-	{
-		for (unsigned a = 0; a < sides_.size(); a++)
-		{
-			if (sides_[a]->modified_time > since)
-				return true;
-		}
-	}
-
-	// Sectors
-	else if (type == MOBJ_SECTOR)
-	{
-		for (unsigned a = 0; a < sectors_.size(); a++)
-		{
-			if (sectors_[a]->modified_time > since)
-				return true;
-		}
-	}
+		mobj_mod_t& entry = mod_journal_[a - 1];
+		if (entry.time <= since)
+			break;
 
-	// Things
-	else if (type == MOBJ_THING)
-	{
-		for (unsigned a = 0; a < things_.size(); a++)
-		{
-			if (things_[a]->modified_time > since)
-				return true;
-		}
+		mobj_holder_t& holder = all_objects_[entry.id];
+		if (holder.in_map && holder.mobj->type == type && holder.mobj->modified_time == entry.time)
+			return true;
 	}
 
 	return false;
@@ -4102,7 +4164,7 @@ MapVertex* SLADEMap::createVertex(double x, double y, double split_dist)
 	}
 
 	// Create the vertex
-	MapVertex* nv = new MapVertex(x, y, this);
+	MapVertex* nv = pool_vertices_.create(x, y, this);
 	nv->index = vertices_.size();
 	vertices_.push_back(nv);
 
@@ -4184,7 +4246,7 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 	}
 
 	// Create new line between vertices
-	MapLine* nl = new MapLine(vertex1, vertex2, nullptr, nullptr, this);
+	MapLine* nl = pool_lines_.create(vertex1, vertex2, nullptr, nullptr, this);
 	nl->index = lines_.size();
 	lines_.push_back(nl);
 
@@ -4204,7 +4266,7 @@ MapLine* SLADEMap::createLine(MapVertex* vertex1, MapVertex* vertex2, bool force
 MapThing* SLADEMap::createThing(double x, double y)
 {
 	// Create the thing
-	MapThing* nt = new MapThing(this);
+	MapThing* nt = pool_things_.create(this);
 
 	// Setup initial values
 	nt->x = x;
@@ -4225,7 +4287,7 @@ MapThing* SLADEMap::createThing(double x, double y)
 MapSector* SLADEMap::createSector()
 {
 	// Create the sector
-	MapSector* ns = new MapSector(this);
+	MapSector* ns = pool_sectors_.create(this);
 
 	// Setup initial values
 	ns->index = sectors_.size();
@@ -4246,7 +4308,7 @@ MapSide* SLADEMap::createSide(MapSector* sector)
 		return nullptr;
 
 	// Create side
-	MapSide* side = new MapSide(sector, this);
+	MapSide* side = pool_sides_.create(sector, this);
 
 	// Setup initial values
 	side->index = sides_.size();
@@ -4394,7 +4456,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	if (l->side1)
 	{
 		// Create side 1
-		s1 = new MapSide(this);
+		s1 = pool_sides_.create(this);
 		s1->copy(l->side1);
 		s1->setSector(l->side1->sector);
 		if (s1->sector)
@@ -4415,7 +4477,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	if (l->side2)
 	{
 		// Create side 2
-		s2 = new MapSide(this);
+		s2 = pool_sides_.create(this);
 		s2->copy(l->side2);
 		s2->setSector(l->side2->sector);
 		if (s2->sector)
@@ -4435,7 +4497,7 @@ MapLine* SLADEMap::splitLine(MapLine* l, MapVertex* v)
 	}
 
 	// Create and add new line
-	MapLine* nl = new MapLine(v, v2, s1, s2, this);
+	MapLine* nl = pool_lines_.create(v, v2, s1, s2, this);
 	nl->copy(l);
 	nl->index = lines_.size();
 	nl->setModified();
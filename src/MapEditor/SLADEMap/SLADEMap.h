@@ -7,6 +7,7 @@
 #include "MapSector.h"
 #include "MapVertex.h"
 #include "MapThing.h"
+#include "MapObjectPool.h"
 #include "Archive/Archive.h"
 #include "Utility/PropertyList/PropertyList.h"
 #include "MapEditor/MapSpecials.h"
@@ -26,6 +27,18 @@ struct mobj_holder_t
 	}
 };
 
+struct mobj_mod_t
+{
+	unsigned	id;
+	long		time;
+
+	mobj_mod_t(unsigned id, long time)
+	{
+		this->id = id;
+		this->time = time;
+	}
+};
+
 struct mobj_cd_t
 {
 	unsigned	id;
@@ -90,6 +103,7 @@ public:
 	// MapObject id stuff (used for undo/redo)
 	void		addMapObject(MapObject* object);
 	void		removeMapObject(MapObject* object);
+	void		objectModified(MapObject* object);
 	MapObject*	getObjectById(unsigned id) { return all_objects_[id].mobj; }
 	void		getObjectIdList(uint8_t type, vector<unsigned>& list);
 	void		restoreObjectIdList(uint8_t type, vector<unsigned>& list);
@@ -236,12 +250,26 @@ private:
 
 	vector<ArchiveEntry*>	udmf_extra_entries_;	// UDMF Extras
 
+	// Object storage (all map objects are created in these)
+	MapObjectPool<MapVertex>	pool_vertices_;
+	MapObjectPool<MapLine>		pool_lines_;
+	MapObjectPool<MapSide>		pool_sides_;
+	MapObjectPool<MapSector>	pool_sectors_;
+	MapObjectPool<MapThing>		pool_things_;
+
 	// For undo/redo
 	vector<mobj_holder_t>	all_objects_;
 	vector<unsigned>		deleted_objects_;
 	vector<unsigned>		created_objects_;
 	vector<mobj_cd_t>		created_deleted_objects_;
 
+	// Modification journal, an entry is added each time an object's modified
+	// time changes (in time order)
+	vector<mobj_mod_t>	mod_journal_;
+
+	unsigned	journalStart(long since);
+	void		compactJournal();
+
 	long	geometry_updated_;	// The last time the map geometry was updated
 	long	things_updated_;	// The last time the thing list was modified
 
@@ -252,9 +280,7 @@ private:
 
 	// Doom format
 	bool	addVertex(doomvertex_t& v);
-	bool	addSide(doomside_t& s);
 	bool	addLine(doomline_t& l);
-	bool	addSector(doomsector_t& s);
 	bool	addThing(doomthing_t& t);
 
 	bool	readDoomVertexes(ArchiveEntry* entry);
@@ -263,11 +289,13 @@ private:
 	bool	readDoomSectors(ArchiveEntry* entry);
 	bool	readDoomThings(ArchiveEntry* entry);
 
-	bool	writeDoomVertexes(ArchiveEntry* entry);
-	bool	writeDoomSidedefs(ArchiveEntry* entry);
-	bool	writeDoomLinedefs(ArchiveEntry* entry);
-	bool	writeDoomSectors(ArchiveEntry* entry);
-	bool	writeDoomThings(ArchiveEntry* entry);
+	template<class L> void reserveLines(L* line_data, unsigned count);
+
+	bool	writeDoomVertexes(MemChunk& data);
+	bool	writeDoomSidedefs(MemChunk& data);
+	bool	writeDoomLinedefs(MemChunk& data);
+	bool	writeDoomSectors(MemChunk& data);
+	bool	writeDoomThings(MemChunk& data);
 
 	// Hexen format
 	bool	addLine(hexenline_t& l);
@@ -276,8 +304,8 @@ private:
 	bool	readHexenLinedefs(ArchiveEntry* entry);
 	bool	readHexenThings(ArchiveEntry* entry);
 
-	bool	writeHexenLinedefs(ArchiveEntry* entry);
-	bool	writeHexenThings(ArchiveEntry* entry);
+	bool	writeHexenLinedefs(MemChunk& data);
+	bool	writeHexenThings(MemChunk& data);
 
 	// Doom 64 format
 	bool	addVertex(doom64vertex_t& v);
@@ -292,11 +320,11 @@ private:
 	bool	readDoom64Sectors(ArchiveEntry* entry);
 	bool	readDoom64Things(ArchiveEntry* entry);
 
-	bool	writeDoom64Vertexes(ArchiveEntry* entry);
-	bool	writeDoom64Sidedefs(ArchiveEntry* entry);
-	bool	writeDoom64Linedefs(ArchiveEntry* entry);
-	bool	writeDoom64Sectors(ArchiveEntry* entry);
-	bool	writeDoom64Things(ArchiveEntry* entry);
+	bool	writeDoom64Vertexes(MemChunk& data);
+	bool	writeDoom64Sidedefs(MemChunk& data);
+	bool	writeDoom64Linedefs(MemChunk& data);
+	bool	writeDoom64Sectors(MemChunk& data);
+	bool	writeDoom64Things(MemChunk& data);
 
 	// UDMF
 	bool	addVertex(ParseTreeNode* def);
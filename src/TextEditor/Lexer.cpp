@@ -33,6 +33,7 @@
 #include "Main.h"
 #include "Lexer.h"
 #include "UI/TextEditorCtrl.h"
+#include "Utility/StringUtils.h"
 
 
 // ----------------------------------------------------------------------------
@@ -43,6 +44,183 @@
 CVAR(Bool, debug_lexer, false, CVAR_SECRET)
 
 
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// ------------------------------------------------------------------------
+	// lowerChar
+	//
+	// Returns [c] in lower case if it is an (ascii) upper case letter
+	// ------------------------------------------------------------------------
+	inline char lowerChar(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+	}
+
+	// ------------------------------------------------------------------------
+	// isNumber
+	//
+	// Returns true if [word] is an integer, hex or float number. If [lower]
+	// is true, 'X' is also accepted for hex numbers
+	// ------------------------------------------------------------------------
+	bool isNumber(const std::string& word, bool lower)
+	{
+		if (StringUtils::isInteger(word.data(), word.size(), false) ||
+			StringUtils::isFloat(word.data(), word.size()))
+			return true;
+
+		if (lower && word.size() > 2 && word[1] == 'X')
+		{
+			auto hex = word;
+			hex[1] = 'x';
+			return StringUtils::isHex(hex.data(), hex.size());
+		}
+
+		return StringUtils::isHex(word.data(), word.size());
+	}
+}
+
+
+// ----------------------------------------------------------------------------
+//
+// Lexer::WordTable Class Functions
+//
+// ----------------------------------------------------------------------------
+
+
+// ----------------------------------------------------------------------------
+// Lexer::WordTable::clear
+//
+// Removes all words from the table
+// ----------------------------------------------------------------------------
+void Lexer::WordTable::clear()
+{
+	slots_.clear();
+	chars_.clear();
+	count_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::WordTable::set
+//
+// Sets the value for [word] to [value], adding it if it doesn't exist
+// ----------------------------------------------------------------------------
+void Lexer::WordTable::set(const std::string& word, char value)
+{
+	if (word.empty())
+		return;
+
+	// Keep the table at most half full
+	if ((count_ + 1) * 2 > slots_.size())
+		rehash(slots_.empty() ? 64 : slots_.size() * 2);
+
+	auto h = hash(word.data(), word.size());
+	auto mask = slots_.size() - 1;
+	for (auto i = h & mask;; i = (i + 1) & mask)
+	{
+		auto& slot = slots_[i];
+
+		// Add new word
+		if (slot.length == 0)
+		{
+			slot.hash = h;
+			slot.offset = chars_.size();
+			slot.length = word.size();
+			slot.value = value;
+			chars_ += word;
+			count_++;
+			return;
+		}
+
+		// Update existing word
+		if (slot.hash == h && slot.length == word.size() &&
+			memcmp(chars_.data() + slot.offset, word.data(), word.size()) == 0)
+		{
+			slot.value = value;
+			return;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::WordTable::get
+//
+// Returns the value for the first [length] characters of [word], or 0 if it
+// isn't in the table. If [lower] is true, [word] is converted to lower case
+// before looking it up
+// ----------------------------------------------------------------------------
+char Lexer::WordTable::get(const char* word, size_t length, bool lower) const
+{
+	if (count_ == 0 || length == 0)
+		return 0;
+
+	auto h = hash(word, length, lower);
+	auto mask = slots_.size() - 1;
+	for (auto i = h & mask; slots_[i].length > 0; i = (i + 1) & mask)
+	{
+		auto& slot = slots_[i];
+		if (slot.hash != h || slot.length != length)
+			continue;
+
+		auto chars = chars_.data() + slot.offset;
+		size_t c = 0;
+		if (lower)
+			while (c < length && chars[c] == lowerChar(word[c])) c++;
+		else
+			while (c < length && chars[c] == word[c]) c++;
+
+		if (c == length)
+			return slot.value;
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::WordTable::hash
+//
+// Returns a (FNV-1a) hash of the first [length] characters of [word]
+// ----------------------------------------------------------------------------
+uint32_t Lexer::WordTable::hash(const char* word, size_t length, bool lower)
+{
+	uint32_t h = 2166136261u;
+	for (size_t a = 0; a < length; a++)
+	{
+		h ^= (uint8_t)(lower ? lowerChar(word[a]) : word[a]);
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+// ----------------------------------------------------------------------------
+// Lexer::WordTable::rehash
+//
+// Resizes the table to [size] slots (must be a power of 2)
+// ----------------------------------------------------------------------------
+void Lexer::WordTable::rehash(size_t size)
+{
+	vector<Slot> old(size);
+	old.swap(slots_);
+
+	auto mask = size - 1;
+	for (auto& slot : old)
+	{
+		if (slot.length == 0)
+			continue;
+
+		auto i = slot.hash & mask;
+		while (slots_[i].length > 0)
+			i = (i + 1) & mask;
+		slots_[i] = slot;
+	}
+}
+
+
 // ----------------------------------------------------------------------------
 //
 // Lexer Class Functions
@@ -56,16 +234,17 @@ CVAR(Bool, debug_lexer, false, CVAR_SECRET)
 // Lexer class constructor
 // ----------------------------------------------------------------------------
 Lexer::Lexer() :
-	whitespace_chars_{ { ' ', '\n', '\r', '\t' } },
 	language_{ nullptr },
-	re_int1_{ "^[+-]?[0-9]+[0-9]*$", wxRE_DEFAULT|wxRE_NOSUB },
-	re_int2_{ "^0[0-9]+$", wxRE_DEFAULT|wxRE_NOSUB },
-	re_int3_{ "^0x[0-9A-Fa-f]+$", wxRE_DEFAULT|wxRE_NOSUB },
-	re_float_{ "^[-+]?[0-9]*.?[0-9]+([eE][-+]?[0-9]+)?$", wxRE_DEFAULT|wxRE_NOSUB },
 	fold_comments_{ false },
 	fold_preprocessor_{ false },
+	preprocessor_char_{ 0 },
 	curr_comment_idx_ { -1 }
 {
+	// Whitespace characters
+	memset(whitespace_chars_, 0, sizeof(whitespace_chars_));
+	for (auto c : { ' ', '\n', '\r', '\t' })
+		whitespace_chars_[(unsigned char) c] = true;
+
 	// Default word characters
 	setWordChars("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
 
@@ -82,6 +261,8 @@ void Lexer::loadLanguage(TextLanguage* language)
 {
 	this->language_ = language;
 	clearWords();
+	fold_words_.clear();
+	pp_fold_words_.clear();
 
 	if (!language)
 		return;
@@ -98,24 +279,40 @@ void Lexer::loadLanguage(TextLanguage* language)
 	for (auto word : language->wordListSorted(TextLanguage::WordType::Keyword))
 		addWord(word, Lexer::Style::Keyword);
 
+	// Load folding words (block begin words take priority if in both lists)
+	for (auto& word : language->wordBlockEnd())
+		fold_words_.set(word.ToStdString(), 2);
+	for (auto& word : language->wordBlockBegin())
+		fold_words_.set(word.ToStdString(), 1);
+	for (auto& word : language->ppBlockEnd())
+		pp_fold_words_.set(word.ToStdString(), 2);
+	for (auto& word : language->ppBlockBegin())
+		pp_fold_words_.set(word.ToStdString(), 1);
+
 	// Load language info
 	preprocessor_char_ = language->preprocessor().empty() ?
 						 (char) 0 : (char) language->preprocessor()[0];
+	preprocessor_ = language->preprocessor().ToStdString();
 }
 
 // ----------------------------------------------------------------------------
 // Lexer::doStyling
 //
 // Performs text styling on [editor], for characters from [start] to [end].
-// Returns true if the next line needs to be styled (eg. for multi-line
-// comments)
+// Returns true if the next line needs to be styled (ie. its starting state
+// changed, eg. a multi-line comment was opened or closed)
 // ----------------------------------------------------------------------------
 bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 {
 	if (start < 0)
 		start = 0;
 
+	// Get the line's text all at once, much quicker than getting each
+	// character from the editor
+	auto text = editor->GetTextRangeRaw(start, std::min(end + 1, editor->GetTextLength()));
+
 	int line = editor->LineFromPosition(start);
+	int next_comment_idx = lineInfo(line + 1).comment_idx;
 	LexerState state
 	{
 		start,
@@ -125,7 +322,10 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 		0,
 		0,
 		false,
-		editor
+		editor,
+		text.data(),
+		start,
+		(int) text.length()
 	};
 
 	if (state.state == State::Comment)
@@ -160,6 +360,7 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 	}
 
 	// Set current & next line's info
+	lineInfo(line + 1);
 	lines_[line].fold_increment = state.fold_increment;
 	lines_[line].has_word = state.has_word;
 	if (state.state == State::Comment)
@@ -178,8 +379,8 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 		lines_[line + 1].comment_idx = -1;
 	}
 
-	// Return true if we are still inside a comment
-	return (state.state == State::Comment);
+	// Return true if the next line's starting state has changed
+	return lines_[line + 1].comment_idx != next_comment_idx;
 }
 
 // ----------------------------------------------------------------------------
@@ -189,7 +390,7 @@ bool Lexer::doStyling(TextEditorCtrl* editor, int start, int end)
 // ----------------------------------------------------------------------------
 void Lexer::addWord(string word, int style)
 {
-	word_list_[language_->caseSensitive() ? word : word.Lower()].style = (char) style;
+	word_list_.set((language_->caseSensitive() ? word : word.Lower()).ToStdString(), (char) style);
 }
 
 // ----------------------------------------------------------------------------
@@ -198,19 +399,19 @@ void Lexer::addWord(string word, int style)
 // Applies a style to [word] in [editor], depending on if it is in the word
 // list, a number or begins with the preprocessor character
 // ----------------------------------------------------------------------------
-void Lexer::styleWord(LexerState& state, string word)
+void Lexer::styleWord(LexerState& state, const std::string& word)
 {
-	if (!language_->caseSensitive())
-		word = word.Lower();
+	bool lower = !language_->caseSensitive();
 
-	if (word_list_[word].style > 0)
-		state.editor->SetStyling(word.length(), word_list_[word].style);
-	else if (word.StartsWith(language_->preprocessor()))
+	char style = word_list_.get(word.data(), word.size(), lower);
+	if (style > 0)
+		state.editor->SetStyling(word.length(), style);
+	else if (word.compare(0, preprocessor_.size(), preprocessor_) == 0)
 		state.editor->SetStyling(word.length(), Style::Preprocessor);
 	else
 	{
 		// Check for number
-		if (re_int2_.Matches(word) || re_int1_.Matches(word) || re_float_.Matches(word) || re_int3_.Matches(word))
+		if (isNumber(word, lower))
 			state.editor->SetStyling(word.length(), Style::Number);
 		else
 			state.editor->SetStyling(word.length(), Style::Default);
@@ -224,9 +425,9 @@ void Lexer::styleWord(LexerState& state, string word)
 // ----------------------------------------------------------------------------
 void Lexer::setWordChars(string chars)
 {
-	word_chars_.clear();
+	memset(word_chars_, 0, sizeof(word_chars_));
 	for (unsigned a = 0; a < chars.length(); a++)
-		word_chars_.push_back((unsigned char) chars[a]);
+		word_chars_[(unsigned char) chars[a]] = true;
 }
 
 // ----------------------------------------------------------------------------
@@ -236,9 +437,9 @@ void Lexer::setWordChars(string chars)
 // ----------------------------------------------------------------------------
 void Lexer::setOperatorChars(string chars)
 {
-	operator_chars_.clear();
+	memset(operator_chars_, 0, sizeof(operator_chars_));
 	for (unsigned a = 0; a < chars.length(); a++)
-		operator_chars_.push_back((unsigned char) chars[a]);
+		operator_chars_[(unsigned char) chars[a]] = true;
 }
 
 // ----------------------------------------------------------------------------
@@ -249,35 +450,29 @@ void Lexer::setOperatorChars(string chars)
 // ----------------------------------------------------------------------------
 bool Lexer::processUnknown(LexerState& state)
 {
+	static const vector<string> no_tokens;
+	static const string no_token;
+
 	int u_length = 0;
 	bool end = false;
 	bool pp = false;
-	vector<string> comment_begin_l;
-	string comment_doc;
-	vector<string> comment_line_l;
-	string block_begin;
-	string block_end;
-
-	if (language_)
-	{
-		comment_begin_l	= language_->commentBeginL();
-		comment_doc 	= language_->docComment();
-		comment_line_l 	= language_->lineCommentL();
-		block_begin 	= language_->blockBegin();
-		block_end 		= language_->blockEnd();
-	}
+	const auto& comment_begin_l	= language_ ? language_->commentBeginL() : no_tokens;
+	const auto& comment_doc		= language_ ? language_->docComment() : no_token;
+	const auto& comment_line_l	= language_ ? language_->lineCommentL() : no_tokens;
+	const auto& block_begin		= language_ ? language_->blockBegin() : no_token;
+	const auto& block_end		= language_ ? language_->blockEnd() : no_token;
 
 	while (true)
 	{
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 		
-		int c = state.editor->GetCharAt(state.position);
+		int c = charAt(state, state.position);
 
 		// Start of string
 		if (c == '"')
@@ -344,7 +539,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Whitespace
-		else if (VECTOR_EXISTS(whitespace_chars_, c))
+		else if (whitespace_chars_[c])
 		{
 			state.state = State::Whitespace;
 			state.position++;
@@ -353,7 +548,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Preprocessor
-		else if (c == (unsigned char) language_->preprocessor()[0])
+		else if (c == (unsigned char) preprocessor_char_)
 		{
 			pp = true;
 			u_length++;
@@ -362,7 +557,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Operator
-		else if (VECTOR_EXISTS(operator_chars_, c))
+		else if (operator_chars_[c])
 		{
 			state.position++;
 			state.state = State::Operator;
@@ -372,7 +567,7 @@ bool Lexer::processUnknown(LexerState& state)
 		}
 
 		// Word
-		else if (VECTOR_EXISTS(word_chars_, c))
+		else if (word_chars_[c])
 		{
 			// Include preprocessor character if it was the previous character
 			if (pp)
@@ -417,10 +612,10 @@ bool Lexer::processUnknown(LexerState& state)
 // ----------------------------------------------------------------------------
 bool Lexer::processComment(LexerState& state)
 {
+	static const string no_token;
+
 	bool end = false;
-	string comment_end = "";
-	if (curr_comment_idx_ >= 0)
-		comment_end = language_->commentEndL()[curr_comment_idx_];
+	const auto& comment_end = curr_comment_idx_ >= 0 ? language_->commentEndL()[curr_comment_idx_] : no_token;
 
 	while (true)
 	{
@@ -463,26 +658,26 @@ bool Lexer::processComment(LexerState& state)
 // ----------------------------------------------------------------------------
 bool Lexer::processWord(LexerState& state)
 {
-	vector<char> word;
+	std::string word;
 	bool end = false;
 
 	// Add first letter
-	word.push_back((char) state.editor->GetCharAt(state.position++));
+	word += (char) charAt(state, state.position++);
 
 	while (true)
 	{
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 
-		char c = (char) state.editor->GetCharAt(state.position);
-		if (VECTOR_EXISTS(word_chars_, c))
+		int c = charAt(state, state.position);
+		if (word_chars_[c])
 		{
-			word.push_back(c);
+			word += (char) c;
 			state.position++;
 		}
 		else
@@ -492,31 +687,21 @@ bool Lexer::processWord(LexerState& state)
 		}
 	}
 
-	// Get word as string
-	string word_string = wxString::FromAscii(&word[0], word.size());
-
 	// Check for preprocessor folding word
-	if (fold_preprocessor_ && word_string.StartsWith(preprocessor_char_))
-	{
-		string word_lower = word_string.Lower().After(preprocessor_char_);
-		if (VECTOR_EXISTS(language_->ppBlockBegin(), word_lower))
-			state.fold_increment++;
-		else if (VECTOR_EXISTS(language_->ppBlockEnd(), word_lower))
-			state.fold_increment--;
-	}
+	char fold;
+	if (fold_preprocessor_ && preprocessor_char_ && word[0] == preprocessor_char_)
+		fold = pp_fold_words_.get(word.data() + 1, word.size() - 1, true);
 	else
-	{
-		string word_lower = word_string.Lower();
-		if (VECTOR_EXISTS(language_->wordBlockBegin(), word_lower))
-			state.fold_increment++;
-		else if (VECTOR_EXISTS(language_->wordBlockEnd(), word_lower))
-			state.fold_increment--;
-	}
+		fold = fold_words_.get(word.data(), word.size(), true);
+	if (fold == 1)
+		state.fold_increment++;
+	else if (fold == 2)
+		state.fold_increment--;
 
 	if (debug_lexer)
-		Log::debug(S_FMT("word: %s", word_string));
+		Log::debug(S_FMT("word: %s", word));
 
-	styleWord(state, word_string);
+	styleWord(state, word);
 
 	return end;
 }
@@ -536,13 +721,13 @@ bool Lexer::processString(LexerState& state)
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 
 		// End of string
-		char c = (char) state.editor->GetCharAt(state.position);
+		int c = charAt(state, state.position);
 		if (c == '"')	
 		{
 			state.length++;
@@ -578,13 +763,13 @@ bool Lexer::processChar(LexerState& state)
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 
 		// End of string
-		char c = (char) state.editor->GetCharAt(state.position);
+		int c = charAt(state, state.position);
 		if (c == '\'')
 		{
 			state.length++;
@@ -620,13 +805,13 @@ bool Lexer::processOperator(LexerState& state)
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 
-		char c = (char) state.editor->GetCharAt(state.position);
-		if (VECTOR_EXISTS(operator_chars_, c))
+		int c = charAt(state, state.position);
+		if (operator_chars_[c])
 		{
 			state.length++;
 			state.position++;
@@ -661,13 +846,13 @@ bool Lexer::processWhitespace(LexerState& state)
 		// Check for end of line
 		if (state.position > state.end)
 		{
-			lines_[state.line + 1].comment_idx = -1;
+			lineInfo(state.line + 1).comment_idx = -1;
 			end = true;
 			break;
 		}
 
-		char c = (char) state.editor->GetCharAt(state.position);
-		if (VECTOR_EXISTS(whitespace_chars_, c))
+		int c = charAt(state, state.position);
+		if (whitespace_chars_[c])
 		{
 			state.length++;
 			state.position++;
@@ -687,19 +872,34 @@ bool Lexer::processWhitespace(LexerState& state)
 	return end;
 }
 
+// ----------------------------------------------------------------------------
+// Lexer::charAt
+//
+// Returns the character at [pos], from the text of the line being styled if
+// possible
+// ----------------------------------------------------------------------------
+int Lexer::charAt(const LexerState& state, int pos) const
+{
+	int index = pos - state.text_start;
+	if (index >= 0 && index < state.text_length)
+		return (unsigned char) state.text[index];
+
+	return state.editor->GetCharAt(pos);
+}
+
 // ----------------------------------------------------------------------------
 // Lexer::checkToken
 //
 // Checks if the text in [editor] starting from [pos] matches [token]
 // ----------------------------------------------------------------------------
-bool Lexer::checkToken(LexerState& state, int pos, string& token)
+bool Lexer::checkToken(const LexerState& state, int pos, const string& token) const
 {
 	if (!token.empty())
 	{
 		unsigned long token_size = token.size();
 		for (unsigned i = 0; i < token_size; i++)
 		{
-			if (state.editor->GetCharAt(pos + i) != (int) token[i])
+			if (charAt(state, pos + i) != (int) token[i])
 				return false;
 		}
 		return true;
@@ -714,16 +914,14 @@ bool Lexer::checkToken(LexerState& state, int pos, string& token)
 // Writes the fitst index that matched to [found_index] if a valid pointer
 // is passed. Returns true if there's a match, false if not.
 // ----------------------------------------------------------------------------
-bool Lexer::checkToken(LexerState &state, int pos, vector<string> &tokens, int *found_idx)
+bool Lexer::checkToken(const LexerState& state, int pos, const vector<string>& tokens, int* found_idx) const
 {
 	if (!tokens.size() == 0)
 	{
 		int idx = 0;
-		string token;
 		while (idx < tokens.size())
 		{
-			token = tokens[idx];
-			if (checkToken(state, pos, token))
+			if (checkToken(state, pos, tokens[idx]))
 			{
 				if (found_idx)
 					*found_idx = idx;
@@ -739,13 +937,18 @@ bool Lexer::checkToken(LexerState &state, int pos, vector<string> &tokens, int *
 // ----------------------------------------------------------------------------
 // Lexer::updateFolding
 //
-// Updates code folding levels in [editor], starting from line [line_start]
+// Updates code folding levels in [editor], starting from line [line_start].
+// If [line_end] is given (the last line that was restyled), stops at the
+// first line after it where the fold level is unchanged, since nothing
+// following it can have changed either
 // ----------------------------------------------------------------------------
-void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
+void Lexer::updateFolding(TextEditorCtrl* editor, int line_start, int line_end)
 {
 	int fold_level = editor->GetFoldLevel(line_start) & wxSTC_FOLDLEVELNUMBERMASK;
 
-	for (int l = line_start; l < editor->GetLineCount(); l++)
+	int line_count = editor->GetLineCount();
+	lineInfo(line_count);
+	for (int l = line_start; l < line_count; l++)
 	{
 		// Determine next line's fold level
 		int next_level = fold_level + lines_[l].fold_increment;
@@ -753,6 +956,7 @@ void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
 			next_level = wxSTC_FOLDLEVELBASE;
 
 		// Check if we are going up a fold level
+		int level = fold_level;
 		if (next_level > fold_level)
 		{
 			if (!lines_[l].has_word)
@@ -761,17 +965,40 @@ void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
 				// move the fold header up a line
 				editor->SetFoldLevel(l - 1, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
 				editor->SetFoldLevel(l, next_level);
+				fold_level = next_level;
+				continue;
 			}
-			else
-				editor->SetFoldLevel(l, fold_level | wxSTC_FOLDLEVELHEADERFLAG);
+
+			level = fold_level | wxSTC_FOLDLEVELHEADERFLAG;
 		}
-		else
-			editor->SetFoldLevel(l, fold_level);
 
+		// Stop if nothing has changed past the restyled lines
+		if (line_end >= 0 && l > line_end && editor->GetFoldLevel(l) == level)
+			break;
+
+		editor->SetFoldLevel(l, level);
 		fold_level = next_level;
 	}
 }
 
+// ----------------------------------------------------------------------------
+// Lexer::updateLines
+//
+// Keeps line info in sync with the text after [lines_added] lines were
+// added (or removed, if negative) following line [line]
+// ----------------------------------------------------------------------------
+void Lexer::updateLines(int line, int lines_added)
+{
+	if (lines_added == 0 || line < 0 || (unsigned) line + 1 >= lines_.size())
+		return;
+
+	auto first = lines_.begin() + line + 1;
+	if (lines_added > 0)
+		lines_.insert(first, lines_added, LineInfo());
+	else
+		lines_.erase(first, first + std::min<size_t>(-lines_added, lines_.end() - first));
+}
+
 // ----------------------------------------------------------------------------
 // Lexer::isFunction
 //
@@ -780,8 +1007,8 @@ void Lexer::updateFolding(TextEditorCtrl* editor, int line_start)
 // ----------------------------------------------------------------------------
 bool Lexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos)
 {
-	string word = editor->GetTextRange(start_pos, end_pos);
-	return word_list_[language_->caseSensitive() ? word : word.MakeLower()].style == (int)Style::Function;
+	auto word = editor->GetTextRangeRaw(start_pos, end_pos);
+	return word_list_.get(word.data(), word.length(), !language_->caseSensitive()) == (char)Style::Function;
 }
 
 
@@ -801,7 +1028,7 @@ bool Lexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos)
 void ZScriptLexer::addWord(string word, int style)
 {
 	if (style == Style::Function)
-		functions_.push_back(language_->caseSensitive() ? word : word.Lower());
+		functions_.set((language_->caseSensitive() ? word : word.Lower()).ToStdString(), (char) style);
 	else
 		Lexer::addWord(word, style);
 }
@@ -811,24 +1038,21 @@ void ZScriptLexer::addWord(string word, int style)
 //
 // ZScript version of Lexer::styleWord - functions require a following '('
 // ----------------------------------------------------------------------------
-void ZScriptLexer::styleWord(LexerState& state, string word)
+void ZScriptLexer::styleWord(LexerState& state, const std::string& word)
 {
 	// Skip whitespace after word
 	auto index = state.position;
 	while (index < state.end)
 	{
-		if (!(VECTOR_EXISTS(whitespace_chars_, state.editor->GetCharAt(index))))
+		if (!whitespace_chars_[charAt(state, index)])
 			break;
 		++index;
 	}
 
 	// Check for '(' (possible function)
-	if (state.editor->GetCharAt(index) == '(')
+	if (charAt(state, index) == '(')
 	{
-		if (!language_->caseSensitive())
-			word = word.Lower();
-
-		if (VECTOR_EXISTS(functions_, word))
+		if (functions_.get(word.data(), word.size(), !language_->caseSensitive()) > 0)
 		{
 			state.editor->SetStyling(word.length(), Style::Function);
 			return;
@@ -864,7 +1088,7 @@ bool ZScriptLexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos
 	auto end = editor->GetTextLength();
 	while (index < end)
 	{
-		if (!(VECTOR_EXISTS(whitespace_chars_, editor->GetCharAt(index))))
+		if (!whitespace_chars_[editor->GetCharAt(index)])
 			break;
 		++index;
 	}
@@ -872,6 +1096,77 @@ bool ZScriptLexer::isFunction(TextEditorCtrl* editor, int start_pos, int end_pos
 		return false;
 
 	// Check if word is a function name
-	string word = editor->GetTextRange(start_pos, end_pos);
-	return VECTOR_EXISTS(functions_, language_->caseSensitive() ? word : word.Lower());
+	auto word = editor->GetTextRangeRaw(start_pos, end_pos);
+	return functions_.get(word.data(), word.length(), !language_->caseSensitive()) > 0;
+}
+
+
+// Testing
+
+#include "General/Console/Console.h"
+#include "MainEditor/MainEditor.h"
+#include "Archive/ArchiveEntry.h"
+#include "App.h"
+
+CONSOLE_COMMAND(benchmark_lexer, 0, false)
+{
+	auto entry = MainEditor::currentEntry();
+	if (!entry)
+		return;
+
+	// Get language from the entry type
+	TextLanguage* language = nullptr;
+	if (entry->getType()->extraProps().propertyExists("text_language"))
+		language = TextLanguage::fromId(entry->getType()->extraProps()["text_language"]);
+	if (!language)
+	{
+		Log::info(S_FMT("Entry %s has no text language", entry->getName()));
+		return;
+	}
+
+	long num = 10;
+	if (!args.empty())
+		args[0].ToLong(&num);
+	if (num < 1)
+		num = 1;
+
+	// Setup hidden text editor with the entry text
+	auto editor = new TextEditorCtrl(MainEditor::windowWx(), -1);
+	editor->Show(false);
+	editor->SetText(wxString::FromUTF8((const char*)entry->getData(), entry->getSize()));
+	editor->setLanguage(language);
+	int lines = editor->GetLineCount();
+
+	// Style the full text [num] times
+	long time = App::runTimer();
+	for (long a = 0; a < num; a++)
+	{
+		editor->StartStyling(0, 31);
+		editor->Colourise(0, -1);
+	}
+	long time_full = App::runTimer() - time;
+
+	// Edit a line in the middle of the text [num] times, restyling up to a
+	// screen's worth of lines after it (as when typing in the editor)
+	int line = lines / 2;
+	time = App::runTimer();
+	for (long a = 0; a < num; a++)
+	{
+		auto pos = editor->PositionFromLine(line);
+		editor->InsertText(pos, "x");
+		editor->Colourise(pos, editor->PositionFromLine(std::min(line + 50, lines)));
+		editor->DeleteRange(pos, 1);
+		editor->Colourise(pos, editor->PositionFromLine(std::min(line + 50, lines)));
+	}
+	long time_edit = App::runTimer() - time;
+
+	Log::info(S_FMT(
+		"Lexer (%s, %d lines) x%d: full %dms, edit %dms",
+		language->id(),
+		lines,
+		(int)num,
+		(int)time_full,
+		(int)time_edit));
+
+	editor->Destroy();
 }
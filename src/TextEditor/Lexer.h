@@ -36,7 +36,8 @@ public:
 	void	setWordChars(string chars);
 	void	setOperatorChars(string chars);
 
-	void	updateFolding(TextEditorCtrl* editor, int line_start);
+	void	updateFolding(TextEditorCtrl* editor, int line_start, int line_end = -1);
+	void	updateLines(int line, int lines_added);
 	void	foldComments(bool fold) { fold_comments_ = fold; }
 	void	foldPreprocessor(bool fold) { fold_preprocessor_ = fold; }
 
@@ -55,25 +56,43 @@ protected:
 		Whitespace,
 	};
 
-	vector<unsigned char>	word_chars_;
-	vector<unsigned char>	operator_chars_;
-	vector<unsigned char>	whitespace_chars_;
+	// Open-addressed hash table of words -> styles. Words can be looked up
+	// directly from the editor text without creating a string
+	class WordTable
+	{
+	public:
+		void	clear();
+		void	set(const std::string& word, char value);
+		char	get(const char* word, size_t length, bool lower = false) const;
+
+	private:
+		struct Slot
+		{
+			uint32_t	hash	= 0;
+			uint32_t	offset	= 0;
+			uint32_t	length	= 0;	// 0 = empty slot
+			char		value	= 0;
+		};
+		vector<Slot>	slots_;
+		std::string		chars_;
+		size_t			count_	= 0;
+
+		static uint32_t	hash(const char* word, size_t length, bool lower = false);
+		void			rehash(size_t size);
+	};
+
+	bool					word_chars_[256];
+	bool					operator_chars_[256];
+	bool					whitespace_chars_[256];
 	TextLanguage*			language_;
-	wxRegEx					re_int1_;
-	wxRegEx					re_int2_;
-	wxRegEx					re_int3_;
-	wxRegEx					re_float_;
 	bool					fold_comments_;
 	bool					fold_preprocessor_;
 	char					preprocessor_char_;
+	std::string				preprocessor_;
 	int						curr_comment_idx_;
-
-	struct WLIndex
-	{
-		char style;
-		WLIndex() : style(0) {}
-	};
-	std::map<string, WLIndex>	word_list_;
+	WordTable				word_list_;
+	WordTable				fold_words_;	// 1 = block begin, 2 = block end
+	WordTable				pp_fold_words_;	// 1 = block begin, 2 = block end
 
 	struct LineInfo
 	{
@@ -84,7 +103,14 @@ protected:
 					 fold_increment { 0 },
 					 has_word { false } {}
 	};
-	std::map<int, LineInfo> lines_;
+	vector<LineInfo>	lines_;
+
+	LineInfo&	lineInfo(int line)
+	{
+		if ((unsigned)line >= lines_.size())
+			lines_.resize(line + 1);
+		return lines_[line];
+	}
 
 	struct LexerState
 	{
@@ -96,6 +122,9 @@ protected:
 		int				fold_increment;
 		bool			has_word;
 		TextEditorCtrl*	editor;
+		const char*		text;		// Raw text of the line being styled
+		int				text_start;	// Position of the first character in [text]
+		int				text_length;
 	};
 	bool	processUnknown(LexerState& state);
 	bool	processComment(LexerState& state);
@@ -105,11 +134,12 @@ protected:
 	bool	processOperator(LexerState& state);
 	bool	processWhitespace(LexerState& state);
 
-	virtual void	styleWord(LexerState& state, string word);
-	bool			checkToken(LexerState& state, int pos, string& token);
-	bool			checkToken(LexerState &state, int pos,
-							   vector<string> &tokens,
-							   int *found_idx = nullptr);
+	int				charAt(const LexerState& state, int pos) const;
+	virtual void	styleWord(LexerState& state, const std::string& word);
+	bool			checkToken(const LexerState& state, int pos, const string& token) const;
+	bool			checkToken(const LexerState& state, int pos,
+							   const vector<string>& tokens,
+							   int* found_idx = nullptr) const;
 };
 
 class ZScriptLexer : public Lexer
@@ -120,10 +150,10 @@ public:
 
 protected:
 	void addWord(string word, int style) override;
-	void styleWord(LexerState& state, string word) override;
+	void styleWord(LexerState& state, const std::string& word) override;
 	void clearWords() override;
 	bool isFunction(TextEditorCtrl* editor, int start_pos, int end_pos) override;
 
 private:
-	vector<string>	functions_;
+	WordTable	functions_;
 };
@@ -225,6 +225,7 @@ TextEditorCtrl::TextEditorCtrl(wxWindow* parent, int id) :
 	Bind(wxEVT_STC_MARGINCLICK, &TextEditorCtrl::onMarginClick, this);
 	Bind(wxEVT_COMMAND_JTCALCULATOR_COMPLETED, &TextEditorCtrl::onJumpToCalculateComplete, this);
 	Bind(wxEVT_STC_CHANGE, &TextEditorCtrl::onModified, this);
+	Bind(wxEVT_STC_MODIFIED, &TextEditorCtrl::onLinesModified, this);
 	Bind(wxEVT_TIMER, &TextEditorCtrl::onUpdateTimer, this);
 	Bind(wxEVT_STC_STYLENEEDED, &TextEditorCtrl::onStyleNeeded, this);
 }
@@ -1880,6 +1881,20 @@ void TextEditorCtrl::onModified(wxStyledTextEvent& e)
 	e.Skip();
 }
 
+// ----------------------------------------------------------------------------
+// TextEditorCtrl::onLinesModified
+//
+// Called when text is inserted or deleted, keeps the lexer's line info in
+// sync if lines were added or removed
+// ----------------------------------------------------------------------------
+void TextEditorCtrl::onLinesModified(wxStyledTextEvent& e)
+{
+	if (e.GetLinesAdded() != 0 && (e.GetModificationType() & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT)))
+		lexer_->updateLines(LineFromPosition(e.GetPosition()), e.GetLinesAdded());
+
+	e.Skip();
+}
+
 // ----------------------------------------------------------------------------
 // TextEditorCtrl::onUpdateTimer
 //
@@ -1907,7 +1922,8 @@ void TextEditorCtrl::onStyleNeeded(wxStyledTextEvent& e)
 	int line_start = LineFromPosition(GetEndStyled());
 	int line_end = LineFromPosition(e.GetPosition());
 
-	// Lex until done (end of lines, end of file or end of block comment)
+	// Lex until done (end of lines, end of file or the next line's starting
+	// state is unchanged, eg. not in a newly opened block comment)
 	int l = line_start;
 	bool force_next = false;
 	while (l <= GetNumberOfLines() && (l <= line_end || force_next))
@@ -1925,7 +1941,7 @@ void TextEditorCtrl::onStyleNeeded(wxStyledTextEvent& e)
 	if (txed_fold_enable)
 	{
 		auto modified = last_modified_;
-		lexer_->updateFolding(this, line_start);
+		lexer_->updateFolding(this, line_start, l - 1);
 		last_modified_ = modified;
 	}
 }
@@ -133,6 +133,7 @@ private:
 	void	onJumpToCalculateComplete(wxThreadEvent& e);
 	void	onJumpToChoiceSelected(wxCommandEvent& e);
 	void	onModified(wxStyledTextEvent& e);
+	void	onLinesModified(wxStyledTextEvent& e);
 	void	onUpdateTimer(wxTimerEvent& e);
 	void	onStyleNeeded(wxStyledTextEvent& e);
 };
@@ -31,22 +31,23 @@
 #include "Main.h"
 #include "MapPreviewCanvas.h"
 #include "Archive/ArchiveManager.h"
-#include "Archive/Formats/WadArchive.h"
 #include "General/ColourConfiguration.h"
 #include "Graphics/SImage/SIFormat.h"
 #include "Graphics/SImage/SImage.h"
-#include "MapEditor/SLADEMap/MapLine.h"
-#include "MapEditor/SLADEMap/MapThing.h"
-#include "MapEditor/SLADEMap/MapVertex.h"
 #include "OpenGL/GLTexture.h"
-#include "Utility/Tokenizer.h"
 
 
 /*******************************************************************
  * VARIABLES
  *******************************************************************/
-CVAR(Float, map_image_thickness, 1.5, CVAR_SAVE)
 CVAR(Bool, map_view_things, true, CVAR_SAVE)
+CVAR(Bool, map_image_software, false, CVAR_SAVE)
+
+
+/*******************************************************************
+ * EXTERNAL VARIABLES
+ *******************************************************************/
+EXTERN_CVAR(Float, map_image_thickness)
 
 
 /*******************************************************************
@@ -61,11 +62,8 @@ MapPreviewCanvas::MapPreviewCanvas(wxWindow* parent) : OGLCanvas(parent, -1)
 	zoom = 1;
 	offset_x = 0;
 	offset_y = 0;
-	temp_archive = nullptr;
 	tex_thing = nullptr;
 	tex_loaded = false;
-	n_sides = 0;
-	n_sectors = 0;
 }
 
 /* MapPreviewCanvas::~MapPreviewCanvas
@@ -76,534 +74,28 @@ MapPreviewCanvas::~MapPreviewCanvas()
 	if (tex_thing) delete tex_thing;
 }
 
-/* MapPreviewCanvas::addVertex
- * Adds a vertex to the map data
- *******************************************************************/
-void MapPreviewCanvas::addVertex(double x, double y)
-{
-	verts.push_back(mep_vertex_t(x, y));
-}
-
-/* MapPreviewCanvas::addLine
- * Adds a line to the map data
- *******************************************************************/
-void MapPreviewCanvas::addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro)
-{
-	mep_line_t line(v1, v2);
-	line.twosided = twosided;
-	line.special = special;
-	line.macro = macro;
-	lines.push_back(line);
-}
-
-/* MapPreviewCanvas::addThing
- * Adds a thing to the map data
- *******************************************************************/
-void MapPreviewCanvas::addThing(double x, double y)
-{
-	mep_thing_t thing;
-	thing.x = x;
-	thing.y = y;
-	things.push_back(thing);
-}
-
 /* MapPreviewCanvas::openMap
  * Opens a map from a mapdesc_t
  *******************************************************************/
 bool MapPreviewCanvas::openMap(Archive::MapDesc map)
 {
-	// All errors = invalid map
-	Global::error = "Invalid map";
-
-	// Check if this map is a pk3 map
-	bool map_archive = false;
-	if (map.archive)
-	{
-		map_archive = true;
-
-		// Attempt to open entry as wad archive
-		temp_archive = new WadArchive();
-		if (!temp_archive->open(map.head))
-		{
-			delete temp_archive;
-			return false;
-		}
-
-		// Detect maps
-		vector<Archive::MapDesc> maps = temp_archive->detectMaps();
-
-		// Set map if there are any in the archive
-		if (maps.size() > 0)
-			map = maps[0];
-		else
-			return false;
-	}
-
-	// Parse UDMF map
-	if (map.format == MAP_UDMF)
-	{
-		ArchiveEntry* udmfdata = nullptr;
-		for (ArchiveEntry* mapentry = map.head; mapentry != map.end; mapentry = mapentry->nextEntry())
-		{
-			// Check entry type
-			if (mapentry->getType() == EntryType::fromId("udmf_textmap"))
-			{
-				udmfdata = mapentry;
-				break;
-			}
-		}
-		if (udmfdata == nullptr)
-			return false;
-
-		// Start parsing
-		Tokenizer tz;
-		tz.openMem(udmfdata->getMCData(), map.head->getName());
-
-		// Get first token
-		string token = tz.getToken();
-		size_t vertcounter = 0, linecounter = 0, thingcounter = 0;
-		while (!token.IsEmpty())
-		{
-			if (!token.CmpNoCase("namespace"))
-			{
-				//  skip till we reach the ';'
-				do { token = tz.getToken(); }
-				while (token.Cmp(";"));
-			}
-			else if (!token.CmpNoCase("vertex"))
-			{
-				// Get X and Y properties
-				bool gotx = false;
-				bool goty = false;
-				double x = 0.;
-				double y = 0.;
-				do
-				{
-					token = tz.getToken();
-					if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
-					{
-						bool isx = !token.CmpNoCase("x");
-						token = tz.getToken();
-						if (token.Cmp("="))
-						{
-							LOG_MESSAGE(1, "Bad syntax for vertex %i in UDMF map data", vertcounter);
-							return false;
-						}
-						if (isx) x = tz.getDouble(), gotx = true;
-						else y = tz.getDouble(), goty = true;
-						// skip to end of declaration after each key
-						do { token = tz.getToken(); }
-						while (token.Cmp(";"));
-					}
-				}
-				while (token.Cmp("}"));
-				if (gotx && goty)
-					addVertex(x, y);
-				else
-				{
-					LOG_MESSAGE(1, "Wrong vertex %i in UDMF map data", vertcounter);
-					return false;
-				}
-				vertcounter++;
-			}
-			else if (!token.CmpNoCase("linedef"))
-			{
-				bool special = false;
-				bool twosided = false;
-				bool gotv1 = false, gotv2 = false;
-				size_t v1 = 0, v2 = 0;
-				do
-				{
-					token = tz.getToken();
-					if (!token.CmpNoCase("v1") || !token.CmpNoCase("v2"))
-					{
-						bool isv1 = !token.CmpNoCase("v1");
-						token = tz.getToken();
-						if (token.Cmp("="))
-						{
-							LOG_MESSAGE(1, "Bad syntax for linedef %i in UDMF map data", linecounter);
-							return false;
-						}
-						if (isv1) v1 = tz.getInteger(), gotv1 = true;
-						else v2 = tz.getInteger(), gotv2 = true;
-						// skip to end of declaration after each key
-						do { token = tz.getToken(); }
-						while (token.Cmp(";"));
-					}
-					else if (!token.CmpNoCase("special"))
-					{
-						special = true;
-						// skip to end of declaration after each key
-						do { token = tz.getToken(); }
-						while (token.Cmp(";"));
-					}
-					else if (!token.CmpNoCase("sideback"))
-					{
-						twosided = true;
-						// skip to end of declaration after each key
-						do { token = tz.getToken(); }
-						while (token.Cmp(";"));
-					}
-				}
-				while (token.Cmp("}"));
-				if (gotv1 && gotv2)
-					addLine(v1, v2, twosided, special);
-				else
-				{
-					LOG_MESSAGE(1, "Wrong line %i in UDMF map data", linecounter);
-					return false;
-				}
-				linecounter++;
-			}
-			else if (S_CMPNOCASE(token, "thing"))
-			{
-				// Get X and Y properties
-				bool gotx = false;
-				bool goty = false;
-				double x = 0.;
-				double y = 0.;
-				do
-				{
-					token = tz.getToken();
-					if (!token.CmpNoCase("x") || !token.CmpNoCase("y"))
-					{
-						bool isx = !token.CmpNoCase("x");
-						token = tz.getToken();
-						if (token.Cmp("="))
-						{
-							LOG_MESSAGE(1, "Bad syntax for thing %i in UDMF map data", vertcounter);
-							return false;
-						}
-						if (isx) x = tz.getDouble(), gotx = true;
-						else y = tz.getDouble(), goty = true;
-						// skip to end of declaration after each key
-						do { token = tz.getToken(); } while (token.Cmp(";"));
-					}
-				} while (token.Cmp("}"));
-				if (gotx && goty)
-					addThing(x, y);
-				else
-				{
-					LOG_MESSAGE(1, "Wrong thing %i in UDMF map data", vertcounter);
-					return false;
-				}
-				vertcounter++;
-			}
-			else
-			{
-				// Check for side or sector definition (increase counts)
-				if (S_CMPNOCASE(token, "sidedef"))
-					n_sides++;
-				else if (S_CMPNOCASE(token, "sector"))
-					n_sectors++;
-
-				// map preview ignores sidedefs, sectors, comments,
-				// unknown fields, etc. so skip to end of block
-				do { token = tz.getToken(); }
-				while (token.Cmp("}") && !token.empty());
-			}
-			// Iterate to next token
-			token = tz.getToken();
-		}
-	}
-
-	// Non-UDMF map
-	if (map.format != MAP_UDMF)
-	{
-		// Read vertices (required)
-		if (!readVertices(map.head, map.end, map.format))
-			return false;
-
-		// Read linedefs (required)
-		if (!readLines(map.head, map.end, map.format))
-			return false;
-
-		// Read things
-		if (map.format != MAP_UDMF)
-			readThings(map.head, map.end, map.format);
-
-		// Read sides & sectors (count only)
-		ArchiveEntry* sidedefs = nullptr;
-		ArchiveEntry* sectors = nullptr;
-		while (map.head)
-		{
-			// Check entry type
-			if (map.head->getType() == EntryType::fromId("map_sidedefs"))
-				sidedefs = map.head;
-			if (map.head->getType() == EntryType::fromId("map_sectors"))
-				sectors = map.head;
-
-			// Exit loop if we've reached the end of the map entries
-			if (map.head == map.end)
-				break;
-			else
-				map.head = map.head->nextEntry();
-		}
-		if (sidedefs && sectors)
-		{
-			// Doom64 map
-			if (map.format != MAP_DOOM64)
-			{
-				n_sides = sidedefs->getSize() / 30;
-				n_sectors = sectors->getSize() / 26;
-			}
-
-			// Doom/Hexen map
-			else
-			{
-				n_sides = sidedefs->getSize() / 12;
-				n_sectors = sectors->getSize() / 16;
-			}
-		}
-	}
-
-	// Clean up
-	if (map_archive)
-	{
-		temp_archive->close();
-		delete temp_archive;
-		temp_archive = nullptr;
-	}
+	map_data.clear();
+	bool ok = map_data.openMap(map);
 
 	// Refresh map
 	Refresh();
 
-	return true;
+	return ok;
 }
 
-/* MapPreviewCanvas::readVertices
- * Reads non-UDMF vertex data
- *******************************************************************/
-bool MapPreviewCanvas::readVertices(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
-{
-	// Find VERTEXES entry
-	ArchiveEntry* vertexes = nullptr;
-	while (map_head)
-	{
-		// Check entry type
-		if (map_head->getType() == EntryType::fromId("map_vertexes"))
-		{
-			vertexes = map_head;
-			break;
-		}
-
-		// Exit loop if we've reached the end of the map entries
-		if (map_head == map_end)
-			break;
-		else
-			map_head = map_head->nextEntry();
-	}
-
-	// Can't open a map without vertices
-	if (!vertexes)
-		return false;
-
-	// Read vertex data
-	MemChunk& mc = vertexes->getMCData();
-	mc.seek(0, SEEK_SET);
-
-	if (map_format == MAP_DOOM64)
-	{
-		doom64vertex_t v;
-		while (1)
-		{
-			// Read vertex
-			if (!mc.read(&v, 8))
-				break;
-
-			// Add vertex
-			addVertex((double)v.x/65536, (double)v.y/65536);
-		}
-	}
-	else
-	{
-		doomvertex_t v;
-		while (1)
-		{
-			// Read vertex
-			if (!mc.read(&v, 4))
-				break;
-
-			// Add vertex
-			addVertex((double)v.x, (double)v.y);
-		}
-	}
-
-	return true;
-}
-
-/* MapPreviewCanvas::readLines
- * Reads non-UDMF line data
- *******************************************************************/
-bool MapPreviewCanvas::readLines(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
-{
-	// Find LINEDEFS entry
-	ArchiveEntry* linedefs = nullptr;
-	while (map_head)
-	{
-		// Check entry type
-		if (map_head->getType() == EntryType::fromId("map_linedefs"))
-		{
-			linedefs = map_head;
-			break;
-		}
-
-		// Exit loop if we've reached the end of the map entries
-		if (map_head == map_end)
-			break;
-		else
-			map_head = map_head->nextEntry();
-	}
-
-	// Can't open a map without linedefs
-	if (!linedefs)
-		return false;
-
-	// Read line data
-	MemChunk& mc = linedefs->getMCData();
-	mc.seek(0, SEEK_SET);
-	if (map_format == MAP_DOOM)
-	{
-		while (1)
-		{
-			// Read line
-			doomline_t l;
-			if (!mc.read(&l, sizeof(doomline_t)))
-				break;
-
-			// Check properties
-			bool special = false;
-			bool twosided = false;
-			if (l.side2 != 0xFFFF)
-				twosided = true;
-			if (l.type > 0)
-				special = true;
-
-			// Add line
-			addLine(l.vertex1, l.vertex2, twosided, special);
-		}
-	}
-	else if (map_format == MAP_DOOM64)
-	{
-		while (1)
-		{
-			// Read line
-			doom64line_t l;
-			if (!mc.read(&l, sizeof(doom64line_t)))
-				break;
-
-			// Check properties
-			bool macro = false;
-			bool special = false;
-			bool twosided = false;
-			if (l.side2  != 0xFFFF)
-				twosided = true;
-			if (l.type > 0)
-			{
-				if (l.type & 0x100)
-					macro = true;
-				else special = true;
-			}
-
-			// Add line
-			addLine(l.vertex1, l.vertex2, twosided, special, macro);
-		}
-	}
-	else if (map_format == MAP_HEXEN)
-	{
-		while (1)
-		{
-			// Read line
-			hexenline_t l;
-			if (!mc.read(&l, sizeof(hexenline_t)))
-				break;
-
-			// Check properties
-			bool special = false;
-			bool twosided = false;
-			if (l.side2 != 0xFFFF)
-				twosided = true;
-			if (l.type > 0)
-				special = true;
-
-			// Add line
-			addLine(l.vertex1, l.vertex2, twosided, special);
-		}
-	}
-
-	return true;
-}
-
-/* MapPreviewCanvas::readThings
- * Reads non-UDMF thing data
- *******************************************************************/
-bool MapPreviewCanvas::readThings(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format)
-{
-	// Find THINGS entry
-	ArchiveEntry* things = nullptr;
-	while (map_head)
-	{
-		// Check entry type
-		if (map_head->getType() == EntryType::fromId("map_things"))
-		{
-			things = map_head;
-			break;
-		}
-
-		// Exit loop if we've reached the end of the map entries
-		if (map_head == map_end)
-			break;
-		else
-			map_head = map_head->nextEntry();
-	}
-
-	// No things
-	if (!things)
-		return false;
-
-	// Read things data
-	if (map_format == MAP_DOOM)
-	{
-		doomthing_t* thng_data = (doomthing_t*)things->getData(true);
-		unsigned nt = things->getSize() / sizeof(doomthing_t);
-		for (size_t a = 0; a < nt; a++)
-			addThing(thng_data[a].x, thng_data[a].y);
-	}
-	else if (map_format == MAP_DOOM64)
-	{
-		doom64thing_t* thng_data = (doom64thing_t*)things->getData(true);
-		unsigned nt = things->getSize() / sizeof(doom64thing_t);
-		for (size_t a = 0; a < nt; a++)
-			addThing(thng_data[a].x, thng_data[a].y);
-	}
-	else if (map_format == MAP_HEXEN)
-	{
-		hexenthing_t* thng_data = (hexenthing_t*)things->getData(true);
-		unsigned nt = things->getSize() / sizeof(hexenthing_t);
-		for (size_t a = 0; a < nt; a++)
-			addThing(thng_data[a].x, thng_data[a].y);
-	}
-
-	return true;
-}
-
-/* MapPreviewCanvas::clearMap
- * Clears map data
- *******************************************************************/
-void MapPreviewCanvas::clearMap()
-{
-	verts.clear();
-	lines.clear();
-	things.clear();
-	n_sides = 0;
-	n_sectors = 0;
-}
 
 /* MapPreviewCanvas::showMap
  * Adjusts zoom and offset to show the whole map
  *******************************************************************/
 void MapPreviewCanvas::showMap()
 {
+	const vector<mep_vertex_t>& verts = map_data.getVertices();
+
 	// Find extents of map
 	mep_vertex_t m_min(999999.0, 999999.0);
 	mep_vertex_t m_max(-999999.0, -999999.0);
@@ -637,6 +129,10 @@ void MapPreviewCanvas::showMap()
  *******************************************************************/
 void MapPreviewCanvas::draw()
 {
+	const vector<mep_vertex_t>& verts = map_data.getVertices();
+	const vector<mep_line_t>& lines = map_data.getLines();
+	const vector<mep_thing_t>& things = map_data.getThings();
+
 	// Setup colours
 	rgba_t col_view_background = ColourConfiguration::getColour("map_view_background");
 	rgba_t col_view_line_1s = ColourConfiguration::getColour("map_view_line_1s");
@@ -774,13 +270,26 @@ void MapPreviewCanvas::draw()
 
 
 /* MapPreviewCanvas::createImage
- * Draws the map in an image
+ * Draws the map in an image. If there is no OpenGL framebuffer
+ * support (eg. no GL context), the map is drawn with the software
+ * rasteriser instead, which also handles any image size
  * TODO: Factorize code with normal draw() and showMap() functions.
- * TODO: Find a way to generate an arbitrary-sized image through
- * tiled rendering.
  *******************************************************************/
 void MapPreviewCanvas::createImage(ArchiveEntry& ae, int width, int height)
 {
+	if (map_image_software || !OpenGL::isInitialised() || !GLEW_ARB_framebuffer_object)
+	{
+		map_data.getImageSize(width, height);
+		SImage img;
+		MemChunk mc;
+		if (map_data.renderImage(img, width, height) && SIFormat::getFormat("png")->saveImage(img, mc))
+			ae.importMemChunk(mc);
+		return;
+	}
+
+	const vector<mep_vertex_t>& verts = map_data.getVertices();
+	const vector<mep_line_t>& lines = map_data.getLines();
+
 	// Find extents of map
 	mep_vertex_t m_min(999999.0, 999999.0);
 	mep_vertex_t m_max(-999999.0, -999999.0);
@@ -957,99 +466,3 @@ void MapPreviewCanvas::createImage(ArchiveEntry& ae, int width, int height)
 	SIFormat::getFormat("png")->saveImage(img, mc);
 	ae.importMemChunk(mc);
 }
-
-/* MapPreviewCanvas::nVertices
- * Returns the number of (attached) vertices in the map
- *******************************************************************/
-unsigned MapPreviewCanvas::nVertices()
-{
-	// Get list of used vertices
-	vector<bool> v_used;
-	for (unsigned a = 0; a < verts.size(); a++)
-		v_used.push_back(false);
-	for (unsigned a = 0; a < lines.size(); a++)
-	{
-		v_used[lines[a].v1] = true;
-		v_used[lines[a].v2] = true;
-	}
-
-	// Get count of used vertices
-	unsigned count = 0;
-	for (unsigned a = 0; a < v_used.size(); a++)
-	{
-		if (v_used[a])
-			count++;
-	}
-
-	return count;
-}
-
-/* MapPreviewCanvas::nSides
- * Returns the number of sides in the map
- *******************************************************************/
-unsigned MapPreviewCanvas::nSides()
-{
-	return n_sides;
-}
-
-/* MapPreviewCanvas::nLines
- * Returns the number of lines in the map
- *******************************************************************/
-unsigned MapPreviewCanvas::nLines()
-{
-	return lines.size();
-}
-
-/* MapPreviewCanvas::nSectors
- * Returns the number of sectors in the map
- *******************************************************************/
-unsigned MapPreviewCanvas::nSectors()
-{
-	return n_sectors;
-}
-
-/* MapPreviewCanvas::nThings
- * Returns the number of things in the map
- *******************************************************************/
-unsigned MapPreviewCanvas::nThings()
-{
-	return things.size();
-}
-
-/* MapPreviewCanvas::getWidth
- * Returns the width (in map units) of the map
- *******************************************************************/
-unsigned MapPreviewCanvas::getWidth()
-{
-	int min_x = wxINT32_MAX;
-	int max_x = wxINT32_MIN;
-
-	for (unsigned a = 0; a < verts.size(); a++)
-	{
-		if (verts[a].x < min_x)
-			min_x = verts[a].x;
-		if (verts[a].x > max_x)
-			max_x = verts[a].x;
-	}
-
-	return max_x - min_x;
-}
-
-/* MapPreviewCanvas::getHeight
- * Returns the height (in map units) of the map
- *******************************************************************/
-unsigned MapPreviewCanvas::getHeight()
-{
-	int min_y = wxINT32_MAX;
-	int max_y = wxINT32_MIN;
-
-	for (unsigned a = 0; a < verts.size(); a++)
-	{
-		if (verts[a].y < min_y)
-			min_y = verts[a].y;
-		if (verts[a].y > max_y)
-			max_y = verts[a].y;
-	}
-
-	return max_y - min_y;
-}
@@ -3,72 +3,38 @@
 #define __MAP_PREVIEW_CANVAS_H__
 
 #include "OGLCanvas.h"
-#include "Archive/Archive.h"
-
-// Structs for basic map features
-struct mep_vertex_t
-{
-	double x;
-	double y;
-	mep_vertex_t(double x, double y) { this->x = x; this->y = y; }
-};
-
-struct mep_line_t
-{
-	unsigned	v1;
-	unsigned	v2;
-	bool		twosided;
-	bool		special;
-	bool		macro;
-	bool		segment;
-	mep_line_t(unsigned v1, unsigned v2) { this->v1 = v1; this->v2 = v2; }
-};
-
-struct mep_thing_t
-{
-	double	x;
-	double	y;
-};
+#include "MapEditor/MapPreviewData.h"
 
 class GLTexture;
 class MapPreviewCanvas : public OGLCanvas
 {
 private:
-	vector<mep_vertex_t>	verts;
-	vector<mep_line_t>		lines;
-	vector<mep_thing_t>		things;
-	unsigned				n_sides;
-	unsigned				n_sectors;
-	double					zoom;
-	double					offset_x;
-	double					offset_y;
-	Archive*				temp_archive;
-	GLTexture*				tex_thing;
-	bool					tex_loaded;
+	MapPreviewData	map_data;
+	double			zoom;
+	double			offset_x;
+	double			offset_y;
+	GLTexture*		tex_thing;
+	bool			tex_loaded;
 
 public:
 	MapPreviewCanvas(wxWindow* parent);
 	~MapPreviewCanvas();
 
-	void addVertex(double x, double y);
-	void addLine(unsigned v1, unsigned v2, bool twosided, bool special, bool macro = false);
-	void addThing(double x, double y);
+	MapPreviewData&	mapData() { return map_data; }
+
 	bool openMap(Archive::MapDesc map);
-	bool readVertices(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
-	bool readLines(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
-	bool readThings(ArchiveEntry* map_head, ArchiveEntry* map_end, int map_format);
-	void clearMap();
+	void clearMap() { map_data.clear(); }
 	void showMap();
 	void draw();
 	void createImage(ArchiveEntry& ae, int width, int height);
 
-	unsigned	nVertices();
-	unsigned	nSides();
-	unsigned	nLines();
-	unsigned	nSectors();
-	unsigned	nThings();
-	unsigned	getWidth();
-	unsigned	getHeight();
+	unsigned	nVertices() { return map_data.nVertices(); }
+	unsigned	nSides() { return map_data.nSides(); }
+	unsigned	nLines() { return map_data.nLines(); }
+	unsigned	nSectors() { return map_data.nSectors(); }
+	unsigned	nThings() { return map_data.nThings(); }
+	unsigned	getWidth() { return map_data.getWidth(); }
+	unsigned	getHeight() { return map_data.getHeight(); }
 };
 
 #endif//__MAP_PREVIEW_CANVAS_H__
@@ -56,6 +56,7 @@ ConsolePanel::ConsolePanel(wxWindow* parent, int id)
 	// Init variables
 	cmd_log_index_ = 0;
 	next_message_index_ = 0;
+	next_line_ = 0;
 
 	// Setup layout
 	initLayout();
@@ -145,8 +146,8 @@ void ConsolePanel::update()
 	setupTextArea();
 
 	// Check if any new log messages were added since the last update
-	auto& log = Log::history();
-	if (log.size() <= next_message_index_)
+	auto log = Log::history(next_message_index_);
+	if (log.empty())
 	{
 		// None added, check again in 500ms
 		timer_update_.Start(500);
@@ -155,34 +156,35 @@ void ConsolePanel::update()
 
 	// Add new log messages to log text area
 	text_log_->SetEditable(true);
-	for (auto a = next_message_index_; a < log.size(); ++a)
+	for (auto& msg : log)
 	{
-		if (a > 0)
+		auto line = next_line_++;
+		if (line > 0)
 			text_log_->AppendText("\n");
 
 		// Add message line + timestamp margin
-		text_log_->AppendText(log[a].message);
-		text_log_->MarginSetText(a, wxDateTime(log[a].timestamp).FormatISOTime());
-		text_log_->MarginSetStyle(a, wxSTC_STYLE_LINENUMBER);
+		text_log_->AppendText(msg.message);
+		text_log_->MarginSetText(line, wxDateTime(msg.timestamp).FormatISOTime());
+		text_log_->MarginSetStyle(line, wxSTC_STYLE_LINENUMBER);
 
 		// Set line colour depending on message type
-		text_log_->StartStyling(text_log_->GetLineEndPosition(a) - text_log_->GetLineLength(a), 0);
-		switch (log[a].type)
+		text_log_->StartStyling(text_log_->GetLineEndPosition(line) - text_log_->GetLineLength(line), 0);
+		switch (msg.type)
 		{
 		case Log::MessageType::Error:
-			text_log_->SetStyling(text_log_->GetLineLength(a), 200); break;
+			text_log_->SetStyling(text_log_->GetLineLength(line), 200); break;
 		case Log::MessageType::Warning:
-			text_log_->SetStyling(text_log_->GetLineLength(a), 201); break;
+			text_log_->SetStyling(text_log_->GetLineLength(line), 201); break;
 		case Log::MessageType::Script:
-			text_log_->SetStyling(text_log_->GetLineLength(a), 202); break;
+			text_log_->SetStyling(text_log_->GetLineLength(line), 202); break;
 		case Log::MessageType::Debug:
-			text_log_->SetStyling(text_log_->GetLineLength(a), 203); break;
+			text_log_->SetStyling(text_log_->GetLineLength(line), 203); break;
 		default: break;
 		}
 	}
 	text_log_->SetEditable(false);
 
-	next_message_index_ = Log::history().size();
+	next_message_index_ = log.back().index + 1;
 	text_log_->ScrollToEnd();
 
 	// Check again in 100ms
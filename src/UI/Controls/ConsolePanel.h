@@ -19,7 +19,8 @@ private:
 	wxTextCtrl*			text_command_;
 	int					cmd_log_index_;
 	wxTimer				timer_update_;
-	unsigned			next_message_index_;
+	size_t				next_message_index_;
+	int					next_line_;	// Line in text_log_ for the next message
 
 	// Events
 	void onCommandEnter(wxCommandEvent& e);
@@ -50,6 +50,63 @@ namespace StringUtils
 }
 
 
+// ----------------------------------------------------------------------------
+//
+// Local Functions
+//
+// ----------------------------------------------------------------------------
+namespace
+{
+	// ------------------------------------------------------------------------
+	// isDigit
+	//
+	// Returns true if [c] is a decimal digit
+	// ------------------------------------------------------------------------
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	// ------------------------------------------------------------------------
+	// allDigits
+	//
+	// Returns true if [len] characters of [str] are all decimal digits
+	// (and there is at least one)
+	// ------------------------------------------------------------------------
+	bool allDigits(const char* str, size_t len)
+	{
+		if (len == 0)
+			return false;
+
+		for (size_t a = 0; a < len; ++a)
+			if (!isDigit(str[a]))
+				return false;
+
+		return true;
+	}
+
+	// ------------------------------------------------------------------------
+	// isFloatMantissa
+	//
+	// Returns true if [str] matches [0-9]*.?[0-9]+ (where '.' is any
+	// character, as in re_float)
+	// ------------------------------------------------------------------------
+	bool isFloatMantissa(const char* str, size_t len)
+	{
+		if (allDigits(str, len))
+			return true;
+
+		// The first non-digit character has to be the single 'any' character,
+		// followed by at least one digit
+		size_t lead = 0;
+		while (lead < len && isDigit(str[lead]))
+			++lead;
+
+		return allDigits(str + lead + 1, len - lead - 1);
+	}
+}
+
+
 // ----------------------------------------------------------------------------
 //
 // StringUtils Namespace Functions
@@ -225,3 +282,86 @@ bool StringUtils::isFloat(const string& str)
 {
 	return (re_float.Matches(str));
 }
+
+// ----------------------------------------------------------------------------
+// StringUtils::isInteger
+//
+// Returns true if the first [len] characters of [str] are a valid integer.
+// If [allow_hex] is true, can also be a valid hex string.
+// Matches the same strings as the regex-based version above
+// ----------------------------------------------------------------------------
+bool StringUtils::isInteger(const char* str, size_t len, bool allow_hex)
+{
+	if (len == 0)
+		return false;
+
+	// Decimal (with optional sign)
+	if (str[0] == '+' || str[0] == '-')
+	{
+		if (allDigits(str + 1, len - 1))
+			return true;
+	}
+	else if (allDigits(str, len))
+		return true;
+
+	return allow_hex && isHex(str, len);
+}
+
+// ----------------------------------------------------------------------------
+// StringUtils::isHex
+//
+// Returns true if the first [len] characters of [str] are a valid hex string
+// ----------------------------------------------------------------------------
+bool StringUtils::isHex(const char* str, size_t len)
+{
+	if (len < 3 || str[0] != '0' || str[1] != 'x')
+		return false;
+
+	for (size_t a = 2; a < len; ++a)
+	{
+		char c = str[a];
+		if (!(isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')))
+			return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// StringUtils::isFloat
+//
+// Returns true if the first [len] characters of [str] are a valid
+// floating-point number
+// ----------------------------------------------------------------------------
+bool StringUtils::isFloat(const char* str, size_t len)
+{
+	// Optional sign
+	if (len > 0 && (str[0] == '+' || str[0] == '-'))
+	{
+		++str;
+		--len;
+	}
+
+	if (len == 0)
+		return false;
+
+	// No exponent
+	if (isFloatMantissa(str, len))
+		return true;
+
+	// Mantissa followed by an exponent ([eE][-+]?[0-9]+)
+	for (size_t a = 1; a + 1 < len; ++a)
+	{
+		if (str[a] != 'e' && str[a] != 'E')
+			continue;
+
+		size_t exp = a + 1;
+		if (str[exp] == '+' || str[exp] == '-')
+			++exp;
+
+		if (allDigits(str + exp, len - exp) && isFloatMantissa(str, a))
+			return true;
+	}
+
+	return false;
+}
@@ -27,4 +27,9 @@ namespace StringUtils
 	bool	isInteger(const string& str, bool allow_hex = true);
 	bool	isHex(const string& str);
 	bool	isFloat(const string& str);
+
+	// Allocation-free versions for (not null-terminated) character data
+	bool	isInteger(const char* str, size_t len, bool allow_hex = true);
+	bool	isHex(const char* str, size_t len);
+	bool	isFloat(const char* str, size_t len);
 }
@@ -0,0 +1,196 @@
+// -----------------------------------------------------------------------------
+// SLADE - It's a Doom Editor
+// Copyright(C) 2008 - 2017 Simon Judd
+//
+// Email:       sirjuddington@gmail.com
+// Web:         http://slade.mancubus.net
+// Filename:    ThreadPool.cpp
+// Description: ThreadPool class, a simple pool of worker threads for running
+//              independent jobs (parsing, conversion etc.) in parallel
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301, USA.
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+//
+// Includes
+//
+// -----------------------------------------------------------------------------
+#include "Main.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+
+// -----------------------------------------------------------------------------
+//
+// Variables
+//
+// -----------------------------------------------------------------------------
+CVAR(Int, max_worker_threads, 0, CVAR_SAVE)
+
+
+// -----------------------------------------------------------------------------
+//
+// ThreadPool Class Functions
+//
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// ThreadPool class constructor. If [num_threads] is 0, one thread per hardware
+// thread is created (limited by the max_worker_threads cvar, if set)
+// -----------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+	if (num_threads == 0)
+	{
+		num_threads = std::thread::hardware_concurrency();
+		if (max_worker_threads > 0 && num_threads > (unsigned)max_worker_threads)
+			num_threads = max_worker_threads;
+		if (num_threads == 0)
+			num_threads = 1;
+	}
+
+	for (unsigned a = 0; a < num_threads; ++a)
+		threads_.emplace_back([this]() { workerLoop(); });
+}
+
+// -----------------------------------------------------------------------------
+// ThreadPool class destructor. Waits for all queued jobs to finish
+// -----------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	cv_jobs_.notify_all();
+
+	for (auto& thread : threads_)
+		thread.join();
+}
+
+// -----------------------------------------------------------------------------
+// Adds [job] to the queue, returns a future that becomes ready when the job
+// has been run
+// -----------------------------------------------------------------------------
+std::future<void> ThreadPool::queue(std::function<void()> job)
+{
+	std::packaged_task<void()> task(std::move(job));
+	auto                       future = task.get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(task));
+	}
+	cv_jobs_.notify_one();
+
+	return future;
+}
+
+// -----------------------------------------------------------------------------
+// Calls [func] with every index from 0 to [count]-1, spread across the pool's
+// threads and the calling thread. Returns once all calls have completed.
+//
+// The calling thread processes indices itself rather than waiting on queued
+// jobs, so this is safe to use from within a job running on the pool
+// -----------------------------------------------------------------------------
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if (count == 0)
+		return;
+
+	// Not worth queueing anything for a single item
+	if (count == 1 || threads_.empty())
+	{
+		for (size_t a = 0; a < count; ++a)
+			func(a);
+		return;
+	}
+
+	// Shared between the calling thread and helper jobs, helpers that start
+	// after everything is done may outlive this call
+	struct State
+	{
+		std::atomic<size_t>     next{ 0 };
+		std::atomic<size_t>     done{ 0 };
+		size_t                  count = 0;
+		std::mutex              mutex;
+		std::condition_variable cv_done;
+	};
+	auto state   = std::make_shared<State>();
+	state->count = count;
+
+	auto process = [state, &func]() {
+		size_t index;
+		while ((index = state->next++) < state->count)
+		{
+			func(index);
+
+			if (++state->done == state->count)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->cv_done.notify_all();
+			}
+		}
+	};
+
+	// Queue helpers (the calling thread counts as one)
+	auto helpers = std::min<size_t>(threads_.size(), count - 1);
+	for (size_t a = 0; a < helpers; ++a)
+	{
+		// [func] is only accessed while there are indices left to process,
+		// which can't outlive this call
+		queue(process);
+	}
+
+	process();
+
+	// Wait for any indices still being processed by helpers
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->cv_done.wait(lock, [&]() { return state->done == state->count; });
+}
+
+// -----------------------------------------------------------------------------
+// Returns the global (shared) thread pool
+// -----------------------------------------------------------------------------
+ThreadPool& ThreadPool::global()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+// -----------------------------------------------------------------------------
+// Runs queued jobs until the pool is destroyed
+// -----------------------------------------------------------------------------
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_jobs_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+			if (jobs_.empty())
+				return;
+
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+
+		job();
+	}
+}
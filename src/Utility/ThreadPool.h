@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// A simple fixed-size pool of worker threads. Jobs are run in the order they
+// are queued. Jobs must not touch UI/OpenGL or load archive entry data (that
+// should be done by the calling thread beforehand)
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned num_threads = 0);
+	~ThreadPool();
+
+	unsigned numThreads() const { return (unsigned)threads_.size(); }
+
+	std::future<void> queue(std::function<void()> job);
+	void              parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	static ThreadPool& global();
+
+private:
+	vector<std::thread>                    threads_;
+	std::deque<std::packaged_task<void()>> jobs_;
+	std::mutex                             mutex_;
+	std::condition_variable                cv_jobs_;
+	bool                                   stopping_ = false;
+
+	void workerLoop();
+};
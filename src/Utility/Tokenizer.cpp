@@ -40,7 +40,7 @@
 //
 // ----------------------------------------------------------------------------
 const string Tokenizer::DEFAULT_SPECIAL_CHARACTERS = ";,:|={}/";
-Tokenizer::Token Tokenizer::invalid_token_{ "", 0, false, 0, 0, 0, false };
+Tokenizer::Token Tokenizer::invalid_token_;
 
 
 // ----------------------------------------------------------------------------
@@ -60,6 +60,16 @@ namespace
 		// Whitespace is either a newline, tab character or space
 		return p == '\n' || p == 13 || p == ' ' || p == '\t';
 	}
+
+	// ------------------------------------------------------------------------
+	// asciiLower
+	//
+	// Returns the lowercase version of [c] (ASCII letters only)
+	// ------------------------------------------------------------------------
+	inline char asciiLower(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+	}
 }
 
 
@@ -70,6 +80,130 @@ namespace
 // ----------------------------------------------------------------------------
 
 
+// ----------------------------------------------------------------------------
+// Token::operator=
+//
+// Copies [copy] to this token. The copy doesn't keep the view of the source
+// data, since it may outlive the tokenizer (or its current data), so the text
+// is built first if needed
+// ----------------------------------------------------------------------------
+Tokenizer::Token& Tokenizer::Token::operator=(const Token& copy)
+{
+	if (this == &copy)
+		return *this;
+
+	text = copy.text;
+	line_no = copy.line_no;
+	quoted_string = copy.quoted_string;
+	pos_start = copy.pos_start;
+	pos_end = copy.pos_end;
+	length = copy.length;
+	valid = copy.valid;
+	escaped = copy.escaped;
+	lower = copy.lower;
+	data = copy.data;
+	text_ready = copy.text_ready;
+
+	if (!text_ready)
+		buildText(*this);
+	data = nullptr;
+
+	return *this;
+}
+
+// ----------------------------------------------------------------------------
+// Token::operator[]
+//
+// Returns the character at [index] in the token
+// ----------------------------------------------------------------------------
+char Tokenizer::Token::operator[](unsigned index) const
+{
+	if (!usesView())
+		return text[index];
+
+	if (index >= length)
+		return 0;
+
+	return lower ? asciiLower(data[index]) : data[index];
+}
+
+// ----------------------------------------------------------------------------
+// Token::equals
+//
+// Returns true if the token matches [cmp] (Case-Sensitive). Compares directly
+// against the source data, so doesn't need [text] to be built
+// ----------------------------------------------------------------------------
+bool Tokenizer::Token::equals(const char* cmp) const
+{
+	if (!usesView())
+		return text.Cmp(cmp) == 0;
+
+	for (unsigned a = 0; a < length; ++a)
+	{
+		char c = lower ? asciiLower(data[a]) : data[a];
+		if (cmp[a] == 0 || cmp[a] != c)
+			return false;
+	}
+
+	return cmp[length] == 0;
+}
+bool Tokenizer::Token::equals(const string& cmp) const
+{
+	if (!usesView())
+		return text == cmp;
+
+	if (cmp.length() != length)
+		return false;
+
+	unsigned a = 0;
+	for (auto c : cmp)
+	{
+		if (c != (lower ? asciiLower(data[a]) : data[a]))
+			return false;
+		++a;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// Token::equalsNC
+//
+// Returns true if the token matches [cmp] (Case-Insensitive). Compares
+// directly against the source data, so doesn't need [text] to be built
+// ----------------------------------------------------------------------------
+bool Tokenizer::Token::equalsNC(const char* cmp) const
+{
+	if (!usesView())
+		return S_CMPNOCASE(text, cmp);
+
+	for (unsigned a = 0; a < length; ++a)
+		if (cmp[a] == 0 || asciiLower(cmp[a]) != asciiLower(data[a]))
+			return false;
+
+	return cmp[length] == 0;
+}
+bool Tokenizer::Token::equalsNC(const string& cmp) const
+{
+	if (!usesView())
+		return S_CMPNOCASE(text, cmp);
+
+	if (cmp.length() != length)
+		return false;
+
+	unsigned a = 0;
+	for (auto c : cmp)
+	{
+		if (!c.IsAscii())
+			return S_CMPNOCASE(string(data, length), cmp);
+		if (asciiLower((char)c) != asciiLower(data[a]))
+			return false;
+		++a;
+	}
+
+	return true;
+}
+
 // ----------------------------------------------------------------------------
 // Token::isInteger
 //
@@ -78,6 +212,19 @@ namespace
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isInteger(bool allow_hex) const
 {
+	if (usesView())
+	{
+		// An uppercase hex prefix would have been read as lowercase
+		if (lower && allow_hex && length > 1 && data[1] == 'X')
+		{
+			std::string hex(data, length);
+			hex[1] = 'x';
+			return StringUtils::isInteger(hex.data(), hex.size(), true);
+		}
+
+		return StringUtils::isInteger(data, length, allow_hex);
+	}
+
 	return StringUtils::isInteger(text, allow_hex);
 }
 
@@ -88,6 +235,19 @@ bool Tokenizer::Token::isInteger(bool allow_hex) const
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isHex() const
 {
+	if (usesView())
+	{
+		// An uppercase hex prefix would have been read as lowercase
+		if (lower && length > 1 && data[1] == 'X')
+		{
+			std::string hex(data, length);
+			hex[1] = 'x';
+			return StringUtils::isHex(hex.data(), hex.size());
+		}
+
+		return StringUtils::isHex(data, length);
+	}
+
 	return StringUtils::isHex(text);
 }
 
@@ -98,9 +258,26 @@ bool Tokenizer::Token::isHex() const
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::isFloat() const
 {
+	if (usesView())
+		return StringUtils::isFloat(data, length);
+
 	return StringUtils::isFloat(text);
 }
 
+// ----------------------------------------------------------------------------
+// Token::asInt
+//
+// Returns the token as an integer value (parsed like atoi)
+// ----------------------------------------------------------------------------
+int Tokenizer::Token::asInt() const
+{
+	if (!usesView())
+		return wxAtoi(text);
+
+	// Numbers fit in std::string's small buffer, so this won't allocate
+	return atoi(std::string(data, length).c_str());
+}
+
 // ----------------------------------------------------------------------------
 // Token::asBool
 //
@@ -109,22 +286,20 @@ bool Tokenizer::Token::isFloat() const
 // ----------------------------------------------------------------------------
 bool Tokenizer::Token::asBool() const
 {
-	return !(S_CMPNOCASE(text, "false") ||
-			 S_CMPNOCASE(text, "no") ||
-			 S_CMPNOCASE(text, "0"));
+	return !(equalsNC("false") || equalsNC("no") || equalsNC("0"));
 }
 
 // ----------------------------------------------------------------------------
-// Token::toBool
+// Token::asFloat
 //
-// Sets [val] to the token as a bool value.
-// "false", "no" and "0" are false, anything else is true.
+// Returns the token as a floating point value (parsed like atof)
 // ----------------------------------------------------------------------------
-void Tokenizer::Token::toBool(bool& val) const
+double Tokenizer::Token::asFloat() const
 {
-	val = !(S_CMPNOCASE(text, "false") ||
-			S_CMPNOCASE(text, "no") ||
-			S_CMPNOCASE(text, "0"));
+	if (!usesView())
+		return wxAtof(text);
+
+	return atof(std::string(data, length).c_str());
 }
 
 
@@ -159,7 +334,7 @@ const Tokenizer::Token& Tokenizer::peek() const
 	if (!token_next_.valid)
 		return invalid_token_;
 
-	return token_next_;
+	return materialised(token_next_);
 }
 
 // ----------------------------------------------------------------------------
@@ -172,9 +347,8 @@ const Tokenizer::Token& Tokenizer::next()
 	if (!token_next_.valid)
 		return invalid_token_;
 
-	token_current_ = token_next_;
-	readNext();
-	return token_current_;
+	advNext();
+	return materialised(token_current_);
 }
 
 // ----------------------------------------------------------------------------
@@ -190,8 +364,24 @@ void Tokenizer::adv(size_t inc)
 	for (size_t a = 0; a < inc - 1; a++)
 		readNext();
 
-	token_current_ = token_next_;
-	readNext();
+	advNext();
+}
+
+// ----------------------------------------------------------------------------
+// Tokenizer::advNext
+//
+// Makes the 'next' token current and reads the following one. The tokens are
+// swapped rather than copied so the text buffers get reused
+// ----------------------------------------------------------------------------
+void Tokenizer::advNext()
+{
+	std::swap(token_current_, token_next_);
+	if (!readNext())
+	{
+		// At the end, the 'next' token is left as a copy of the current one
+		token_next_ = token_current_;
+		token_next_.valid = false;
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -237,7 +427,7 @@ bool Tokenizer::advIf(char check, size_t inc)
 // ----------------------------------------------------------------------------
 bool Tokenizer::advIfNC(const char* check, size_t inc)
 {
-	if (S_CMPNOCASE(token_current_.text, check))
+	if (token_current_.equalsNC(check))
 	{
 		adv(inc);
 		return true;
@@ -247,7 +437,7 @@ bool Tokenizer::advIfNC(const char* check, size_t inc)
 }
 bool Tokenizer::advIfNC(const string& check, size_t inc)
 {
-	if (S_CMPNOCASE(token_current_.text, check))
+	if (token_current_.equalsNC(check))
 	{
 		adv(inc);
 		return true;
@@ -311,7 +501,7 @@ bool Tokenizer::advIfNextNC(const char* check, size_t inc)
 	if (!token_next_.valid)
 		return false;
 
-	if (S_CMPNOCASE(token_next_.text, check))
+	if (token_next_.equalsNC(check))
 	{
 		adv(inc);
 		return true;
@@ -334,8 +524,7 @@ void Tokenizer::advToNextLine()
 	// If the next token is on the next line just move to it
 	if (token_next_.line_no > token_current_.line_no)
 	{
-		token_current_ = token_next_;
-		readNext();
+		advNext();
 		return;
 	}
 
@@ -409,7 +598,7 @@ vector<Tokenizer::Token> Tokenizer::getTokensUntil(const char* end)
 	vector<Token> tokens;
 	while (!atEnd())
 	{
-		tokens.push_back(token_current_);
+		tokens.push_back(current());
 
 		adv();
 
@@ -425,7 +614,7 @@ vector<Tokenizer::Token> Tokenizer::getTokensUntilNC(const char* end)
 	vector<Token> tokens;
 	while (!atEnd())
 	{
-		tokens.push_back(token_current_);
+		tokens.push_back(current());
 
 		adv();
 
@@ -449,7 +638,7 @@ vector<Tokenizer::Token> Tokenizer::getTokensUntilNextLine(bool from_start)
 	vector<Token> tokens;
 	while (!atEnd())
 	{
-		tokens.push_back(token_current_);
+		tokens.push_back(current());
 
 		if (token_next_.line_no > token_current_.line_no)
 		{
@@ -517,7 +706,7 @@ bool Tokenizer::checkOrEndNC(const char* check) const
 	if (!token_next_.valid)
 		return true;
 
-	return S_CMPNOCASE(token_current_.text, check);
+	return token_current_.equalsNC(check);
 }
 
 // ----------------------------------------------------------------------------
@@ -552,7 +741,7 @@ bool Tokenizer::checkNextNC(const char* check) const
 	if (!token_next_.valid)
 		return false;
 
-	return S_CMPNOCASE(token_next_.text, check);
+	return token_next_.equalsNC(check);
 }
 
 // ----------------------------------------------------------------------------
@@ -656,6 +845,10 @@ void Tokenizer::reset()
 	state_ = TokenizeState{};
 	state_.size = data_.size();
 
+	// Clear tokens (they may reference previously opened data)
+	token_current_ = invalid_token_;
+	token_next_ = invalid_token_;
+
 	// Read first tokens
 	readNext(&token_current_);
 	readNext(&token_next_);
@@ -905,31 +1098,23 @@ bool Tokenizer::readNext(Token* target)
 	// Write to target token (if specified)
 	if (target)
 	{
-		// How is this slower than using += in a loop as below? Just wxString things >_>
-		//target->text.assign(
-		//	data_.data() + state_.current_token.pos_start,
-		//	state_.position - state_.current_token.pos_start
-		//);
-		
-		target->text.Empty();
-		for (unsigned a = state_.current_token.pos_start; a < state_.position; ++a)
-		{
-			if (state_.current_token.quoted_string && data_[a] == '\\')
-				++a;
-
-			target->text += data_[a];
-		}
-
 		target->line_no = state_.current_token.line_no;
 		target->quoted_string = state_.current_token.quoted_string;
 		target->pos_start = state_.current_token.pos_start;
 		target->pos_end = state_.position;
 		target->length = target->pos_end - target->pos_start;
 		target->valid = true;
-
-		// Convert to lowercase if configured to and it isn't a quoted string
-		if (read_lowercase_ && !target->quoted_string)
-			target->text.LowerCase();
+		target->data = data_.data() + target->pos_start;
+		target->lower = read_lowercase_ && !target->quoted_string;
+		target->escaped =
+			target->quoted_string &&
+			memchr(target->data, '\\', target->length) != nullptr;
+
+		// Text is built when the token is accessed, unless it has escape
+		// sequences (in which case the source data can't be used directly)
+		target->text_ready = false;
+		if (target->escaped)
+			buildText(*target);
 	}
 
 	// Skip closing " if it was a quoted string
@@ -937,11 +1122,37 @@ bool Tokenizer::readNext(Token* target)
 		++state_.position;
 
 	if (debug_)
-		Log::debug(S_FMT("%d: \"%s\"", token_current_.line_no, CHR(token_current_.text)));
+		Log::debug(S_FMT("%d: \"%s\"", token_current_.line_no, CHR(current().text)));
 		
 	return true;
 }
 
+// ----------------------------------------------------------------------------
+// Tokenizer::buildText
+//
+// Builds the [text] string of [token] from its source data
+// ----------------------------------------------------------------------------
+void Tokenizer::buildText(Token& token)
+{
+	// How is this slower than using += in a loop as below? Just wxString things >_>
+	//token.text.assign(token.data, token.length);
+
+	token.text.Empty();
+	for (unsigned a = 0; a < token.length; ++a)
+	{
+		if (token.quoted_string && token.data[a] == '\\')
+			++a;
+
+		token.text += token.data[a];
+	}
+
+	// Convert to lowercase if configured to and it isn't a quoted string
+	if (token.lower)
+		token.text.LowerCase();
+
+	token.text_ready = true;
+}
+
 void Tokenizer::resetToLineStart()
 {
 	// Reset state to start of current token
@@ -969,6 +1180,7 @@ void Tokenizer::resetToLineStart()
 #include "General/Console/Console.h"
 #include "MainEditor/MainEditor.h"
 #include "Archive/ArchiveEntry.h"
+#include "Archive/ArchiveManager.h"
 #include "App.h"
 
 CONSOLE_COMMAND(test_tokenizer, 0, false)
@@ -1043,3 +1255,72 @@ CONSOLE_COMMAND(test_tokenizer, 0, false)
 			Log::debug(S_FMT("%d: \"%s\"%s", token.line_no, CHR(token.text), token.quoted_string ? " (quoted)" : ""));
 	}
 }
+
+CONSOLE_COMMAND(benchmark_tokenizer, 0, false)
+{
+	// Get the bundled game configurations
+	auto resource = App::archiveManager().programResourceArchive();
+	if (!resource)
+		return;
+	auto dir = resource->getDir("config/games");
+	if (!dir)
+		return;
+	vector<ArchiveEntry*> entries;
+	resource->getEntryTreeAsList(entries, dir);
+
+	long num = 10;
+	if (!args.empty())
+		args[0].ToLong(&num);
+	if (num < 1)
+		num = 1;
+
+	// Total size of data tokenized per pass
+	size_t bytes = 0;
+	for (auto entry : entries)
+		bytes += entry->getSize();
+
+	Tokenizer tz;
+	auto run = [&](const char* name, bool build_text)
+	{
+		size_t tokens = 0;
+		size_t matched = 0;
+		long time = App::runTimer();
+		for (long a = 0; a < num; a++)
+		{
+			for (auto entry : entries)
+			{
+				tz.openMem(entry->getMCData(), entry->getName());
+				while (!tz.atEnd())
+				{
+					if (build_text)
+					{
+						if (!tz.current().text.IsEmpty())
+							++matched;
+					}
+					else if (tz.check('{') || tz.checkNC("include"))
+						++matched;
+
+					tz.adv();
+					++tokens;
+				}
+			}
+		}
+		time = App::runTimer() - time;
+
+		double mb = (double)bytes * num / (1024.0 * 1024.0);
+		Log::info(S_FMT(
+			"%s: %lu tokens (%lu matched) (%1.2fMB) x%d in %dms, %1.2fMB/s",
+			name,
+			(unsigned long)(tokens / num),
+			(unsigned long)(matched / num),
+			(double)bytes / (1024.0 * 1024.0),
+			(int)num,
+			(int)time,
+			time > 0 ? mb / (time / 1000.0) : 0.0
+		));
+	};
+
+	Log::info(S_FMT("Tokenizing %lu game configuration entries", (unsigned long)entries.size()));
+	run("Compare only", false);
+	run("Build text", true);
+}
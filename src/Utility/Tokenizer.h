@@ -17,36 +17,58 @@ public:
 	struct Token
 	{
 		string		text;
-		unsigned	line_no;
-		bool		quoted_string;
-		unsigned	pos_start;
-		unsigned	pos_end;
-		unsigned	length;
-		bool		valid;
+		unsigned	line_no = 0;
+		bool		quoted_string = false;
+		unsigned	pos_start = 0;
+		unsigned	pos_end = 0;
+		unsigned	length = 0;
+		bool		valid = false;
+
+		// View of the token within the tokenizer's source data. This is only
+		// valid while the tokenizer that read the token is alive and hasn't
+		// opened anything else. [text] is built from it lazily, on first
+		// access through current()/peek()/next(). Copies of a token never
+		// keep the view (see operator=), only the tokenizer's own tokens do
+		const char*	data = nullptr;		// Token characters (not null-terminated)
+		bool		escaped = false;	// Quoted string with escape sequences (text is always built)
+		bool		lower = false;		// Token is read in lowercase
+		bool		text_ready = true;	// [text] has been built from [data]
+
+		Token() = default;
+		Token(const Token& copy) { *this = copy; }
+		Token(Token&& other) = default;
+		Token&	operator=(const Token& copy);
+		Token&	operator=(Token&& other) = default;
 
 		explicit	operator	string() const { return text; }
 		explicit	operator	const string() const { return text; }
 		explicit	operator	const char*() const { return CHR(text); }
-		bool		operator	==(const string& cmp) const { return text == cmp; }
-		bool		operator	==(const char* cmp) const { return text.Cmp(cmp) == 0; }
-		bool		operator	==(char cmp) const { return length == 1 && text[0] == cmp; }
-		bool		operator	!=(const string& cmp) const { return text != cmp; }
-		bool		operator	!=(const char* cmp) const { return text.Cmp(cmp) != 0; }
-		bool		operator	!=(char cmp) const { return length != 1 || text[0] != cmp; }
-		char		operator	[](unsigned index) const { return text[index]; }
+		bool		operator	==(const string& cmp) const { return equals(cmp); }
+		bool		operator	==(const char* cmp) const { return equals(cmp); }
+		bool		operator	==(char cmp) const { return length == 1 && (*this)[0] == cmp; }
+		bool		operator	!=(const string& cmp) const { return !equals(cmp); }
+		bool		operator	!=(const char* cmp) const { return !equals(cmp); }
+		bool		operator	!=(char cmp) const { return length != 1 || (*this)[0] != cmp; }
+		char		operator	[](unsigned index) const;
+
+		bool	usesView() const { return data && !escaped; }
+		bool	equals(const char* cmp) const;
+		bool	equals(const string& cmp) const;
+		bool	equalsNC(const char* cmp) const;
+		bool	equalsNC(const string& cmp) const;
 
 		bool	isInteger(bool allow_hex = false) const;
 		bool	isHex() const;
 		bool	isFloat() const;
 
-		int		asInt() const { return wxAtoi(text); }
+		int		asInt() const;
 		bool	asBool() const;
-		double 	asFloat() const { return wxAtof(text); }
+		double 	asFloat() const;
 
-		void 	toInt(int& val) const { val = wxAtoi(text); }
-		void 	toBool(bool& val) const;
-		void 	toFloat(double& val) const { val = wxAtof(text); }
-		void	toFloat(float& val) const { val = (float) wxAtof(text); }
+		void 	toInt(int& val) const { val = asInt(); }
+		void 	toBool(bool& val) const { val = asBool(); }
+		void 	toFloat(double& val) const { val = asFloat(); }
+		void	toFloat(float& val) const { val = (float)asFloat(); }
 	};
 
 	struct TokenizeState
@@ -78,7 +100,7 @@ public:
 	const string&	source() const { return source_; }
 	bool			decorate() const { return decorate_; }
 	bool			readLowerCase() const { return read_lowercase_; }
-	const Token&	current() const { return token_current_; }
+	const Token&	current() const { return materialised(token_current_); }
 	const Token&	peek() const;
 
 	// Modifiers
@@ -122,7 +144,7 @@ public:
 	bool	checkOrEnd(const char* check) const;
 	bool	checkOrEnd(const string& check) const;
 	bool	checkOrEnd(char check) const;
-	bool	checkNC(const char* check) const { return S_CMPNOCASE(token_current_.text, check); }
+	bool	checkNC(const char* check) const { return token_current_.equalsNC(check); }
 	bool	checkOrEndNC(const char* check) const;
 	bool	checkNext(const char* check) const;
 	bool	checkNext(const string& check) const;
@@ -147,10 +169,10 @@ public:
 
 	// Old tokenizer interface bridge (don't use)
 	string		getToken()
-				{ if (atEnd()) return ""; string t = token_current_.text; adv(); return t; }
+				{ if (atEnd()) return ""; string t = current().text; adv(); return t; }
 	void		getToken(string* str)
-				{ if (atEnd()) *str = ""; else *str = token_current_.text; adv(); }
-	string		peekToken() const { if (atEnd()) return ""; return token_next_.text; }
+				{ if (atEnd()) *str = ""; else *str = current().text; adv(); }
+	string		peekToken() const { if (atEnd()) return ""; return peek().text; }
 	int			getInteger()
 				{ if (atEnd()) return 0; int v = token_current_.asInt(); adv(); return v; }
 	double		getDouble()
@@ -168,8 +190,8 @@ public:
 
 private:
 	vector<char>	data_;
-	Token			token_current_;
-	Token			token_next_;
+	mutable Token	token_current_;	// Mutable so [text] can be built on access
+	mutable Token	token_next_;
 	TokenizeState	state_;
 
 	// Configuration
@@ -192,5 +214,9 @@ private:
 	void		tokenizeWhitespace();
 	bool		readNext(Token* target);
 	bool		readNext() { return readNext(&token_next_); }
+	void		advNext();
 	void		resetToLineStart();
+
+	static void			buildText(Token& token);
+	static const Token&	materialised(Token& token) { if (!token.text_ready) buildText(token); return token; }
 };